@@ -1839,106 +1839,156 @@ gnc_module_finalize_backend_dbi( void )
 }
 
 /* --------------------------------------------------------- */
+/* Loading a book reads every column of every row of tables like splits
+ * and slots by name.  Looking a field up by name in libdbi is a linear
+ * search with string compares, so each column of a result is resolved
+ * to its field index, type and attributes only once, the first time it
+ * is asked for.  Its value is kept in a GValue belonging to the column
+ * which is refilled when the next row is read, instead of allocating a
+ * new GValue (and string copy) for every cell.  Strings are returned
+ * without copying; libdbi keeps them until the result is freed. */
+#define DBI_DATETIME_STR_LEN 32
+
+typedef struct
+{
+    guint idx;                  /* libdbi field index, 0 if no such column */
+    gushort type;
+    guint attrs;
+    guint row_num;              /* row for which value was fetched, 0 if none */
+    gboolean is_null;
+    GValue value;
+    time_t datetime;            /* last DATETIME formatted into datetime_str */
+    gchar datetime_str[DBI_DATETIME_STR_LEN];
+} GncDbiSqlColumn;
+
 typedef struct
 {
     GncSqlRow base;
 
     /*@ dependent @*/
     dbi_result result;
-    GList* gvalue_list;
+    GHashTable* columns;        /* column name -> GncDbiSqlColumn */
+    guint row_num;              /* counts rows read, starting from 1 */
 } GncDbiSqlRow;
 
+static void
+column_free( gpointer data )
+{
+    GncDbiSqlColumn* column = (GncDbiSqlColumn*)data;
+
+    if ( G_IS_VALUE( &column->value ) )
+    {
+        g_value_unset( &column->value );
+    }
+    g_free( column );
+}
+
 static void
 row_dispose( /*@ only @*/ GncSqlRow* row )
 {
     GncDbiSqlRow* dbi_row = (GncDbiSqlRow*)row;
-    GList* node;
 
-    if ( dbi_row->gvalue_list != NULL )
+    g_hash_table_destroy( dbi_row->columns );
+    g_free( dbi_row );
+}
+
+static GncDbiSqlColumn*
+row_get_column( GncDbiSqlRow* dbi_row, const gchar* col_name )
+{
+    GncDbiSqlColumn* column;
+
+    column = g_hash_table_lookup( dbi_row->columns, col_name );
+    if ( column == NULL )
     {
-        for ( node = dbi_row->gvalue_list; node != NULL; node = node->next )
+        column = g_new0( GncDbiSqlColumn, 1 );
+        column->idx = dbi_result_get_field_idx( dbi_row->result, col_name );
+        if ( column->idx != 0 )
         {
-            GValue* value;
-            if ( !G_IS_VALUE(node->data) )
-                continue;
-            value = (GValue*)node->data;
-            if ( G_VALUE_HOLDS_STRING(value) )
-            {
-                g_free( (gpointer)g_value_get_string( value ) );
-            }
-            g_free( value );
+            column->type = dbi_result_get_field_type_idx( dbi_row->result, column->idx );
+            column->attrs = dbi_result_get_field_attribs_idx( dbi_row->result, column->idx );
         }
-        g_list_free( dbi_row->gvalue_list );
+        g_hash_table_insert( dbi_row->columns, g_strdup( col_name ), column );
     }
-    g_free( dbi_row );
+
+    return column;
 }
 
 static /*@ null @*/ const GValue*
 row_get_value_at_col_name( GncSqlRow* row, const gchar* col_name )
 {
     GncDbiSqlRow* dbi_row = (GncDbiSqlRow*)row;
-    gushort type;
-    guint attrs;
+    GncDbiSqlColumn* column;
     GValue* value;
     time_t time;
     struct tm tm_struct;
 
-    type = dbi_result_get_field_type( dbi_row->result, col_name );
-    attrs = dbi_result_get_field_attribs( dbi_row->result, col_name );
-    value = g_new0( GValue, 1 );
-    g_assert( value != NULL );
+    column = row_get_column( dbi_row, col_name );
+    if ( column->row_num == dbi_row->row_num )
+    {
+        return column->is_null ? NULL : &column->value;
+    }
+    column->row_num = dbi_row->row_num;
+    column->is_null = FALSE;
+
+    value = &column->value;
+    if ( G_IS_VALUE( value ) )
+    {
+        g_value_unset( value );
+    }
 
-    switch ( type )
+    switch ( column->type )
     {
     case DBI_TYPE_INTEGER:
         (void)g_value_init( value, G_TYPE_INT64 );
-        g_value_set_int64( value, dbi_result_get_longlong( dbi_row->result, col_name ) );
+        g_value_set_int64( value, dbi_result_get_longlong_idx( dbi_row->result, column->idx ) );
         break;
     case DBI_TYPE_DECIMAL:
         gnc_push_locale( LC_NUMERIC, "C" );
-        if ( (attrs & DBI_DECIMAL_SIZEMASK) == DBI_DECIMAL_SIZE4 )
+        if ( (column->attrs & DBI_DECIMAL_SIZEMASK) == DBI_DECIMAL_SIZE4 )
         {
             (void)g_value_init( value, G_TYPE_FLOAT );
-            g_value_set_float( value, dbi_result_get_float( dbi_row->result, col_name ) );
+            g_value_set_float( value, dbi_result_get_float_idx( dbi_row->result, column->idx ) );
         }
-        else if ( (attrs & DBI_DECIMAL_SIZEMASK) == DBI_DECIMAL_SIZE8 )
+        else if ( (column->attrs & DBI_DECIMAL_SIZEMASK) == DBI_DECIMAL_SIZE8 )
         {
             (void)g_value_init( value, G_TYPE_DOUBLE );
-            g_value_set_double( value, dbi_result_get_double( dbi_row->result, col_name ) );
+            g_value_set_double( value, dbi_result_get_double_idx( dbi_row->result, column->idx ) );
         }
         else
         {
-            PERR( "Field %s: strange decimal length attrs=%d\n", col_name, attrs );
+            PERR( "Field %s: strange decimal length attrs=%d\n", col_name, column->attrs );
         }
         gnc_pop_locale( LC_NUMERIC );
         break;
     case DBI_TYPE_STRING:
         (void)g_value_init( value, G_TYPE_STRING );
-        g_value_take_string( value, dbi_result_get_string_copy( dbi_row->result, col_name ) );
+        g_value_set_static_string( value, dbi_result_get_string_idx( dbi_row->result, column->idx ) );
         break;
     case DBI_TYPE_DATETIME:
-        if ( dbi_result_field_is_null( dbi_row->result, col_name ) )
+        if ( dbi_result_field_is_null_idx( dbi_row->result, column->idx ) )
         {
+            column->is_null = TRUE;
             return NULL;
         }
-        else
+        time = dbi_result_get_datetime_idx( dbi_row->result, column->idx );
+        if ( column->datetime_str[0] == '\0' || time != column->datetime )
         {
-            time = dbi_result_get_datetime( dbi_row->result, col_name );
             (void)gmtime_r( &time, &tm_struct );
-            (void)g_value_init( value, G_TYPE_STRING );
-            g_value_take_string( value,
-                                 g_strdup_printf( "%d%02d%02d%02d%02d%02d",
-                                                  1900 + tm_struct.tm_year, tm_struct.tm_mon + 1, tm_struct.tm_mday,
-                                                  tm_struct.tm_hour, tm_struct.tm_min, tm_struct.tm_sec ) );
+            (void)g_snprintf( column->datetime_str, DBI_DATETIME_STR_LEN,
+                              "%d%02d%02d%02d%02d%02d",
+                              1900 + tm_struct.tm_year, tm_struct.tm_mon + 1, tm_struct.tm_mday,
+                              tm_struct.tm_hour, tm_struct.tm_min, tm_struct.tm_sec );
+            column->datetime = time;
         }
+        (void)g_value_init( value, G_TYPE_STRING );
+        g_value_set_static_string( value, column->datetime_str );
         break;
     default:
-        PERR( "Field %s: unknown DBI_TYPE: %d\n", col_name, type );
-        g_free( value );
+        PERR( "Field %s: unknown DBI_TYPE: %d\n", col_name, column->type );
+        column->is_null = TRUE;
         return NULL;
     }
 
-    dbi_row->gvalue_list = g_list_prepend( dbi_row->gvalue_list, value );
     return value;
 }
 
@@ -1953,6 +2003,8 @@ create_dbi_row( /*@ dependent @*/ dbi_result result )
     row->base.getValueAtColName = row_get_value_at_col_name;
     row->base.dispose = row_dispose;
     row->result = result;
+    row->columns = g_hash_table_new_full( g_str_hash, g_str_equal,
+                                          g_free, column_free );
 
     return (GncSqlRow*)row;
 }
@@ -1967,7 +2019,7 @@ typedef struct
     dbi_result result;
     guint num_rows;
     guint cur_row;
-    GncSqlRow* row;
+    GncSqlRow* row;             /* reused for every row of the result */
 } GncDbiSqlResult;
 
 static void
@@ -2001,16 +2053,23 @@ result_get_num_rows( GncSqlResult* result )
     return dbi_result->num_rows;
 }
 
+/* Returns the result's row object after moving to a new row */
+static GncSqlRow*
+result_get_row( GncDbiSqlResult* dbi_result )
+{
+    if ( dbi_result->row == NULL )
+    {
+        dbi_result->row = create_dbi_row( dbi_result->result );
+    }
+    ((GncDbiSqlRow*)dbi_result->row)->row_num++;
+    return dbi_result->row;
+}
+
 static /*@ null @*/ GncSqlRow*
 result_get_first_row( GncSqlResult* result )
 {
     GncDbiSqlResult* dbi_result = (GncDbiSqlResult*)result;
 
-    if ( dbi_result->row != NULL )
-    {
-        gnc_sql_row_dispose( dbi_result->row );
-        dbi_result->row = NULL;
-    }
     if ( dbi_result->num_rows > 0 )
     {
         gint status = dbi_result_first_row( dbi_result->result );
@@ -2020,8 +2079,7 @@ result_get_first_row( GncSqlResult* result )
             qof_backend_set_error( dbi_result->dbi_conn->qbe, ERR_BACKEND_SERVER_ERR );
         }
         dbi_result->cur_row = 1;
-        dbi_result->row = create_dbi_row( dbi_result->result );
-        return dbi_result->row;
+        return result_get_row( dbi_result );
     }
     else
     {
@@ -2034,11 +2092,6 @@ result_get_next_row( GncSqlResult* result )
 {
     GncDbiSqlResult* dbi_result = (GncDbiSqlResult*)result;
 
-    if ( dbi_result->row != NULL )
-    {
-        gnc_sql_row_dispose( dbi_result->row );
-        dbi_result->row = NULL;
-    }
     if ( dbi_result->cur_row < dbi_result->num_rows )
     {
         gint status = dbi_result_next_row( dbi_result->result );
@@ -2048,8 +2101,7 @@ result_get_next_row( GncSqlResult* result )
             qof_backend_set_error( dbi_result->dbi_conn->qbe, ERR_BACKEND_SERVER_ERR );
         }
         dbi_result->cur_row++;
-        dbi_result->row = create_dbi_row( dbi_result->result );
-        return dbi_result->row;
+        return result_get_row( dbi_result );
     }
     else
     {
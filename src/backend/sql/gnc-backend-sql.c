@@ -30,6 +30,7 @@
 #include "config.h"
 
 #include <errno.h>
+#include <string.h>
 #include <glib.h>
 #include <glib/gi18n.h>
 #include <glib/gstdio.h>
@@ -88,11 +89,25 @@ static void update_progress( GncSqlBackend* be );
 static void finish_progress( GncSqlBackend* be );
 static void register_standard_col_type_handlers( void );
 static gboolean reset_version_info( GncSqlBackend* be );
+/*@ dependent @*//*@ null @*/
+static GncSqlColumnTypeHandler* get_handler( const GncSqlColumnTableEntry* table_row );
 /*@ null @*/
 static GncSqlStatement* build_insert_statement( GncSqlBackend* be,
         const gchar* table_name,
         QofIdTypeConst obj_name, gpointer pObject,
         const GncSqlColumnTableEntry* table );
+static gchar* build_insert_prefix( GncSqlBackend* be,
+                                   const gchar* table_name,
+                                   const GncSqlColumnTableEntry* table );
+static gchar* build_insert_values( GncSqlBackend* be,
+                                   QofIdTypeConst obj_name, gpointer pObject,
+                                   const GncSqlColumnTableEntry* table );
+static void insert_writer_begin( GncSqlBackend* be );
+static gboolean insert_writer_end( GncSqlBackend* be, gboolean flush );
+static gboolean insert_writer_flush( GncSqlBackend* be );
+static gboolean insert_writer_add( GncSqlBackend* be, const gchar* table_name,
+                                   QofIdTypeConst obj_name, gpointer pObject,
+                                   const GncSqlColumnTableEntry* table );
 /*@ null @*/
 static GncSqlStatement* build_update_statement( GncSqlBackend* be,
         const gchar* table_name,
@@ -133,6 +148,7 @@ typedef struct
 static QofLogModule log_module = G_LOG_DOMAIN;
 
 #define SQLITE_PROVIDER_NAME "SQLite"
+#define KEY_LOAD_TX_AS_NEEDED "sql_load_transactions_as_needed"
 
 /* ================================================================= */
 
@@ -231,6 +247,8 @@ gnc_sql_load( GncSqlBackend* be, /*@ dependent @*/ QofBook *book, QofBackendLoad
     {
         g_assert( be->primary_book == NULL );
         be->primary_book = book;
+        be->load_tx_as_needed = gnc_gconf_get_bool( GCONF_GENERAL,
+                                KEY_LOAD_TX_AS_NEEDED, NULL );
 
         /* Load any initial stuff. Some of this needs to happen in a certain order */
         for ( i = 0; fixed_load_order[i] != NULL; i++ )
@@ -264,8 +282,13 @@ gnc_sql_load( GncSqlBackend* be, /*@ dependent @*/ QofBook *book, QofBackendLoad
     }
     else if ( loadType == LOAD_TYPE_LOAD_ALL )
     {
-        // Load all transactions
-        gnc_sql_transaction_load_all_tx( be );
+        // Load all transactions, and the invoices loaded with them
+        if ( be->load_tx_as_needed )
+        {
+            gnc_sql_transaction_load_all_tx( be );
+            gnc_sql_invoice_load_all( be );
+            be->load_tx_as_needed = FALSE;
+        }
     }
 
     be->loading = FALSE;
@@ -510,6 +533,7 @@ gnc_sql_sync_all( GncSqlBackend* be, /*@ dependent @*/ QofBook *book )
     be->operations_done = 0;
 
     is_ok = gnc_sql_connection_begin_transaction( be->conn );
+    insert_writer_begin( be );
 
     // FIXME: should write the set of commodities that are used
     //write_commodities( be, book );
@@ -537,6 +561,10 @@ gnc_sql_sync_all( GncSqlBackend* be, /*@ dependent @*/ QofBook *book )
     {
         qof_object_foreach_backend( GNC_SQL_BACKEND, write_cb, be );
     }
+    if ( !insert_writer_end( be, is_ok ) )
+    {
+        is_ok = FALSE;
+    }
     if ( is_ok )
     {
         is_ok = gnc_sql_connection_commit_transaction( be->conn );
@@ -996,17 +1024,11 @@ gnc_sql_free_query( QofBackend* pBEnd, gpointer pQuery )
     // Try various objects first
     be_data.is_ok = FALSE;
     be_data.be = be;
-    be_data.pCompiledQuery = pQuery;
+    be_data.pCompiledQuery = pQueryInfo->pCompiledQuery;
     be_data.pQueryInfo = pQueryInfo;
 
     qof_object_foreach_backend( GNC_SQL_BACKEND, free_query_cb, &be_data );
-    if ( be_data.is_ok )
-    {
-        LEAVE( "" );
-        return;
-    }
-
-    if ( pQueryInfo->pCompiledQuery != NULL )
+    if ( !be_data.is_ok && pQueryInfo->pCompiledQuery != NULL )
     {
         DEBUG( "%s\n", (gchar*)pQueryInfo->pCompiledQuery );
         g_free( pQueryInfo->pCompiledQuery );
@@ -1077,6 +1099,534 @@ gnc_sql_run_query( QofBackend* pBEnd, gpointer pQuery )
     LEAVE( "" );
 }
 
+/* ================================================================= */
+/* Conversion of queries on objects stored one per table row to SQL.
+ *
+ * Loading the rows for a query may fetch too many objects, since the
+ * engine runs the query again over what is loaded, but never too few.
+ * A predicate is either converted exactly, converted to a condition which
+ * also holds for some rows which don't match, or left for the engine.
+ * ORDER BY and LIMIT are only added when every predicate is converted
+ * exactly and every sort key is a column compared the way the engine
+ * compares it. */
+
+static const gchar*
+get_comparison_operator( QofQueryCompare how )
+{
+    switch ( how )
+    {
+    case QOF_COMPARE_LT:
+        return "<";
+    case QOF_COMPARE_LTE:
+        return "<=";
+    case QOF_COMPARE_EQUAL:
+        return "=";
+    case QOF_COMPARE_GT:
+        return ">";
+    case QOF_COMPARE_GTE:
+        return ">=";
+    case QOF_COMPARE_NEQ:
+        return "<>";
+    default:
+        return NULL;
+    }
+}
+
+/* The engine's string match is a substring match.  LIKE is case sensitive
+ * in some databases and not in others, so it can only be used where it
+ * holds for at least every matching row. */
+static gboolean
+append_string_condition( const GncSqlBackend* be, const gchar* col_name,
+                         QofQueryPredData* pPredData, GString* sql )
+{
+    query_string_t string_data = (query_string_t)pPredData;
+    const gchar* match = string_data->matchstring;
+    gchar* pattern;
+    gchar* quoted;
+    const gchar* p;
+
+    if ( string_data->is_regex || pPredData->how != QOF_COMPARE_EQUAL
+            || match == NULL || *match == '\0' )
+    {
+        return FALSE;
+    }
+    for ( p = match; *p != '\0'; p++ )
+    {
+        // '\' is an escape character in LIKE patterns, and LOWER() only
+        // folds the case of ASCII letters in some databases
+        if ( *p == '\\' ) return FALSE;
+        if ( string_data->options == QOF_STRING_MATCH_CASEINSENSITIVE
+                && (guchar)*p >= 0x80 )
+        {
+            return FALSE;
+        }
+    }
+
+    if ( string_data->options == QOF_STRING_MATCH_CASEINSENSITIVE )
+    {
+        gchar* lower = g_ascii_strdown( match, -1 );
+        pattern = g_strdup_printf( "%%%s%%", lower );
+        g_free( lower );
+    }
+    else
+    {
+        pattern = g_strdup_printf( "%%%s%%", match );
+    }
+    quoted = gnc_sql_connection_quote_string( be->conn, pattern );
+    g_free( pattern );
+    if ( quoted == NULL ) return FALSE;
+
+    if ( string_data->options == QOF_STRING_MATCH_CASEINSENSITIVE )
+    {
+        g_string_append_printf( sql, "LOWER(%s) LIKE %s", col_name, quoted );
+    }
+    else
+    {
+        g_string_append_printf( sql, "%s LIKE %s", col_name, quoted );
+    }
+    g_free( quoted );
+
+    return TRUE;
+}
+
+/* Dates are stored to the second, so a date with a fraction of a second
+ * falls between two stored values. */
+static gboolean
+append_date_condition( const GncSqlBackend* be, const gchar* col_name,
+                       QofQueryPredData* pPredData, GString* sql )
+{
+    query_date_t date_data = (query_date_t)pPredData;
+    QofQueryCompare how = pPredData->how;
+    time_t time;
+    struct tm* tm;
+    gchar* datebuf;
+
+    if ( date_data->options != QOF_DATE_MATCH_NORMAL
+            || date_data->date.tv_nsec < 0 )
+    {
+        return FALSE;
+    }
+
+    // gnc_sql_convert_timespec_to_string() maps years before 1960 into
+    // this century, which doesn't keep them in order
+    time = timespecToTime_t( date_data->date );
+    tm = gmtime( &time );
+    if ( tm == NULL || tm->tm_year < 60 ) return FALSE;
+
+    if ( date_data->date.tv_nsec != 0 )
+    {
+        if ( how == QOF_COMPARE_EQUAL )
+        {
+            g_string_append( sql, "1=0" );
+            return TRUE;
+        }
+        if ( how == QOF_COMPARE_NEQ )
+        {
+            g_string_append( sql, "1=1" );
+            return TRUE;
+        }
+        if ( how == QOF_COMPARE_LT ) how = QOF_COMPARE_LTE;
+        else if ( how == QOF_COMPARE_GTE ) how = QOF_COMPARE_GT;
+    }
+    if ( get_comparison_operator( how ) == NULL ) return FALSE;
+
+    datebuf = gnc_sql_convert_timespec_to_string( be, date_data->date );
+    g_string_append_printf( sql, "%s%s'%s'",
+                            col_name, get_comparison_operator( how ), datebuf );
+    g_free( datebuf );
+
+    return TRUE;
+}
+
+static gboolean
+append_guid_condition( const GncSqlBackend* be, const gchar* col_name,
+                       QofQueryPredData* pPredData, GString* sql )
+{
+    query_guid_t guid_data = (query_guid_t)pPredData;
+    gchar guid_buf[GUID_ENCODING_LENGTH+1];
+    GList* node;
+
+    if ( guid_data->options == QOF_GUID_MATCH_NULL )
+    {
+        (void)guid_to_string_buff( guid_null(), guid_buf );
+        g_string_append_printf( sql, "(%s IS NULL OR %s='%s')",
+                                col_name, col_name, guid_buf );
+        return TRUE;
+    }
+    if ( guid_data->guids == NULL
+            || ( guid_data->options != QOF_GUID_MATCH_ANY
+                 && guid_data->options != QOF_GUID_MATCH_NONE ) )
+    {
+        return FALSE;
+    }
+
+    // A missing reference matches NONE but not ANY
+    if ( guid_data->options == QOF_GUID_MATCH_ANY )
+    {
+        g_string_append_printf( sql, "(%s IS NOT NULL AND %s IN (", col_name, col_name );
+    }
+    else
+    {
+        g_string_append_printf( sql, "(%s IS NULL OR %s NOT IN (", col_name, col_name );
+    }
+    for ( node = guid_data->guids; node != NULL; node = node->next )
+    {
+        (void)guid_to_string_buff( node->data, guid_buf );
+        if ( node != guid_data->guids )
+        {
+            g_string_append( sql, "," );
+        }
+        g_string_append_printf( sql, "'%s'", guid_buf );
+    }
+    g_string_append( sql, "))" );
+
+    return TRUE;
+}
+
+gboolean
+gnc_sql_append_predicate_condition( const GncSqlBackend* be, const gchar* col_name,
+                                    QofQueryPredData* pPredData, gboolean is_inverted,
+                                    GString* sql, /*@ null @*/ gboolean* is_exact )
+{
+    GString* cond;
+    gboolean exact = TRUE;
+    gboolean is_ok = FALSE;
+    const gchar* type_name;
+    const gchar* op;
+
+    g_return_val_if_fail( be != NULL, FALSE );
+    g_return_val_if_fail( col_name != NULL, FALSE );
+    g_return_val_if_fail( pPredData != NULL, FALSE );
+    g_return_val_if_fail( sql != NULL, FALSE );
+
+    type_name = pPredData->type_name;
+    op = get_comparison_operator( pPredData->how );
+    cond = g_string_new( "" );
+
+    if ( safe_strcmp( type_name, QOF_TYPE_STRING ) == 0 )
+    {
+        is_ok = append_string_condition( be, col_name, pPredData, cond );
+        exact = FALSE;
+    }
+    else if ( safe_strcmp( type_name, QOF_TYPE_DATE ) == 0 )
+    {
+        is_ok = append_date_condition( be, col_name, pPredData, cond );
+    }
+    else if ( safe_strcmp( type_name, QOF_TYPE_GUID ) == 0 )
+    {
+        is_ok = append_guid_condition( be, col_name, pPredData, cond );
+    }
+    else if ( safe_strcmp( type_name, QOF_TYPE_INT32 ) == 0 && op != NULL )
+    {
+        g_string_append_printf( cond, "%s%s%d",
+                                col_name, op, ((query_int32_t)pPredData)->val );
+        is_ok = TRUE;
+    }
+    else if ( safe_strcmp( type_name, QOF_TYPE_INT64 ) == 0 && op != NULL )
+    {
+        g_string_append_printf( cond, "%s%s%" G_GINT64_FORMAT,
+                                col_name, op, ((query_int64_t)pPredData)->val );
+        is_ok = TRUE;
+    }
+    else if ( safe_strcmp( type_name, QOF_TYPE_BOOLEAN ) == 0
+              && ( pPredData->how == QOF_COMPARE_EQUAL
+                   || pPredData->how == QOF_COMPARE_NEQ ) )
+    {
+        gboolean want_true = ((query_boolean_t)pPredData)->val;
+
+        if ( pPredData->how == QOF_COMPARE_NEQ ) want_true = !want_true;
+        g_string_append_printf( cond, "%s%s0", col_name, want_true ? "<>" : "=" );
+        is_ok = TRUE;
+    }
+
+    // Only an exact condition can be inverted
+    if ( is_ok && is_inverted )
+    {
+        if ( exact )
+        {
+            g_string_prepend( cond, "NOT (" );
+            g_string_append( cond, ")" );
+        }
+        else
+        {
+            is_ok = FALSE;
+        }
+    }
+
+    if ( is_ok )
+    {
+        g_string_append( sql, cond->str );
+        if ( is_exact != NULL ) *is_exact = exact;
+    }
+    g_string_free( cond, TRUE );
+
+    return is_ok;
+}
+
+/* Column handlers for references to other objects store their guid in a
+ * single column. */
+static gboolean
+is_objectref_column( const GncSqlColumnTableEntry* table_row )
+{
+    GncSqlColumnTypeHandler* pHandler = get_handler( table_row );
+
+    return pHandler != NULL
+           && pHandler->add_gvalue_to_slist_fn == gnc_sql_add_gvalue_objectref_guid_to_slist;
+}
+
+/* Returns the column of the table which holds the value of a query
+ * parameter path, or NULL if there isn't one.  A column belongs to a
+ * parameter if it is loaded through that parameter, or with the same
+ * access function. */
+/*@ null @*/ static const GncSqlColumnTableEntry*
+find_query_column( QofIdTypeConst obj_name, GSList* param_path,
+                   const gchar* type_name, const GncSqlColumnTableEntry* col_table )
+{
+    const gchar* param_name = param_path->data;
+    QofAccessFunc getter;
+    QofType param_type;
+    const GncSqlColumnTableEntry* table_row;
+
+    getter = qof_class_get_parameter_getter( obj_name, param_name );
+    param_type = qof_class_get_parameter_type( obj_name, param_name );
+    if ( getter == NULL || param_type == NULL ) return NULL;
+
+    for ( table_row = col_table; table_row->col_name != NULL; table_row++ )
+    {
+        const gchar* col_type = table_row->col_type;
+
+        if ( safe_strcmp( table_row->qof_param_name, param_name ) != 0
+                && safe_strcmp( table_row->gobj_param_name, param_name ) != 0
+                && ( table_row->getter == NULL || table_row->getter != getter ) )
+        {
+            continue;
+        }
+
+        if ( param_path->next == NULL )
+        {
+            if ( strcmp( param_type, type_name ) != 0 ) return NULL;
+            if ( ( strcmp( col_type, CT_STRING ) == 0 && strcmp( type_name, QOF_TYPE_STRING ) == 0 )
+                    || ( strcmp( col_type, CT_TIMESPEC ) == 0 && strcmp( type_name, QOF_TYPE_DATE ) == 0 )
+                    || ( strcmp( col_type, CT_GUID ) == 0 && strcmp( type_name, QOF_TYPE_GUID ) == 0 )
+                    || ( strcmp( col_type, CT_INT ) == 0 && strcmp( type_name, QOF_TYPE_INT32 ) == 0 )
+                    || ( strcmp( col_type, CT_INT64 ) == 0 && strcmp( type_name, QOF_TYPE_INT64 ) == 0 )
+                    || ( strcmp( col_type, CT_BOOLEAN ) == 0 && strcmp( type_name, QOF_TYPE_BOOLEAN ) == 0 ) )
+            {
+                return table_row;
+            }
+        }
+        else if ( param_path->next->next == NULL
+                  && strcmp( param_path->next->data, QOF_PARAM_GUID ) == 0
+                  && strcmp( type_name, QOF_TYPE_GUID ) == 0
+                  && is_objectref_column( table_row ) )
+        {
+            return table_row;
+        }
+        return NULL;
+    }
+
+    return NULL;
+}
+
+/* Returns an SQL expression for the value the engine sees for a column.
+ * NULL numbers and dates are loaded as 0. */
+static gchar*
+get_column_expression( const GncSqlBackend* be, const GncSqlColumnTableEntry* table_row )
+{
+    if ( (table_row->flags & COL_NNUL) != 0
+            || strcmp( table_row->col_type, CT_STRING ) == 0
+            || strcmp( table_row->col_type, CT_GUID ) == 0
+            || is_objectref_column( table_row ) )
+    {
+        return g_strdup( table_row->col_name );
+    }
+    else if ( strcmp( table_row->col_type, CT_TIMESPEC ) == 0 )
+    {
+        Timespec ts = { 0, 0 };
+        gchar* datebuf = gnc_sql_convert_timespec_to_string( be, ts );
+        gchar* expr = g_strdup_printf( "COALESCE(%s,'%s')", table_row->col_name, datebuf );
+
+        g_free( datebuf );
+        return expr;
+    }
+    else
+    {
+        return g_strdup_printf( "COALESCE(%s,0)", table_row->col_name );
+    }
+}
+
+static gboolean
+convert_table_query_term( const GncSqlBackend* be, QofIdTypeConst obj_name,
+                          const GncSqlColumnTableEntry* col_table,
+                          QofQueryTerm* term, GString* sql, gboolean* is_exact )
+{
+    GSList* paramPath = qof_query_term_get_param_path( term );
+    QofQueryPredData* pPredData = qof_query_term_get_pred_data( term );
+    const GncSqlColumnTableEntry* table_row;
+    gchar* col_expr;
+    gboolean is_ok;
+
+    if ( paramPath == NULL || pPredData == NULL ) return FALSE;
+
+    table_row = find_query_column( obj_name, paramPath, pPredData->type_name, col_table );
+    if ( table_row == NULL ) return FALSE;
+
+    col_expr = get_column_expression( be, table_row );
+    is_ok = gnc_sql_append_predicate_condition( be, col_expr, pPredData,
+            qof_query_term_is_inverted( term ), sql, is_exact );
+    g_free( col_expr );
+
+    return is_ok;
+}
+
+/* The engine sorts the matching objects and keeps the last max_results,
+ * so the rows are selected in the reverse order.  Only sort keys which
+ * compare in SQL as they do in the engine are used: strings don't, since
+ * SQL collations differ from the engine's comparison. */
+static gboolean
+append_table_query_order( const GncSqlBackend* be, QofQuery* query,
+                          QofIdTypeConst obj_name,
+                          const GncSqlColumnTableEntry* col_table, GString* sql )
+{
+    QofQuerySort* sorts[3];
+    gboolean need_comma = FALSE;
+    gint i;
+
+    qof_query_get_sorts( query, &sorts[0], &sorts[1], &sorts[2] );
+    for ( i = 0; i < 3; i++ )
+    {
+        GSList* paramPath = qof_query_sort_get_param_path( sorts[i] );
+        const QofParam* param;
+        const GncSqlColumnTableEntry* table_row;
+        gchar* col_expr;
+
+        // No sort at this level
+        if ( paramPath == NULL ) continue;
+
+        if ( paramPath->next != NULL ) return FALSE;
+        param = qof_class_get_parameter( obj_name, paramPath->data );
+        if ( param == NULL || param->param_compfcn != NULL ) return FALSE;
+        table_row = find_query_column( obj_name, paramPath, param->param_type, col_table );
+        if ( table_row == NULL
+                || strcmp( table_row->col_type, CT_STRING ) == 0
+                || strcmp( table_row->col_type, CT_GUID ) == 0 )
+        {
+            return FALSE;
+        }
+        if ( strcmp( table_row->col_type, CT_TIMESPEC ) == 0
+                && qof_query_sort_get_sort_options( sorts[i] ) == QOF_DATE_MATCH_DAY )
+        {
+            return FALSE;
+        }
+
+        col_expr = get_column_expression( be, table_row );
+        g_string_append_printf( sql, "%s%s %s", need_comma ? "," : " ORDER BY ",
+                                col_expr,
+                                qof_query_sort_get_increasing( sorts[i] ) ? "DESC" : "ASC" );
+        g_free( col_expr );
+        need_comma = TRUE;
+    }
+
+    return TRUE;
+}
+
+/*@ null @*/ GncSqlStatement*
+gnc_sql_compile_table_query( GncSqlBackend* be, QofQuery* query,
+                             const gchar* table_name,
+                             const GncSqlColumnTableEntry* col_table )
+{
+    QofIdTypeConst obj_name;
+    GString* sql;
+    GncSqlStatement* stmt;
+    gboolean is_exact = TRUE;
+    gint max_results;
+
+    g_return_val_if_fail( be != NULL, NULL );
+    g_return_val_if_fail( query != NULL, NULL );
+    g_return_val_if_fail( table_name != NULL, NULL );
+    g_return_val_if_fail( col_table != NULL, NULL );
+
+    obj_name = qof_query_get_search_for( query );
+    sql = g_string_new( "SELECT * FROM " );
+    g_string_append( sql, table_name );
+
+    /* The query is an OR of AND terms.  If any of the AND terms has no
+     * condition which can be converted, every row might match. */
+    if ( qof_query_has_terms( query ) )
+    {
+        GList* orTerm;
+        GString* where = g_string_new( "" );
+        gboolean restricted = TRUE;
+
+        for ( orTerm = qof_query_get_terms( query );
+                orTerm != NULL && restricted; orTerm = orTerm->next )
+        {
+            GList* andTerm;
+            gboolean need_AND = FALSE;
+
+            if ( where->len != 0 )
+            {
+                g_string_append( where, " OR " );
+            }
+            g_string_append( where, "(" );
+            for ( andTerm = (GList*)orTerm->data; andTerm != NULL; andTerm = andTerm->next )
+            {
+                gsize len = where->len;
+                gboolean term_exact = FALSE;
+
+                if ( need_AND )
+                {
+                    g_string_append( where, " AND " );
+                }
+                if ( convert_table_query_term( be, obj_name, col_table,
+                                               (QofQueryTerm*)andTerm->data, where, &term_exact ) )
+                {
+                    need_AND = TRUE;
+                }
+                else
+                {
+                    g_string_truncate( where, len );
+                }
+                if ( !term_exact ) is_exact = FALSE;
+            }
+            g_string_append( where, ")" );
+            restricted = need_AND;
+        }
+
+        if ( restricted )
+        {
+            g_string_append( sql, " WHERE " );
+            g_string_append( sql, where->str );
+        }
+        else
+        {
+            is_exact = FALSE;
+        }
+        g_string_free( where, TRUE );
+    }
+
+    max_results = qof_query_get_max_results( query );
+    if ( is_exact && max_results >= 0 )
+    {
+        gsize len = sql->len;
+
+        if ( append_table_query_order( be, query, obj_name, col_table, sql ) )
+        {
+            g_string_append_printf( sql, " LIMIT %d", max_results );
+        }
+        else
+        {
+            g_string_truncate( sql, len );
+        }
+    }
+
+    DEBUG( "Compiled: %s\n", sql->str );
+    stmt = gnc_sql_create_statement_from_sql( be, sql->str );
+    g_string_free( sql, TRUE );
+
+    return stmt;
+}
+
 /* ================================================================= */
 /* Order in which business objects need to be loaded */
 static const gchar* business_fixed_load_order[] =
@@ -2520,6 +3070,7 @@ gnc_sql_execute_select_statement( GncSqlBackend* be, GncSqlStatement* stmt )
     g_return_val_if_fail( be != NULL, NULL );
     g_return_val_if_fail( stmt != NULL, NULL );
 
+    (void)insert_writer_flush( be );
     result = gnc_sql_connection_execute_select_statement( be->conn, stmt );
     if ( result == NULL )
     {
@@ -2562,6 +3113,7 @@ gnc_sql_execute_select_sql( GncSqlBackend* be, const gchar* sql )
     {
         return NULL;
     }
+    (void)insert_writer_flush( be );
     result = gnc_sql_connection_execute_select_statement( be->conn, stmt );
     gnc_sql_statement_dispose( stmt );
     if ( result == NULL )
@@ -2573,15 +3125,13 @@ gnc_sql_execute_select_sql( GncSqlBackend* be, const gchar* sql )
     return result;
 }
 
-gint
-gnc_sql_execute_nonselect_sql( GncSqlBackend* be, const gchar* sql )
+/* Execute an SQL command without first sending any pending inserts */
+static gint
+execute_nonselect_sql( GncSqlBackend* be, const gchar* sql )
 {
     GncSqlStatement* stmt;
     gint result;
 
-    g_return_val_if_fail( be != NULL, 0 );
-    g_return_val_if_fail( sql != NULL, 0 );
-
     stmt = gnc_sql_create_statement_from_sql( be, sql );
     if ( stmt == NULL )
     {
@@ -2592,6 +3142,16 @@ gnc_sql_execute_nonselect_sql( GncSqlBackend* be, const gchar* sql )
     return result;
 }
 
+gint
+gnc_sql_execute_nonselect_sql( GncSqlBackend* be, const gchar* sql )
+{
+    g_return_val_if_fail( be != NULL, 0 );
+    g_return_val_if_fail( sql != NULL, 0 );
+
+    (void)insert_writer_flush( be );
+    return execute_nonselect_sql( be, sql );
+}
+
 static guint
 execute_statement_get_count( GncSqlBackend* be, GncSqlStatement* stmt )
 {
@@ -2696,6 +3256,12 @@ gnc_sql_do_db_operation( GncSqlBackend* be,
     g_return_val_if_fail( pObject != NULL, FALSE );
     g_return_val_if_fail( table != NULL, FALSE );
 
+    if ( op == OP_DB_INSERT && be->insert_writer != NULL )
+    {
+        return insert_writer_add( be, table_name, obj_name, pObject, table );
+    }
+    (void)insert_writer_flush( be );
+
     if ( op == OP_DB_INSERT )
     {
         stmt = build_insert_statement( be, table_name, obj_name, pObject, table );
@@ -2840,32 +3406,22 @@ free_gvalue_list( GSList* list )
     g_slist_free( list );
 }
 
-/*@ null @*/ static GncSqlStatement*
-build_insert_statement( GncSqlBackend* be,
-                        const gchar* table_name,
-                        QofIdTypeConst obj_name, gpointer pObject,
-                        const GncSqlColumnTableEntry* table )
+/* Returns "INSERT INTO table(col,...) VALUES" for a table */
+static gchar*
+build_insert_prefix( GncSqlBackend* be,
+                     const gchar* table_name,
+                     const GncSqlColumnTableEntry* table )
 {
-    GncSqlStatement* stmt;
     GString* sql;
-    GSList* values;
-    GSList* node;
-    gchar* sqlbuf;
     GList* colnames = NULL;
     GList* colname;
     const GncSqlColumnTableEntry* table_row;
 
-    g_return_val_if_fail( be != NULL, NULL );
-    g_return_val_if_fail( table_name != NULL, NULL );
-    g_return_val_if_fail( obj_name != NULL, NULL );
-    g_return_val_if_fail( pObject != NULL, NULL );
-    g_return_val_if_fail( table != NULL, NULL );
-
-    sqlbuf = g_strdup_printf( "INSERT INTO %s(", table_name );
-    sql = g_string_new( sqlbuf );
-    g_free( sqlbuf );
+    sql = g_string_new( "INSERT INTO " );
+    (void)g_string_append( sql, table_name );
+    (void)g_string_append( sql, "(" );
 
-    // Get all col names and all values
+    // Get all col names
     for ( table_row = table; table_row->col_name != NULL; table_row++ )
     {
         if (( table_row->flags & COL_AUTOINC ) == 0 )
@@ -2884,14 +3440,28 @@ build_insert_statement( GncSqlBackend* be,
     {
         if ( colname != colnames )
         {
-            g_string_append( sql, "," );
+            (void)g_string_append( sql, "," );
         }
-        g_string_append( sql, (gchar*)colname->data );
+        (void)g_string_append( sql, (gchar*)colname->data );
         g_free( colname->data );
     }
     g_list_free( colnames );
 
-    g_string_append( sql, ") VALUES(" );
+    (void)g_string_append( sql, ") VALUES" );
+    return g_string_free( sql, FALSE );
+}
+
+/* Returns "(value,...)" for an object, to go after build_insert_prefix() */
+static gchar*
+build_insert_values( GncSqlBackend* be,
+                     QofIdTypeConst obj_name, gpointer pObject,
+                     const GncSqlColumnTableEntry* table )
+{
+    GString* sql;
+    GSList* values;
+    GSList* node;
+
+    sql = g_string_new( "(" );
     values = create_gslist_from_values( be, obj_name, pObject, table );
     for ( node = values; node != NULL; node = node->next )
     {
@@ -2909,8 +3479,34 @@ build_insert_statement( GncSqlBackend* be,
     free_gvalue_list( values );
     (void)g_string_append( sql, ")" );
 
-    stmt = gnc_sql_connection_create_statement_from_sql( be->conn, sql->str );
-    (void)g_string_free( sql, TRUE );
+    return g_string_free( sql, FALSE );
+}
+
+/*@ null @*/ static GncSqlStatement*
+build_insert_statement( GncSqlBackend* be,
+                        const gchar* table_name,
+                        QofIdTypeConst obj_name, gpointer pObject,
+                        const GncSqlColumnTableEntry* table )
+{
+    GncSqlStatement* stmt;
+    gchar* prefix;
+    gchar* values;
+    gchar* sql;
+
+    g_return_val_if_fail( be != NULL, NULL );
+    g_return_val_if_fail( table_name != NULL, NULL );
+    g_return_val_if_fail( obj_name != NULL, NULL );
+    g_return_val_if_fail( pObject != NULL, NULL );
+    g_return_val_if_fail( table != NULL, NULL );
+
+    prefix = build_insert_prefix( be, table_name, table );
+    values = build_insert_values( be, obj_name, pObject, table );
+    sql = g_strconcat( prefix, values, NULL );
+    g_free( prefix );
+    g_free( values );
+
+    stmt = gnc_sql_connection_create_statement_from_sql( be->conn, sql );
+    g_free( sql );
 
     return stmt;
 }
@@ -3025,6 +3621,256 @@ build_delete_statement( GncSqlBackend* be,
     return stmt;
 }
 
+/* ================================================================= */
+/* Batched inserts
+
+   A full save writes every object into freshly created tables and
+   reads nothing back until it is done, so while gnc_sql_sync_all() is
+   running the inserts made through gnc_sql_do_db_operation() are
+   collected per table and sent as multi-row INSERT statements rather
+   than one statement per split, slot or transaction.  The
+   "INSERT INTO table(cols) VALUES" part is built once per table.
+
+   Pending rows are sent before any other statement is executed, so the
+   database always looks as if each row had been inserted immediately.
+   If the database rejects a multi-row INSERT, the rows are retried one
+   at a time and batching is turned off for the rest of the save.  Each
+   multi-row INSERT is sent inside a savepoint, which is rolled back
+   before the retry; PostgreSQL would otherwise refuse every further
+   statement of the enclosing transaction.  If the savepoint can't be
+   set, the rows are sent one at a time from the start.
+ */
+
+#define INSERT_BATCH_MAX_ROWS 250
+#define INSERT_BATCH_MAX_SQL_LEN (256*1024)
+
+typedef struct
+{
+    /*@ dependent @*/
+    const GncSqlColumnTableEntry* table;
+    gchar* prefix;
+    GPtrArray* rows;			/* "(value,...)" strings */
+    gsize sql_len;
+} GncSqlInsertBatch;
+
+struct GncSqlInsertWriter
+{
+    GHashTable* batches;		/* table name -> GncSqlInsertBatch */
+    gboolean single_row;		/* multi-row INSERT isn't supported */
+};
+
+static void
+insert_batch_clear( GncSqlInsertBatch* batch )
+{
+    guint i;
+
+    for ( i = 0; i < batch->rows->len; i++ )
+    {
+        g_free( g_ptr_array_index( batch->rows, i ) );
+    }
+    g_ptr_array_set_size( batch->rows, 0 );
+    batch->sql_len = strlen( batch->prefix );
+}
+
+static void
+insert_batch_free( gpointer data )
+{
+    GncSqlInsertBatch* batch = (GncSqlInsertBatch*)data;
+
+    insert_batch_clear( batch );
+    g_ptr_array_free( batch->rows, TRUE );
+    g_free( batch->prefix );
+    g_free( batch );
+}
+
+static gboolean
+insert_batch_execute( GncSqlBackend* be, GncSqlInsertBatch* batch )
+{
+    GncSqlInsertWriter* writer = be->insert_writer;
+    gboolean ok = TRUE;
+    guint i;
+
+    if ( batch->rows->len == 0 )
+    {
+        return TRUE;
+    }
+
+    if ( !writer->single_row && batch->rows->len > 1 &&
+            execute_nonselect_sql( be, "SAVEPOINT gnc_insert_batch" ) == -1 )
+    {
+        PWARN( "Could not set a savepoint, inserting rows one at a time" );
+        writer->single_row = TRUE;
+    }
+
+    if ( !writer->single_row || batch->rows->len == 1 )
+    {
+        GString* sql = g_string_sized_new( batch->sql_len + 1 );
+
+        (void)g_string_append( sql, batch->prefix );
+        for ( i = 0; i < batch->rows->len; i++ )
+        {
+            if ( i != 0 )
+            {
+                (void)g_string_append( sql, "," );
+            }
+            (void)g_string_append( sql, g_ptr_array_index( batch->rows, i ) );
+        }
+        ok = ( execute_nonselect_sql( be, sql->str ) != -1 );
+        if ( !ok && batch->rows->len == 1 )
+        {
+            PERR( "SQL error: %s\n", sql->str );
+        }
+        (void)g_string_free( sql, TRUE );
+        if ( batch->rows->len == 1 )
+        {
+            insert_batch_clear( batch );
+            return ok;
+        }
+        if ( ok )
+        {
+            insert_batch_clear( batch );
+            return ( execute_nonselect_sql( be, "RELEASE SAVEPOINT gnc_insert_batch" ) != -1 );
+        }
+        PWARN( "Multi-row INSERT failed, inserting rows one at a time" );
+        writer->single_row = TRUE;
+        if ( execute_nonselect_sql( be, "ROLLBACK TO SAVEPOINT gnc_insert_batch" ) == -1 )
+        {
+            PERR( "Could not roll back a failed multi-row INSERT" );
+            insert_batch_clear( batch );
+            return FALSE;
+        }
+        (void)execute_nonselect_sql( be, "RELEASE SAVEPOINT gnc_insert_batch" );
+        ok = TRUE;
+    }
+
+    for ( i = 0; i < batch->rows->len && ok; i++ )
+    {
+        gchar* sql = g_strconcat( batch->prefix,
+                                  g_ptr_array_index( batch->rows, i ), NULL );
+        ok = ( execute_nonselect_sql( be, sql ) != -1 );
+        if ( !ok )
+        {
+            PERR( "SQL error: %s\n", sql );
+        }
+        g_free( sql );
+    }
+    insert_batch_clear( batch );
+    return ok;
+}
+
+static void
+insert_writer_begin( GncSqlBackend* be )
+{
+    GncSqlInsertWriter* writer;
+
+    g_return_if_fail( be->insert_writer == NULL );
+
+    writer = g_new0( GncSqlInsertWriter, 1 );
+    writer->batches = g_hash_table_new_full( g_str_hash, g_str_equal,
+                      g_free, insert_batch_free );
+    be->insert_writer = writer;
+}
+
+/* Sends all pending inserts.  Returns FALSE if any of them failed. */
+static gboolean
+insert_writer_flush( GncSqlBackend* be )
+{
+    GHashTableIter iter;
+    gpointer batch;
+    gboolean ok = TRUE;
+
+    if ( be->insert_writer == NULL )
+    {
+        return TRUE;
+    }
+
+    g_hash_table_iter_init( &iter, be->insert_writer->batches );
+    while ( g_hash_table_iter_next( &iter, NULL, &batch ) )
+    {
+        if ( !insert_batch_execute( be, (GncSqlInsertBatch*)batch ) )
+        {
+            ok = FALSE;
+        }
+    }
+    if ( !ok )
+    {
+        qof_backend_set_error( &be->be, ERR_BACKEND_SERVER_ERR );
+    }
+
+    return ok;
+}
+
+/* Stops batching, sending the pending inserts if flush is TRUE and
+ * discarding them otherwise.  Returns FALSE if sending failed. */
+static gboolean
+insert_writer_end( GncSqlBackend* be, gboolean flush )
+{
+    gboolean ok = TRUE;
+
+    if ( be->insert_writer == NULL )
+    {
+        return TRUE;
+    }
+
+    if ( flush )
+    {
+        ok = insert_writer_flush( be );
+    }
+    g_hash_table_destroy( be->insert_writer->batches );
+    g_free( be->insert_writer );
+    be->insert_writer = NULL;
+
+    return ok;
+}
+
+static gboolean
+insert_writer_add( GncSqlBackend* be, const gchar* table_name,
+                   QofIdTypeConst obj_name, gpointer pObject,
+                   const GncSqlColumnTableEntry* table )
+{
+    GncSqlInsertWriter* writer = be->insert_writer;
+    GncSqlInsertBatch* batch;
+    gchar* values;
+    gboolean ok = TRUE;
+
+    batch = g_hash_table_lookup( writer->batches, table_name );
+    if ( batch != NULL && batch->table != table )
+    {
+        /* Same table written with a different column description */
+        ok = insert_batch_execute( be, batch );
+        g_hash_table_remove( writer->batches, table_name );
+        batch = NULL;
+    }
+    if ( batch == NULL )
+    {
+        batch = g_new0( GncSqlInsertBatch, 1 );
+        batch->table = table;
+        batch->prefix = build_insert_prefix( be, table_name, table );
+        batch->rows = g_ptr_array_new();
+        batch->sql_len = strlen( batch->prefix );
+        g_hash_table_insert( writer->batches, g_strdup( table_name ), batch );
+    }
+
+    values = build_insert_values( be, obj_name, pObject, table );
+    batch->sql_len += strlen( values ) + 1;
+    g_ptr_array_add( batch->rows, values );
+
+    if ( writer->single_row || batch->rows->len >= INSERT_BATCH_MAX_ROWS
+            || batch->sql_len >= INSERT_BATCH_MAX_SQL_LEN )
+    {
+        if ( !insert_batch_execute( be, batch ) )
+        {
+            ok = FALSE;
+        }
+    }
+    if ( !ok )
+    {
+        qof_backend_set_error( &be->be, ERR_BACKEND_SERVER_ERR );
+    }
+
+    return ok;
+}
+
 /* ================================================================= */
 gboolean
 gnc_sql_commit_standard_item( GncSqlBackend* be, QofInstance* inst, const gchar* tableName,
@@ -44,6 +44,7 @@
 #include <gmodule.h>
 
 typedef struct GncSqlConnection GncSqlConnection;
+typedef struct GncSqlInsertWriter GncSqlInsertWriter;
 
 /**
  * @struct GncSqlBackend
@@ -63,6 +64,8 @@ struct GncSqlBackend
     gint operations_done;			/**< Number of operations (save/load) done */
     GHashTable* versions;			/**< Version number for each table */
     const gchar* timespec_format;	/**< Format string for SQL for timespec values */
+    GncSqlInsertWriter* insert_writer;	/**< Batches INSERTs during a full save */
+    gboolean load_tx_as_needed;	/**< Transactions and invoices are loaded by queries, not at startup */
 };
 typedef struct GncSqlBackend GncSqlBackend;
 
@@ -706,6 +709,43 @@ gint64 gnc_sql_get_integer_value( const GValue* value );
  */
 gchar* gnc_sql_convert_timespec_to_string( const GncSqlBackend* be, Timespec ts );
 
+/**
+ * Appends to an SQL string a condition on a column for a query predicate.
+ * The condition holds for every row whose value matches the predicate, and
+ * for string matches it may also hold for some rows which don't.
+ *
+ * @param be SQL backend
+ * @param col_name Column name, or SQL expression for the column value
+ * @param pPredData Query predicate
+ * @param is_inverted TRUE if the query term is inverted
+ * @param sql SQL string to which the condition is appended
+ * @param is_exact If not NULL, set to TRUE if the condition holds for exactly
+ * the matching rows
+ * @return TRUE if a condition was appended, FALSE if the predicate can't be
+ * converted
+ */
+gboolean gnc_sql_append_predicate_condition( const GncSqlBackend* be, const gchar* col_name,
+        QofQueryPredData* pPredData, gboolean is_inverted,
+        GString* sql, /*@ null @*/ gboolean* is_exact );
+
+/**
+ * Compiles a query on objects stored one per row of a table into a SELECT
+ * statement for the rows of the objects which might match it.  Terms on
+ * the table's columns become the WHERE clause.  If every term is converted
+ * exactly and the query is sorted on columns, its maximum number of
+ * results becomes ORDER BY and LIMIT clauses.
+ *
+ * @param be SQL backend
+ * @param query Query
+ * @param table_name SQL table name
+ * @param col_table Column table
+ * @return Statement
+ */
+/*@ null @*/
+GncSqlStatement* gnc_sql_compile_table_query( GncSqlBackend* be, QofQuery* query,
+        const gchar* table_name,
+        const GncSqlColumnTableEntry* col_table );
+
 /**
  * Upgrades a table to a new structure.  The upgrade is done by creating a new table with
  * the new structure, SELECTing the old data into the new table, deleting the old table,
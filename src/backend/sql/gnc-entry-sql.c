@@ -170,20 +170,23 @@ load_single_entry( GncSqlBackend* be, GncSqlRow* row )
     return pEntry;
 }
 
+/**
+ * Loads the entries selected by a statement which are not in memory yet.
+ * When transactions are loaded as needed, an entry's invoice or bill is
+ * loaded with it.
+ *
+ * @param be SQL backend
+ * @param stmt SQL statement
+ */
 static void
-load_all_entries( GncSqlBackend* be )
+query_entries( GncSqlBackend* be, GncSqlStatement* stmt )
 {
-    GncSqlStatement* stmt;
     GncSqlResult* result;
-    QofBook* pBook;
 
     g_return_if_fail( be != NULL );
+    g_return_if_fail( stmt != NULL );
 
-    pBook = be->primary_book;
-
-    stmt = gnc_sql_create_select_statement( be, TABLE_NAME );
     result = gnc_sql_execute_select_statement( be, stmt );
-    gnc_sql_statement_dispose( stmt );
     if ( result != NULL )
     {
         GncSqlRow* row;
@@ -192,10 +195,11 @@ load_all_entries( GncSqlBackend* be )
         row = gnc_sql_result_get_first_row( result );
         while ( row != NULL )
         {
-            GncEntry* pEntry = load_single_entry( be, row );
-            if ( pEntry != NULL )
+            const GncGUID* guid = gnc_sql_load_guid( be, row );
+
+            if ( guid != NULL && gncEntryLookup( be->primary_book, guid ) == NULL )
             {
-                list = g_list_append( list, pEntry );
+                list = g_list_prepend( list, load_single_entry( be, row ) );
             }
             row = gnc_sql_result_get_next_row( result );
         }
@@ -209,6 +213,124 @@ load_all_entries( GncSqlBackend* be )
     }
 }
 
+void
+gnc_sql_entry_load_for_invoices( GncSqlBackend* be, GList* list )
+{
+    GString* guids;
+    gchar* sql;
+    GncSqlStatement* stmt;
+
+    g_return_if_fail( be != NULL );
+
+    if ( list == NULL ) return;
+
+    guids = g_string_sized_new( (GUID_ENCODING_LENGTH + 3) * g_list_length( list ) );
+    (void)gnc_sql_append_guid_list_to_sql( guids, list, G_MAXUINT );
+    sql = g_strdup_printf( "SELECT * FROM %s WHERE invoice IN (%s) OR bill IN (%s)",
+                           TABLE_NAME, guids->str, guids->str );
+    g_string_free( guids, TRUE );
+
+    stmt = gnc_sql_create_statement_from_sql( be, sql );
+    g_free( sql );
+    if ( stmt != NULL )
+    {
+        query_entries( be, stmt );
+        gnc_sql_statement_dispose( stmt );
+    }
+}
+
+static void
+load_all_entries( GncSqlBackend* be )
+{
+    GncSqlStatement* stmt;
+
+    g_return_if_fail( be != NULL );
+
+    /* When invoices are loaded by queries, their entries are loaded with
+     * them.  Entries on no invoice or bill, such as those of orders, are
+     * still loaded now. */
+    if ( be->load_tx_as_needed )
+    {
+        gchar* sql = g_strdup_printf( "SELECT * FROM %s WHERE invoice IS NULL AND bill IS NULL",
+                                      TABLE_NAME );
+        stmt = gnc_sql_create_statement_from_sql( be, sql );
+        g_free( sql );
+    }
+    else
+    {
+        stmt = gnc_sql_create_select_statement( be, TABLE_NAME );
+    }
+    if ( stmt != NULL )
+    {
+        query_entries( be, stmt );
+        gnc_sql_statement_dispose( stmt );
+    }
+}
+
+/* ================================================================= */
+typedef struct
+{
+    GncSqlStatement* stmt;
+    gboolean has_been_run;
+} entry_query_info_t;
+
+static /*@ null @*/ gpointer
+compile_entry_query( GncSqlBackend* be, QofQuery* query )
+{
+    entry_query_info_t* query_info;
+
+    g_return_val_if_fail( be != NULL, NULL );
+    g_return_val_if_fail( query != NULL, NULL );
+
+    query_info = g_malloc( (gsize)sizeof(entry_query_info_t) );
+    g_assert( query_info != NULL );
+    query_info->stmt = NULL;
+
+    // Nothing needs to be loaded if every entry was loaded at startup
+    query_info->has_been_run = !be->load_tx_as_needed;
+    if ( !query_info->has_been_run )
+    {
+        query_info->stmt = gnc_sql_compile_table_query( be, query, TABLE_NAME, col_table );
+    }
+
+    return query_info;
+}
+
+static void
+run_entry_query( GncSqlBackend* be, gpointer pQuery )
+{
+    entry_query_info_t* query_info = (entry_query_info_t*)pQuery;
+
+    g_return_if_fail( be != NULL );
+    g_return_if_fail( pQuery != NULL );
+
+    // Nothing to do if every entry has been loaded since
+    if ( !be->load_tx_as_needed ) return;
+
+    if ( !query_info->has_been_run && query_info->stmt != NULL )
+    {
+        query_entries( be, query_info->stmt );
+        query_info->has_been_run = TRUE;
+        gnc_sql_statement_dispose( query_info->stmt );
+        query_info->stmt = NULL;
+    }
+}
+
+static void
+free_entry_query( GncSqlBackend* be, gpointer pQuery )
+{
+    entry_query_info_t* query_info = (entry_query_info_t*)pQuery;
+
+    g_return_if_fail( be != NULL );
+    g_return_if_fail( pQuery != NULL );
+
+    if ( query_info->stmt != NULL )
+    {
+        gnc_sql_statement_dispose( query_info->stmt );
+    }
+    g_free( pQuery );
+}
+
 /* ================================================================= */
 static void
 create_entry_tables( GncSqlBackend* be )
@@ -290,7 +412,9 @@ gnc_entry_sql_initialize( void )
         save_entry,							/* commit */
         load_all_entries,					/* initial_load */
         create_entry_tables,				/* create_tables */
-        NULL, NULL, NULL,
+        compile_entry_query,				/* compile_query */
+        run_entry_query,					/* run_query */
+        free_entry_query,					/* free_query */
         write_entries						/* write */
     };
 
@@ -30,6 +30,17 @@
 #ifndef GNC_ENTRY_SQL_H
 #define GNC_ENTRY_SQL_H
 
+#include "gnc-backend-sql.h"
+
 void gnc_entry_sql_initialize( void );
 
+/**
+ * Loads the entries of a list of invoices or bills which have not been
+ * loaded yet.
+ *
+ * @param be SQL backend
+ * @param list List of invoices
+ */
+void gnc_sql_entry_load_for_invoices( GncSqlBackend* be, GList* list );
+
 #endif /* GNC_ENTRY_SQL_H */
@@ -42,6 +42,7 @@
 
 #include "gncBillTermP.h"
 #include "gncInvoiceP.h"
+#include "gnc-entry-sql.h"
 #include "gnc-invoice-sql.h"
 #include "gnc-owner-sql.h"
 #include "gnc-bill-term-sql.h"
@@ -113,6 +114,65 @@ load_single_invoice( GncSqlBackend* be, GncSqlRow* row )
     return pInvoice;
 }
 
+/**
+ * Loads the invoices selected by a statement which are not in memory yet,
+ * then their entries.  Invoices which are already loaded are left alone,
+ * since they may be being edited.
+ *
+ * @param be SQL backend
+ * @param stmt SQL statement
+ */
+static void
+query_invoices( GncSqlBackend* be, GncSqlStatement* stmt )
+{
+    GncSqlResult* result;
+    GList* list = NULL;
+
+    g_return_if_fail( be != NULL );
+    g_return_if_fail( stmt != NULL );
+
+    result = gnc_sql_execute_select_statement( be, stmt );
+    if ( result != NULL )
+    {
+        GncSqlRow* row;
+
+        row = gnc_sql_result_get_first_row( result );
+        while ( row != NULL )
+        {
+            const GncGUID* guid = gnc_sql_load_guid( be, row );
+
+            if ( guid != NULL && gncInvoiceLookup( be->primary_book, guid ) == NULL )
+            {
+                list = g_list_prepend( list, load_single_invoice( be, row ) );
+            }
+            row = gnc_sql_result_get_next_row( result );
+        }
+        gnc_sql_result_dispose( result );
+    }
+
+    if ( list != NULL )
+    {
+        gnc_sql_slots_load_for_list( be, list );
+        gnc_sql_entry_load_for_invoices( be, list );
+        g_list_free( list );
+    }
+}
+
+void
+gnc_sql_invoice_load_all( GncSqlBackend* be )
+{
+    GncSqlStatement* stmt;
+
+    g_return_if_fail( be != NULL );
+
+    stmt = gnc_sql_create_select_statement( be, TABLE_NAME );
+    if ( stmt != NULL )
+    {
+        query_invoices( be, stmt );
+        gnc_sql_statement_dispose( stmt );
+    }
+}
+
 static void
 load_all_invoices( GncSqlBackend* be )
 {
@@ -122,6 +182,9 @@ load_all_invoices( GncSqlBackend* be )
 
     g_return_if_fail( be != NULL );
 
+    // Invoices are loaded by queries, like transactions
+    if ( be->load_tx_as_needed ) return;
+
     pBook = be->primary_book;
 
     stmt = gnc_sql_create_select_statement( be, TABLE_NAME );
@@ -152,6 +215,70 @@ load_all_invoices( GncSqlBackend* be )
     }
 }
 
+/* ================================================================= */
+typedef struct
+{
+    GncSqlStatement* stmt;
+    gboolean has_been_run;
+} invoice_query_info_t;
+
+static /*@ null @*/ gpointer
+compile_invoice_query( GncSqlBackend* be, QofQuery* query )
+{
+    invoice_query_info_t* query_info;
+
+    g_return_val_if_fail( be != NULL, NULL );
+    g_return_val_if_fail( query != NULL, NULL );
+
+    query_info = g_malloc( (gsize)sizeof(invoice_query_info_t) );
+    g_assert( query_info != NULL );
+    query_info->stmt = NULL;
+
+    // Nothing needs to be loaded if every invoice was loaded at startup
+    query_info->has_been_run = !be->load_tx_as_needed;
+    if ( !query_info->has_been_run )
+    {
+        query_info->stmt = gnc_sql_compile_table_query( be, query, TABLE_NAME, col_table );
+    }
+
+    return query_info;
+}
+
+static void
+run_invoice_query( GncSqlBackend* be, gpointer pQuery )
+{
+    invoice_query_info_t* query_info = (invoice_query_info_t*)pQuery;
+
+    g_return_if_fail( be != NULL );
+    g_return_if_fail( pQuery != NULL );
+
+    // Nothing to do if every invoice has been loaded since
+    if ( !be->load_tx_as_needed ) return;
+
+    if ( !query_info->has_been_run && query_info->stmt != NULL )
+    {
+        query_invoices( be, query_info->stmt );
+        query_info->has_been_run = TRUE;
+        gnc_sql_statement_dispose( query_info->stmt );
+        query_info->stmt = NULL;
+    }
+}
+
+static void
+free_invoice_query( GncSqlBackend* be, gpointer pQuery )
+{
+    invoice_query_info_t* query_info = (invoice_query_info_t*)pQuery;
+
+    g_return_if_fail( be != NULL );
+    g_return_if_fail( pQuery != NULL );
+
+    if ( query_info->stmt != NULL )
+    {
+        gnc_sql_statement_dispose( query_info->stmt );
+    }
+    g_free( pQuery );
+}
+
 /* ================================================================= */
 static void
 create_invoice_tables( GncSqlBackend* be )
@@ -302,6 +429,25 @@ load_invoice_guid( const GncSqlBackend* be, GncSqlRow* row,
     {
         string_to_guid( g_value_get_string( val ), &guid );
         invoice = gncInvoiceLookup( be->primary_book, &guid );
+
+        // If the invoice is not found, try loading it
+        if ( invoice == NULL && be->load_tx_as_needed )
+        {
+            gchar* buf;
+            GncSqlStatement* stmt;
+
+            buf = g_strdup_printf( "SELECT * FROM %s WHERE guid='%s'",
+                                   TABLE_NAME, g_value_get_string( val ) );
+            stmt = gnc_sql_create_statement_from_sql( (GncSqlBackend*)be, buf );
+            g_free( buf );
+            if ( stmt != NULL )
+            {
+                query_invoices( (GncSqlBackend*)be, stmt );
+                gnc_sql_statement_dispose( stmt );
+            }
+            invoice = gncInvoiceLookup( be->primary_book, &guid );
+        }
+
         if ( invoice != NULL )
         {
             if ( table_row->gobj_param_name != NULL )
@@ -337,7 +483,9 @@ gnc_invoice_sql_initialize( void )
         save_invoice,						/* commit */
         load_all_invoices,					/* initial_load */
         create_invoice_tables,				/* create_tables */
-        NULL, NULL, NULL,
+        compile_invoice_query,				/* compile_query */
+        run_invoice_query,					/* run_query */
+        free_invoice_query,					/* free_query */
         write_invoices						/* write */
     };
 
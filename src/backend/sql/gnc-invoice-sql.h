@@ -30,8 +30,17 @@
 #ifndef GNC_INVOICE_SQL_H
 #define GNC_INVOICE_SQL_H
 
+#include "gnc-backend-sql.h"
+
 #define CT_INVOICEREF "invoice"
 
 void gnc_invoice_sql_initialize( void );
 
+/**
+ * Loads all invoices which have not been loaded yet, with their entries.
+ *
+ * @param be SQL backend
+ */
+void gnc_sql_invoice_load_all( GncSqlBackend* be );
+
 #endif /* GNC_INVOICE_SQL_H */
@@ -53,9 +53,6 @@
 #include "splint-defs.h"
 #endif
 
-#define SIMPLE_QUERY_COMPILATION 1
-#define LOAD_TRANSACTIONS_AS_NEEDED 0
-
 static QofLogModule log_module = G_LOG_DOMAIN;
 
 #define TRANSACTION_TABLE "transactions"
@@ -391,16 +388,17 @@ query_transactions( GncSqlBackend* be, GncSqlStatement* stmt )
         GSList* nextbal;
         Account* root = gnc_book_get_root_account( be->primary_book );
 
-#if LOAD_TRANSACTIONS_AS_NEEDED
-        qof_event_suspend();
-        xaccAccountBeginEdit( root );
-
-        // Save the start/ending balances (balance, cleared and reconciled) for
-        // every account.
-        gnc_account_foreach_descendant( gnc_book_get_root_account( be->primary_book ),
-                                        save_account_balances,
-                                        &bal_list );
-#endif
+        if ( be->load_tx_as_needed )
+        {
+            qof_event_suspend();
+            xaccAccountBeginEdit( root );
+
+            // Save the start/ending balances (balance, cleared and reconciled) for
+            // every account.
+            gnc_account_foreach_descendant( gnc_book_get_root_account( be->primary_book ),
+                                            save_account_balances,
+                                            &bal_list );
+        }
 
         // Load the transactions
         row = gnc_sql_result_get_first_row( result );
@@ -430,7 +428,6 @@ query_transactions( GncSqlBackend* be, GncSqlStatement* stmt )
         }
         g_list_free( tx_list );
 
-#if LOAD_TRANSACTIONS_AS_NEEDED
         // Update the account balances based on the loaded splits.  If the end
         // balance has changed, update the start balance so that the end
         // balance is the same as it was before the splits were loaded.
@@ -484,9 +481,11 @@ query_transactions( GncSqlBackend* be, GncSqlStatement* stmt )
             g_slist_free( bal_list );
         }
 
-        xaccAccountCommitEdit( root );
-        qof_event_resume();
-#endif
+        if ( be->load_tx_as_needed )
+        {
+            xaccAccountCommitEdit( root );
+            qof_event_resume();
+        }
     }
 }
 
@@ -903,41 +902,76 @@ void gnc_sql_transaction_load_all_tx( GncSqlBackend* be )
     }
 }
 
+/**
+ * Initial load of transactions.  Unless transactions are to be loaded as
+ * needed by queries, all of them are loaded.
+ *
+ * @param be SQL backend
+ */
 static void
-convert_query_comparison_to_sql( QofQueryPredData* pPredData, gboolean isInverted, GString* sql )
+initial_load_transactions( GncSqlBackend* be )
 {
-    if ( pPredData->how == QOF_COMPARE_LT
-            || ( isInverted && pPredData->how == QOF_COMPARE_GTE ) )
+    g_return_if_fail( be != NULL );
+
+    if ( !be->load_tx_as_needed )
     {
-        g_string_append( sql, "<" );
+        gnc_sql_transaction_load_all_tx( be );
     }
-    else if ( pPredData->how == QOF_COMPARE_LTE
-              || ( isInverted && pPredData->how == QOF_COMPARE_GT ) )
+}
+
+static void
+convert_query_comparison_to_sql( QofQueryPredData* pPredData, gboolean isInverted, GString* sql )
+{
+    QofQueryCompare how = pPredData->how;
+
+    if ( isInverted )
     {
-        g_string_append( sql, "<=" );
+        switch ( how )
+        {
+        case QOF_COMPARE_LT:
+            how = QOF_COMPARE_GTE;
+            break;
+        case QOF_COMPARE_LTE:
+            how = QOF_COMPARE_GT;
+            break;
+        case QOF_COMPARE_EQUAL:
+            how = QOF_COMPARE_NEQ;
+            break;
+        case QOF_COMPARE_GT:
+            how = QOF_COMPARE_LTE;
+            break;
+        case QOF_COMPARE_GTE:
+            how = QOF_COMPARE_LT;
+            break;
+        case QOF_COMPARE_NEQ:
+            how = QOF_COMPARE_EQUAL;
+            break;
+        default:
+            break;
+        }
     }
-    else if ( pPredData->how == QOF_COMPARE_EQUAL
-              || ( isInverted && pPredData->how == QOF_COMPARE_NEQ ) )
+
+    switch ( how )
     {
+    case QOF_COMPARE_LT:
+        g_string_append( sql, "<" );
+        break;
+    case QOF_COMPARE_LTE:
+        g_string_append( sql, "<=" );
+        break;
+    case QOF_COMPARE_EQUAL:
         g_string_append( sql, "=" );
-    }
-    else if ( pPredData->how == QOF_COMPARE_GT
-              || ( isInverted && pPredData->how == QOF_COMPARE_LTE ) )
-    {
+        break;
+    case QOF_COMPARE_GT:
         g_string_append( sql, ">" );
-    }
-    else if ( pPredData->how == QOF_COMPARE_GTE
-              || ( isInverted && pPredData->how == QOF_COMPARE_LT ) )
-    {
+        break;
+    case QOF_COMPARE_GTE:
         g_string_append( sql, ">=" );
-    }
-    else if ( pPredData->how == QOF_COMPARE_NEQ
-              || ( isInverted && pPredData->how == QOF_COMPARE_EQUAL ) )
-    {
-        g_string_append( sql, "~=" );
-    }
-    else
-    {
+        break;
+    case QOF_COMPARE_NEQ:
+        g_string_append( sql, "<>" );
+        break;
+    default:
         PERR( "Unknown comparison type\n" );
         g_string_append( sql, "??" );
     }
@@ -1130,162 +1164,145 @@ typedef struct
     gboolean has_been_run;
 } split_query_info_t;
 
+/**
+ * Appends to sql a condition on the splits (s) and transactions (t) tables
+ * which holds for every split matching a query term.  Loading the
+ * transactions for a query may fetch too many, since the engine runs the
+ * query again over what is loaded, but never too few, so terms which
+ * can't be converted that way are left for the engine to check.
+ *
+ * @param be SQL backend
+ * @param term Query term
+ * @param sql String to which the condition is appended
+ * @return TRUE if the term was converted, FALSE if nothing was appended
+ */
+static gboolean
+convert_split_query_term_to_sql( const GncSqlBackend* be, QofQueryTerm* term, GString* sql )
+{
+    GSList* paramPath = qof_query_term_get_param_path( term );
+    QofQueryPredData* pPredData = qof_query_term_get_pred_data( term );
+    const gchar* param = paramPath->data;
+    const gchar* subparam = paramPath->next != NULL ? paramPath->next->data : NULL;
+
+    if ( strcmp( param, SPLIT_ACCOUNT ) == 0
+            && safe_strcmp( subparam, QOF_PARAM_GUID ) == 0
+            && safe_strcmp( pPredData->type_name, QOF_TYPE_GUID ) == 0 )
+    {
+        query_guid_t guid_data = (query_guid_t)pPredData;
+
+        if ( guid_data->guids == NULL
+                || ( guid_data->options != QOF_GUID_MATCH_ANY
+                     && guid_data->options != QOF_GUID_MATCH_NONE ) )
+        {
+            return FALSE;
+        }
+        convert_query_term_to_sql( be, "s.account_guid", term, sql );
+        return TRUE;
+    }
+    else if ( strcmp( param, SPLIT_RECONCILE ) == 0
+              && safe_strcmp( pPredData->type_name, QOF_TYPE_CHAR ) == 0 )
+    {
+        query_char_t char_data = (query_char_t)pPredData;
+
+        if ( char_data->char_list == NULL || char_data->char_list[0] == '\0' )
+        {
+            return FALSE;
+        }
+        convert_query_term_to_sql( be, "s.reconcile_state", term, sql );
+        return TRUE;
+    }
+    else if ( strcmp( param, SPLIT_TRANS ) == 0
+              && safe_strcmp( subparam, TRANS_DATE_POSTED ) == 0
+              && safe_strcmp( pPredData->type_name, QOF_TYPE_DATE ) == 0 )
+    {
+        return gnc_sql_append_predicate_condition( be, "t.post_date", pPredData,
+                qof_query_term_is_inverted( term ), sql, NULL );
+    }
+    else if ( strcmp( param, SPLIT_TRANS ) == 0
+              && safe_strcmp( subparam, TRANS_DESCRIPTION ) == 0
+              && safe_strcmp( pPredData->type_name, QOF_TYPE_STRING ) == 0 )
+    {
+        // The engine matches a substring of the description
+        return gnc_sql_append_predicate_condition( be, "t.description", pPredData,
+                qof_query_term_is_inverted( term ), sql, NULL );
+    }
+
+    return FALSE;
+}
+
 static /*@ null @*/ gpointer
 compile_split_query( GncSqlBackend* be, QofQuery* query )
 {
-    const GncGUID* acct_guid;
-    gchar guid_buf[GUID_ENCODING_LENGTH+1];
     split_query_info_t* query_info = NULL;
-    gchar* query_sql;
+    gchar* query_sql = NULL;
 
     g_return_val_if_fail( be != NULL, NULL );
     g_return_val_if_fail( query != NULL, NULL );
 
     query_info = g_malloc( (gsize)sizeof(split_query_info_t) );
     g_assert( query_info != NULL );
-    query_info->has_been_run = FALSE;
+    query_info->stmt = NULL;
+
+    // Nothing needs to be loaded if every transaction was loaded at startup
+    query_info->has_been_run = !be->load_tx_as_needed;
+    if ( query_info->has_been_run ) return query_info;
 
+    /* The query is an OR of AND terms.  If any of the AND terms has no
+     * condition which can be converted, every transaction might match. */
     if ( qof_query_has_terms( query ) )
     {
-        GList* orterms = qof_query_get_terms( query );
         GList* orTerm;
         GString* sql = g_string_new( "" );
-        gboolean need_OR = FALSE;
+        gboolean restricted = TRUE;
 
-        for ( orTerm = orterms; orTerm != NULL; orTerm = orTerm->next )
+        for ( orTerm = qof_query_get_terms( query );
+                orTerm != NULL && restricted; orTerm = orTerm->next )
         {
-            GList* andterms = (GList*)orTerm->data;
             GList* andTerm;
+            gsize start = sql->len;
             gboolean need_AND = FALSE;
-            gboolean has_tx_guid_check = FALSE;
 
-            if ( need_OR )
+            if ( start != 0 )
             {
                 g_string_append( sql, " OR " );
             }
             g_string_append( sql, "(" );
-            for ( andTerm = andterms; andTerm != NULL; andTerm = andTerm->next )
+            for ( andTerm = (GList*)orTerm->data; andTerm != NULL; andTerm = andTerm->next )
             {
-                QofQueryTerm* term;
-                GSList* paramPath;
-                gboolean unknownPath = FALSE;
-
-                term = (QofQueryTerm*)andTerm->data;
-                paramPath = qof_query_term_get_param_path( term );
-
-                if ( strcmp( paramPath->data, QOF_PARAM_BOOK ) == 0 ) continue;
-
-#if SIMPLE_QUERY_COMPILATION
-                if ( strcmp( paramPath->data, SPLIT_ACCOUNT ) != 0
-                        || strcmp( paramPath->next->data, QOF_PARAM_GUID ) != 0 ) continue;
-#endif
+                gsize len = sql->len;
 
-                if ( need_AND ) g_string_append( sql, " AND " );
-
-                if ( strcmp( paramPath->data, SPLIT_ACCOUNT ) == 0
-                        && strcmp( paramPath->next->data, QOF_PARAM_GUID ) == 0 )
-                {
-                    convert_query_term_to_sql( be, "s.account_guid", term, sql );
-#if SIMPLE_QUERY_COMPILATION
-                    goto done_compiling_query;
-#endif
-
-                }
-                else if ( strcmp( paramPath->data, SPLIT_RECONCILE ) == 0 )
+                if ( need_AND )
                 {
-                    convert_query_term_to_sql( be, "s.reconcile_state", term, sql );
-
+                    g_string_append( sql, " AND " );
                 }
-                else if ( strcmp( paramPath->data, SPLIT_TRANS ) == 0 )
+                if ( convert_split_query_term_to_sql( be, (QofQueryTerm*)andTerm->data, sql ) )
                 {
-#if 0
-                    if ( !has_tx_guid_check )
-                    {
-                        g_string_append( sql, "(splits.tx_guid = transactions.guid) AND " );
-                        has_tx_guid_check = TRUE;
-                    }
-#endif
-                    if ( strcmp( paramPath->next->data, TRANS_DATE_POSTED ) == 0 )
-                    {
-                        convert_query_term_to_sql( be, "t.post_date", term, sql );
-                    }
-                    else if ( strcmp( paramPath->next->data, TRANS_DESCRIPTION ) == 0 )
-                    {
-                        convert_query_term_to_sql( be, "t.description", term, sql );
-                    }
-                    else
-                    {
-                        unknownPath = TRUE;
-                    }
-
-                }
-                else if ( strcmp( paramPath->data, SPLIT_VALUE ) == 0 )
-                {
-                    convert_query_term_to_sql( be, "s.value_num/s.value_denom", term, sql );
-
+                    need_AND = TRUE;
                 }
                 else
                 {
-                    unknownPath = TRUE;
+                    g_string_truncate( sql, len );
                 }
-
-                if ( unknownPath )
-                {
-                    GString* name = g_string_new( (gchar*)paramPath->data );
-                    while ( paramPath->next != NULL )
-                    {
-                        g_string_append( name, "." );
-                        g_string_append( name, paramPath->next->data );
-                        paramPath = paramPath->next;
-                    }
-                    PERR( "Unknown SPLIT query field: %s\n", name->str );
-                    g_string_free( name, TRUE );
-                }
-                need_AND = TRUE;
-            }
-
-            /* If the last char in the string is a '(', then for some reason, there were
-               no terms added to the SQL.  If so, remove it and ignore the OR term. */
-            if ( sql->str[sql->len-1] == '(' )
-            {
-                g_string_truncate( sql, sql->len - 1 );
-                need_OR = FALSE;
-            }
-            else
-            {
-                g_string_append( sql, ")" );
-                need_OR = TRUE;
             }
+            g_string_append( sql, ")" );
+            restricted = need_AND;
         }
 
-#if SIMPLE_QUERY_COMPILATION
-done_compiling_query:
-#endif
-        if ( sql->len != 0 )
+        if ( restricted )
         {
-#if SIMPLE_QUERY_COMPILATION
-            g_string_append( sql, ")" );
-#endif
             query_sql = g_strdup_printf(
-                            "SELECT DISTINCT t.* FROM %s AS t, %s AS s WHERE s.tx_guid=t.guid AND %s",
+                            "SELECT DISTINCT t.* FROM %s AS t, %s AS s WHERE s.tx_guid=t.guid AND (%s)",
                             TRANSACTION_TABLE, SPLIT_TABLE, sql->str );
         }
-        else
-        {
-            query_sql = g_strdup_printf( "SELECT * FROM %s", TRANSACTION_TABLE );
-        }
-        query_info->stmt = gnc_sql_create_statement_from_sql( be, query_sql );
-
         g_string_free( sql, TRUE );
-        g_free( query_sql );
-
     }
-    else
+
+    if ( query_sql == NULL )
     {
         query_sql = g_strdup_printf( "SELECT * FROM %s", TRANSACTION_TABLE );
-        query_info->stmt = gnc_sql_create_statement_from_sql( be, query_sql );
-        g_free( query_sql );
     }
+    query_info->stmt = gnc_sql_create_statement_from_sql( be, query_sql );
+    g_free( query_sql );
 
     return query_info;
 }
@@ -1298,6 +1315,9 @@ run_split_query( GncSqlBackend* be, gpointer pQuery )
     g_return_if_fail( be != NULL );
     g_return_if_fail( pQuery != NULL );
 
+    // Nothing to do if every transaction has been loaded since
+    if ( !be->load_tx_as_needed ) return;
+
     if ( !query_info->has_been_run )
     {
         query_transactions( be, query_info->stmt );
@@ -1310,9 +1330,15 @@ run_split_query( GncSqlBackend* be, gpointer pQuery )
 static void
 free_split_query( GncSqlBackend* be, gpointer pQuery )
 {
+    split_query_info_t* query_info = (split_query_info_t*)pQuery;
+
     g_return_if_fail( be != NULL );
     g_return_if_fail( pQuery != NULL );
 
+    if ( query_info->stmt != NULL )
+    {
+        gnc_sql_statement_dispose( query_info->stmt );
+    }
     g_free( pQuery );
 }
 
@@ -1390,7 +1416,6 @@ load_single_acct_balances( const GncSqlBackend* be, GncSqlRow* row )
 /*@ null @*/ GSList*
 gnc_sql_get_account_balances_slist( GncSqlBackend* be )
 {
-#if LOAD_TRANSACTIONS_AS_NEEDED
     GncSqlResult* result;
     GncSqlStatement* stmt;
     gchar* buf;
@@ -1398,6 +1423,9 @@ gnc_sql_get_account_balances_slist( GncSqlBackend* be )
 
     g_return_val_if_fail( be != NULL, NULL );
 
+    // With all transactions loaded, balances are computed from the splits
+    if ( !be->load_tx_as_needed ) return NULL;
+
     buf = g_strdup_printf( "SELECT account_guid, reconcile_state, sum(quantity_num) as quantity_num, quantity_denom FROM %s GROUP BY account_guid, reconcile_state, quantity_denom ORDER BY account_guid, reconcile_state",
                            SPLIT_TABLE );
     stmt = gnc_sql_create_statement_from_sql( be, buf );
@@ -1471,9 +1499,6 @@ gnc_sql_get_account_balances_slist( GncSqlBackend* be )
     }
 
     return bal_slist;
-#else
-    return NULL;
-#endif
 }
 
 /* ----------------------------------------------------------------- */
@@ -1544,11 +1569,7 @@ gnc_sql_init_transaction_handler( void )
         GNC_SQL_BACKEND_VERSION,
         GNC_ID_TRANS,
         commit_transaction,          /* commit */
-#if LOAD_TRANSACTIONS_AS_NEEDED
-        NULL,                        /* initial load */
-#else
-        gnc_sql_transaction_load_all_tx,
-#endif
+        initial_load_transactions,   /* initial load */
         create_transaction_tables,   /* create tables */
         NULL,                        /* compile_query */
         NULL,                        /* run_query */
@@ -1562,15 +1583,9 @@ gnc_sql_init_transaction_handler( void )
         commit_split,                /* commit */
         NULL,                        /* initial_load */
         NULL,                        /* create tables */
-#if LOAD_TRANSACTIONS_AS_NEEDED
         compile_split_query,
         run_split_query,
         free_split_query,
-#else
-        NULL,                        /* compile_query */
-        NULL,                        /* run_query */
-        NULL,                        /* free_query */
-#endif
         NULL                         /* write */
     };
 
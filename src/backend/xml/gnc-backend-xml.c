@@ -74,6 +74,7 @@ typedef int ssize_t;
 
 #include "io-gncxml.h"
 #include "io-gncxml-v2.h"
+#include "io-gncxml-snapshot.h"
 #include "gnc-backend-xml.h"
 #include "gnc-gconf-utils.h"
 
@@ -758,6 +759,11 @@ gnc_xml_be_write_to_file(FileBackend *fbe,
         /* Since we successfully saved the book,
          * we should mark it clean. */
         qof_book_mark_saved (book);
+
+        /* Refresh the binary snapshot so the next open can skip
+         * parsing.  Failing to write it doesn't fail the save. */
+        gnc_xml_snapshot_write (book, datafile);
+
         LEAVE (" successful save of book=%p to file=%s", book, datafile);
         return TRUE;
     }
@@ -1063,6 +1069,10 @@ gnc_xml_be_load_from_file (QofBackend *bend, QofBook *book, QofBackendLoadType l
     switch (gnc_xml_be_determine_file_type(be->fullpath))
     {
     case GNC_BOOK_XML2_FILE:
+        /* Use the snapshot written by the last save if it still
+         * matches the file; otherwise parse the XML. */
+        if (gnc_xml_snapshot_load (book, be->fullpath))
+            break;
         rc = qof_session_load_from_xml_file_v2 (be, book);
         if (FALSE == rc)
         {
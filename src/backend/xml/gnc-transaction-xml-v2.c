@@ -25,6 +25,7 @@
 #include "config.h"
 
 #include <glib.h>
+#include <stdio.h>
 #include <string.h>
 
 #include "gnc-xml-helper.h"
@@ -47,6 +48,8 @@
 #include "gnc-lot.h"
 #include "gnc-lot-p.h"
 
+static QofLogModule log_module = GNC_MOD_IO;
+
 const gchar *transaction_version_string = "2.0.0";
 
 static void
@@ -193,6 +196,145 @@ gnc_transaction_dom_tree_create(Transaction *trn)
     return ret;
 }
 
+static void
+add_timespec_to_stream(FILE *out, int level, const gchar *tag, Timespec tms,
+                       gboolean always)
+{
+    if (always || !((tms.tv_sec == 0) && (tms.tv_nsec == 0)))
+    {
+        timespec_to_xml_stream(out, level, tag, &tms);
+    }
+}
+
+/* Mirrors split_to_dom_tree(), element for element. */
+static void
+split_to_xml_stream(FILE *out, int level, const gchar *tag, Split *spl)
+{
+    xml_stream_indent(out, level);
+    fprintf(out, "<%s>\n", tag);
+
+    guid_to_xml_stream(out, level + 1, "split:id", xaccSplitGetGUID(spl));
+
+    {
+        const char *memo = xaccSplitGetMemo(spl);
+
+        if (memo && safe_strcmp(memo, "") != 0)
+        {
+            text_child_to_xml_stream(out, level + 1, "split:memo", memo);
+        }
+    }
+
+    {
+        const char *action = xaccSplitGetAction(spl);
+
+        if (action && safe_strcmp(action, "") != 0)
+        {
+            text_child_to_xml_stream(out, level + 1, "split:action", action);
+        }
+    }
+
+    {
+        char tmp[2];
+
+        tmp[0] = xaccSplitGetReconcile(spl);
+        tmp[1] = '\0';
+
+        text_child_to_xml_stream(out, level + 1, "split:reconciled-state",
+                                 tmp);
+    }
+
+    add_timespec_to_stream(out, level + 1, "split:reconcile-date",
+                           xaccSplitRetDateReconciledTS(spl), FALSE);
+
+    {
+        gnc_numeric num = xaccSplitGetValue(spl);
+        gnc_numeric_to_xml_stream(out, level + 1, "split:value", &num);
+    }
+
+    {
+        gnc_numeric num = xaccSplitGetAmount(spl);
+        gnc_numeric_to_xml_stream(out, level + 1, "split:quantity", &num);
+    }
+
+    guid_to_xml_stream(out, level + 1, "split:account",
+                       xaccAccountGetGUID(xaccSplitGetAccount(spl)));
+
+    {
+        GNCLot * lot = xaccSplitGetLot (spl);
+
+        if (lot)
+        {
+            guid_to_xml_stream(out, level + 1, "split:lot",
+                               gnc_lot_get_guid(lot));
+        }
+    }
+
+    kvp_frame_to_xml_stream(out, level + 1, "split:slots",
+                            xaccSplitGetSlots(spl));
+
+    xml_stream_indent(out, level);
+    fprintf(out, "</%s>\n", tag);
+}
+
+/* Writes the same bytes as xmlElemDump() of the tree built by
+ * gnc_transaction_dom_tree_create() followed by a newline, without
+ * building the tree.  Used when saving, where transactions dominate the
+ * file. */
+gboolean
+gnc_transaction_write_xml_stream(FILE *out, Transaction *trn)
+{
+    GList *n;
+
+    fprintf(out, "<gnc:transaction version=\"%s\">\n",
+            transaction_version_string);
+
+    guid_to_xml_stream(out, 1, "trn:id", xaccTransGetGUID(trn));
+
+    commodity_ref_to_xml_stream(out, 1, "trn:currency",
+                                xaccTransGetCurrency(trn));
+
+    if (xaccTransGetNum(trn) && (safe_strcmp(xaccTransGetNum(trn), "") != 0))
+    {
+        text_child_to_xml_stream(out, 1, "trn:num", xaccTransGetNum(trn));
+    }
+
+    add_timespec_to_stream(out, 1, "trn:date-posted",
+                           xaccTransRetDatePostedTS(trn), TRUE);
+
+    add_timespec_to_stream(out, 1, "trn:date-entered",
+                           xaccTransRetDateEnteredTS(trn), TRUE);
+
+    if (xaccTransGetDescription(trn))
+    {
+        text_child_to_xml_stream(out, 1, "trn:description",
+                                 xaccTransGetDescription(trn));
+    }
+
+    kvp_frame_to_xml_stream(out, 1, "trn:slots", xaccTransGetSlots(trn));
+
+    n = xaccTransGetSplitList(trn);
+    if (n)
+    {
+        xml_stream_indent(out, 1);
+        fputs("<trn:splits>\n", out);
+        for (; n; n = n->next)
+        {
+            split_to_xml_stream(out, 2, "trn:split", n->data);
+        }
+        xml_stream_indent(out, 1);
+        fputs("</trn:splits>\n", out);
+    }
+    else
+    {
+        xml_stream_indent(out, 1);
+        fputs("<trn:splits/>\n", out);
+    }
+
+    fputs("</gnc:transaction>\n", out);
+
+    return !ferror(out);
+}
+
 /***********************************************************************/
 
 struct split_pdata
@@ -572,43 +714,6 @@ struct dom_tree_handler trn_dom_handlers[] =
     { NULL, NULL, 0, 0 },
 };
 
-static gboolean
-gnc_transaction_end_handler(gpointer data_for_children,
-                            GSList* data_from_children, GSList* sibling_data,
-                            gpointer parent_data, gpointer global_data,
-                            gpointer *result, const gchar *tag)
-{
-    Transaction *trn = NULL;
-    gboolean successful = FALSE;
-    xmlNodePtr tree = (xmlNodePtr)data_for_children;
-    gxpf_data *gdata = (gxpf_data*)global_data;
-
-    if (parent_data)
-    {
-        return TRUE;
-    }
-
-    /* OK.  For some messed up reason this is getting called again with a
-       NULL tag.  So we ignore those cases */
-    if (!tag)
-    {
-        return TRUE;
-    }
-
-    g_return_val_if_fail(tree, FALSE);
-
-    trn = dom_tree_to_transaction(tree, gdata->bookdata);
-    if (trn != NULL)
-    {
-        gdata->cb(tag, gdata->parsedata, trn);
-        successful = TRUE;
-    }
-
-    xmlFreeNode(tree);
-
-    return trn != NULL;
-}
-
 Transaction *
 dom_tree_to_transaction( xmlNodePtr node, QofBook *book )
 {
@@ -642,8 +747,958 @@ dom_tree_to_transaction( xmlNodePtr node, QofBook *book )
     return trn;
 }
 
+/***********************************************************************/
+/* Streaming parser.
+ *
+ * Instead of building a DOM subtree for every <gnc:transaction> and then
+ * walking it with dom_tree_to_transaction(), these sixtp handlers fill in
+ * the Transaction, its Splits and their slots straight from the SAX
+ * callbacks.  Element names are mapped to small integers once, character
+ * data goes into one buffer per transaction, and the only per-element
+ * allocations are the values themselves.
+ *
+ * The outcome matches dom_tree_to_transaction(): an unknown child of the
+ * transaction or of a split, or a missing required element, discards
+ * the transaction or split, and the same values are ignored.
+ */
+
+typedef enum
+{
+    TRN_TAG_UNKNOWN = 0,
+    TRN_TAG_TRANSACTION,
+    TRN_TAG_ID,
+    TRN_TAG_CURRENCY,
+    TRN_TAG_NUM,
+    TRN_TAG_DATE_POSTED,
+    TRN_TAG_DATE_ENTERED,
+    TRN_TAG_DESCRIPTION,
+    TRN_TAG_SLOTS,
+    TRN_TAG_SPLITS,
+    TRN_TAG_SPLIT,
+    SPL_TAG_ID,
+    SPL_TAG_MEMO,
+    SPL_TAG_ACTION,
+    SPL_TAG_RECONCILED_STATE,
+    SPL_TAG_RECONCILE_DATE,
+    SPL_TAG_VALUE,
+    SPL_TAG_QUANTITY,
+    SPL_TAG_ACCOUNT,
+    SPL_TAG_LOT,
+    SPL_TAG_SLOTS,
+    CMDTY_TAG_SPACE,
+    CMDTY_TAG_ID,
+    TS_TAG_DATE,
+    TS_TAG_NS,
+    GDATE_TAG,
+    SLOT_TAG,
+    SLOT_TAG_KEY,
+    /* Not a tag name: any element holding a kvp value, which inside a
+     * list need not be called slot:value. */
+    SLOT_TAG_VALUE,
+} trn_sax_tag;
+
+static const struct
+{
+    const gchar *name;
+    trn_sax_tag tag;
+} trn_sax_tag_names[] =
+{
+    { "gnc:transaction", TRN_TAG_TRANSACTION },
+    { "trn:id", TRN_TAG_ID },
+    { "trn:currency", TRN_TAG_CURRENCY },
+    { "trn:num", TRN_TAG_NUM },
+    { "trn:date-posted", TRN_TAG_DATE_POSTED },
+    { "trn:date-entered", TRN_TAG_DATE_ENTERED },
+    { "trn:description", TRN_TAG_DESCRIPTION },
+    { "trn:slots", TRN_TAG_SLOTS },
+    { "trn:splits", TRN_TAG_SPLITS },
+    { "trn:split", TRN_TAG_SPLIT },
+    { "split:id", SPL_TAG_ID },
+    { "split:memo", SPL_TAG_MEMO },
+    { "split:action", SPL_TAG_ACTION },
+    { "split:reconciled-state", SPL_TAG_RECONCILED_STATE },
+    { "split:reconcile-date", SPL_TAG_RECONCILE_DATE },
+    { "split:value", SPL_TAG_VALUE },
+    { "split:quantity", SPL_TAG_QUANTITY },
+    { "split:account", SPL_TAG_ACCOUNT },
+    { "split:lot", SPL_TAG_LOT },
+    { "split:slots", SPL_TAG_SLOTS },
+    { "cmdty:space", CMDTY_TAG_SPACE },
+    { "cmdty:id", CMDTY_TAG_ID },
+    { "ts:date", TS_TAG_DATE },
+    { "ts:ns", TS_TAG_NS },
+    { "gdate", GDATE_TAG },
+    { "slot", SLOT_TAG },
+    { "slot:key", SLOT_TAG_KEY },
+    { "slot:value", SLOT_TAG_VALUE },
+    { NULL, TRN_TAG_UNKNOWN },
+};
+
+static GHashTable *trn_sax_tags = NULL;
+
+#define TRN_SAX_BIT(tag) (1 << ((tag) - TRN_TAG_ID))
+#define TRN_SAX_REQUIRED \
+    (TRN_SAX_BIT(TRN_TAG_ID) | TRN_SAX_BIT(TRN_TAG_DATE_POSTED) | \
+     TRN_SAX_BIT(TRN_TAG_DATE_ENTERED) | TRN_SAX_BIT(TRN_TAG_SPLITS))
+#define SPL_SAX_REQUIRED \
+    (TRN_SAX_BIT(SPL_TAG_ID) | TRN_SAX_BIT(SPL_TAG_RECONCILED_STATE) | \
+     TRN_SAX_BIT(SPL_TAG_VALUE) | TRN_SAX_BIT(SPL_TAG_QUANTITY) | \
+     TRN_SAX_BIT(SPL_TAG_ACCOUNT))
+
+/* One open <trn:slots>/<split:slots>, <slot> or kvp value element. */
+typedef struct
+{
+    trn_sax_tag tag;
+    const gchar *type;  /* value type attribute, NULL if unknown */
+    kvp_frame *frame;   /* slots element or frame value */
+    GList *list;        /* list value, in reverse */
+    gchar *key;         /* slot */
+    kvp_value *value;   /* slot */
+} trn_sax_kvp;
+
+typedef struct
+{
+    QofBook *book;
+    Transaction *trn;
+    Split *split;
+
+    GArray *tags;       /* open elements, innermost last */
+    guint ignore_depth; /* > 0 while inside an element being skipped */
+    GString *text;
+    gboolean guid_ok;   /* the current element has type="guid" */
+
+    gboolean trn_ok;
+    guint32 trn_seen;
+    gboolean split_ok;
+    guint32 split_seen;
+    gboolean splits_stopped;
+
+    gchar *cmdty_space;
+    gchar *cmdty_id;
+
+    Timespec ts;
+    gboolean ts_seen_s;
+    gboolean ts_seen_ns;
+    gboolean ts_failed;
+
+    GDate gdate;
+    gboolean gdate_seen;
+    gboolean gdate_failed;
+
+    GSList *kvp;        /* of trn_sax_kvp, innermost first */
+} trn_sax_state;
+
+static trn_sax_tag
+trn_sax_lookup(const gchar *name)
+{
+    return GPOINTER_TO_INT(g_hash_table_lookup(trn_sax_tags, name));
+}
+
+static trn_sax_tag
+trn_sax_parent(trn_sax_state *state)
+{
+    if (state->tags->len == 0)
+        return TRN_TAG_UNKNOWN;
+    return g_array_index(state->tags, trn_sax_tag, state->tags->len - 1);
+}
+
+/* dom_tree_to_guid() only accepts a first attribute of type="guid" or
+ * type="new". */
+static gboolean
+trn_sax_guid_attrs_ok(gchar **attrs)
+{
+    if (!attrs || !attrs[0])
+        return FALSE;
+    if (strcmp(attrs[0], "type") != 0)
+    {
+        PERR("Unknown attribute for id tag: %s", attrs[0]);
+        return FALSE;
+    }
+    if (safe_strcmp(attrs[1], "guid") == 0 || safe_strcmp(attrs[1], "new") == 0)
+        return TRUE;
+
+    PERR("Unknown type %s for attribute type", attrs[1] ? attrs[1] : "(null)");
+    return FALSE;
+}
+
+static gboolean
+trn_sax_text_to_guid(trn_sax_state *state, GncGUID *guid)
+{
+    if (!state->guid_ok)
+        return FALSE;
+    string_to_guid(state->text->str, guid);
+    return TRUE;
+}
+
+static void
+trn_sax_ts_reset(trn_sax_state *state)
+{
+    state->ts.tv_sec = 0;
+    state->ts.tv_nsec = 0;
+    state->ts_seen_s = FALSE;
+    state->ts_seen_ns = FALSE;
+    state->ts_failed = FALSE;
+}
+
+/* Same result as dom_tree_to_timespec(). */
+static Timespec
+trn_sax_ts_result(trn_sax_state *state)
+{
+    Timespec ret = state->ts;
+
+    if (!state->ts_failed && !state->ts_seen_s)
+        PERR("no ts:date node found.");
+    if (state->ts_failed || !state->ts_seen_s)
+    {
+        ret.tv_sec = 0;
+        ret.tv_nsec = 0;
+    }
+    return ret;
+}
+
+static void
+trn_sax_gdate_reset(trn_sax_state *state)
+{
+    g_date_clear(&state->gdate, 1);
+    state->gdate_seen = FALSE;
+    state->gdate_failed = FALSE;
+}
+
+/* Opens the kvp context for a child of the innermost kvp element.
+ * Returns the role of the new element, or TRN_TAG_UNKNOWN if it is to be
+ * skipped. */
+static trn_sax_tag
+trn_sax_kvp_start(trn_sax_state *state, trn_sax_tag tag, gchar **attrs)
+{
+    trn_sax_kvp *parent = state->kvp->data;
+    trn_sax_kvp *ctx;
+    gchar **attr;
+    /* The slots element itself, or a frame value. */
+    gboolean holds_slots = (parent->tag == TRN_TAG_SLOTS) ||
+                           (safe_strcmp(parent->type, "frame") == 0);
+
+    if (parent->tag == SLOT_TAG)
+    {
+        if (tag == SLOT_TAG_KEY)
+            return SLOT_TAG_KEY;
+        if (tag != SLOT_TAG_VALUE)
+            return TRN_TAG_UNKNOWN;
+    }
+    else if (holds_slots)
+    {
+        if (tag != SLOT_TAG)
+            return TRN_TAG_UNKNOWN;
+
+        ctx = g_new0(trn_sax_kvp, 1);
+        ctx->tag = SLOT_TAG;
+        state->kvp = g_slist_prepend(state->kvp, ctx);
+        return SLOT_TAG;
+    }
+    else if (safe_strcmp(parent->type, "timespec") == 0)
+    {
+        return (tag == TS_TAG_DATE || tag == TS_TAG_NS) ? tag : TRN_TAG_UNKNOWN;
+    }
+    else if (safe_strcmp(parent->type, "gdate") == 0)
+    {
+        return tag == GDATE_TAG ? tag : TRN_TAG_UNKNOWN;
+    }
+    else if (safe_strcmp(parent->type, "list") != 0)
+    {
+        /* Scalar values have no child elements. */
+        return TRN_TAG_UNKNOWN;
+    }
+
+    /* A value: the slot:value of a slot, or any element of a list. */
+    ctx = g_new0(trn_sax_kvp, 1);
+    ctx->tag = SLOT_TAG_VALUE;
+    for (attr = attrs; attr && attr[0]; attr += 2)
+    {
+        if (strcmp(attr[0], "type") == 0)
+        {
+            ctx->type = g_intern_string(attr[1]);
+            break;
+        }
+    }
+
+    if (safe_strcmp(ctx->type, "guid") == 0)
+        state->guid_ok = trn_sax_guid_attrs_ok(attrs);
+
+    if (safe_strcmp(ctx->type, "frame") == 0)
+        ctx->frame = kvp_frame_new();
+    else if (safe_strcmp(ctx->type, "timespec") == 0)
+        trn_sax_ts_reset(state);
+    else if (safe_strcmp(ctx->type, "gdate") == 0)
+        trn_sax_gdate_reset(state);
+
+    state->kvp = g_slist_prepend(state->kvp, ctx);
+    return SLOT_TAG_VALUE;
+}
+
+static void
+trn_sax_kvp_free(trn_sax_kvp *ctx)
+{
+    if (ctx->tag != TRN_TAG_SLOTS && ctx->frame)
+        kvp_frame_delete(ctx->frame);
+    g_list_foreach(ctx->list, (GFunc) kvp_value_delete, NULL);
+    g_list_free(ctx->list);
+    g_free(ctx->key);
+    if (ctx->value)
+        kvp_value_delete(ctx->value);
+    g_free(ctx);
+}
+
+/* Same conversions as dom_tree_to_kvp_value(). */
+static kvp_value *
+trn_sax_kvp_value(trn_sax_state *state, trn_sax_kvp *ctx)
+{
+    const gchar *text = state->text->str;
+    const gchar *type = ctx->type;
+    kvp_value *ret = NULL;
+
+    if (!type)
+        return NULL;
+
+    if (strcmp(type, "integer") == 0)
+    {
+        gint64 daint;
+        if (string_to_gint64(text, &daint))
+            ret = kvp_value_new_gint64(daint);
+    }
+    else if (strcmp(type, "double") == 0)
+    {
+        double dadoub;
+        if (string_to_double(text, &dadoub))
+            ret = kvp_value_new_double(dadoub);
+    }
+    else if (strcmp(type, "numeric") == 0)
+    {
+        gnc_numeric danum;
+        if (string_to_gnc_numeric(text, &danum))
+            ret = kvp_value_new_gnc_numeric(danum);
+    }
+    else if (strcmp(type, "string") == 0)
+    {
+        ret = kvp_value_new_string(text);
+    }
+    else if (strcmp(type, "guid") == 0)
+    {
+        GncGUID daguid;
+        if (trn_sax_text_to_guid(state, &daguid))
+            ret = kvp_value_new_guid(&daguid);
+    }
+    else if (strcmp(type, "timespec") == 0)
+    {
+        Timespec ts = trn_sax_ts_result(state);
+        if (ts.tv_sec || ts.tv_nsec)
+            ret = kvp_value_new_timespec(ts);
+    }
+    else if (strcmp(type, "gdate") == 0)
+    {
+        if (!state->gdate_failed && !state->gdate_seen)
+            PWARN("no gdate node found.");
+        else if (!state->gdate_failed)
+            ret = kvp_value_new_gdate(state->gdate);
+    }
+    else if (strcmp(type, "binary") == 0)
+    {
+        void *val;
+        guint64 len;
+
+        if (string_to_binary(text, &val, &len))
+            ret = kvp_value_new_binary_nc(val, len);
+        else
+            PERR("string_to_binary returned false");
+    }
+    else if (strcmp(type, "list") == 0)
+    {
+        ret = kvp_value_new_glist_nc(g_list_reverse(ctx->list));
+        ctx->list = NULL;
+    }
+    else if (strcmp(type, "frame") == 0)
+    {
+        ret = kvp_value_new_frame_nc(ctx->frame);
+        ctx->frame = NULL;
+    }
+
+    return ret;
+}
+
+/* Closes the innermost kvp context, handing its result to its parent. */
+static void
+trn_sax_kvp_end(trn_sax_state *state, trn_sax_tag tag)
+{
+    trn_sax_kvp *ctx = state->kvp->data;
+    trn_sax_kvp *parent;
+
+    if (tag == SLOT_TAG_KEY)
+    {
+        g_free(ctx->key);
+        ctx->key = g_strdup(state->text->str);
+        return;
+    }
+    if (tag != SLOT_TAG && tag != SLOT_TAG_VALUE)
+        return;
+
+    state->kvp = g_slist_delete_link(state->kvp, state->kvp);
+    parent = state->kvp->data;
+
+    if (tag == SLOT_TAG_VALUE)
+    {
+        kvp_value *val = trn_sax_kvp_value(state, ctx);
+
+        if (val && parent->tag == SLOT_TAG)
+        {
+            if (parent->value)
+                kvp_value_delete(parent->value);
+            parent->value = val;
+        }
+        else if (val)
+        {
+            parent->list = g_list_prepend(parent->list, val);
+        }
+    }
+    else if (ctx->key && ctx->value)
+    {
+        kvp_frame_set_slot_nc(parent->frame, ctx->key, ctx->value);
+        ctx->value = NULL;
+    }
+
+    trn_sax_kvp_free(ctx);
+}
+
+static void
+trn_sax_kvp_open_slots(trn_sax_state *state, kvp_frame *frame)
+{
+    trn_sax_kvp *ctx = g_new0(trn_sax_kvp, 1);
+
+    /* TRN_TAG_SLOTS marks a frame owned by the transaction or split. */
+    ctx->tag = TRN_TAG_SLOTS;
+    ctx->frame = frame;
+    state->kvp = g_slist_prepend(state->kvp, ctx);
+}
+
+static void
+trn_sax_kvp_close_slots(trn_sax_state *state)
+{
+    trn_sax_kvp_free(state->kvp->data);
+    state->kvp = g_slist_delete_link(state->kvp, state->kvp);
+}
+
+/* Works out the role of a new element from its parent and sets up any
+ * state it needs.  TRN_TAG_UNKNOWN means skip the element and its
+ * contents. */
+static trn_sax_tag
+trn_sax_child_start(trn_sax_state *state, trn_sax_tag parent,
+                    const gchar *name, gchar **attrs)
+{
+    trn_sax_tag tag = trn_sax_lookup(name);
+
+    state->guid_ok = FALSE;
+
+    switch (parent)
+    {
+    case TRN_TAG_TRANSACTION:
+        if (tag < TRN_TAG_ID || tag > TRN_TAG_SPLITS)
+        {
+            PERR("Unhandled tag: %s", name);
+            state->trn_ok = FALSE;
+            return TRN_TAG_UNKNOWN;
+        }
+        state->trn_seen |= TRN_SAX_BIT(tag);
+        switch (tag)
+        {
+        case TRN_TAG_ID:
+            state->guid_ok = trn_sax_guid_attrs_ok(attrs);
+            break;
+        case TRN_TAG_CURRENCY:
+            g_free(state->cmdty_space);
+            g_free(state->cmdty_id);
+            state->cmdty_space = state->cmdty_id = NULL;
+            break;
+        case TRN_TAG_DATE_POSTED:
+        case TRN_TAG_DATE_ENTERED:
+            trn_sax_ts_reset(state);
+            break;
+        case TRN_TAG_SLOTS:
+            trn_sax_kvp_open_slots(state, xaccTransGetSlots(state->trn));
+            break;
+        case TRN_TAG_SPLITS:
+            state->splits_stopped = FALSE;
+            break;
+        default:
+            break;
+        }
+        return tag;
+
+    case TRN_TAG_SPLITS:
+        if (state->splits_stopped)
+            return TRN_TAG_UNKNOWN;
+        if (tag != TRN_TAG_SPLIT)
+        {
+            state->splits_stopped = TRUE;
+            return TRN_TAG_UNKNOWN;
+        }
+        state->split = xaccMallocSplit(state->book);
+        state->split_ok = TRUE;
+        state->split_seen = 0;
+        return tag;
+
+    case TRN_TAG_SPLIT:
+        if (tag < SPL_TAG_ID || tag > SPL_TAG_SLOTS)
+        {
+            PERR("Unhandled tag: %s", name);
+            state->split_ok = FALSE;
+            return TRN_TAG_UNKNOWN;
+        }
+        state->split_seen |= TRN_SAX_BIT(tag);
+        switch (tag)
+        {
+        case SPL_TAG_ID:
+        case SPL_TAG_ACCOUNT:
+        case SPL_TAG_LOT:
+            state->guid_ok = trn_sax_guid_attrs_ok(attrs);
+            break;
+        case SPL_TAG_RECONCILE_DATE:
+            trn_sax_ts_reset(state);
+            break;
+        case SPL_TAG_SLOTS:
+            trn_sax_kvp_open_slots(state, xaccSplitGetSlots(state->split));
+            break;
+        default:
+            break;
+        }
+        return tag;
+
+    case TRN_TAG_CURRENCY:
+        return (tag == CMDTY_TAG_SPACE || tag == CMDTY_TAG_ID) ?
+               tag : TRN_TAG_UNKNOWN;
+
+    case TRN_TAG_DATE_POSTED:
+    case TRN_TAG_DATE_ENTERED:
+    case SPL_TAG_RECONCILE_DATE:
+        return (tag == TS_TAG_DATE || tag == TS_TAG_NS) ? tag : TRN_TAG_UNKNOWN;
+
+    case TRN_TAG_SLOTS:
+    case SPL_TAG_SLOTS:
+    case SLOT_TAG:
+    case SLOT_TAG_VALUE:
+        return trn_sax_kvp_start(state, tag, attrs);
+
+    default:
+        return TRN_TAG_UNKNOWN;
+    }
+}
+
+static void
+trn_sax_split_end(trn_sax_state *state)
+{
+    Split *spl = state->split;
+
+    state->split = NULL;
+    if ((state->split_seen & SPL_SAX_REQUIRED) != SPL_SAX_REQUIRED)
+    {
+        PERR("didn't find all of the expected tags in the input");
+        state->split_ok = FALSE;
+    }
+
+    if (state->split_ok)
+    {
+        xaccTransAppendSplit(state->trn, spl);
+    }
+    else
+    {
+        xaccSplitDestroy(spl);
+        state->splits_stopped = TRUE;
+    }
+}
+
+static void
+trn_sax_split_account(trn_sax_state *state)
+{
+    GncGUID id;
+    Account *account;
+
+    g_return_if_fail(trn_sax_text_to_guid(state, &id));
+
+    account = xaccAccountLookup(&id, state->book);
+    if (!account && gnc_transaction_xml_v2_testing &&
+            !guid_equal(&id, guid_null()))
+    {
+        account = xaccMallocAccount(state->book);
+        xaccAccountSetGUID(account, &id);
+        xaccAccountSetCommoditySCU(account,
+                                   xaccSplitGetAmount(state->split).denom);
+    }
+
+    xaccAccountInsertSplit(account, state->split);
+}
+
+static void
+trn_sax_split_lot(trn_sax_state *state)
+{
+    GncGUID id;
+    GNCLot *lot;
+
+    g_return_if_fail(trn_sax_text_to_guid(state, &id));
+
+    lot = gnc_lot_lookup(&id, state->book);
+    if (!lot && gnc_transaction_xml_v2_testing &&
+            !guid_equal(&id, guid_null()))
+    {
+        lot = gnc_lot_new(state->book);
+        gnc_lot_set_guid(lot, id);
+    }
+
+    gnc_lot_add_split(lot, state->split);
+}
+
+/* Applies a finished element to the transaction or split. */
+static void
+trn_sax_child_end(trn_sax_state *state, trn_sax_tag tag, const gchar *name)
+{
+    const gchar *text = state->text->str;
+    GncGUID guid;
+    gnc_numeric num;
+    Timespec ts;
+
+    switch (tag)
+    {
+    case TRN_TAG_ID:
+        if (trn_sax_text_to_guid(state, &guid))
+            xaccTransSetGUID(state->trn, &guid);
+        break;
+    case TRN_TAG_CURRENCY:
+    {
+        gnc_commodity *ref = NULL;
+
+        if (state->cmdty_space && state->cmdty_id)
+        {
+            g_strstrip(state->cmdty_space);
+            g_strstrip(state->cmdty_id);
+            ref = gnc_commodity_table_lookup(
+                      gnc_commodity_table_get_table(state->book),
+                      state->cmdty_space, state->cmdty_id);
+        }
+        if (!ref)
+            PERR("Unknown currency in transaction");
+        xaccTransSetCurrency(state->trn, ref);
+    }
+    break;
+    case TRN_TAG_NUM:
+        xaccTransSetNum(state->trn, text);
+        break;
+    case TRN_TAG_DATE_POSTED:
+        ts = trn_sax_ts_result(state);
+        if (dom_tree_valid_timespec(&ts, BAD_CAST name))
+            xaccTransSetDatePostedTS(state->trn, &ts);
+        break;
+    case TRN_TAG_DATE_ENTERED:
+        ts = trn_sax_ts_result(state);
+        if (dom_tree_valid_timespec(&ts, BAD_CAST name))
+            xaccTransSetDateEnteredTS(state->trn, &ts);
+        break;
+    case TRN_TAG_DESCRIPTION:
+        xaccTransSetDescription(state->trn, text);
+        break;
+    case TRN_TAG_SLOTS:
+    case SPL_TAG_SLOTS:
+        trn_sax_kvp_close_slots(state);
+        break;
+    case TRN_TAG_SPLIT:
+        trn_sax_split_end(state);
+        break;
+
+    case SPL_TAG_ID:
+        if (trn_sax_text_to_guid(state, &guid))
+            xaccSplitSetGUID(state->split, &guid);
+        break;
+    case SPL_TAG_MEMO:
+        xaccSplitSetMemo(state->split, text);
+        break;
+    case SPL_TAG_ACTION:
+        xaccSplitSetAction(state->split, text);
+        break;
+    case SPL_TAG_RECONCILED_STATE:
+        xaccSplitSetReconcile(state->split, text[0]);
+        break;
+    case SPL_TAG_RECONCILE_DATE:
+        ts = trn_sax_ts_result(state);
+        if (dom_tree_valid_timespec(&ts, BAD_CAST name))
+            xaccSplitSetDateReconciledTS(state->split, &ts);
+        break;
+    case SPL_TAG_VALUE:
+        if (string_to_gnc_numeric(text, &num))
+            xaccSplitSetValue(state->split, num);
+        break;
+    case SPL_TAG_QUANTITY:
+        if (string_to_gnc_numeric(text, &num))
+            xaccSplitSetAmount(state->split, num);
+        break;
+    case SPL_TAG_ACCOUNT:
+        trn_sax_split_account(state);
+        break;
+    case SPL_TAG_LOT:
+        trn_sax_split_lot(state);
+        break;
+
+    case CMDTY_TAG_SPACE:
+        g_free(state->cmdty_space);
+        state->cmdty_space = g_strdup(text);
+        break;
+    case CMDTY_TAG_ID:
+        g_free(state->cmdty_id);
+        state->cmdty_id = g_strdup(text);
+        break;
+
+    case TS_TAG_DATE:
+        if (state->ts_seen_s || !string_to_timespec_secs(text, &state->ts))
+            state->ts_failed = TRUE;
+        state->ts_seen_s = TRUE;
+        break;
+    case TS_TAG_NS:
+        if (state->ts_seen_ns || !string_to_timespec_nsecs(text, &state->ts))
+            state->ts_failed = TRUE;
+        state->ts_seen_ns = TRUE;
+        break;
+
+    case GDATE_TAG:
+    {
+        gint year, month, day;
+
+        if (state->gdate_seen
+                || sscanf(text, "%d-%d-%d", &year, &month, &day) != 3)
+        {
+            state->gdate_failed = TRUE;
+        }
+        else
+        {
+            g_date_set_dmy(&state->gdate, day, month, year);
+            if (!g_date_valid(&state->gdate))
+            {
+                PWARN("invalid date");
+                state->gdate_failed = TRUE;
+            }
+        }
+        state->gdate_seen = TRUE;
+    }
+    break;
+
+    case SLOT_TAG:
+    case SLOT_TAG_KEY:
+    case SLOT_TAG_VALUE:
+        trn_sax_kvp_end(state, tag);
+        break;
+
+    default:
+        break;
+    }
+}
+
+static void
+trn_sax_state_free(trn_sax_state *state)
+{
+    while (state->kvp)
+    {
+        trn_sax_kvp_free(state->kvp->data);
+        state->kvp = g_slist_delete_link(state->kvp, state->kvp);
+    }
+    g_array_free(state->tags, TRUE);
+    g_string_free(state->text, TRUE);
+    g_free(state->cmdty_space);
+    g_free(state->cmdty_id);
+    g_free(state);
+}
+
+/* Throws away a transaction that failed to parse, and anything still
+ * attached to the parse state. */
+static void
+trn_sax_discard(trn_sax_state *state)
+{
+    if (state->split)
+    {
+        xaccSplitDestroy(state->split);
+        state->split = NULL;
+    }
+    if (state->trn)
+    {
+        xaccTransDestroy(state->trn);
+        xaccTransCommitEdit(state->trn);
+        state->trn = NULL;
+    }
+}
+
+static gboolean
+trn_sax_start_handler(GSList* sibling_data, gpointer parent_data,
+                      gpointer global_data, gpointer *data_for_children,
+                      gpointer *result, const gchar *tag, gchar **attrs)
+{
+    trn_sax_state *state;
+    trn_sax_tag role;
+
+    if (parent_data == NULL)
+    {
+        gxpf_data *gdata = (gxpf_data*)global_data;
+
+        state = g_new0(trn_sax_state, 1);
+        state->book = gdata->bookdata;
+        state->tags = g_array_new(FALSE, FALSE, sizeof(trn_sax_tag));
+        state->text = g_string_sized_new(64);
+        state->trn_ok = TRUE;
+
+        state->trn = xaccMallocTransaction(state->book);
+        xaccTransBeginEdit(state->trn);
+
+        role = TRN_TAG_TRANSACTION;
+        g_array_append_val(state->tags, role);
+
+        /* only publish the result if we're the parent */
+        *result = state;
+        *data_for_children = state;
+        return TRUE;
+    }
+
+    state = parent_data;
+    *data_for_children = state;
+    *result = NULL;
+
+    if (state->ignore_depth > 0)
+    {
+        state->ignore_depth++;
+        return TRUE;
+    }
+
+    role = trn_sax_child_start(state, trn_sax_parent(state), tag, attrs);
+    if (role == TRN_TAG_UNKNOWN)
+    {
+        state->ignore_depth = 1;
+        return TRUE;
+    }
+
+    g_array_append_val(state->tags, role);
+    g_string_truncate(state->text, 0);
+    return TRUE;
+}
+
+static gboolean
+trn_sax_chars_handler(GSList *sibling_data, gpointer parent_data,
+                      gpointer global_data, gpointer *result,
+                      const char *text, int length)
+{
+    trn_sax_state *state = parent_data;
+
+    if (state->ignore_depth == 0 && length > 0)
+        g_string_append_len(state->text, text, length);
+    return TRUE;
+}
+
+static gboolean
+trn_sax_end_handler(gpointer data_for_children,
+                    GSList* data_from_children, GSList* sibling_data,
+                    gpointer parent_data, gpointer global_data,
+                    gpointer *result, const gchar *tag)
+{
+    trn_sax_state *state = data_for_children;
+    gxpf_data *gdata = (gxpf_data*)global_data;
+    Transaction *trn;
+
+    /* OK.  For some messed up reason this is getting called again with a
+       NULL tag.  So we ignore those cases */
+    if (!tag)
+    {
+        return TRUE;
+    }
+
+    if (parent_data)
+    {
+        trn_sax_tag role;
+
+        if (state->ignore_depth > 0)
+        {
+            state->ignore_depth--;
+            return TRUE;
+        }
+        role = trn_sax_parent(state);
+        g_array_set_size(state->tags, state->tags->len - 1);
+        trn_sax_child_end(state, role, tag);
+        g_string_truncate(state->text, 0);
+        return TRUE;
+    }
+
+    if ((state->trn_seen & TRN_SAX_REQUIRED) != TRN_SAX_REQUIRED)
+    {
+        PERR("didn't find all of the expected tags in the input");
+        state->trn_ok = FALSE;
+    }
+
+    trn = state->trn;
+    if (state->trn_ok)
+    {
+        xaccTransCommitEdit(trn);
+        state->trn = NULL;
+        gdata->cb(tag, gdata->parsedata, trn);
+    }
+    else
+    {
+        trn_sax_discard(state);
+        trn = NULL;
+    }
+
+    trn_sax_state_free(state);
+    *result = NULL;
+
+    return trn != NULL;
+}
+
+static void
+trn_sax_fail_handler(gpointer data_for_children,
+                     GSList* data_from_children,
+                     GSList* sibling_data,
+                     gpointer parent_data,
+                     gpointer global_data,
+                     gpointer *result,
+                     const gchar *tag)
+{
+    trn_sax_state *state = *result;
+
+    if (!state) return;
+
+    trn_sax_discard(state);
+    trn_sax_state_free(state);
+    *result = NULL;
+}
+
 sixtp*
 gnc_transaction_sixtp_parser_create(void)
 {
-    return sixtp_dom_parser_new(gnc_transaction_end_handler, NULL, NULL);
+    sixtp *top_level;
+
+    if (!trn_sax_tags)
+    {
+        int i;
+
+        trn_sax_tags = g_hash_table_new(g_str_hash, g_str_equal);
+        for (i = 0; trn_sax_tag_names[i].name; i++)
+            g_hash_table_insert(trn_sax_tags,
+                                (gpointer) trn_sax_tag_names[i].name,
+                                GINT_TO_POINTER(trn_sax_tag_names[i].tag));
+    }
+
+    if (!(top_level =
+                sixtp_set_any(sixtp_new(), FALSE,
+                              SIXTP_START_HANDLER_ID, trn_sax_start_handler,
+                              SIXTP_CHARACTERS_HANDLER_ID, trn_sax_chars_handler,
+                              SIXTP_END_HANDLER_ID, trn_sax_end_handler,
+                              SIXTP_FAIL_HANDLER_ID, trn_sax_fail_handler,
+                              SIXTP_NO_MORE_HANDLERS)))
+    {
+        return NULL;
+    }
+
+    if (!sixtp_add_sub_parser(top_level, SIXTP_MAGIC_CATCHER, top_level))
+    {
+        sixtp_destroy(top_level);
+        return NULL;
+    }
+
+    return top_level;
 }
@@ -59,6 +59,7 @@ xmlNodePtr gnc_budget_dom_tree_create( GncBudget *bgt );
 sixtp* gnc_budget_sixtp_parser_create(void);
 
 xmlNodePtr gnc_transaction_dom_tree_create(Transaction *txn);
+gboolean gnc_transaction_write_xml_stream(FILE *out, Transaction *txn);
 sixtp* gnc_transaction_sixtp_parser_create(void);
 
 sixtp* gnc_template_transaction_sixtp_parser_create(void);
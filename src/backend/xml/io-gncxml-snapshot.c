@@ -0,0 +1,1415 @@
+/********************************************************************\
+ * io-gncxml-snapshot.c -- binary snapshot cache for xml data files *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+\********************************************************************/
+
+/*
+ * Snapshot layout.  Everything is in host byte order; a snapshot
+ * written on another kind of machine is simply ignored.
+ *
+ *   header        snap_header below
+ *   string table  count, then for each string its length, its bytes
+ *                 and a terminating NUL
+ *   sections      book, commodities, accounts (with their lots),
+ *                 transactions (with their splits), prices, end
+ *
+ * Strings are written as 1-based indexes into the string table, 0
+ * meaning NULL.  Commodities, accounts and lots are written as
+ * 0-based indexes into the order they appear in the snapshot,
+ * SNAP_NONE meaning NULL.  Accounts are written parents first, so an
+ * account's parent always has a smaller index than the account.
+ *
+ * The checksum covers everything after the header.  The header also
+ * records the size, modification time and SHA-256 digest of the data
+ * file.  The size and time are cheap to check.  The digest catches a
+ * file rewritten within the same second at the same size.
+ */
+
+#include "config.h"
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <fcntl.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#ifdef HAVE_UNISTD_H
+# include <unistd.h>
+#endif
+#include <zlib.h>
+
+#include "gnc-engine.h"
+#include "gnc-lot.h"
+#include "gnc-pricedb.h"
+#include "Scrub.h"
+#include "SX-book.h"
+#include "Transaction.h"
+#include "TransactionP.h"
+#include "TransLog.h"
+
+#include "io-gncxml-snapshot.h"
+
+static QofLogModule log_module = GNC_MOD_IO;
+
+#define SNAP_SUFFIX      ".snapshot"
+#define SNAP_MAGIC       "GNCSNAP"
+#define SNAP_VERSION     2
+#define SNAP_BYTE_ORDER  0x01020304
+#define SNAP_NONE        G_MAXUINT32
+#define SNAP_DIGEST_LEN  32     /* SHA-256 */
+
+typedef struct
+{
+    gchar   magic[8];
+    guint32 version;
+    guint32 byte_order;
+    gint64  source_size;    /* of the XML file the snapshot was taken from */
+    gint64  source_mtime;
+    guint8  source_digest[SNAP_DIGEST_LEN];  /* of the XML file's bytes */
+    guint64 body_len;
+    guint32 crc;            /* crc32 of the body */
+    guint32 reserved;
+} snap_header;
+
+typedef enum
+{
+    SNAP_SECTION_BOOK = 1,
+    SNAP_SECTION_COMMODITIES,
+    SNAP_SECTION_ACCOUNTS,
+    SNAP_SECTION_TRANSACTIONS,
+    SNAP_SECTION_PRICES,
+    SNAP_SECTION_END
+} snap_section;
+
+/* Object types a snapshot fully describes.  A book holding anything
+ * else is left to the XML file alone. */
+static const gchar *snap_types[] =
+{
+    QOF_ID_BOOK,
+    GNC_ID_ACCOUNT,
+    GNC_ID_COMMODITY,
+    GNC_ID_COMMODITY_NAMESPACE,
+    GNC_ID_COMMODITY_TABLE,
+    GNC_ID_LOT,
+    GNC_ID_PRICE,
+    GNC_ID_PRICEDB,
+    GNC_ID_SPLIT,
+    GNC_ID_SXES,
+    GNC_ID_SXTG,
+    GNC_ID_TRANS,
+    NULL
+};
+
+/* Compute the SHA-256 digest of the raw bytes of file. */
+static gboolean
+snap_file_digest(const char *file, guint8 digest[SNAP_DIGEST_LEN])
+{
+    GMappedFile *map;
+    GChecksum *sum;
+    gsize len = SNAP_DIGEST_LEN;
+
+    map = g_mapped_file_new(file, FALSE, NULL);
+    if (!map)
+        return FALSE;
+
+    sum = g_checksum_new(G_CHECKSUM_SHA256);
+    if (g_mapped_file_get_length(map) > 0)
+        g_checksum_update(sum,
+                          (const guchar *) g_mapped_file_get_contents(map),
+                          g_mapped_file_get_length(map));
+    g_checksum_get_digest(sum, digest, &len);
+    g_checksum_free(sum);
+    g_mapped_file_free(map);
+    return len == SNAP_DIGEST_LEN;
+}
+
+static gchar *
+snap_file_name(const char *datafile)
+{
+    return g_strconcat(datafile, SNAP_SUFFIX, NULL);
+}
+
+static guint32
+snap_crc(guint32 crc, const guchar *buf, gsize len)
+{
+    while (len > 0)
+    {
+        uInt chunk = (uInt) MIN(len, (gsize) G_MAXINT32);
+
+        crc = crc32(crc, buf, chunk);
+        buf += chunk;
+        len -= chunk;
+    }
+    return crc;
+}
+
+void
+gnc_xml_snapshot_remove(const char *datafile)
+{
+    gchar *snap_name;
+
+    g_return_if_fail(datafile);
+
+    snap_name = snap_file_name(datafile);
+    if (g_unlink(snap_name) != 0 && errno != ENOENT)
+    {
+        PWARN("unable to remove snapshot %s: %s",
+              snap_name, g_strerror(errno));
+    }
+    g_free(snap_name);
+}
+
+/* ================================================================ */
+/* Writing */
+
+typedef struct
+{
+    GByteArray *data;
+    GHashTable *strings;        /* string -> 1-based table index */
+    GPtrArray  *string_list;
+    GHashTable *refs;           /* commodity/account/lot -> index + 1 */
+    guint32     n_lots;
+} snap_writer;
+
+static void
+snap_put(GByteArray *buf, gconstpointer data, gsize len)
+{
+    if (len > 0)
+        g_byte_array_append(buf, data, len);
+}
+
+static void
+snap_put_u32(GByteArray *buf, guint32 val)
+{
+    snap_put(buf, &val, sizeof(val));
+}
+
+static void
+snap_put_i64(GByteArray *buf, gint64 val)
+{
+    snap_put(buf, &val, sizeof(val));
+}
+
+static void
+snap_put_ts(GByteArray *buf, Timespec ts)
+{
+    snap_put_i64(buf, ts.tv_sec);
+    snap_put_i64(buf, ts.tv_nsec);
+}
+
+static void
+snap_put_numeric(GByteArray *buf, gnc_numeric num)
+{
+    snap_put_i64(buf, num.num);
+    snap_put_i64(buf, num.denom);
+}
+
+static void
+snap_put_guid(GByteArray *buf, const GncGUID *guid)
+{
+    snap_put(buf, guid ? guid : guid_null(), sizeof(GncGUID));
+}
+
+static void
+snap_put_string(snap_writer *w, const char *str)
+{
+    guint32 idx = 0;
+
+    if (str)
+    {
+        idx = GPOINTER_TO_UINT(g_hash_table_lookup(w->strings, str));
+        if (idx == 0)
+        {
+            g_ptr_array_add(w->string_list, (gpointer) str);
+            idx = w->string_list->len;
+            g_hash_table_insert(w->strings, (gpointer) str,
+                                GUINT_TO_POINTER(idx));
+        }
+    }
+    snap_put_u32(w->data, idx);
+}
+
+static void
+snap_add_ref(snap_writer *w, gconstpointer obj, guint32 idx)
+{
+    g_hash_table_insert(w->refs, (gpointer) obj, GUINT_TO_POINTER(idx + 1));
+}
+
+static gboolean
+snap_has_ref(snap_writer *w, gconstpointer obj)
+{
+    return obj && g_hash_table_lookup(w->refs, obj) != NULL;
+}
+
+static void
+snap_put_ref(snap_writer *w, gconstpointer obj)
+{
+    guint32 idx = 0;
+
+    if (obj)
+        idx = GPOINTER_TO_UINT(g_hash_table_lookup(w->refs, obj));
+    snap_put_u32(w->data, idx ? idx - 1 : SNAP_NONE);
+}
+
+static void snap_put_frame(snap_writer *w, KvpFrame *frame);
+
+static void
+snap_put_value(snap_writer *w, const KvpValue *val)
+{
+    KvpValueType type = kvp_value_get_type(val);
+
+    snap_put_u32(w->data, type);
+    switch (type)
+    {
+    case KVP_TYPE_GINT64:
+        snap_put_i64(w->data, kvp_value_get_gint64(val));
+        break;
+    case KVP_TYPE_DOUBLE:
+    {
+        double d = kvp_value_get_double(val);
+        snap_put(w->data, &d, sizeof(d));
+    }
+    break;
+    case KVP_TYPE_NUMERIC:
+        snap_put_numeric(w->data, kvp_value_get_numeric(val));
+        break;
+    case KVP_TYPE_STRING:
+        snap_put_string(w, kvp_value_get_string(val));
+        break;
+    case KVP_TYPE_GUID:
+        snap_put_guid(w->data, kvp_value_get_guid(val));
+        break;
+    case KVP_TYPE_TIMESPEC:
+        snap_put_ts(w->data, kvp_value_get_timespec(val));
+        break;
+    case KVP_TYPE_BINARY:
+    {
+        guint64 size = 0;
+        void *bin = kvp_value_get_binary(val, &size);
+
+        snap_put(w->data, &size, sizeof(size));
+        snap_put(w->data, bin, size);
+    }
+    break;
+    case KVP_TYPE_GLIST:
+    {
+        GList *node = kvp_value_get_glist(val);
+
+        snap_put_u32(w->data, g_list_length(node));
+        for (; node; node = node->next)
+            snap_put_value(w, node->data);
+    }
+    break;
+    case KVP_TYPE_FRAME:
+        snap_put_frame(w, kvp_value_get_frame(val));
+        break;
+    case KVP_TYPE_GDATE:
+    {
+        GDate date = kvp_value_get_gdate(val);
+
+        snap_put_u32(w->data,
+                     g_date_valid(&date) ? g_date_get_julian(&date) : 0);
+    }
+    break;
+    }
+}
+
+static void
+snap_put_slot(const gchar *key, KvpValue *value, gpointer data)
+{
+    snap_writer *w = data;
+
+    snap_put_string(w, key);
+    snap_put_value(w, value);
+}
+
+static void
+snap_put_frame(snap_writer *w, KvpFrame *frame)
+{
+    snap_put_u32(w->data, kvp_frame_count_slots(frame));
+    kvp_frame_for_each_slot(frame, snap_put_slot, w);
+}
+
+static gboolean
+snap_collect_commodity(gnc_commodity *com, gpointer data)
+{
+    g_ptr_array_add(data, com);
+    return TRUE;
+}
+
+static void
+snap_write_commodities(snap_writer *w, QofBook *book)
+{
+    GPtrArray *comms = g_ptr_array_new();
+    guint i;
+
+    gnc_commodity_table_foreach_commodity(gnc_commodity_table_get_table(book),
+                                          snap_collect_commodity, comms);
+
+    snap_put_u32(w->data, comms->len);
+    for (i = 0; i < comms->len; i++)
+    {
+        gnc_commodity *com = g_ptr_array_index(comms, i);
+        gboolean quote_flag = gnc_commodity_get_quote_flag(com);
+        gnc_quote_source *source = NULL;
+
+        if (quote_flag)
+            source = gnc_commodity_get_quote_source(com);
+
+        snap_add_ref(w, com, i);
+        snap_put_string(w, gnc_commodity_get_namespace(com));
+        snap_put_string(w, gnc_commodity_get_mnemonic(com));
+        snap_put_string(w, gnc_commodity_get_fullname(com));
+        snap_put_string(w, gnc_commodity_get_cusip(com));
+        snap_put_u32(w->data, gnc_commodity_get_fraction(com));
+        snap_put_u32(w->data, quote_flag);
+        snap_put_string(w, source ? gnc_quote_source_get_internal_name(source)
+                        : NULL);
+        snap_put_string(w, quote_flag ? gnc_commodity_get_quote_tz(com) : NULL);
+        snap_put_frame(w, qof_instance_get_slots(QOF_INSTANCE(com)));
+    }
+    g_ptr_array_free(comms, TRUE);
+}
+
+static void
+snap_write_accounts(snap_writer *w, QofBook *book)
+{
+    Account *root = gnc_book_get_root_account(book);
+    GList *accounts, *node, *lots, *lp;
+    guint32 i;
+
+    /* gnc_account_get_descendants() lists parents before children. */
+    accounts = g_list_prepend(gnc_account_get_descendants(root), root);
+
+    snap_put_u32(w->data, g_list_length(accounts));
+    for (node = accounts, i = 0; node; node = node->next, i++)
+        snap_add_ref(w, node->data, i);
+
+    for (node = accounts; node; node = node->next)
+    {
+        Account *acc = node->data;
+
+        snap_put_guid(w->data, xaccAccountGetGUID(acc));
+        snap_put_string(w, xaccAccountGetName(acc));
+        snap_put_string(w, xaccAccountTypeEnumAsString(xaccAccountGetType(acc)));
+        snap_put_ref(w, xaccAccountGetCommodity(acc));
+        snap_put_u32(w->data, xaccAccountGetCommoditySCUi(acc));
+        snap_put_u32(w->data, xaccAccountGetNonStdSCU(acc));
+        snap_put_string(w, xaccAccountGetCode(acc));
+        snap_put_string(w, xaccAccountGetDescription(acc));
+        snap_put_ref(w, gnc_account_get_parent(acc));
+        snap_put_frame(w, xaccAccountGetSlots(acc));
+
+        lots = xaccAccountGetLotList(acc);
+        snap_put_u32(w->data, g_list_length(lots));
+        for (lp = lots; lp; lp = lp->next)
+        {
+            GNCLot *lot = lp->data;
+
+            snap_add_ref(w, lot, w->n_lots++);
+            snap_put_guid(w->data, gnc_lot_get_guid(lot));
+            snap_put_frame(w, gnc_lot_get_slots(lot));
+        }
+        g_list_free(lots);
+    }
+    g_list_free(accounts);
+}
+
+static void
+snap_write_split(snap_writer *w, Split *split)
+{
+    snap_put_guid(w->data, xaccSplitGetGUID(split));
+    snap_put_string(w, xaccSplitGetMemo(split));
+    snap_put_string(w, xaccSplitGetAction(split));
+    snap_put_u32(w->data, (guchar) xaccSplitGetReconcile(split));
+    snap_put_ts(w->data, xaccSplitRetDateReconciledTS(split));
+    snap_put_numeric(w->data, xaccSplitGetValue(split));
+    snap_put_numeric(w->data, xaccSplitGetAmount(split));
+    snap_put_ref(w, xaccSplitGetAccount(split));
+    snap_put_ref(w, xaccSplitGetLot(split));
+    snap_put_frame(w, xaccSplitGetSlots(split));
+}
+
+static void
+snap_collect_instance(QofInstance *inst, gpointer data)
+{
+    g_ptr_array_add(data, inst);
+}
+
+static gint
+snap_trans_order(gconstpointer a, gconstpointer b)
+{
+    return xaccTransOrder(*(Transaction * const *) a,
+                          *(Transaction * const *) b);
+}
+
+static void
+snap_write_transactions(snap_writer *w, QofBook *book)
+{
+    GPtrArray *trans = g_ptr_array_new();
+    guint i;
+
+    qof_collection_foreach(qof_book_get_collection(book, GNC_ID_TRANS),
+                           snap_collect_instance, trans);
+    /* Keep the file independent of hash table order, and hand the
+     * splits to their accounts in the order they will be sorted into. */
+    g_ptr_array_sort(trans, snap_trans_order);
+
+    snap_put_u32(w->data, trans->len);
+    for (i = 0; i < trans->len; i++)
+    {
+        Transaction *trn = g_ptr_array_index(trans, i);
+        GList *splits = xaccTransGetSplitList(trn);
+        GList *node;
+
+        snap_put_guid(w->data, xaccTransGetGUID(trn));
+        snap_put_ref(w, xaccTransGetCurrency(trn));
+        snap_put_string(w, xaccTransGetNum(trn));
+        snap_put_ts(w->data, xaccTransRetDatePostedTS(trn));
+        snap_put_ts(w->data, xaccTransRetDateEnteredTS(trn));
+        snap_put_string(w, xaccTransGetDescription(trn));
+        snap_put_frame(w, xaccTransGetSlots(trn));
+
+        snap_put_u32(w->data, g_list_length(splits));
+        for (node = splits; node; node = node->next)
+            snap_write_split(w, node->data);
+    }
+    g_ptr_array_free(trans, TRUE);
+}
+
+static gboolean
+snap_collect_price(GNCPrice *price, gpointer data)
+{
+    g_ptr_array_add(data, price);
+    return TRUE;
+}
+
+static void
+snap_write_prices(snap_writer *w, QofBook *book)
+{
+    GPtrArray *prices = g_ptr_array_new();
+    guint32 i, count = 0;
+
+    gnc_pricedb_foreach_price(gnc_pricedb_get_db(book), snap_collect_price,
+                              prices, FALSE);
+
+    /* Like the XML writer, drop prices without both commodities. */
+    for (i = 0; i < prices->len; i++)
+    {
+        GNCPrice *price = g_ptr_array_index(prices, i);
+
+        if (snap_has_ref(w, gnc_price_get_commodity(price)) &&
+                snap_has_ref(w, gnc_price_get_currency(price)))
+            g_ptr_array_index(prices, count++) = price;
+    }
+
+    snap_put_u32(w->data, count);
+    for (i = 0; i < count; i++)
+    {
+        GNCPrice *price = g_ptr_array_index(prices, i);
+
+        snap_put_guid(w->data, gnc_price_get_guid(price));
+        snap_put_ref(w, gnc_price_get_commodity(price));
+        snap_put_ref(w, gnc_price_get_currency(price));
+        snap_put_ts(w->data, gnc_price_get_time(price));
+        snap_put_string(w, gnc_price_get_source(price));
+        snap_put_string(w, gnc_price_get_typestr(price));
+        snap_put_numeric(w->data, gnc_price_get_value(price));
+    }
+    g_ptr_array_free(prices, TRUE);
+}
+
+static void
+snap_check_collection(QofCollection *col, gpointer data)
+{
+    gboolean *supported = data;
+    QofIdTypeConst type = qof_collection_get_type(col);
+    int i;
+
+    if (qof_collection_count(col) == 0)
+        return;
+
+    for (i = 0; snap_types[i]; i++)
+    {
+        if (safe_strcmp(type, snap_types[i]) == 0)
+            return;
+    }
+
+    PINFO("book holds %s objects", type);
+    *supported = FALSE;
+}
+
+static gboolean
+snap_book_supported(QofBook *book)
+{
+    Account *template_root;
+    gboolean supported = TRUE;
+
+    if (!gnc_book_get_root_account(book))
+        return FALSE;
+
+    template_root = gnc_book_get_template_root(book);
+    if (template_root && gnc_account_n_descendants(template_root) > 0)
+        return FALSE;
+
+    qof_book_foreach_collection(book, snap_check_collection, &supported);
+    return supported;
+}
+
+static gboolean
+snap_write_file(const gchar *snap_name, const struct stat *source,
+                const snap_header *hdr, GByteArray *strings, GByteArray *data)
+{
+    gchar *tmp_name = g_strconcat(snap_name, ".tmp", NULL);
+    FILE *out = NULL;
+    int flags = 0;
+    int fd;
+    gboolean ok;
+
+#ifdef G_OS_WIN32
+    flags = O_BINARY;
+#endif
+
+    /* The snapshot holds the same data as the book, so give it the
+     * same permissions. */
+    fd = g_open(tmp_name, O_WRONLY | O_CREAT | O_TRUNC | flags,
+                source->st_mode & 0777);
+    if (fd != -1)
+    {
+        out = fdopen(fd, "wb");
+        if (!out)
+            close(fd);
+    }
+
+    ok = (out != NULL)
+         && fwrite(hdr, sizeof(*hdr), 1, out) == 1
+         && fwrite(strings->data, strings->len, 1, out) == 1
+         && (data->len == 0 || fwrite(data->data, data->len, 1, out) == 1);
+    if (out && fclose(out) != 0)
+        ok = FALSE;
+
+    if (ok)
+    {
+#ifdef G_OS_WIN32
+        g_unlink(snap_name);
+#endif
+        ok = (g_rename(tmp_name, snap_name) == 0);
+    }
+
+    if (!ok)
+    {
+        PWARN("unable to write snapshot %s: %s",
+              snap_name, g_strerror(errno));
+        g_unlink(tmp_name);
+    }
+    g_free(tmp_name);
+    return ok;
+}
+
+gboolean
+gnc_xml_snapshot_write(QofBook *book, const char *datafile)
+{
+    snap_writer w;
+    snap_header hdr;
+    GByteArray *strings;
+    struct stat source;
+    gchar *snap_name;
+    gboolean ok;
+    guint i;
+
+    g_return_val_if_fail(book && datafile, FALSE);
+
+    ENTER("book=%p file=%s", book, datafile);
+
+    if (!snap_book_supported(book) || g_stat(datafile, &source) != 0
+            || !S_ISREG(source.st_mode))
+    {
+        gnc_xml_snapshot_remove(datafile);
+        LEAVE("no snapshot for this book");
+        return FALSE;
+    }
+
+    w.data = g_byte_array_new();
+    w.strings = g_hash_table_new(g_str_hash, g_str_equal);
+    w.string_list = g_ptr_array_new();
+    w.refs = g_hash_table_new(g_direct_hash, g_direct_equal);
+    w.n_lots = 0;
+
+    snap_put_u32(w.data, SNAP_SECTION_BOOK);
+    snap_put_guid(w.data, qof_book_get_guid(book));
+    snap_put_frame(&w, qof_book_get_slots(book));
+    snap_put_u32(w.data, SNAP_SECTION_COMMODITIES);
+    snap_write_commodities(&w, book);
+    snap_put_u32(w.data, SNAP_SECTION_ACCOUNTS);
+    snap_write_accounts(&w, book);
+    snap_put_u32(w.data, SNAP_SECTION_TRANSACTIONS);
+    snap_write_transactions(&w, book);
+    snap_put_u32(w.data, SNAP_SECTION_PRICES);
+    snap_write_prices(&w, book);
+    snap_put_u32(w.data, SNAP_SECTION_END);
+
+    strings = g_byte_array_new();
+    snap_put_u32(strings, w.string_list->len);
+    for (i = 0; i < w.string_list->len; i++)
+    {
+        const gchar *str = g_ptr_array_index(w.string_list, i);
+        guint32 len = strlen(str);
+
+        snap_put_u32(strings, len);
+        snap_put(strings, str, len + 1);
+    }
+
+    memset(&hdr, 0, sizeof(hdr));
+    if (!snap_file_digest(datafile, hdr.source_digest))
+    {
+        gnc_xml_snapshot_remove(datafile);
+        ok = FALSE;
+        goto done;
+    }
+    memcpy(hdr.magic, SNAP_MAGIC, sizeof(hdr.magic));
+    hdr.version = SNAP_VERSION;
+    hdr.byte_order = SNAP_BYTE_ORDER;
+    hdr.source_size = source.st_size;
+    hdr.source_mtime = source.st_mtime;
+    hdr.body_len = strings->len + w.data->len;
+    hdr.crc = snap_crc(snap_crc(crc32(0L, Z_NULL, 0),
+                                strings->data, strings->len),
+                       w.data->data, w.data->len);
+
+    snap_name = snap_file_name(datafile);
+    ok = snap_write_file(snap_name, &source, &hdr, strings, w.data);
+    g_free(snap_name);
+
+done:
+    g_byte_array_free(strings, TRUE);
+    g_byte_array_free(w.data, TRUE);
+    g_hash_table_destroy(w.strings);
+    g_ptr_array_free(w.string_list, TRUE);
+    g_hash_table_destroy(w.refs);
+
+    LEAVE("%s", ok ? "written" : "failed");
+    return ok;
+}
+
+/* ================================================================ */
+/* Reading */
+
+/* The same reader runs twice over a snapshot: first with no book, to
+ * check that every record and reference is sound, then with the book
+ * to create the objects.  Only a snapshot that passed the first run is
+ * ever turned into objects, so a bad one never leaves a half-filled
+ * book behind. */
+typedef struct
+{
+    const guchar *pos;
+    const guchar *end;
+    const gchar **strings;
+    guint32 n_strings;
+    gboolean ok;
+    QofBook *book;              /* NULL while checking */
+    GPtrArray *commodities;
+    GPtrArray *accounts;
+    GPtrArray *lots;
+} snap_reader;
+
+static void
+snap_get(snap_reader *r, gpointer dest, gsize len)
+{
+    if (!r->ok || (gsize) (r->end - r->pos) < len)
+    {
+        r->ok = FALSE;
+        memset(dest, 0, len);
+        return;
+    }
+    memcpy(dest, r->pos, len);
+    r->pos += len;
+}
+
+static guint32
+snap_get_u32(snap_reader *r)
+{
+    guint32 val;
+
+    snap_get(r, &val, sizeof(val));
+    return val;
+}
+
+static gint64
+snap_get_i64(snap_reader *r)
+{
+    gint64 val;
+
+    snap_get(r, &val, sizeof(val));
+    return val;
+}
+
+static Timespec
+snap_get_ts(snap_reader *r)
+{
+    Timespec ts;
+
+    ts.tv_sec = snap_get_i64(r);
+    ts.tv_nsec = snap_get_i64(r);
+    return ts;
+}
+
+static gnc_numeric
+snap_get_numeric(snap_reader *r)
+{
+    gint64 num = snap_get_i64(r);
+    gint64 denom = snap_get_i64(r);
+
+    return gnc_numeric_create(num, denom);
+}
+
+static void
+snap_get_guid(snap_reader *r, GncGUID *guid)
+{
+    snap_get(r, guid, sizeof(GncGUID));
+}
+
+static const gchar *
+snap_get_string(snap_reader *r)
+{
+    guint32 idx = snap_get_u32(r);
+
+    if (idx == 0)
+        return NULL;
+    if (idx > r->n_strings)
+    {
+        r->ok = FALSE;
+        return NULL;
+    }
+    return r->strings[idx - 1];
+}
+
+static gpointer
+snap_get_ref(snap_reader *r, GPtrArray *objs)
+{
+    guint32 idx = snap_get_u32(r);
+
+    if (idx == SNAP_NONE)
+        return NULL;
+    if (idx >= objs->len)
+    {
+        r->ok = FALSE;
+        return NULL;
+    }
+    return g_ptr_array_index(objs, idx);
+}
+
+static gboolean
+snap_expect_section(snap_reader *r, snap_section section)
+{
+    if (snap_get_u32(r) != (guint32) section)
+        r->ok = FALSE;
+    return r->ok;
+}
+
+static void snap_get_frame(snap_reader *r, KvpFrame *frame);
+
+static KvpValue *
+snap_get_value(snap_reader *r)
+{
+    gboolean build = (r->book != NULL);
+
+    switch (snap_get_u32(r))
+    {
+    case KVP_TYPE_GINT64:
+    {
+        gint64 val = snap_get_i64(r);
+        return build ? kvp_value_new_gint64(val) : NULL;
+    }
+    case KVP_TYPE_DOUBLE:
+    {
+        double val;
+        snap_get(r, &val, sizeof(val));
+        return build ? kvp_value_new_double(val) : NULL;
+    }
+    case KVP_TYPE_NUMERIC:
+    {
+        gnc_numeric val = snap_get_numeric(r);
+        return build ? kvp_value_new_numeric(val) : NULL;
+    }
+    case KVP_TYPE_STRING:
+    {
+        const gchar *val = snap_get_string(r);
+        return (build && val) ? kvp_value_new_string(val) : NULL;
+    }
+    case KVP_TYPE_GUID:
+    {
+        GncGUID val;
+        snap_get_guid(r, &val);
+        return build ? kvp_value_new_guid(&val) : NULL;
+    }
+    case KVP_TYPE_TIMESPEC:
+    {
+        Timespec val = snap_get_ts(r);
+        return build ? kvp_value_new_timespec(val) : NULL;
+    }
+    case KVP_TYPE_BINARY:
+    {
+        const guchar *bin;
+        guint64 size;
+
+        snap_get(r, &size, sizeof(size));
+        if (!r->ok || size > (guint64) (r->end - r->pos))
+        {
+            r->ok = FALSE;
+            return NULL;
+        }
+        bin = r->pos;
+        r->pos += size;
+        return build ? kvp_value_new_binary(bin, size) : NULL;
+    }
+    case KVP_TYPE_GLIST:
+    {
+        GList *list = NULL;
+        guint32 i, n = snap_get_u32(r);
+
+        for (i = 0; i < n && r->ok; i++)
+        {
+            KvpValue *val = snap_get_value(r);
+            if (val)
+                list = g_list_prepend(list, val);
+        }
+        return build ? kvp_value_new_glist_nc(g_list_reverse(list)) : NULL;
+    }
+    case KVP_TYPE_FRAME:
+    {
+        KvpFrame *frame = build ? kvp_frame_new() : NULL;
+
+        snap_get_frame(r, frame);
+        return build ? kvp_value_new_frame_nc(frame) : NULL;
+    }
+    case KVP_TYPE_GDATE:
+    {
+        guint32 julian = snap_get_u32(r);
+        GDate val;
+
+        g_date_clear(&val, 1);
+        if (g_date_valid_julian(julian))
+            g_date_set_julian(&val, julian);
+        return build ? kvp_value_new_gdate(val) : NULL;
+    }
+    default:
+        r->ok = FALSE;
+        return NULL;
+    }
+}
+
+/* Reads a frame's slots into frame, which is NULL while checking. */
+static void
+snap_get_frame(snap_reader *r, KvpFrame *frame)
+{
+    guint32 i, n = snap_get_u32(r);
+
+    for (i = 0; i < n && r->ok; i++)
+    {
+        const gchar *key = snap_get_string(r);
+        KvpValue *value = snap_get_value(r);
+
+        if (!key)
+            r->ok = FALSE;
+        if (frame && key && value)
+            kvp_frame_set_slot_nc(frame, key, value);
+        else if (value)
+            kvp_value_delete(value);
+    }
+}
+
+static void
+snap_read_strings(snap_reader *r)
+{
+    guint32 i;
+
+    r->n_strings = snap_get_u32(r);
+    if (r->n_strings > (gsize) (r->end - r->pos) / (sizeof(guint32) + 1))
+    {
+        r->ok = FALSE;
+        return;
+    }
+
+    r->strings = g_new(const gchar *, r->n_strings);
+    for (i = 0; i < r->n_strings && r->ok; i++)
+    {
+        guint32 len = snap_get_u32(r);
+
+        if (!r->ok || (gsize) (r->end - r->pos) <= len || r->pos[len] != '\0')
+        {
+            r->ok = FALSE;
+            return;
+        }
+        r->strings[i] = (const gchar *) r->pos;
+        r->pos += len + 1;
+    }
+}
+
+static void
+snap_read_book(snap_reader *r)
+{
+    GncGUID guid;
+
+    snap_get_guid(r, &guid);
+    if (r->book)
+        qof_instance_set_guid(QOF_INSTANCE(r->book), &guid);
+    snap_get_frame(r, r->book ? qof_book_get_slots(r->book) : NULL);
+}
+
+static void
+snap_read_commodities(snap_reader *r)
+{
+    gnc_commodity_table *table = NULL;
+    guint32 i, n = snap_get_u32(r);
+
+    if (r->book)
+        table = gnc_commodity_table_get_table(r->book);
+
+    for (i = 0; i < n && r->ok; i++)
+    {
+        const gchar *space = snap_get_string(r);
+        const gchar *mnemonic = snap_get_string(r);
+        const gchar *fullname = snap_get_string(r);
+        const gchar *cusip = snap_get_string(r);
+        guint32 fraction = snap_get_u32(r);
+        guint32 quote_flag = snap_get_u32(r);
+        const gchar *source = snap_get_string(r);
+        const gchar *tz = snap_get_string(r);
+        gnc_commodity *com = NULL;
+
+        if (!space || !mnemonic)
+            r->ok = FALSE;
+
+        if (table && r->ok)
+        {
+            /* The default currencies are already in the table; like the
+             * XML parser, only their quote settings and slots come from
+             * the file. */
+            com = gnc_commodity_table_lookup(table, space, mnemonic);
+            if (!com)
+            {
+                com = gnc_commodity_new(r->book, fullname, space, mnemonic,
+                                        cusip, fraction);
+                com = gnc_commodity_table_insert(table, com);
+            }
+
+            gnc_commodity_begin_edit(com);
+            gnc_commodity_set_quote_flag(com, quote_flag);
+            if (source)
+            {
+                gnc_quote_source *qs = gnc_quote_source_lookup_by_internal(source);
+                if (!qs)
+                    qs = gnc_quote_source_add_new(source, FALSE);
+                gnc_commodity_set_quote_source(com, qs);
+            }
+            if (tz)
+                gnc_commodity_set_quote_tz(com, tz);
+        }
+
+        snap_get_frame(r, com ? qof_instance_get_slots(QOF_INSTANCE(com)) : NULL);
+        if (com)
+            gnc_commodity_commit_edit(com);
+        g_ptr_array_add(r->commodities, com);
+    }
+}
+
+/* Accounts are left open for editing, as the XML parser does, so that
+ * adding the transactions doesn't rebalance them split by split.  The
+ * caller commits them once everything is in. */
+static void
+snap_read_accounts(snap_reader *r)
+{
+    guint32 i, j, n = snap_get_u32(r);
+
+    if (r->book && n < G_MAXINT)
+        qof_collection_reserve(qof_book_get_collection(r->book, GNC_ID_ACCOUNT), n);
+
+    for (i = 0; i < n && r->ok; i++)
+    {
+        GncGUID guid;
+        const gchar *name, *type_str, *code, *description;
+        GNCAccountType type = ACCT_TYPE_INVALID;
+        gnc_commodity *com;
+        guint32 scu, non_std, parent_idx, n_lots;
+        Account *acc = NULL;
+
+        snap_get_guid(r, &guid);
+        name = snap_get_string(r);
+        type_str = snap_get_string(r);
+        com = snap_get_ref(r, r->commodities);
+        scu = snap_get_u32(r);
+        non_std = snap_get_u32(r);
+        code = snap_get_string(r);
+        description = snap_get_string(r);
+        parent_idx = snap_get_u32(r);
+
+        if (type_str)
+            type = xaccAccountStringToEnum(type_str);
+
+        /* The root comes first and every other account after its
+         * parent. */
+        if (i == 0)
+        {
+            if (type != ACCT_TYPE_ROOT || parent_idx != SNAP_NONE)
+                r->ok = FALSE;
+        }
+        else if (type == ACCT_TYPE_INVALID || parent_idx >= i)
+        {
+            r->ok = FALSE;
+        }
+
+        if (r->book && r->ok)
+        {
+            acc = xaccMallocAccount(r->book);
+            xaccAccountBeginEdit(acc);
+            xaccAccountSetGUID(acc, &guid);
+            if (name)
+                xaccAccountSetName(acc, name);
+            xaccAccountSetType(acc, type);
+            if (com)
+            {
+                xaccAccountSetCommodity(acc, com);
+                xaccAccountSetCommoditySCU(acc, scu);
+            }
+            if (non_std)
+                xaccAccountSetNonStdSCU(acc, TRUE);
+            if (code)
+                xaccAccountSetCode(acc, code);
+            if (description)
+                xaccAccountSetDescription(acc, description);
+
+            if (i == 0)
+                gnc_book_set_root_account(r->book, acc);
+            else
+                gnc_account_append_child(g_ptr_array_index(r->accounts,
+                                         parent_idx), acc);
+        }
+
+        snap_get_frame(r, acc ? xaccAccountGetSlots(acc) : NULL);
+        g_ptr_array_add(r->accounts, acc);
+
+        n_lots = snap_get_u32(r);
+        for (j = 0; j < n_lots && r->ok; j++)
+        {
+            GNCLot *lot = NULL;
+
+            snap_get_guid(r, &guid);
+            if (acc)
+            {
+                lot = gnc_lot_new(r->book);
+                gnc_lot_set_guid(lot, guid);
+            }
+            snap_get_frame(r, lot ? gnc_lot_get_slots(lot) : NULL);
+            if (lot)
+                xaccAccountInsertLot(acc, lot);
+            g_ptr_array_add(r->lots, lot);
+        }
+    }
+}
+
+static void
+snap_read_split(snap_reader *r, Transaction *trn)
+{
+    GncGUID guid;
+    const gchar *memo, *action;
+    guint32 reconcile;
+    Timespec reconciled;
+    gnc_numeric value, amount;
+    Account *acc;
+    GNCLot *lot;
+    Split *split = NULL;
+
+    snap_get_guid(r, &guid);
+    memo = snap_get_string(r);
+    action = snap_get_string(r);
+    reconcile = snap_get_u32(r);
+    reconciled = snap_get_ts(r);
+    value = snap_get_numeric(r);
+    amount = snap_get_numeric(r);
+    acc = snap_get_ref(r, r->accounts);
+    lot = snap_get_ref(r, r->lots);
+
+    if (trn && r->ok)
+    {
+        split = xaccMallocSplit(r->book);
+        xaccSplitSetGUID(split, &guid);
+        if (memo)
+            xaccSplitSetMemo(split, memo);
+        if (action)
+            xaccSplitSetAction(split, action);
+        xaccSplitSetReconcile(split, (char) reconcile);
+        if (reconciled.tv_sec || reconciled.tv_nsec)
+            xaccSplitSetDateReconciledTS(split, &reconciled);
+        xaccSplitSetValue(split, value);
+        xaccSplitSetAmount(split, amount);
+        if (acc)
+            xaccAccountInsertSplit(acc, split);
+        if (lot)
+            gnc_lot_add_split(lot, split);
+    }
+
+    snap_get_frame(r, split ? xaccSplitGetSlots(split) : NULL);
+    if (split)
+        xaccTransAppendSplit(trn, split);
+}
+
+static void
+snap_read_transactions(snap_reader *r)
+{
+    guint32 i, j, n = snap_get_u32(r);
+
+    if (r->book && n < G_MAXINT / 2)
+    {
+        qof_collection_reserve(qof_book_get_collection(r->book, GNC_ID_TRANS), n);
+        qof_collection_reserve(qof_book_get_collection(r->book, GNC_ID_SPLIT), 2 * n);
+    }
+
+    for (i = 0; i < n && r->ok; i++)
+    {
+        GncGUID guid;
+        gnc_commodity *currency;
+        const gchar *num, *description;
+        Timespec posted, entered;
+        Transaction *trn = NULL;
+        guint32 n_splits;
+
+        snap_get_guid(r, &guid);
+        currency = snap_get_ref(r, r->commodities);
+        num = snap_get_string(r);
+        posted = snap_get_ts(r);
+        entered = snap_get_ts(r);
+        description = snap_get_string(r);
+
+        if (r->book && r->ok)
+        {
+            trn = xaccMallocTransaction(r->book);
+            xaccTransBeginEdit(trn);
+            xaccTransSetGUID(trn, &guid);
+            xaccTransSetCurrency(trn, currency);
+            if (num)
+                xaccTransSetNum(trn, num);
+            xaccTransSetDatePostedTS(trn, &posted);
+            xaccTransSetDateEnteredTS(trn, &entered);
+            if (description)
+                xaccTransSetDescription(trn, description);
+        }
+        snap_get_frame(r, trn ? xaccTransGetSlots(trn) : NULL);
+
+        n_splits = snap_get_u32(r);
+        for (j = 0; j < n_splits && r->ok; j++)
+            snap_read_split(r, trn);
+
+        if (trn)
+            xaccTransCommitEdit(trn);
+    }
+}
+
+static void
+snap_read_prices(snap_reader *r)
+{
+    GNCPriceDB *db = r->book ? gnc_pricedb_get_db(r->book) : NULL;
+    guint32 i, n = snap_get_u32(r);
+
+    for (i = 0; i < n && r->ok; i++)
+    {
+        GncGUID guid;
+        gnc_commodity *commodity, *currency;
+        Timespec time;
+        const gchar *source, *type;
+        gnc_numeric value;
+        GNCPrice *price;
+
+        snap_get_guid(r, &guid);
+        commodity = snap_get_ref(r, r->commodities);
+        currency = snap_get_ref(r, r->commodities);
+        time = snap_get_ts(r);
+        source = snap_get_string(r);
+        type = snap_get_string(r);
+        value = snap_get_numeric(r);
+
+        if (!db || !r->ok || !commodity || !currency)
+            continue;
+
+        price = gnc_price_create(r->book);
+        gnc_price_begin_edit(price);
+        gnc_price_set_guid(price, &guid);
+        gnc_price_set_commodity(price, commodity);
+        gnc_price_set_currency(price, currency);
+        gnc_price_set_time(price, time);
+        if (source)
+            gnc_price_set_source(price, source);
+        if (type)
+            gnc_price_set_typestr(price, type);
+        gnc_price_set_value(price, value);
+        gnc_price_commit_edit(price);
+        gnc_pricedb_add_price(db, price);
+        gnc_price_unref(price);
+    }
+}
+
+static gboolean
+snap_read_sections(snap_reader *r, const guchar *start)
+{
+    r->pos = start;
+    r->ok = TRUE;
+    g_ptr_array_set_size(r->commodities, 0);
+    g_ptr_array_set_size(r->accounts, 0);
+    g_ptr_array_set_size(r->lots, 0);
+
+    if (snap_expect_section(r, SNAP_SECTION_BOOK))
+        snap_read_book(r);
+    if (snap_expect_section(r, SNAP_SECTION_COMMODITIES))
+        snap_read_commodities(r);
+    if (snap_expect_section(r, SNAP_SECTION_ACCOUNTS))
+        snap_read_accounts(r);
+    if (snap_expect_section(r, SNAP_SECTION_TRANSACTIONS))
+        snap_read_transactions(r);
+    if (snap_expect_section(r, SNAP_SECTION_PRICES))
+        snap_read_prices(r);
+    snap_expect_section(r, SNAP_SECTION_END);
+
+    return r->ok && r->pos == r->end;
+}
+
+static gboolean
+snap_header_ok(const guchar *data, gsize len, const char *datafile,
+               const struct stat *source)
+{
+    snap_header hdr;
+    guint8 digest[SNAP_DIGEST_LEN];
+
+    if (len < sizeof(hdr))
+        return FALSE;
+    memcpy(&hdr, data, sizeof(hdr));
+
+    if (memcmp(hdr.magic, SNAP_MAGIC, sizeof(hdr.magic)) != 0
+            || hdr.version != SNAP_VERSION
+            || hdr.byte_order != SNAP_BYTE_ORDER)
+    {
+        PINFO("not a snapshot this version can read");
+        return FALSE;
+    }
+    if (hdr.source_size != (gint64) source->st_size
+            || hdr.source_mtime != (gint64) source->st_mtime
+            || !snap_file_digest(datafile, digest)
+            || memcmp(hdr.source_digest, digest, sizeof(digest)) != 0)
+    {
+        PINFO("data file changed since the snapshot was written");
+        return FALSE;
+    }
+    if (hdr.body_len != len - sizeof(hdr)
+            || hdr.crc != snap_crc(crc32(0L, Z_NULL, 0),
+                                   data + sizeof(hdr), len - sizeof(hdr)))
+    {
+        PWARN("snapshot is damaged");
+        return FALSE;
+    }
+    return TRUE;
+}
+
+gboolean
+gnc_xml_snapshot_load(QofBook *book, const char *datafile)
+{
+    snap_reader r;
+    struct stat source;
+    GMappedFile *map;
+    GNCPriceDB *db;
+    Account *root;
+    const guchar *data, *sections;
+    gchar *snap_name;
+    gsize len;
+    gboolean loaded = FALSE;
+    guint i;
+
+    g_return_val_if_fail(book && datafile, FALSE);
+
+    if (g_stat(datafile, &source) != 0)
+        return FALSE;
+
+    snap_name = snap_file_name(datafile);
+    map = g_mapped_file_new(snap_name, FALSE, NULL);
+    g_free(snap_name);
+    if (!map)
+        return FALSE;
+
+    ENTER("book=%p file=%s", book, datafile);
+
+    data = (const guchar *) g_mapped_file_get_contents(map);
+    len = g_mapped_file_get_length(map);
+
+    memset(&r, 0, sizeof(r));
+    r.commodities = g_ptr_array_new();
+    r.accounts = g_ptr_array_new();
+    r.lots = g_ptr_array_new();
+
+    if (!snap_header_ok(data, len, datafile, &source))
+        goto done;
+
+    r.pos = data + sizeof(snap_header);
+    r.end = data + len;
+    r.ok = TRUE;
+    snap_read_strings(&r);
+    sections = r.pos;
+
+    if (!r.ok || !snap_read_sections(&r, sections))
+    {
+        PWARN("snapshot for %s is malformed", datafile);
+        goto done;
+    }
+
+    /* As when parsing the XML file, there's nothing to log and the
+     * objects are only scrubbed once they are all in place. */
+    xaccLogDisable();
+    xaccDisableDataScrubbing();
+    db = gnc_pricedb_get_db(book);
+    gnc_pricedb_set_bulk_update(db, TRUE);
+
+    r.book = book;
+    if (!snap_read_sections(&r, sections))
+        PERR("snapshot for %s changed while loading", datafile);
+
+    gnc_pricedb_set_bulk_update(db, FALSE);
+    xaccEnableDataScrubbing();
+
+    /* The same fixes qof_session_load_from_xml_file_v2_full applies
+     * after parsing, so a book looks the same whichever way it was
+     * loaded. */
+    root = gnc_book_get_root_account(book);
+    xaccAccountTreeScrubQuoteSources(root, gnc_commodity_table_get_table(book));
+    xaccAccountTreeScrubCommodities(root);
+    xaccAccountTreeScrubSplits(root);
+
+    for (i = 0; i < r.accounts->len; i++)
+        xaccAccountCommitEdit(g_ptr_array_index(r.accounts, i));
+
+    xaccLogEnable();
+    loaded = TRUE;
+
+done:
+    g_free(r.strings);
+    g_ptr_array_free(r.commodities, TRUE);
+    g_ptr_array_free(r.accounts, TRUE);
+    g_ptr_array_free(r.lots, TRUE);
+    g_mapped_file_free(map);
+
+    LEAVE("%s", loaded ? "loaded" : "not used");
+    return loaded;
+}
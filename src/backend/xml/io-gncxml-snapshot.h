@@ -0,0 +1,61 @@
+/********************************************************************\
+ * io-gncxml-snapshot.h -- binary snapshot cache for xml data files *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+\********************************************************************/
+
+/**
+ * @file io-gncxml-snapshot.h
+ * @brief Binary snapshot of a book, kept next to its XML data file.
+ *
+ * After every successful save the XML backend also writes
+ * "<datafile>.snapshot": a checksummed, host byte order image of the
+ * commodities, accounts, lots, transactions and prices of the book.
+ * Strings are stored once in a table and objects refer to each other
+ * by array index, so the file can be mapped and turned into engine
+ * objects without any text parsing.  The snapshot records the size,
+ * modification time and SHA-256 digest of the XML file it was taken
+ * from; if the data file has changed since, or the snapshot is damaged
+ * or from another version, it is ignored and the XML file is parsed as
+ * usual.  A loaded book gets the same account tree scrubs as a parsed
+ * one.
+ *
+ * Books holding objects the snapshot does not describe (scheduled
+ * transactions, budgets, business objects) never get a snapshot.
+ */
+
+#ifndef IO_GNCXML_SNAPSHOT_H
+#define IO_GNCXML_SNAPSHOT_H
+
+#include <glib.h>
+
+#include "qof.h"
+
+/** Write the snapshot for a book that was just saved to datafile.
+ *  Any stale snapshot is removed if the book can't be described. */
+gboolean gnc_xml_snapshot_write(QofBook *book, const char *datafile);
+
+/** Fill an empty book from the snapshot of datafile.  Returns FALSE,
+ *  without touching the book, if there is no usable snapshot. */
+gboolean gnc_xml_snapshot_load(QofBook *book, const char *datafile);
+
+/** Remove the snapshot belonging to datafile, if there is one. */
+void gnc_xml_snapshot_remove(const char *datafile);
+
+#endif /* IO_GNCXML_SNAPSHOT_H */
@@ -97,6 +97,13 @@ struct file_backend
 #define GNC_V2_STRING "gnc-v2"
 extern const gchar *gnc_v2_book_version_string;        /* see gnc-book-xml-v2 */
 
+static FILE *try_gz_open (const char *filename, const char *perms,
+                          gboolean use_gzip, gboolean compress);
+static gboolean wait_for_gzip (FILE *file);
+static gboolean is_gzipped_file (const gchar *name);
+static void parse_gz_push_handler (xmlParserCtxtPtr xml_context,
+                                   const gchar *filename);
+
 void
 run_callback(sixtp_gdv2 *data, const char *type)
 {
@@ -395,10 +402,22 @@ gnc_counter_end_handler(gpointer data_for_children,
     else if (safe_strcmp(type, "transaction") == 0)
     {
         sixdata->counter.transactions_total = val;
+        /* Size the collections for what is coming.  The file doesn't
+         * count splits, most transactions have two of them. */
+        if (val > 0 && val < G_MAXINT / 2)
+        {
+            qof_collection_reserve(
+                qof_book_get_collection(sixdata->book, GNC_ID_TRANS), val);
+            qof_collection_reserve(
+                qof_book_get_collection(sixdata->book, GNC_ID_SPLIT), 2 * val);
+        }
     }
     else if (safe_strcmp(type, "account") == 0)
     {
         sixdata->counter.accounts_total = val;
+        if (val > 0 && val < G_MAXINT)
+            qof_collection_reserve(
+                qof_book_get_collection(sixdata->book, GNC_ID_ACCOUNT), val);
     }
     else if (safe_strcmp(type, "book") == 0)
     {
@@ -750,6 +769,14 @@ qof_session_load_from_xml_file_v2_full(
     xaccLogDisable ();
     xaccDisableDataScrubbing();
 
+    /* Inflate compressed files on helper threads and feed the parser as
+     * the data arrives, rather than letting libxml2 inflate them inline. */
+    if (!push_handler && is_gzipped_file(fbe->fullpath))
+    {
+        push_handler = (sixtp_push_handler) parse_gz_push_handler;
+        push_user_data = fbe->fullpath;
+    }
+
     if (push_handler)
     {
         gpointer parse_result = NULL;
@@ -1093,14 +1120,8 @@ static int
 xml_add_trn_data(Transaction *t, gpointer data)
 {
     struct file_backend *be_data = data;
-    xmlNodePtr node;
 
-    node = gnc_transaction_dom_tree_create(t);
-
-    xmlElemDump(be_data->out, NULL, node);
-    xmlFreeNode(node);
-
-    if (ferror(be_data->out) || fprintf(be_data->out, "\n") < 0)
+    if (!gnc_transaction_write_xml_stream(be_data->out, t))
         return -1;
 
     be_data->gd->counter.transactions_loaded++;
@@ -1319,6 +1340,428 @@ gnc_book_write_accounts_to_xml_filehandle_v2(QofBackend *be, QofBook *book, FILE
 
 #define BUFLEN 4096
 
+/* Compressed files are written as a series of independent gzip members,
+ * each holding GZ_BLOCK_SIZE bytes of XML, so that they can be deflated
+ * and inflated on several cores at once.  Plain gzip and zlib read such
+ * files as one concatenated stream.  Every member carries an extra field
+ * with subfield id GZ_BLOCK_SI1 GZ_BLOCK_SI2 whose 4 byte payload is the
+ * total size of the member; the reader uses it to hand whole members to
+ * the workers without having to inflate them first. */
+#define GZ_BLOCK_SIZE (256 * 1024)
+#define GZ_BLOCK_SI1 'G'
+#define GZ_BLOCK_SI2 'C'
+#define GZ_BLOCK_HEADER_LEN 20
+#define GZ_BLOCK_TRAILER_LEN 8
+/* Sanity limit for members read back from a file. */
+#define GZ_BLOCK_MAX_MEMBER (16 * 1024 * 1024)
+
+typedef struct
+{
+    GMutex *mutex;
+    GCond *cond;
+} gz_block_sync_t;
+
+typedef struct
+{
+    gz_block_sync_t *sync;
+    guchar *in;
+    gsize in_len;
+    guchar *out;
+    gsize out_len;
+    gboolean ok;
+    gboolean done;
+} gz_block_t;
+
+static void
+gz_put_le32(guchar *buf, guint32 val)
+{
+    buf[0] = val & 0xff;
+    buf[1] = (val >> 8) & 0xff;
+    buf[2] = (val >> 16) & 0xff;
+    buf[3] = (val >> 24) & 0xff;
+}
+
+static guint32
+gz_get_le32(const guchar *buf)
+{
+    return (guint32) buf[0] | ((guint32) buf[1] << 8) |
+           ((guint32) buf[2] << 16) | ((guint32) buf[3] << 24);
+}
+
+/* Returns the total member size stored in a block header, or 0 if the
+ * header is not one of ours. */
+static guint32
+gz_block_member_size(const guchar *header)
+{
+    if (header[0] != 037 || header[1] != 0213 || header[2] != Z_DEFLATED
+            || header[3] != 4 /* FEXTRA only */
+            || header[10] != 8 || header[11] != 0
+            || header[12] != GZ_BLOCK_SI1 || header[13] != GZ_BLOCK_SI2
+            || header[14] != 4 || header[15] != 0)
+        return 0;
+
+    return gz_get_le32(header + 16);
+}
+
+static gboolean
+gz_is_block_file(const gchar *filename)
+{
+    guchar header[GZ_BLOCK_HEADER_LEN];
+    gboolean retval = FALSE;
+    FILE *file = g_fopen(filename, "rb");
+
+    if (!file)
+        return FALSE;
+    if (fread(header, 1, GZ_BLOCK_HEADER_LEN, file) == GZ_BLOCK_HEADER_LEN)
+        retval = gz_block_member_size(header) != 0;
+    fclose(file);
+
+    return retval;
+}
+
+static gint
+gz_block_n_workers(void)
+{
+#ifdef _SC_NPROCESSORS_ONLN
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    if (n > 1)
+        return (gint) MIN(n, 32);
+#endif
+    return 1;
+}
+
+static void
+gz_block_finish(gz_block_t *block, gboolean ok)
+{
+    g_mutex_lock(block->sync->mutex);
+    block->ok = ok;
+    block->done = TRUE;
+    g_cond_broadcast(block->sync->cond);
+    g_mutex_unlock(block->sync->mutex);
+}
+
+static void
+gz_block_wait(gz_block_t *block)
+{
+    g_mutex_lock(block->sync->mutex);
+    while (!block->done)
+        g_cond_wait(block->sync->cond, block->sync->mutex);
+    g_mutex_unlock(block->sync->mutex);
+}
+
+static void
+gz_block_free(gz_block_t *block)
+{
+    g_free(block->in);
+    g_free(block->out);
+    g_free(block);
+}
+
+/* Thread pool worker: turns block->in into a complete gzip member. */
+static void
+gz_block_deflate_func(gz_block_t *block, gpointer unused)
+{
+    z_stream strm;
+    gsize bound;
+    gboolean ok = FALSE;
+
+    memset(&strm, 0, sizeof(strm));
+    if (deflateInit2(&strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS,
+                     8, Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+        gz_block_finish(block, FALSE);
+        return;
+    }
+
+    bound = deflateBound(&strm, block->in_len);
+    block->out = g_malloc(GZ_BLOCK_HEADER_LEN + bound + GZ_BLOCK_TRAILER_LEN);
+
+    strm.next_in = block->in;
+    strm.avail_in = block->in_len;
+    strm.next_out = block->out + GZ_BLOCK_HEADER_LEN;
+    strm.avail_out = bound;
+
+    if (deflate(&strm, Z_FINISH) == Z_STREAM_END)
+    {
+        guchar *out = block->out;
+        gsize len = GZ_BLOCK_HEADER_LEN + strm.total_out;
+
+        memset(out, 0, GZ_BLOCK_HEADER_LEN);
+        out[0] = 037;
+        out[1] = 0213;
+        out[2] = Z_DEFLATED;
+        out[3] = 4;
+        out[9] = 3; /* OS: Unix, as gzip writes */
+        out[10] = 8; /* XLEN */
+        out[12] = GZ_BLOCK_SI1;
+        out[13] = GZ_BLOCK_SI2;
+        out[14] = 4;
+        gz_put_le32(out + len, crc32(crc32(0L, Z_NULL, 0), block->in,
+                                     block->in_len));
+        gz_put_le32(out + len + 4, block->in_len);
+        len += GZ_BLOCK_TRAILER_LEN;
+        gz_put_le32(out + 16, len);
+
+        block->out_len = len;
+        ok = TRUE;
+    }
+    deflateEnd(&strm);
+
+    g_free(block->in);
+    block->in = NULL;
+    gz_block_finish(block, ok);
+}
+
+/* Thread pool worker: inflates the gzip member in block->in.  zlib checks
+ * the CRC and length in the trailer. */
+static void
+gz_block_inflate_func(gz_block_t *block, gpointer unused)
+{
+    z_stream strm;
+    gboolean ok = FALSE;
+
+    block->out_len = gz_get_le32(block->in + block->in_len - 4);
+    if (block->out_len > GZ_BLOCK_MAX_MEMBER)
+    {
+        gz_block_finish(block, FALSE);
+        return;
+    }
+    block->out = g_malloc(block->out_len + 1);
+
+    memset(&strm, 0, sizeof(strm));
+    if (inflateInit2(&strm, MAX_WBITS + 16) != Z_OK)
+    {
+        gz_block_finish(block, FALSE);
+        return;
+    }
+
+    strm.next_in = block->in;
+    strm.avail_in = block->in_len;
+    strm.next_out = block->out;
+    /* One spare byte, so that a member longer than its trailer claims
+     * cannot end in Z_STREAM_END. */
+    strm.avail_out = block->out_len + 1;
+
+    if (inflate(&strm, Z_FINISH) == Z_STREAM_END
+            && strm.total_out == block->out_len && strm.avail_in == 0)
+        ok = TRUE;
+    inflateEnd(&strm);
+
+    g_free(block->in);
+    block->in = NULL;
+    gz_block_finish(block, ok);
+}
+
+static gboolean
+gz_write_all(gint fd, const guchar *buf, gsize len)
+{
+    while (len > 0)
+    {
+        gssize written =
+#if COMPILER(MSVC)
+            _write
+#else
+            write
+#endif
+            (fd, buf, len);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return FALSE;
+        }
+        buf += written;
+        len -= written;
+    }
+    return TRUE;
+}
+
+/* Reads from fd until buf is full or the writer closes the pipe.  Returns
+ * the number of bytes read or -1 on error. */
+static gssize
+gz_read_full(gint fd, guchar *buf, gsize len)
+{
+    gsize total = 0;
+
+    while (total < len)
+    {
+        gssize bytes = read(fd, buf + total, len - total);
+        if (bytes == 0)
+            break;
+        if (bytes < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        total += bytes;
+    }
+    return total;
+}
+
+/* Waits for the oldest block in the queue and passes its output on, to
+ * the compressed file when saving or to the pipe when loading. */
+static gboolean
+gz_block_flush_one(GQueue *pending, FILE *file, gint fd)
+{
+    gz_block_t *block = g_queue_pop_head(pending);
+    gboolean ok;
+
+    gz_block_wait(block);
+    ok = block->ok;
+    if (ok)
+    {
+        if (file)
+            ok = fwrite(block->out, 1, block->out_len, file) == block->out_len;
+        else
+            ok = gz_write_all(fd, block->out, block->out_len);
+    }
+    gz_block_free(block);
+
+    return ok;
+}
+
+typedef gz_block_t *(*gz_block_source)(gz_thread_params_t *params,
+                                       FILE *file, guint index,
+                                       gboolean *eof);
+
+/* Runs a pool of workers over the blocks produced by next_block, keeping
+ * at most two blocks per worker in flight and emitting them in order. */
+static gint
+gz_block_run(gz_thread_params_t *params, FILE *file, GFunc worker,
+             gz_block_source next_block)
+{
+    gz_block_sync_t sync;
+    GThreadPool *pool;
+    GQueue *pending;
+    GError *error = NULL;
+    gint n_workers = gz_block_n_workers();
+    gboolean eof = FALSE;
+    guint index = 0;
+    gint success = 1;
+
+    pool = g_thread_pool_new(worker, NULL, n_workers, FALSE, &error);
+    if (!pool)
+    {
+        g_warning("Could not create threads for (de)compression: %s",
+                  error->message);
+        g_error_free(error);
+        return 0;
+    }
+
+    sync.mutex = g_mutex_new();
+    sync.cond = g_cond_new();
+    pending = g_queue_new();
+
+    while (success && !eof)
+    {
+        gz_block_t *block = next_block(params, file, index++, &eof);
+
+        if (!block)
+        {
+            if (!eof)
+                success = 0;
+            break;
+        }
+
+        block->sync = &sync;
+        g_queue_push_tail(pending, block);
+        g_thread_pool_push(pool, block, NULL);
+
+        while (success && g_queue_get_length(pending) >= 2 * n_workers)
+            if (!gz_block_flush_one(pending, params->compress ? file : NULL,
+                                    params->fd))
+                success = 0;
+    }
+
+    /* Drain the queue even after a failure; the workers still reference
+     * the blocks. */
+    while (!g_queue_is_empty(pending))
+        if (!gz_block_flush_one(pending, params->compress ? file : NULL,
+                                params->fd))
+            success = 0;
+
+    g_thread_pool_free(pool, FALSE, TRUE);
+    g_queue_free(pending);
+    g_cond_free(sync.cond);
+    g_mutex_free(sync.mutex);
+
+    return success;
+}
+
+/* Cuts the data arriving on the pipe into blocks.  An empty input still
+ * produces one (empty) member so that the file is valid gzip. */
+static gz_block_t *
+gz_block_next_to_deflate(gz_thread_params_t *params, FILE *file,
+                         guint index, gboolean *eof)
+{
+    gz_block_t *block = g_new0(gz_block_t, 1);
+    gssize bytes;
+
+    block->in = g_malloc(GZ_BLOCK_SIZE);
+    bytes = gz_read_full(params->fd, block->in, GZ_BLOCK_SIZE);
+    if (bytes < 0)
+    {
+        g_warning("Could not read from pipe. The error is '%s' (errno %d)",
+                  g_strerror(errno) ? g_strerror(errno) : "", errno);
+        gz_block_free(block);
+        return NULL;
+    }
+    block->in_len = bytes;
+
+    if (bytes < GZ_BLOCK_SIZE)
+    {
+        *eof = TRUE;
+        if (bytes == 0 && index > 0)
+        {
+            gz_block_free(block);
+            return NULL;
+        }
+    }
+    return block;
+}
+
+/* Reads the next whole member from the compressed file. */
+static gz_block_t *
+gz_block_next_to_inflate(gz_thread_params_t *params, FILE *file,
+                         guint index, gboolean *eof)
+{
+    guchar header[GZ_BLOCK_HEADER_LEN];
+    gz_block_t *block;
+    gsize bytes;
+    guint32 size;
+
+    bytes = fread(header, 1, GZ_BLOCK_HEADER_LEN, file);
+    if (bytes == 0 && feof(file))
+    {
+        *eof = TRUE;
+        return NULL;
+    }
+
+    size = bytes == GZ_BLOCK_HEADER_LEN ? gz_block_member_size(header) : 0;
+    if (size < GZ_BLOCK_HEADER_LEN + GZ_BLOCK_TRAILER_LEN
+            || size > GZ_BLOCK_MAX_MEMBER)
+    {
+        g_warning("Could not read from compressed file '%s'. "
+                  "Bad block header.", params->filename);
+        return NULL;
+    }
+
+    block = g_new0(gz_block_t, 1);
+    block->in = g_malloc(size);
+    block->in_len = size;
+    memcpy(block->in, header, GZ_BLOCK_HEADER_LEN);
+    if (fread(block->in + GZ_BLOCK_HEADER_LEN, 1, size - GZ_BLOCK_HEADER_LEN,
+              file) != size - GZ_BLOCK_HEADER_LEN)
+    {
+        g_warning("Could not read from compressed file '%s'. "
+                  "The file is truncated.", params->filename);
+        gz_block_free(block);
+        return NULL;
+    }
+    return block;
+}
+
 /* Compress or decompress function that is to be run in a separate thread.
  * Returns 1 on success or 0 otherwise, stuffed into a pointer type. */
 static gpointer
@@ -1330,6 +1773,39 @@ gz_thread_func(gz_thread_params_t *params)
     gzFile *file;
     gint success = 1;
 
+    /* Files we write, and files written that way, are handled a block at
+     * a time by a pool of workers; other gzip files are read serially. */
+    if (params->compress || gz_is_block_file(params->filename))
+    {
+        FILE *fp = g_fopen(params->filename, params->compress ? "wb" : "rb");
+
+        if (fp == NULL)
+        {
+            g_warning("Could not open the compressed file '%s'. "
+                      "The error is '%s' (errno %d)", params->filename,
+                      g_strerror(errno) ? g_strerror(errno) : "", errno);
+            success = 0;
+            goto cleanup_gz_thread_func;
+        }
+
+        if (params->compress)
+            success = gz_block_run(params, fp,
+                                   (GFunc) gz_block_deflate_func,
+                                   gz_block_next_to_deflate);
+        else
+            success = gz_block_run(params, fp,
+                                   (GFunc) gz_block_inflate_func,
+                                   gz_block_next_to_inflate);
+
+        if (fclose(fp) != 0)
+        {
+            g_warning("Could not close the compressed file '%s'",
+                      params->filename);
+            success = 0;
+        }
+        goto cleanup_gz_thread_func;
+    }
+
 #ifdef G_OS_WIN32
     {
         gchar *conv_name = g_win32_locale_filename_from_utf8(params->filename);
@@ -1946,6 +2422,41 @@ cleanup_find_ambs:
     return (clean_return) ? n_impossible : -1;
 }
 
+static void
+parse_gz_push_handler (xmlParserCtxtPtr xml_context, const gchar *filename)
+{
+    sixtp_sax_data *sax_data = xml_context->userData;
+    gchar buffer[16 * BUFLEN];
+    gboolean parsing = TRUE;
+    FILE *file;
+    size_t bytes;
+
+    file = try_gz_open(filename, "r", TRUE, FALSE);
+    if (file == NULL)
+    {
+        PWARN("Unable to open file %s", filename);
+        sax_data->parsing_ok = FALSE;
+        return;
+    }
+
+    /* Keep reading after a parse error so that the decompression thread
+     * is not left writing into a closed pipe. */
+    while ((bytes = fread(buffer, 1, sizeof(buffer), file)) > 0)
+    {
+        if (parsing && xmlParseChunk(xml_context, buffer, bytes, 0) != 0)
+            parsing = FALSE;
+    }
+    if (ferror(file))
+        sax_data->parsing_ok = FALSE;
+
+    /* last chunk */
+    xmlParseChunk(xml_context, "", 0, 1);
+
+    fclose(file);
+    if (!wait_for_gzip(file))
+        sax_data->parsing_ok = FALSE;
+}
+
 typedef struct
 {
     gchar *filename;
@@ -25,6 +25,8 @@
 
 #include "config.h"
 #include <glib.h>
+#include <stdio.h>
+#include <string.h>
 
 #include "gnc-xml-helper.h"
 
@@ -261,7 +263,7 @@ add_text_to_node(xmlNodePtr node, gchar *type, gchar *val)
 
 
 static void
-add_kvp_slot(gpointer key, gpointer value, gpointer data);
+add_kvp_slot(const gchar *key, kvp_value *value, gpointer data);
 
 static void
 add_kvp_value_node(xmlNodePtr node, gchar *tag, kvp_value* val)
@@ -351,11 +353,10 @@ add_kvp_value_node(xmlNodePtr node, gchar *tag, kvp_value* val)
         xmlSetProp(val_node, BAD_CAST "type", BAD_CAST "frame");
 
         frame = kvp_value_get_frame (val);
-        if (!frame || !kvp_frame_get_hash (frame))
+        if (kvp_frame_is_empty (frame))
             break;
 
-        g_hash_table_foreach_sorted(kvp_frame_get_hash(frame),
-                                    add_kvp_slot, val_node, (GCompareFunc)strcmp);
+        kvp_frame_for_each_slot(frame, add_kvp_slot, val_node);
     }
     break;
 
@@ -363,16 +364,16 @@ add_kvp_value_node(xmlNodePtr node, gchar *tag, kvp_value* val)
 }
 
 static void
-add_kvp_slot(gpointer key, gpointer value, gpointer data)
+add_kvp_slot(const gchar *key, kvp_value *value, gpointer data)
 {
     xmlNodePtr slot_node;
     xmlNodePtr node = (xmlNodePtr)data;
 
     slot_node = xmlNewChild(node, NULL, BAD_CAST "slot", NULL);
 
-    xmlNewTextChild(slot_node, NULL, BAD_CAST "slot:key", (xmlChar*)key);
+    xmlNewTextChild(slot_node, NULL, BAD_CAST "slot:key", BAD_CAST key);
 
-    add_kvp_value_node(slot_node, "slot:value", (kvp_value*)value);
+    add_kvp_value_node(slot_node, "slot:value", value);
 }
 
 xmlNodePtr
@@ -380,26 +381,407 @@ kvp_frame_to_dom_tree(const char *tag, const kvp_frame *frame)
 {
     xmlNodePtr ret;
 
-    if (!frame)
+    if (kvp_frame_is_empty(frame))
     {
         return NULL;
     }
 
-    if (!kvp_frame_get_hash(frame))
+    ret = xmlNewNode(NULL, BAD_CAST tag);
+
+    /* Slots come out sorted by key */
+    kvp_frame_for_each_slot((kvp_frame *) frame, add_kvp_slot, ret);
+
+    return ret;
+}
+
+
+/***********************************************************************/
+/* Streaming generators.
+ *
+ * These write the same bytes that xmlElemDump() produces for the trees
+ * built above, without allocating the intermediate DOM nodes.  Each one
+ * writes the indentation for 'level', the element and a trailing
+ * newline; nothing is written in the cases where the corresponding DOM
+ * generator returns NULL.  Write errors are left for the caller to pick
+ * up with ferror().
+ */
+
+/* libxml2 indents two spaces per level and stops at 30 levels. */
+#define XML_STREAM_INDENT_MAX 30
+
+void
+xml_stream_indent(FILE *out, int level)
+{
+    static const char spaces[] =
+        "                                                            ";
+
+    if (level > XML_STREAM_INDENT_MAX)
+        level = XML_STREAM_INDENT_MAX;
+    if (level > 0)
+        fwrite(spaces, 1, 2 * level, out);
+}
+
+void
+xml_stream_escape_text(FILE *out, const char *str)
+{
+    const char *run = str;
+    const char *p;
+
+    for (p = str; *p; p++)
     {
-        return NULL;
+        const char *ent;
+
+        switch (*p)
+        {
+        case '<':
+            ent = "&lt;";
+            break;
+        case '>':
+            ent = "&gt;";
+            break;
+        case '&':
+            ent = "&amp;";
+            break;
+        case '\r':
+            ent = "&#13;";
+            break;
+        default:
+            continue;
+        }
+        if (p > run)
+            fwrite(run, 1, p - run, out);
+        fputs(ent, out);
+        run = p + 1;
     }
+    if (p > run)
+        fwrite(run, 1, p - run, out);
+}
+
+/* Opening tag, with an optional type attribute, for an element that will
+ * have children. */
+static void
+xml_stream_open(FILE *out, int level, const char *tag, const char *type)
+{
+    xml_stream_indent(out, level);
+    if (type)
+        fprintf(out, "<%s type=\"%s\">", tag, type);
+    else
+        fprintf(out, "<%s>", tag);
+}
 
-    if (g_hash_table_size(kvp_frame_get_hash(frame)) == 0)
+static void
+xml_stream_close(FILE *out, const char *tag)
+{
+    fprintf(out, "</%s>\n", tag);
+}
+
+static void
+xml_stream_empty(FILE *out, int level, const char *tag, const char *type)
+{
+    xml_stream_indent(out, level);
+    if (type)
+        fprintf(out, "<%s type=\"%s\"/>\n", tag, type);
+    else
+        fprintf(out, "<%s/>\n", tag);
+}
+
+/* Element holding a text node, as built by xmlNewTextChild(): a NULL
+ * string gives an empty element, an empty string an empty text node. */
+static void
+xml_stream_text(FILE *out, int level, const char *tag, const char *type,
+                const char *str)
+{
+    if (!str)
     {
-        return NULL;
+        xml_stream_empty(out, level, tag, type);
+        return;
     }
+    xml_stream_open(out, level, tag, type);
+    xml_stream_escape_text(out, str);
+    xml_stream_close(out, tag);
+}
 
-    ret = xmlNewNode(NULL, BAD_CAST tag);
+/* Element whose content was set with xmlNodeAddContent() or
+ * xmlNodeSetContent(), neither of which adds a node for an empty
+ * string. */
+static void
+xml_stream_content(FILE *out, int level, const char *tag, const char *type,
+                   const char *str)
+{
+    xml_stream_text(out, level, tag, type, (str && *str) ? str : NULL);
+}
 
-    g_hash_table_foreach_sorted(kvp_frame_get_hash(frame),
-                                add_kvp_slot, ret, (GCompareFunc)strcmp);
+void
+text_to_xml_stream(FILE *out, int level, const char *tag, const char *str)
+{
+    g_return_if_fail(tag);
+    g_return_if_fail(str);
+    xml_stream_content(out, level, tag, NULL, str);
+}
 
-    return ret;
+void
+text_child_to_xml_stream(FILE *out, int level, const char *tag,
+                         const char *str)
+{
+    xml_stream_text(out, level, tag, NULL, str);
 }
 
+void
+guid_to_xml_stream(FILE *out, int level, const char *tag, const GncGUID* gid)
+{
+    char guid_str[GUID_ENCODING_LENGTH + 1];
+
+    if (!guid_to_string_buff(gid, guid_str))
+    {
+        PERR("guid_to_string_buff failed\n");
+        return;
+    }
+
+    xml_stream_content(out, level, tag, "guid", guid_str);
+}
+
+void
+commodity_ref_to_xml_stream(FILE *out, int level, const char *tag,
+                            const gnc_commodity *c)
+{
+    g_return_if_fail(c);
+
+    if (!gnc_commodity_get_namespace(c) || !gnc_commodity_get_mnemonic(c))
+    {
+        return;
+    }
+
+    xml_stream_open(out, level, tag, NULL);
+    fputc('\n', out);
+    text_child_to_xml_stream(out, level + 1, "cmdty:space",
+                       gnc_commodity_get_namespace_compat(c));
+    text_child_to_xml_stream(out, level + 1, "cmdty:id",
+                       gnc_commodity_get_mnemonic(c));
+    xml_stream_indent(out, level);
+    xml_stream_close(out, tag);
+}
+
+static void
+timespec_to_xml_stream_typed(FILE *out, int level, const char *tag,
+                             const char *type, const Timespec *spec)
+{
+    gchar *date_str;
+
+    g_return_if_fail(spec);
+
+    date_str = timespec_sec_to_string(spec);
+    if (!date_str)
+    {
+        return;
+    }
+
+    xml_stream_open(out, level, tag, type);
+    fputc('\n', out);
+    text_child_to_xml_stream(out, level + 1, "ts:date", date_str);
+    if (spec->tv_nsec > 0)
+    {
+        gchar *ns_str = timespec_nsec_to_string(spec);
+        if (ns_str)
+        {
+            text_child_to_xml_stream(out, level + 1, "ts:ns", ns_str);
+            g_free(ns_str);
+        }
+    }
+    xml_stream_indent(out, level);
+    xml_stream_close(out, tag);
+
+    g_free(date_str);
+}
+
+void
+timespec_to_xml_stream(FILE *out, int level, const char *tag,
+                       const Timespec *spec)
+{
+    timespec_to_xml_stream_typed(out, level, tag, NULL, spec);
+}
+
+static void
+gdate_to_xml_stream_typed(FILE *out, int level, const char *tag,
+                          const char *type, const GDate *date)
+{
+    gchar date_str[512];
+
+    g_return_if_fail(date);
+
+    g_date_strftime(date_str, sizeof(date_str), "%Y-%m-%d", date);
+
+    xml_stream_open(out, level, tag, type);
+    fputc('\n', out);
+    text_child_to_xml_stream(out, level + 1, "gdate", date_str);
+    xml_stream_indent(out, level);
+    xml_stream_close(out, tag);
+}
+
+void
+gnc_numeric_to_xml_stream(FILE *out, int level, const char *tag,
+                          const gnc_numeric *num)
+{
+    gchar *numstr;
+
+    g_return_if_fail(num);
+
+    numstr = gnc_numeric_to_string(*num);
+    g_return_if_fail(numstr);
+
+    xml_stream_content(out, level, tag, NULL, numstr);
+
+    g_free(numstr);
+}
+
+struct kvp_stream_data
+{
+    FILE *out;
+    int level;
+};
+
+static void
+add_kvp_slot_to_stream(const gchar *key, kvp_value *value, gpointer data);
+
+static void
+kvp_value_to_xml_stream(FILE *out, int level, const char *tag,
+                        kvp_value *val)
+{
+    gchar *tmp_str;
+
+    switch (kvp_value_get_type(val))
+    {
+    case KVP_TYPE_GINT64:
+        tmp_str = g_strdup_printf("%" G_GINT64_FORMAT,
+                                  kvp_value_get_gint64(val));
+        xml_stream_content(out, level, tag, "integer", tmp_str);
+        g_free(tmp_str);
+        break;
+    case KVP_TYPE_DOUBLE:
+        tmp_str = double_to_string(kvp_value_get_double(val));
+        xml_stream_content(out, level, tag, "double", tmp_str);
+        g_free(tmp_str);
+        break;
+    case KVP_TYPE_NUMERIC:
+        tmp_str = gnc_numeric_to_string(kvp_value_get_numeric(val));
+        xml_stream_content(out, level, tag, "numeric", tmp_str);
+        g_free(tmp_str);
+        break;
+    case KVP_TYPE_STRING:
+        xml_stream_text(out, level, tag, "string", kvp_value_get_string(val));
+        break;
+    case KVP_TYPE_GUID:
+    {
+        char guid_str[GUID_ENCODING_LENGTH + 1];
+
+        guid_to_string_buff(kvp_value_get_guid(val), guid_str);
+        xml_stream_content(out, level, tag, "guid", guid_str);
+    }
+    break;
+    case KVP_TYPE_TIMESPEC:
+    {
+        Timespec ts = kvp_value_get_timespec(val);
+
+        timespec_to_xml_stream_typed(out, level, tag, "timespec", &ts);
+    }
+    break;
+    case KVP_TYPE_GDATE:
+    {
+        GDate d = kvp_value_get_gdate(val);
+
+        gdate_to_xml_stream_typed(out, level, tag, "gdate", &d);
+    }
+    break;
+    case KVP_TYPE_BINARY:
+    {
+        guint64 size;
+        void *binary_data = kvp_value_get_binary(val, &size);
+
+        if (!binary_data)
+        {
+            xml_stream_empty(out, level, tag, "binary");
+            g_return_if_fail(binary_data);
+        }
+        tmp_str = binary_to_string(binary_data, size);
+        xml_stream_content(out, level, tag, "binary", tmp_str);
+        g_free(tmp_str);
+    }
+    break;
+    case KVP_TYPE_GLIST:
+    {
+        GList *cursor = kvp_value_get_glist(val);
+
+        if (!cursor)
+        {
+            xml_stream_empty(out, level, tag, "list");
+            break;
+        }
+        xml_stream_open(out, level, tag, "list");
+        fputc('\n', out);
+        for (; cursor; cursor = cursor->next)
+        {
+            kvp_value_to_xml_stream(out, level + 1, "slot:value",
+                                    (kvp_value*)cursor->data);
+        }
+        xml_stream_indent(out, level);
+        xml_stream_close(out, tag);
+    }
+    break;
+    case KVP_TYPE_FRAME:
+    {
+        kvp_frame *frame = kvp_value_get_frame(val);
+        struct kvp_stream_data data;
+
+        if (kvp_frame_is_empty(frame))
+        {
+            xml_stream_empty(out, level, tag, "frame");
+            break;
+        }
+        xml_stream_open(out, level, tag, "frame");
+        fputc('\n', out);
+        data.out = out;
+        data.level = level + 1;
+        kvp_frame_for_each_slot(frame, add_kvp_slot_to_stream, &data);
+        xml_stream_indent(out, level);
+        xml_stream_close(out, tag);
+    }
+    break;
+    default:
+        xml_stream_empty(out, level, tag, NULL);
+        break;
+    }
+}
+
+static void
+add_kvp_slot_to_stream(const gchar *key, kvp_value *value, gpointer data)
+{
+    struct kvp_stream_data *sd = data;
+
+    xml_stream_open(sd->out, sd->level, "slot", NULL);
+    fputc('\n', sd->out);
+    text_child_to_xml_stream(sd->out, sd->level + 1, "slot:key",
+                             key);
+    kvp_value_to_xml_stream(sd->out, sd->level + 1, "slot:value", value);
+    xml_stream_indent(sd->out, sd->level);
+    xml_stream_close(sd->out, "slot");
+}
+
+void
+kvp_frame_to_xml_stream(FILE *out, int level, const char *tag,
+                        const kvp_frame *frame)
+{
+    struct kvp_stream_data data;
+
+    if (kvp_frame_is_empty(frame))
+    {
+        return;
+    }
+
+    xml_stream_open(out, level, tag, NULL);
+    fputc('\n', out);
+    data.out = out;
+    data.level = level + 1;
+    kvp_frame_for_each_slot((kvp_frame *) frame, add_kvp_slot_to_stream,
+                            &data);
+    xml_stream_indent(out, level);
+    xml_stream_close(out, tag);
+}
@@ -25,6 +25,7 @@
 #define SIXTP_DOM_GENERATORS_H
 
 #include <glib.h>
+#include <stdio.h>
 
 #include "gnc-xml-helper.h"
 
@@ -49,4 +50,24 @@ xmlNodePtr recurrence_to_dom_tree(const gchar *tag, const Recurrence *r);
 
 gchar* double_to_string(double value);
 
+/* Streaming versions of the generators above.  Each writes exactly what
+ * xmlElemDump() would write for the corresponding DOM tree at nesting
+ * depth 'level', followed by a newline. */
+void xml_stream_indent(FILE *out, int level);
+void xml_stream_escape_text(FILE *out, const char *str);
+void text_to_xml_stream(FILE *out, int level, const char *tag,
+                        const char *str);
+void text_child_to_xml_stream(FILE *out, int level, const char *tag,
+                              const char *str);
+void guid_to_xml_stream(FILE *out, int level, const char *tag,
+                        const GncGUID* gid);
+void commodity_ref_to_xml_stream(FILE *out, int level, const char *tag,
+                                 const gnc_commodity *c);
+void timespec_to_xml_stream(FILE *out, int level, const char *tag,
+                            const Timespec *spec);
+void gnc_numeric_to_xml_stream(FILE *out, int level, const char *tag,
+                               const gnc_numeric *num);
+void kvp_frame_to_xml_stream(FILE *out, int level, const char *tag,
+                             const kvp_frame *frame);
+
 #endif /* _SIXTP_DOM_GENERATORS_H_ */
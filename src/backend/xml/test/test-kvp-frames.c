@@ -1,6 +1,7 @@
 #include "config.h"
 
 #include <stdlib.h>
+#include <string.h>
 
 #include "test-stuff.h"
 #include "test-engine-stuff.h"
@@ -143,6 +144,72 @@ test_kvp_frames1(void)
     }
 }
 
+static void
+test_kvp_slot_order_helper(const gchar *key, kvp_value *value, gpointer data)
+{
+    const gchar **last = data;
+
+    do_test(*last == NULL || strcmp(*last, key) < 0,
+            "kvp_frame_for_each_slot in key order");
+    *last = key;
+}
+
+static void
+test_kvp_slots(void)
+{
+    static const char *keys[] =
+    {
+        "notes", "online_id", "gains-split", "lot-split", "color",
+        "hbci", "placeholder", "a", "zz", "gains-source",
+    };
+    const guint n_keys = G_N_ELEMENTS(keys);
+    kvp_frame *frame = kvp_frame_new();
+    const gchar *last = NULL;
+    guint i;
+
+    for (i = 0; i < n_keys; i++)
+        kvp_frame_set_gint64(frame, keys[i], i);
+    do_test(kvp_frame_count_slots(frame) == n_keys, "kvp_frame_count_slots");
+
+    for (i = 0; i < n_keys; i++)
+        do_test(kvp_frame_get_gint64(frame, keys[i]) == i,
+                "kvp_frame_get_gint64 after unordered inserts");
+    kvp_frame_for_each_slot(frame, test_kvp_slot_order_helper, &last);
+
+    /* Replacing a slot must not add one */
+    kvp_frame_set_gint64(frame, keys[0], 42);
+    do_test(kvp_frame_count_slots(frame) == n_keys &&
+            kvp_frame_get_gint64(frame, keys[0]) == 42,
+            "kvp_frame_set_gint64 replaces");
+
+    for (i = 0; i < n_keys; i += 2)
+        kvp_frame_set_slot(frame, keys[i], NULL);
+    do_test(kvp_frame_count_slots(frame) == n_keys / 2, "slot removal");
+    for (i = 0; i < n_keys; i++)
+        do_test((kvp_frame_get_slot(frame, keys[i]) != NULL) == (i % 2 == 1),
+                "kvp_frame_get_slot after removal");
+
+    kvp_frame_set_string(frame, "/lot-mgmt//next-id/", "trailing");
+    do_test(kvp_frame_get_slot_path(frame, "lot-mgmt", NULL) == NULL,
+            "path with trailing slash is refused");
+    kvp_frame_set_string(frame, "//lot-mgmt/next/id", "deep");
+    do_test(g_strcmp0(kvp_frame_get_string(frame, "lot-mgmt/next/id"),
+                      "deep") == 0, "kvp_frame_get_string by path");
+    do_test(kvp_frame_get_string(frame, "lot-mgmt/next") == NULL &&
+            kvp_frame_get_frame(frame, "lot-mgmt/next") != NULL,
+            "kvp_frame_get_frame by path");
+    do_test(kvp_frame_get_string(frame, "lot-mgmt/nex/id") == NULL &&
+            kvp_frame_get_string(frame, "lot-mgmt/nextt/id") == NULL,
+            "path segments must match whole keys");
+
+    for (i = 0; i < n_keys; i++)
+        kvp_frame_set_slot(frame, keys[i], NULL);
+    kvp_frame_set_slot(frame, "lot-mgmt", NULL);
+    do_test(kvp_frame_is_empty(frame), "kvp_frame_is_empty after removal");
+
+    kvp_frame_delete(frame);
+}
+
 static void
 test_kvp_printing(void)
 {
@@ -219,6 +286,7 @@ main(int argc, char** argv)
     test_kvp_create_delete();
     test_kvp_printing();
     test_kvp_frames1();
+    test_kvp_slots();
     test_kvp_xml_stuff();
     print_test_results();
     exit(get_rv());
@@ -36,6 +36,7 @@
 #include <glib.h>
 #include <glib-object.h>
 #include <glib/gstdio.h>
+#include <utime.h>
 
 #include "cashobjects.h"
 #include "TransLog.h"
@@ -72,6 +73,107 @@ remove_locks(const char *filename)
     remove_files_pattern(filename, ".LCK");
 }
 
+/* Saving leaves a binary snapshot beside books it can describe; open
+ * the file again through it and check nothing was lost on the way. */
+static void
+test_load_snapshot(const char *filename, QofBook *saved, gboolean ignore_lock)
+{
+    QofSession *session;
+    QofBook *book;
+    gchar *snap_name;
+
+    snap_name = g_strdup_printf("%s.snapshot", filename);
+    if (!g_file_test(snap_name, G_FILE_TEST_EXISTS))
+    {
+        g_free(snap_name);
+        return;
+    }
+
+    session = qof_session_new();
+    remove_locks(filename);
+    qof_session_begin(session, filename, ignore_lock, FALSE, TRUE);
+    qof_session_load(session, NULL);
+    book = qof_session_get_book(session);
+
+    do_test_args(qof_session_get_error(session) == ERR_BACKEND_NO_ERR,
+                 "session load snapshot", __FILE__, __LINE__,
+                 "qof error=%d for file [%s]",
+                 qof_session_get_error(session), filename);
+    do_test_args(guid_equal(qof_book_get_guid(book), qof_book_get_guid(saved)),
+                 "snapshot book guid", __FILE__, __LINE__,
+                 "for file [%s]", filename);
+    do_test_args(gnc_book_count_transactions(book)
+                 == gnc_book_count_transactions(saved),
+                 "snapshot transaction count", __FILE__, __LINE__,
+                 "for file [%s]", filename);
+    do_test_args(xaccAccountEqual(gnc_book_get_root_account(book),
+                                  gnc_book_get_root_account(saved), TRUE),
+                 "snapshot account tree", __FILE__, __LINE__,
+                 "for file [%s]", filename);
+
+    qof_session_end(session);
+    qof_session_destroy(session);
+
+    test_snapshot_stale(filename, saved, ignore_lock);
+    g_unlink(snap_name);
+    g_free(snap_name);
+}
+
+/* Change the name of the first account in the data file without
+ * changing its size or modification time.  The snapshot must notice
+ * and the XML must be parsed again, picking up the new name. */
+static void
+test_snapshot_stale(const char *filename, QofBook *saved, gboolean ignore_lock)
+{
+    QofSession *session;
+    QofBook *book;
+    struct stat buf;
+    struct utimbuf times;
+    gchar *contents, *name;
+    gsize len;
+
+    if (g_stat(filename, &buf) != 0
+            || !g_file_get_contents(filename, &contents, &len, NULL))
+        return;
+    name = g_strstr_len(contents, len, "<act:name>");
+    if (!name || (guchar) contents[0] == 0x1f
+            || !g_ascii_isalpha(name[strlen("<act:name>")]))
+    {
+        g_free(contents);
+        return;
+    }
+    name += strlen("<act:name>");
+    *name = (*name == 'Q') ? 'Z' : 'Q';
+
+    g_file_set_contents(filename, contents, len, NULL);
+    times.actime = buf.st_atime;
+    times.modtime = buf.st_mtime;
+    g_utime(filename, &times);
+
+    session = qof_session_new();
+    remove_locks(filename);
+    qof_session_begin(session, filename, ignore_lock, FALSE, TRUE);
+    qof_session_load(session, NULL);
+    book = qof_session_get_book(session);
+
+    do_test_args(qof_session_get_error(session) == ERR_BACKEND_NO_ERR,
+                 "session load stale snapshot", __FILE__, __LINE__,
+                 "qof error=%d for file [%s]",
+                 qof_session_get_error(session), filename);
+    do_test_args(!xaccAccountEqual(gnc_book_get_root_account(book),
+                                   gnc_book_get_root_account(saved), TRUE),
+                 "stale snapshot ignored", __FILE__, __LINE__,
+                 "for file [%s]", filename);
+
+    qof_session_end(session);
+    qof_session_destroy(session);
+
+    /* Put the file back the way it was */
+    *name = (*name == 'Q') ? 'Z' : 'Q';
+    g_file_set_contents(filename, contents, len, NULL);
+    g_free(contents);
+}
+
 static void
 test_load_file(const char *filename)
 {
@@ -101,6 +203,8 @@ test_load_file(const char *filename)
     /* Uncomment the line below to generate corrected files */
     qof_session_save( session, NULL );
     qof_session_end(session);
+
+    test_load_snapshot(filename, book, ignore_lock);
 }
 
 int
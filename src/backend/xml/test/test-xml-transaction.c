@@ -366,6 +366,50 @@ test_add_transaction(const char *tag, gpointer globaldata, gpointer data)
     return retval;
 }
 
+/* The streaming writer used for saving must produce exactly what
+ * xmlElemDump() writes for the DOM tree. */
+static const gchar *
+stream_and_dom_differ(xmlNodePtr node, Transaction *trn)
+{
+    FILE *dom_out = tmpfile();
+    FILE *stream_out = tmpfile();
+    const gchar *msg = NULL;
+    int c1, c2;
+
+    if (!dom_out || !stream_out)
+    {
+        msg = "could not create temporary files";
+        goto done;
+    }
+
+    xmlElemDump(dom_out, NULL, node);
+    fprintf(dom_out, "\n");
+    if (!gnc_transaction_write_xml_stream(stream_out, trn))
+    {
+        msg = "gnc_transaction_write_xml_stream failed";
+        goto done;
+    }
+
+    rewind(dom_out);
+    rewind(stream_out);
+    do
+    {
+        c1 = getc(dom_out);
+        c2 = getc(stream_out);
+    }
+    while (c1 == c2 && c1 != EOF);
+
+    if (c1 != c2)
+        msg = "streamed output differs from the DOM dump";
+
+done:
+    if (dom_out)
+        fclose(dom_out);
+    if (stream_out)
+        fclose(stream_out);
+    return msg;
+}
+
 static void
 test_transaction(void)
 {
@@ -440,6 +484,13 @@ test_transaction(void)
             success_args("transaction_xml", __FILE__, __LINE__, "%d", i );
         }
 
+        {
+            const gchar *stream_msg = stream_and_dom_differ(test_node, ran_trn);
+            do_test_args(stream_msg == NULL, "transaction_xml_stream",
+                         __FILE__, __LINE__, "%s",
+                         stream_msg ? stream_msg : "");
+        }
+
         filename1 = g_strdup_printf("test_file_XXXXXX");
 
         fd = g_mkstemp(filename1);
@@ -143,11 +143,42 @@ typedef struct AccountPrivate
     gnc_numeric reconciled_balance;
 
     gboolean balance_dirty;     /* balances in splits incorrect */
+    gint balance_dirty_pos;     /* first split whose balance is incorrect */
 
     GList *splits;              /* list of split pointers */
     gboolean sort_dirty;        /* sort order of splits is bad */
 
+    /* The split list above is mirrored by a balanced sequence of its
+     * GList nodes, ordered by xaccSplitOrder(), and a hash mapping each
+     * split to its place in that sequence.  Together they give
+     * logarithmic insertion and removal and constant time membership
+     * tests, while 'splits' itself is always kept in the same order so
+     * that it can still be walked directly. */
+    GSequence *split_seq;       /* sequence of GList nodes in 'splits' */
+    GHashTable *split_index;    /* Split* -> GSequenceIter* */
+
+    /* Splits whose sort key or amount may have changed are taken out
+     * of the sequence (but left in 'splits') until the next sort, at
+     * which point they are put back in their proper place. */
+    GHashTable *split_pending;  /* Split* -> GList* node in 'splits' */
+
+    /* The "online_id" of each split (or, failing that, of its
+     * transaction), as stored by the importers.  Built the first time
+     * an importer looks for a duplicate and then kept up to date as
+     * splits are added to and removed from the account; NULL until
+     * then. */
+    GHashTable *online_ids;     /* online_id -> GPtrArray of Split* */
+    GHashTable *online_id_keys; /* Split* -> its key in online_ids */
+
     LotList   *lots;		/* list of lot pointers */
+
+    /* The lots above that are still open, ordered by the posted date
+     * of their earliest split.  A lot that changes is taken out and
+     * set aside in open_lots_pending; the next lookup puts it back in
+     * its place if it is still open. */
+    GSequence *open_lots;           /* sequence of GNCLot* */
+    GHashTable *open_lot_index;     /* GNCLot* -> GSequenceIter* */
+    GHashTable *open_lots_pending;  /* set of GNCLot* */
     GNCPolicy *policy;		/* Cached pointer to policy method */
 
     /* The "mark" flag can be used by the user to mark this account
@@ -167,6 +198,19 @@ typedef struct AccountPrivate
 \********************************************************************/
 
 static void xaccAccountBringUpToDate (Account *acc);
+static void gnc_account_clear_splits (Account *acc);
+static void open_lots_clear (AccountPrivate *priv);
+static void online_id_index_free (AccountPrivate *priv);
+
+/* Note that the running balances of the splits from position 'pos'
+ * onward (in split order) need to be recomputed. */
+static inline void
+gnc_account_mark_balance_dirty (AccountPrivate *priv, gint pos)
+{
+    if (!priv->balance_dirty || pos < priv->balance_dirty_pos)
+        priv->balance_dirty_pos = pos;
+    priv->balance_dirty = TRUE;
+}
 
 
 /********************************************************************\
@@ -321,9 +365,16 @@ gnc_account_init(Account* acc)
     priv->starting_cleared_balance = gnc_numeric_zero();
     priv->starting_reconciled_balance = gnc_numeric_zero();
     priv->balance_dirty = FALSE;
+    priv->balance_dirty_pos = 0;
 
     priv->splits = NULL;
     priv->sort_dirty = FALSE;
+    priv->split_seq = g_sequence_new(NULL);
+    priv->split_index = g_hash_table_new(g_direct_hash, g_direct_equal);
+    priv->split_pending = g_hash_table_new(g_direct_hash, g_direct_equal);
+    priv->open_lots = g_sequence_new(NULL);
+    priv->open_lot_index = g_hash_table_new(g_direct_hash, g_direct_equal);
+    priv->open_lots_pending = g_hash_table_new(g_direct_hash, g_direct_equal);
 }
 
 static void
@@ -335,6 +386,25 @@ gnc_account_dispose (GObject *acctp)
 static void
 gnc_account_finalize(GObject* acctp)
 {
+    AccountPrivate *priv;
+
+    priv = GET_PRIVATE(acctp);
+    g_list_free(priv->splits);
+    priv->splits = NULL;
+    g_sequence_free(priv->split_seq);
+    priv->split_seq = NULL;
+    g_hash_table_destroy(priv->split_index);
+    priv->split_index = NULL;
+    g_hash_table_destroy(priv->split_pending);
+    priv->split_pending = NULL;
+    online_id_index_free(priv);
+    g_sequence_free(priv->open_lots);
+    priv->open_lots = NULL;
+    g_hash_table_destroy(priv->open_lot_index);
+    priv->open_lot_index = NULL;
+    g_hash_table_destroy(priv->open_lots_pending);
+    priv->open_lots_pending = NULL;
+
     G_OBJECT_CLASS(gnc_account_parent_class)->finalize(acctp);
 }
 
@@ -1114,6 +1184,7 @@ xaccFreeAccount (Account *acc)
         }
         g_list_free (priv->lots);
         priv->lots = NULL;
+        open_lots_clear (priv);
     }
 
     /* Next, clean up the splits */
@@ -1250,8 +1321,7 @@ xaccAccountCommitEdit (Account *acc)
         }
         else
         {
-            g_list_free(priv->splits);
-            priv->splits = NULL;
+            gnc_account_clear_splits(acc);
         }
 
         /* It turns out there's a case where this assertion does not hold:
@@ -1276,6 +1346,7 @@ xaccAccountCommitEdit (Account *acc)
         }
         g_list_free(priv->lots);
         priv->lots = NULL;
+        open_lots_clear(priv);
 
         qof_instance_set_dirty(&acc->inst);
         qof_instance_decrease_editlevel(acc);
@@ -1597,57 +1668,263 @@ gnc_account_set_balance_dirty (Account *acc)
         return;
 
     priv = GET_PRIVATE(acc);
-    priv->balance_dirty = TRUE;
+    gnc_account_mark_balance_dirty(priv, 0);
 }
 
 /********************************************************************\
 \********************************************************************/
 
+/* Compare two nodes of the account's split list by the splits they
+ * hold.  This is the sort function for the split sequence. */
+static gint
+split_link_order (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+    return xaccSplitOrder(((const GList *)a)->data, ((const GList *)b)->data);
+}
+
+/* Hook a list node into the account's split list directly after the
+ * node of the split that precedes it in the split sequence.  'iter' is
+ * the sequence position the node is stored at. */
+static void
+split_link_insert (AccountPrivate *priv, GList *link, GSequenceIter *iter)
+{
+    GList *prev;
+
+    if (g_sequence_iter_is_begin(iter))
+    {
+        link->prev = NULL;
+        link->next = priv->splits;
+        if (priv->splits)
+            priv->splits->prev = link;
+        priv->splits = link;
+        return;
+    }
+
+    prev = g_sequence_get(g_sequence_iter_prev(iter));
+    link->prev = prev;
+    link->next = prev->next;
+    if (link->next)
+        link->next->prev = link;
+    prev->next = link;
+}
+
+/* Rebuild the links of the split list so that they follow the split
+ * sequence.  No nodes are allocated or freed. */
+static void
+split_list_relink (AccountPrivate *priv)
+{
+    GSequenceIter *iter;
+    GList *prev = NULL;
+
+    priv->splits = NULL;
+    for (iter = g_sequence_get_begin_iter(priv->split_seq);
+            !g_sequence_iter_is_end(iter);
+            iter = g_sequence_iter_next(iter))
+    {
+        GList *link = g_sequence_get(iter);
+
+        link->prev = prev;
+        link->next = NULL;
+        if (prev)
+            prev->next = link;
+        else
+            priv->splits = link;
+        prev = link;
+    }
+}
+
+/* Put the pending splits back into the split sequence, each at its
+ * sorted position, moving its list node only if its neighbours
+ * changed.  Balances are marked dirty from the new position; the old
+ * position was already accounted for when the split was set aside. */
+static void
+split_pending_flush (AccountPrivate *priv)
+{
+    GHashTableIter hiter;
+    gpointer key, value;
+
+    g_hash_table_iter_init(&hiter, priv->split_pending);
+    while (g_hash_table_iter_next(&hiter, &key, &value))
+    {
+        GList *link = value;
+        GSequenceIter *iter, *next;
+        GList *prev_link, *next_link;
+
+        iter = g_sequence_insert_sorted(priv->split_seq, link,
+                                        split_link_order, NULL);
+        g_hash_table_insert(priv->split_index, key, iter);
+        gnc_account_mark_balance_dirty(priv,
+                                       g_sequence_iter_get_position(iter));
+
+        prev_link = g_sequence_iter_is_begin(iter) ? NULL :
+                    g_sequence_get(g_sequence_iter_prev(iter));
+        next = g_sequence_iter_next(iter);
+        next_link = g_sequence_iter_is_end(next) ? NULL : g_sequence_get(next);
+        if (link->prev == prev_link && link->next == next_link)
+            continue;
+
+        priv->splits = g_list_remove_link(priv->splits, link);
+        split_link_insert(priv, link, iter);
+    }
+    g_hash_table_remove_all(priv->split_pending);
+}
+
+/* The online_id an importer attached to the split, or to its
+ * transaction if the split itself has none. */
+static const char *
+split_online_id (const Split *s)
+{
+    const char *id;
+    Transaction *trans;
+
+    id = kvp_frame_get_string(xaccSplitGetSlots(s), "online_id");
+    if (id && *id)
+        return id;
+    trans = xaccSplitGetParent(s);
+    if (!trans)
+        return NULL;
+    id = kvp_frame_get_string(xaccTransGetSlots(trans), "online_id");
+    return (id && *id) ? id : NULL;
+}
+
+static void
+online_id_array_free (gpointer data)
+{
+    g_ptr_array_free(data, TRUE);
+}
+
+static void
+online_id_index_add (AccountPrivate *priv, Split *s)
+{
+    const char *id;
+    gpointer key, value;
+    GPtrArray *splits;
+
+    id = split_online_id(s);
+    if (!id)
+        return;
+
+    if (g_hash_table_lookup_extended(priv->online_ids, id, &key, &value))
+    {
+        splits = value;
+    }
+    else
+    {
+        key = g_strdup(id);
+        splits = g_ptr_array_sized_new(1);
+        g_hash_table_insert(priv->online_ids, key, splits);
+    }
+    g_ptr_array_add(splits, s);
+    g_hash_table_insert(priv->online_id_keys, s, key);
+}
+
+static void
+online_id_index_remove (AccountPrivate *priv, Split *s)
+{
+    gchar *key;
+    GPtrArray *splits;
+
+    key = g_hash_table_lookup(priv->online_id_keys, s);
+    if (!key)
+        return;
+
+    g_hash_table_remove(priv->online_id_keys, s);
+    splits = g_hash_table_lookup(priv->online_ids, key);
+    g_ptr_array_remove_fast(splits, s);
+    if (splits->len == 0)
+        g_hash_table_remove(priv->online_ids, key);
+}
+
+static void
+online_id_index_build (AccountPrivate *priv)
+{
+    GList *node;
+
+    priv->online_ids = g_hash_table_new_full(g_str_hash, g_str_equal,
+                       g_free, online_id_array_free);
+    priv->online_id_keys = g_hash_table_new(g_direct_hash, g_direct_equal);
+    for (node = priv->splits; node; node = node->next)
+        online_id_index_add(priv, node->data);
+}
+
+static void
+online_id_index_free (AccountPrivate *priv)
+{
+    if (!priv->online_ids)
+        return;
+    g_hash_table_destroy(priv->online_id_keys);
+    priv->online_id_keys = NULL;
+    g_hash_table_destroy(priv->online_ids);
+    priv->online_ids = NULL;
+}
+
+/* Drop every split from the account without touching the splits
+ * themselves.  Only used when the book is being shut down. */
+static void
+gnc_account_clear_splits (Account *acc)
+{
+    AccountPrivate *priv;
+
+    priv = GET_PRIVATE(acc);
+    g_hash_table_remove_all(priv->split_index);
+    g_hash_table_remove_all(priv->split_pending);
+    g_sequence_remove_range(g_sequence_get_begin_iter(priv->split_seq),
+                            g_sequence_get_end_iter(priv->split_seq));
+    g_list_free(priv->splits);
+    priv->splits = NULL;
+    online_id_index_free(priv);
+}
+
 gboolean
 gnc_account_find_split (Account *acc, Split *s)
 {
     AccountPrivate *priv;
-    GList *node;
 
     g_return_val_if_fail(GNC_IS_ACCOUNT(acc), FALSE);
     g_return_val_if_fail(GNC_IS_SPLIT(s), FALSE);
 
     priv = GET_PRIVATE(acc);
-    node = g_list_find(priv->splits, s);
-    return node ? TRUE : FALSE;
+    return (g_hash_table_lookup(priv->split_index, s) != NULL ||
+            g_hash_table_lookup(priv->split_pending, s) != NULL);
 }
 
 gboolean
 gnc_account_insert_split (Account *acc, Split *s)
 {
     AccountPrivate *priv;
-    GList *node;
+    GSequenceIter *iter;
+    GList *link;
 
     g_return_val_if_fail(GNC_IS_ACCOUNT(acc), FALSE);
     g_return_val_if_fail(GNC_IS_SPLIT(s), FALSE);
 
     priv = GET_PRIVATE(acc);
-    node = g_list_find(priv->splits, s);
-    if (node)
+    if (gnc_account_find_split(acc, s))
         return FALSE;
 
+    link = g_list_alloc();
+    link->data = s;
     if (qof_instance_get_editlevel(acc) == 0)
     {
-        priv->splits = g_list_insert_sorted(priv->splits, s,
-                                            (GCompareFunc)xaccSplitOrder);
+        iter = g_sequence_insert_sorted(priv->split_seq, link,
+                                        split_link_order, NULL);
     }
     else
     {
-        priv->splits = g_list_prepend(priv->splits, s);
+        iter = g_sequence_prepend(priv->split_seq, link);
         priv->sort_dirty = TRUE;
     }
+    split_link_insert(priv, link, iter);
+    g_hash_table_insert(priv->split_index, s, iter);
+    if (priv->online_ids)
+        online_id_index_add(priv, s);
 
     //FIXME: find better event
     qof_event_gen (&acc->inst, QOF_EVENT_MODIFY, NULL);
     /* Also send an event based on the account */
-    qof_event_gen(&acc->inst, GNC_EVENT_ITEM_ADDED, s);
+    qof_event_gen_about(&acc->inst, GNC_EVENT_ITEM_ADDED, QOF_INSTANCE(s), s, 0);
 
-    priv->balance_dirty = TRUE;
+    gnc_account_mark_balance_dirty(priv, g_sequence_iter_get_position(iter));
 //  DRH: Should the below be added? It is present in the delete path.
 //  xaccAccountRecomputeBalance(acc);
     return TRUE;
@@ -1657,40 +1934,176 @@ gboolean
 gnc_account_remove_split (Account *acc, Split *s)
 {
     AccountPrivate *priv;
-    GList *node;
+    GSequenceIter *iter;
+    GList *link;
 
     g_return_val_if_fail(GNC_IS_ACCOUNT(acc), FALSE);
     g_return_val_if_fail(GNC_IS_SPLIT(s), FALSE);
 
     priv = GET_PRIVATE(acc);
-    node = g_list_find(priv->splits, s);
-    if (NULL == node)
-        return FALSE;
+    link = g_hash_table_lookup(priv->split_pending, s);
+    if (link)
+    {
+        /* Already out of the sequence; its balances are already dirty. */
+        g_hash_table_remove(priv->split_pending, s);
+    }
+    else
+    {
+        iter = g_hash_table_lookup(priv->split_index, s);
+        if (NULL == iter)
+            return FALSE;
 
-    priv->splits = g_list_delete_link(priv->splits, node);
+        link = g_sequence_get(iter);
+        gnc_account_mark_balance_dirty(priv,
+                                       g_sequence_iter_get_position(iter));
+        g_sequence_remove(iter);
+        g_hash_table_remove(priv->split_index, s);
+    }
+    priv->splits = g_list_delete_link(priv->splits, link);
+    if (priv->online_ids)
+        online_id_index_remove(priv, s);
     //FIXME: find better event type
     qof_event_gen(&acc->inst, QOF_EVENT_MODIFY, NULL);
     // And send the account-based event, too
-    qof_event_gen(&acc->inst, GNC_EVENT_ITEM_REMOVED, s);
+    qof_event_gen_about(&acc->inst, GNC_EVENT_ITEM_REMOVED, QOF_INSTANCE(s), s, 0);
 
-    priv->balance_dirty = TRUE;
     xaccAccountRecomputeBalance(acc);
     return TRUE;
 }
 
+Split *
+gnc_account_find_split_by_online_id (Account *acc, const char *online_id,
+                                     const Split *skip)
+{
+    AccountPrivate *priv;
+    GPtrArray *splits;
+    guint i;
+
+    g_return_val_if_fail(GNC_IS_ACCOUNT(acc), NULL);
+    if (!online_id || !*online_id)
+        return NULL;
+
+    priv = GET_PRIVATE(acc);
+    if (!priv->online_ids)
+        online_id_index_build(priv);
+
+    splits = g_hash_table_lookup(priv->online_ids, online_id);
+    if (!splits)
+        return NULL;
+
+    i = 0;
+    while (i < splits->len)
+    {
+        Split *s = g_ptr_array_index(splits, i);
+
+        /* Someone changed the id behind our back; file the split
+         * under its new one and look again at this slot. */
+        if (safe_strcmp(split_online_id(s), online_id) != 0)
+        {
+            gnc_account_update_online_id(acc, s);
+            splits = g_hash_table_lookup(priv->online_ids, online_id);
+            if (!splits)
+                return NULL;
+            continue;
+        }
+        if (!skip || xaccSplitGetParent(s) != xaccSplitGetParent(skip))
+            return s;
+        i++;
+    }
+    return NULL;
+}
+
+void
+gnc_account_update_online_id (Account *acc, Split *s)
+{
+    AccountPrivate *priv;
+
+    g_return_if_fail(GNC_IS_ACCOUNT(acc));
+    g_return_if_fail(GNC_IS_SPLIT(s));
+
+    priv = GET_PRIVATE(acc);
+    if (!priv->online_ids || !gnc_account_find_split(acc, s))
+        return;
+
+    online_id_index_remove(priv, s);
+    online_id_index_add(priv, s);
+}
+
+void
+gnc_account_split_changed (Account *acc, Split *s)
+{
+    AccountPrivate *priv;
+    GSequenceIter *iter;
+
+    g_return_if_fail(GNC_IS_ACCOUNT(acc));
+    g_return_if_fail(GNC_IS_SPLIT(s));
+
+    if (qof_instance_get_destroying(acc))
+        return;
+
+    /* A split that isn't in the account yet will be put in its proper
+     * place when it is inserted. */
+    priv = GET_PRIVATE(acc);
+    iter = g_hash_table_lookup(priv->split_index, s);
+    if (NULL == iter)
+        return;
+
+    gnc_account_mark_balance_dirty(priv, g_sequence_iter_get_position(iter));
+    g_hash_table_insert(priv->split_pending, s, g_sequence_get(iter));
+    g_hash_table_remove(priv->split_index, s);
+    g_sequence_remove(iter);
+}
+
 void
 xaccAccountSortSplits (Account *acc, gboolean force)
 {
     AccountPrivate *priv;
+    GHashTableIter hiter;
+    gpointer key, value;
 
     g_return_if_fail(GNC_IS_ACCOUNT(acc));
 
     priv = GET_PRIVATE(acc);
-    if (!priv->sort_dirty || (!force && qof_instance_get_editlevel(acc) > 0))
+    if (!force && qof_instance_get_editlevel(acc) > 0)
         return;
-    priv->splits = g_list_sort(priv->splits, (GCompareFunc)xaccSplitOrder);
+
+    if (!priv->sort_dirty)
+    {
+        split_pending_flush(priv);
+        return;
+    }
+
+    g_hash_table_iter_init(&hiter, priv->split_pending);
+    while (g_hash_table_iter_next(&hiter, &key, &value))
+        g_hash_table_insert(priv->split_index, key,
+                            g_sequence_append(priv->split_seq, value));
+    g_hash_table_remove_all(priv->split_pending);
+
+    g_sequence_sort(priv->split_seq, split_link_order, NULL);
+    split_list_relink(priv);
     priv->sort_dirty = FALSE;
-    priv->balance_dirty = TRUE;
+    gnc_account_mark_balance_dirty(priv, 0);
+}
+
+void
+gnc_account_foreach_split (const Account *acc, GFunc func,
+                           gpointer user_data)
+{
+    AccountPrivate *priv;
+    GList *node, *next;
+
+    g_return_if_fail(GNC_IS_ACCOUNT(acc));
+    g_return_if_fail(func);
+
+    xaccAccountSortSplits((Account*)acc, FALSE);  // normally a noop
+    priv = GET_PRIVATE(acc);
+    for (node = priv->splits; node; node = next)
+    {
+        /* Fetch the next node first so that func may remove the
+         * current split from the account. */
+        next = node->next;
+        func(node->data, user_data);
+    }
 }
 
 static void
@@ -1807,6 +2220,87 @@ gnc_account_set_policy (Account *acc, GNCPolicy *policy)
 /********************************************************************\
 \********************************************************************/
 
+/* Open lots are ordered by the date of their earliest split, with
+ * the GUID breaking ties so that the order is total. */
+static gint
+open_lot_order (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+    GNCLot *la = (GNCLot *) a, *lb = (GNCLot *) b;
+    Timespec ta, tb;
+    gint result;
+
+    ta = xaccTransRetDatePostedTS(
+             xaccSplitGetParent(gnc_lot_get_earliest_split(la)));
+    tb = xaccTransRetDatePostedTS(
+             xaccSplitGetParent(gnc_lot_get_earliest_split(lb)));
+    result = timespec_cmp(&ta, &tb);
+    if (result)
+        return result;
+    return guid_compare(qof_instance_get_guid(la), qof_instance_get_guid(lb));
+}
+
+static void
+open_lot_forget (AccountPrivate *priv, GNCLot *lot)
+{
+    GSequenceIter *iter;
+
+    iter = g_hash_table_lookup(priv->open_lot_index, lot);
+    if (iter)
+    {
+        g_sequence_remove(iter);
+        g_hash_table_remove(priv->open_lot_index, lot);
+    }
+    g_hash_table_remove(priv->open_lots_pending, lot);
+}
+
+static void
+open_lots_clear (AccountPrivate *priv)
+{
+    g_hash_table_remove_all(priv->open_lot_index);
+    g_hash_table_remove_all(priv->open_lots_pending);
+    g_sequence_remove_range(g_sequence_get_begin_iter(priv->open_lots),
+                            g_sequence_get_end_iter(priv->open_lots));
+}
+
+/* Put the lots that changed since the last lookup back in their
+ * place, dropping those that have been closed or emptied. */
+static void
+open_lots_flush (Account *acc)
+{
+    AccountPrivate *priv;
+    GHashTableIter hiter;
+    gpointer key, value;
+
+    priv = GET_PRIVATE(acc);
+    g_hash_table_iter_init(&hiter, priv->open_lots_pending);
+    while (g_hash_table_iter_next(&hiter, &key, &value))
+    {
+        GNCLot *lot = key;
+
+        if (gnc_lot_get_account(lot) != acc || gnc_lot_is_closed(lot) ||
+                !gnc_lot_get_earliest_split(lot))
+            continue;
+        g_hash_table_insert(priv->open_lot_index, lot,
+                            g_sequence_insert_sorted(priv->open_lots, lot,
+                                    open_lot_order, NULL));
+    }
+    g_hash_table_remove_all(priv->open_lots_pending);
+}
+
+void
+gnc_account_lot_changed (Account *acc, GNCLot *lot)
+{
+    AccountPrivate *priv;
+
+    g_return_if_fail(GNC_IS_ACCOUNT(acc));
+    g_return_if_fail(GNC_IS_LOT(lot));
+
+    priv = GET_PRIVATE(acc);
+    open_lot_forget(priv, lot);
+    if (gnc_lot_get_account(lot) == acc && !qof_instance_get_destroying(lot))
+        g_hash_table_insert(priv->open_lots_pending, lot, lot);
+}
+
 void
 xaccAccountRemoveLot (Account *acc, GNCLot *lot)
 {
@@ -1820,6 +2314,7 @@ xaccAccountRemoveLot (Account *acc, GNCLot *lot)
 
     ENTER ("(acc=%p, lot=%p)", acc, lot);
     priv->lots = g_list_remove(priv->lots, lot);
+    open_lot_forget(priv, lot);
     qof_event_gen (QOF_INSTANCE(lot), QOF_EVENT_REMOVE, NULL);
     qof_event_gen (&acc->inst, QOF_EVENT_MODIFY, NULL);
     LEAVE ("(acc=%p, lot=%p)", acc, lot);
@@ -1849,11 +2344,13 @@ xaccAccountInsertLot (Account *acc, GNCLot *lot)
         old_acc = lot_account;
         opriv = GET_PRIVATE(old_acc);
         opriv->lots = g_list_remove(opriv->lots, lot);
+        open_lot_forget(opriv, lot);
     }
 
     priv = GET_PRIVATE(acc);
     priv->lots = g_list_prepend(priv->lots, lot);
     gnc_lot_set_account(lot, acc);
+    gnc_account_lot_changed(acc, lot);
 
     /* Don't move the splits to the new account.  The caller will do this
      * if appropriate, and doing it here will not work if we are being
@@ -1960,6 +2457,11 @@ xaccAccountMoveAllSplits (Account *accfrom, Account *accto)
  * in dollars.  Thus, two different mechanisms must be used to      *
  * compute balances, depending on account type.                     *
  *                                                                  *
+ * Only the splits from the first one whose balance was marked dirty *
+ * onward are visited; the running balances of the splits before it *
+ * are still correct and the sum is picked up from there.  Editing  *
+ * a recent split in a large account is therefore cheap.            *
+ *                                                                  *
  * Args:   account -- the account for which to recompute balances   *
  * Return: void                                                     *
 \********************************************************************/
@@ -1971,26 +2473,43 @@ xaccAccountRecomputeBalance (Account * acc)
     gnc_numeric  balance;
     gnc_numeric  cleared_balance;
     gnc_numeric  reconciled_balance;
-    Split *last_split = NULL;
-    GList *lp;
+    GSequenceIter *iter;
+    gint pos;
 
     if (NULL == acc) return;
 
     priv = GET_PRIVATE(acc);
     if (qof_instance_get_editlevel(acc) > 0) return;
-    if (!priv->balance_dirty) return;
     if (qof_instance_get_destroying(acc)) return;
     if (qof_book_shutting_down(qof_instance_get_book(acc))) return;
 
-    balance            = priv->starting_balance;
-    cleared_balance    = priv->starting_cleared_balance;
-    reconciled_balance = priv->starting_reconciled_balance;
+    /* Put changed splits back in order first; this may dirty more
+     * balances. */
+    xaccAccountSortSplits(acc, FALSE);
+    if (!priv->balance_dirty) return;
 
-    PINFO ("acct=%s starting baln=%" G_GINT64_FORMAT "/%" G_GINT64_FORMAT,
-           priv->accountName, balance.num, balance.denom);
-    for (lp = priv->splits; lp; lp = lp->next)
+    pos = MIN(priv->balance_dirty_pos, g_sequence_get_length(priv->split_seq));
+    iter = g_sequence_get_iter_at_pos(priv->split_seq, pos);
+    if (pos > 0)
     {
-        Split *split = (Split *) lp->data;
+        Split *prev = ((GList *)g_sequence_get(g_sequence_iter_prev(iter)))->data;
+
+        balance            = prev->balance;
+        cleared_balance    = prev->cleared_balance;
+        reconciled_balance = prev->reconciled_balance;
+    }
+    else
+    {
+        balance            = priv->starting_balance;
+        cleared_balance    = priv->starting_cleared_balance;
+        reconciled_balance = priv->starting_reconciled_balance;
+    }
+
+    PINFO ("acct=%s from split %d baln=%" G_GINT64_FORMAT "/%" G_GINT64_FORMAT,
+           priv->accountName, pos, balance.num, balance.denom);
+    for (; !g_sequence_iter_is_end(iter); iter = g_sequence_iter_next(iter))
+    {
+        Split *split = ((GList *)g_sequence_get(iter))->data;
         gnc_numeric amt = xaccSplitGetAmount (split);
 
         balance = gnc_numeric_add_fixed(balance, amt);
@@ -2010,8 +2529,6 @@ xaccAccountRecomputeBalance (Account * acc)
         split->balance = balance;
         split->cleared_balance = cleared_balance;
         split->reconciled_balance = reconciled_balance;
-
-        last_split = split;
     }
 
     priv->balance = balance;
@@ -2132,7 +2649,7 @@ xaccAccountSetType (Account *acc, GNCAccountType tip)
 
     xaccAccountBeginEdit(acc);
     priv->type = tip;
-    priv->balance_dirty = TRUE; /* new type may affect balance computation */
+    gnc_account_mark_balance_dirty(priv, 0); /* new type may affect balance computation */
     mark_account(acc);
     xaccAccountCommitEdit(acc);
 }
@@ -2289,7 +2806,7 @@ xaccAccountSetCommodity (Account * acc, gnc_commodity * com)
     }
 
     priv->sort_dirty = TRUE;  /* Not needed. */
-    priv->balance_dirty = TRUE;
+    gnc_account_mark_balance_dirty(priv, 0);
     mark_account (acc);
 
     xaccAccountCommitEdit(acc);
@@ -3051,7 +3568,7 @@ gnc_account_set_start_balance (Account *acc, const gnc_numeric start_baln)
 
     priv = GET_PRIVATE(acc);
     priv->starting_balance = start_baln;
-    priv->balance_dirty = TRUE;
+    gnc_account_mark_balance_dirty(priv, 0);
 }
 
 gnc_numeric
@@ -3072,7 +3589,7 @@ gnc_account_set_start_cleared_balance (Account *acc,
 
     priv = GET_PRIVATE(acc);
     priv->starting_cleared_balance = start_baln;
-    priv->balance_dirty = TRUE;
+    gnc_account_mark_balance_dirty(priv, 0);
 }
 
 gnc_numeric
@@ -3093,7 +3610,7 @@ gnc_account_set_start_reconciled_balance (Account *acc,
 
     priv = GET_PRIVATE(acc);
     priv->starting_reconciled_balance = start_baln;
-    priv->balance_dirty = TRUE;
+    gnc_account_mark_balance_dirty(priv, 0);
 }
 
 gnc_numeric
@@ -3155,20 +3672,72 @@ xaccAccountGetProjectedMinimumBalance (const Account *acc)
 /********************************************************************\
 \********************************************************************/
 
-gnc_numeric
-xaccAccountGetBalanceAsOfDate (Account *acc, time_t date)
+/* Find the first split in the account posted after 'ts', or at or
+ * after 'ts' if 'inclusive' is TRUE, by binary search of the split
+ * sequence.  Splits without a transaction sort last and are treated
+ * as lying in the infinite future.  Returns the end iterator if there
+ * is no such split.  The sequence must be sorted. */
+static GSequenceIter *
+gnc_account_find_split_posted_after (AccountPrivate *priv, Timespec ts,
+                                     gboolean inclusive)
+{
+    GSequenceIter *begin, *end;
+
+    begin = g_sequence_get_begin_iter(priv->split_seq);
+    end = g_sequence_get_end_iter(priv->split_seq);
+    while (begin != end)
+    {
+        GSequenceIter *mid = g_sequence_range_get_midpoint(begin, end);
+        Split *split = ((GList *)g_sequence_get(mid))->data;
+        Transaction *trans = xaccSplitGetParent(split);
+        Timespec trans_ts;
+        gint cmp;
+
+        if (!trans)
+        {
+            end = mid;
+            continue;
+        }
+        xaccTransGetDatePostedTS(trans, &trans_ts);
+        cmp = timespec_cmp(&trans_ts, &ts);
+        if (cmp > 0 || (inclusive && cmp == 0))
+            end = mid;
+        else
+            begin = g_sequence_iter_next(mid);
+    }
+    return begin;
+}
+
+typedef enum
+{
+    BALANCE_TOTAL,
+    BALANCE_CLEARED,
+    BALANCE_RECONCILED
+} BalanceKind;
+
+static gnc_numeric
+split_get_balance_kind (const Split *split, BalanceKind kind)
+{
+    switch (kind)
+    {
+    case BALANCE_CLEARED:
+        return xaccSplitGetClearedBalance(split);
+    case BALANCE_RECONCILED:
+        return xaccSplitGetReconciledBalance(split);
+    default:
+        return xaccSplitGetBalance(split);
+    }
+}
+
+/* Common code for the balance-as-of-date routines.  The running
+ * balance of the last split posted before 'date' is the answer; it is
+ * found with a binary search rather than by walking the split list. */
+static gnc_numeric
+xaccAccountGetXxxBalanceAsOfDate (Account *acc, time_t date, BalanceKind kind)
 {
-    /* Ideally this could use xaccAccountForEachSplit, but
-     * it doesn't exist yet and I'm uncertain of exactly how
-     * it would work at this time, since it differs from
-     * xaccAccountForEachTransaction by using gpointer return
-     * values rather than gints.
-     */
     AccountPrivate *priv;
-    GList   *lp;
-    Timespec ts, trans_ts;
-    gboolean found = FALSE;
-    gnc_numeric balance;
+    GSequenceIter *iter;
+    Timespec ts;
 
     g_return_val_if_fail(GNC_IS_ACCOUNT(acc), gnc_numeric_zero());
 
@@ -3176,85 +3745,81 @@ xaccAccountGetBalanceAsOfDate (Account *acc, time_t date)
     xaccAccountRecomputeBalance (acc); /* just in case, normally a noop */
 
     priv = GET_PRIVATE(acc);
-    balance = priv->balance;
-
-    /* Since transaction post times are stored as a Timespec,
-     * convert date into a Timespec as well rather than converting
-     * each transaction's Timespec into a time_t.
-     *
-     * FIXME: CAS: I think this comment is a bogus justification for
-     * using xaccTransGetDatePostedTS.  There's no benefit to using
-     * Timespec when the input argument is time_t, and it's hard to
-     * imagine that casting long long to long and comparing two longs is
-     * worse than comparing two long longs every time.  IMO,
-     * xaccAccountGetPresentBalance gets this right, and its algorithm
-     * should be used here.
-     */
+
     ts.tv_sec = date;
     ts.tv_nsec = 0;
+    iter = gnc_account_find_split_posted_after(priv, ts, TRUE);
 
-    lp = priv->splits;
-    while ( lp && !found )
+    /* No splits posted on or after the given date, so the latest
+     * account balance is good enough. */
+    if (g_sequence_iter_is_end(iter))
     {
-        xaccTransGetDatePostedTS( xaccSplitGetParent( (Split *)lp->data ),
-                                  &trans_ts );
-        if ( timespec_cmp( &trans_ts, &ts ) >= 0 )
-            found = TRUE;
-        else
-            lp = lp->next;
-    }
-
-    if ( lp )
-    {
-        if ( lp->prev )
-        {
-            /* Since lp is now pointing to a split which was past the reconcile
-             * date, get the running balance of the previous split.
-             */
-            balance = xaccSplitGetBalance( (Split *)lp->prev->data );
-        }
-        else
+        switch (kind)
         {
-            /* AsOf date must be before any entries, return zero. */
-            balance = gnc_numeric_zero();
+        case BALANCE_CLEARED:
+            return priv->cleared_balance;
+        case BALANCE_RECONCILED:
+            return priv->reconciled_balance;
+        default:
+            return priv->balance;
         }
     }
 
-    /* Otherwise there were no splits posted after the given date,
-     * so the latest account balance should be good enough.
-     */
+    /* AsOf date must be before any entries, return zero. */
+    if (g_sequence_iter_is_begin(iter))
+        return gnc_numeric_zero();
 
-    return( balance );
+    /* The iterator points at a split past the date; use the running
+     * balance of the previous split. */
+    iter = g_sequence_iter_prev(iter);
+    return split_get_balance_kind(((GList *)g_sequence_get(iter))->data, kind);
+}
+
+gnc_numeric
+xaccAccountGetBalanceAsOfDate (Account *acc, time_t date)
+{
+    return xaccAccountGetXxxBalanceAsOfDate(acc, date, BALANCE_TOTAL);
+}
+
+gnc_numeric
+xaccAccountGetClearedBalanceAsOfDate (Account *acc, time_t date)
+{
+    return xaccAccountGetXxxBalanceAsOfDate(acc, date, BALANCE_CLEARED);
+}
+
+gnc_numeric
+xaccAccountGetReconciledBalanceAsOfDate (Account *acc, time_t date)
+{
+    return xaccAccountGetXxxBalanceAsOfDate(acc, date, BALANCE_RECONCILED);
 }
 
 /*
  * Originally gsr_account_present_balance in gnc-split-reg.c
  *
- * How does this routine compare to xaccAccountGetBalanceAsOfDate just
- * above?  These two routines should eventually be collapsed into one.
- * Perhaps the startup logic from that one, and the logic from this
- * one that walks from the tail of the split list.
+ * This is the balance of the last split posted no later than the end
+ * of today, found by binary search.
  */
+/* XXX: violates the const'ness by forcing a sort */
 gnc_numeric
 xaccAccountGetPresentBalance (const Account *acc)
 {
     AccountPrivate *priv;
-    GList *node;
-    time_t today;
+    GSequenceIter *iter;
+    Timespec ts;
 
     g_return_val_if_fail(GNC_IS_ACCOUNT(acc), gnc_numeric_zero());
 
-    priv = GET_PRIVATE(acc);
-    today = gnc_timet_get_today_end();
-    for (node = g_list_last(priv->splits); node; node = node->prev)
-    {
-        Split *split = node->data;
+    xaccAccountSortSplits ((Account *)acc, TRUE); /* normally a noop */
 
-        if (xaccTransGetDate (xaccSplitGetParent (split)) <= today)
-            return xaccSplitGetBalance (split);
-    }
+    priv = GET_PRIVATE(acc);
+    ts.tv_sec = gnc_timet_get_today_end();
+    ts.tv_nsec = 0;
+    iter = gnc_account_find_split_posted_after(priv, ts, FALSE);
+    if (g_sequence_iter_is_begin(iter))
+        return gnc_numeric_zero ();
 
-    return gnc_numeric_zero ();
+    iter = g_sequence_iter_prev(iter);
+    return xaccSplitGetBalance(((GList *)g_sequence_get(iter))->data);
 }
 
 
@@ -3606,19 +4171,19 @@ xaccAccountFindOpenLots (const Account *acc,
                          gpointer user_data, GCompareFunc sort_func)
 {
     AccountPrivate *priv;
-    GList *lot_list;
+    GSequenceIter *iter;
     GList *retval = NULL;
 
     g_return_val_if_fail(GNC_IS_ACCOUNT(acc), NULL);
 
+    /* Only the open lots need be looked at */
+    open_lots_flush((Account *) acc);
     priv = GET_PRIVATE(acc);
-    for (lot_list = priv->lots; lot_list; lot_list = lot_list->next)
+    for (iter = g_sequence_get_begin_iter(priv->open_lots);
+            !g_sequence_iter_is_end(iter);
+            iter = g_sequence_iter_next(iter))
     {
-        GNCLot *lot = lot_list->data;
-
-        /* If this lot is closed, then ignore it */
-        if (gnc_lot_is_closed (lot))
-            continue;
+        GNCLot *lot = g_sequence_get(iter);
 
         if (match_func && !(match_func)(lot, user_data))
             continue;
@@ -3652,6 +4217,43 @@ xaccAccountForEachLot(const Account *acc,
     return result;
 }
 
+gpointer
+xaccAccountForEachOpenLot(const Account *acc, gboolean latest_first,
+                          gpointer (*proc)(GNCLot *lot, void *data), void *data)
+{
+    AccountPrivate *priv;
+    GSequenceIter *iter;
+    gpointer result = NULL;
+
+    g_return_val_if_fail(GNC_IS_ACCOUNT(acc), NULL);
+    g_return_val_if_fail(proc, NULL);
+
+    open_lots_flush((Account *) acc);
+    priv = GET_PRIVATE(acc);
+    if (latest_first)
+    {
+        iter = g_sequence_get_end_iter(priv->open_lots);
+        while (!g_sequence_iter_is_begin(iter))
+        {
+            iter = g_sequence_iter_prev(iter);
+            if ((result = proc(g_sequence_get(iter), data)))
+                break;
+        }
+    }
+    else
+    {
+        iter = g_sequence_get_begin_iter(priv->open_lots);
+        while (!g_sequence_iter_is_end(iter))
+        {
+            if ((result = proc(g_sequence_get(iter), data)))
+                break;
+            iter = g_sequence_iter_next(iter);
+        }
+    }
+
+    return result;
+}
+
 /********************************************************************\
 \********************************************************************/
 
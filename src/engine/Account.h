@@ -378,6 +378,49 @@ gboolean gnc_account_insert_split (Account *acc, Split *s);
  *  reason. */
 gboolean gnc_account_remove_split (Account *acc, Split *s);
 
+/** Call a function once for each split in an account, in the order
+ *  given by xaccSplitOrder().  The function may remove the split it
+ *  is passed from the account, but must not otherwise add or remove
+ *  splits.
+ *
+ *  @param acc The account whose splits should be visited.
+ *
+ *  @param func The function to call.  It is passed the split and
+ *  user_data.
+ *
+ *  @param user_data This data will be passed to each call of func. */
+void gnc_account_foreach_split (const Account *acc, GFunc func,
+                                gpointer user_data);
+
+/** Find a split in an account carrying the given online_id, as set
+ *  by the importers on the split or, failing that, on its
+ *  transaction.  The account keeps an index of these ids, built on
+ *  the first call, so repeated lookups don't walk the split list.
+ *
+ *  @param acc The account to search.
+ *
+ *  @param online_id The id to look for.
+ *
+ *  @param skip A split, usually the one being imported, whose
+ *  transaction is to be ignored.  May be NULL.
+ *
+ *  @result A split with that online_id from some other transaction,
+ *  or NULL. */
+Split * gnc_account_find_split_by_online_id (Account *acc,
+        const char *online_id,
+        const Split *skip);
+
+/** Tell an account that the online_id of one of its splits, or of
+ *  that split's transaction, has been set or changed, so that
+ *  gnc_account_find_split_by_online_id() sees the new value.
+ *  Committing an edit of the transaction does this for all of its
+ *  splits, so this is only needed for a change made outside one.
+ *
+ *  @param acc The account holding the split.
+ *
+ *  @param s The split whose online_id changed. */
+void gnc_account_update_online_id (Account *acc, Split *s);
+
 /** Get the account's name */
 const char * xaccAccountGetName (const Account *account);
 /** Get the account's accounting code */
@@ -554,6 +597,14 @@ gnc_numeric xaccAccountGetProjectedMinimumBalance (const Account *account);
 /** Get the balance of the account as of the date specified */
 gnc_numeric xaccAccountGetBalanceAsOfDate (Account *account,
         time_t date);
+/** Get the balance of the account as of the date specified, only
+    including cleared transactions */
+gnc_numeric xaccAccountGetClearedBalanceAsOfDate (Account *account,
+        time_t date);
+/** Get the balance of the account as of the date specified, only
+    including reconciled transactions */
+gnc_numeric xaccAccountGetReconciledBalanceAsOfDate (Account *account,
+        time_t date);
 
 /* These two functions convert a given balance from one commodity to
    another.  The account argument is only used to get the Book, and
@@ -1088,6 +1139,19 @@ gpointer xaccAccountForEachLot(
     const Account *acc,
     gpointer (*proc)(GNCLot *lot, gpointer user_data), /*@ null @*/ gpointer user_data);
 
+/** The xaccAccountForEachOpenLot() method applies 'proc' to each open
+ *    lot in the account, in the order of the posted date of the
+ *    earliest split in each lot, or in the reverse order if
+ *    latest_first is TRUE.  If 'proc' returns a non-NULL value,
+ *    further application will be stopped, and the resulting value
+ *    will be returned.  The account keeps its open lots in this
+ *    order as they change, so no sorting is done here.  'proc' must
+ *    not add splits to or remove splits from any lot of the account.
+ */
+gpointer xaccAccountForEachOpenLot(
+    const Account *acc, gboolean latest_first,
+    gpointer (*proc)(GNCLot *lot, gpointer user_data), /*@ null @*/ gpointer user_data);
+
 
 /** Find a list of open lots that match the match_func.  Sort according
  * to sort_func.  If match_func is NULL, then all open lots are returned.
@@ -60,6 +60,18 @@ struct account_s
  * call this on an existing account! */
 void xaccAccountSetGUID (Account *account, const GncGUID *guid);
 
+/* Tell the account that the sort key, amount or reconcile state of
+ * one of its splits may have changed.  The split will be moved to its
+ * proper place at the next sort, and only the running balances from
+ * there on will be recomputed. */
+void gnc_account_split_changed (Account *acc, Split *s);
+
+/* Tell the account that the splits of one of its lots, or their
+ * amounts or dates, may have changed.  The lot will be put back in
+ * the account's ordered set of open lots, if it is still open and
+ * still in the account, the next time that set is used. */
+void gnc_account_lot_changed (Account *acc, GNCLot *lot);
+
 /* Register Accounts with the engine */
 gboolean xaccAccountRegister (void);
 
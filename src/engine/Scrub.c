@@ -42,6 +42,9 @@
 #include <glib/gi18n.h>
 #include <stdio.h>
 #include <string.h>
+#ifdef HAVE_UNISTD_H
+# include <unistd.h>
+#endif
 
 #include "Account.h"
 #include "AccountP.h"
@@ -300,14 +303,15 @@ xaccAccountScrubImbalance (Account *acc)
     }
 }
 
-void
-xaccTransScrubCurrencyFromSplits(Transaction *trans)
+/* The currency shared by all the splits whose amount equals their
+ * value and whose account commodity is a currency, or NULL if there
+ * are none or they disagree.  Only reads the transaction. */
+static gnc_commodity *
+trans_split_currency (const Transaction *trans)
 {
     GList *node;
     gnc_commodity *common_currency = NULL;
 
-    if (!trans) return;
-
     for (node = xaccTransGetSplitList (trans); node; node = node->next)
     {
         Split *split = node->data;
@@ -343,7 +347,17 @@ xaccTransScrubCurrencyFromSplits(Transaction *trans)
             }
         }
     }
+    return common_currency;
+}
+
+void
+xaccTransScrubCurrencyFromSplits(Transaction *trans)
+{
+    gnc_commodity *common_currency;
 
+    if (!trans) return;
+
+    common_currency = trans_split_currency (trans);
     if (common_currency &&
             !gnc_commodity_equiv (common_currency, xaccTransGetCurrency (trans)))
     {
@@ -1052,6 +1066,203 @@ xaccTransFindCommonCurrency (Transaction *trans, QofBook *book)
     return xaccTransFindOldCommonCurrency( trans, book );
 }
 
+/* ================================================================ */
+/* Checking a transaction for orphans, mismatched split values,
+ * currency and imbalance only reads it, so that part is shared out
+ * among worker threads in chunks of transactions.  Repairs change
+ * the engine and are made afterwards, in order, on the calling
+ * thread, and only for the transactions the workers flagged. */
+
+#define SCRUB_CHUNK 256
+
+typedef struct
+{
+    GPtrArray *trans;       /* every transaction under the account */
+    guint8 *flags;          /* set where a transaction needs repair */
+    gint next_chunk;        /* next chunk to hand out; atomic */
+    gint n_chunks;
+} ScrubJob;
+
+/* TRUE if any of the repairs made by xaccAccountTreeScrubParallel()
+ * could change the transaction.  Errs on the side of TRUE. */
+static gboolean
+trans_needs_scrub (const Transaction *trans)
+{
+    GList *node;
+    gnc_commodity *currency, *common;
+
+    currency = trans->common_currency;
+    if (!currency) return TRUE;
+
+    for (node = trans->splits; node; node = node->next)
+    {
+        Split *split = node->data;
+        gnc_commodity *acc_commodity;
+
+        /* Orphans, and anything xaccSplitScrub() would change */
+        if (!split->acc) return TRUE;
+        if (gnc_numeric_check (split->amount) ||
+                gnc_numeric_check (split->value))
+            return TRUE;
+        acc_commodity = xaccAccountGetCommodity (split->acc);
+        if (!acc_commodity) return TRUE;
+        if (gnc_commodity_equiv (acc_commodity, currency) &&
+                !gnc_numeric_equal (split->amount, split->value))
+            return TRUE;
+    }
+
+    common = trans_split_currency (trans);
+    if (common && !gnc_commodity_equiv (common, currency))
+        return TRUE;
+
+    return !xaccTransIsBalanced (trans);
+}
+
+static void
+scrub_check_chunk (ScrubJob *job, gint chunk)
+{
+    guint i, end;
+
+    i = chunk * SCRUB_CHUNK;
+    end = MIN (i + SCRUB_CHUNK, job->trans->len);
+    for (; i < end; i++)
+        job->flags[i] = trans_needs_scrub (g_ptr_array_index (job->trans, i));
+}
+
+static gpointer
+scrub_check_thread (gpointer data)
+{
+    ScrubJob *job = data;
+    gint chunk;
+
+    while ((chunk = g_atomic_int_exchange_and_add (&job->next_chunk, 1))
+            < job->n_chunks)
+    {
+        scrub_check_chunk (job, chunk);
+    }
+    return NULL;
+}
+
+static gint
+scrub_n_workers (void)
+{
+#ifdef _SC_NPROCESSORS_ONLN
+    long n = sysconf (_SC_NPROCESSORS_ONLN);
+    if (n > 1)
+        return (gint) MIN (n, 32);
+#endif
+    return 1;
+}
+
+static int
+scrub_collect_trans (Transaction *trans, gpointer data)
+{
+    g_ptr_array_add (data, trans);
+    return 0;
+}
+
+static void
+scrub_progress (QofPercentageFunc percentage_func, const char *message,
+                guint done, guint total, gint *last)
+{
+    gint percent;
+
+    if (!percentage_func || total == 0) return;
+    percent = (gint) ((100.0 * done) / total);
+    if (percent == *last) return;
+    *last = percent;
+    percentage_func (message, percent);
+}
+
+void
+xaccAccountTreeScrubParallel (Account *acc, QofPercentageFunc percentage_func)
+{
+    ScrubJob job;
+    GThread **threads = NULL;
+    QofBook *book;
+    GArray *flagged;
+    gint n_threads = 0, i, last = -1;
+    guint n;
+
+    if (!acc) return;
+    ENTER ("(acc=%s)", xaccAccountGetName (acc));
+
+    /* Let the caller lock out the user before anything is collected;
+     * the callback is not made again until the workers are done, as it
+     * may run the main loop. */
+    if (percentage_func)
+        percentage_func (_("Checking transactions"), 0);
+
+    book = gnc_account_get_book (acc);
+    job.trans = g_ptr_array_new ();
+    xaccAccountTreeForEachTransaction (acc, scrub_collect_trans, job.trans);
+    job.flags = g_new0 (guint8, job.trans->len + 1);
+    job.next_chunk = 0;
+    job.n_chunks = (job.trans->len + SCRUB_CHUNK - 1) / SCRUB_CHUNK;
+
+    if (g_thread_supported () && job.n_chunks > 1)
+    {
+        n_threads = MIN (scrub_n_workers (), job.n_chunks);
+        threads = g_new0 (GThread *, n_threads);
+        for (i = 0; i < n_threads; i++)
+        {
+            GError *error = NULL;
+            threads[i] = g_thread_create (scrub_check_thread, &job, TRUE, &error);
+            if (!threads[i])
+            {
+                PWARN ("Could not start scrub worker: %s", error->message);
+                g_error_free (error);
+                break;
+            }
+        }
+        n_threads = i;
+    }
+
+    /* Whatever the workers didn't get to is checked here */
+    scrub_check_thread (&job);
+    for (i = 0; i < n_threads; i++)
+        g_thread_join (threads[i]);
+    g_free (threads);
+
+    /* Remember the flagged transactions by GUID; a transaction may be
+     * deleted while the progress callback runs the main loop. */
+    flagged = g_array_new (FALSE, FALSE, sizeof (GncGUID));
+    for (n = 0; n < job.trans->len; n++)
+        if (job.flags[n])
+            g_array_append_vals (flagged,
+                                 xaccTransGetGUID (g_ptr_array_index (job.trans, n)),
+                                 1);
+    PINFO ("checked %u transactions, %u need repair",
+           job.trans->len, flagged->len);
+    g_free (job.flags);
+    g_ptr_array_free (job.trans, TRUE);
+
+    /* The same repairs xaccAccountTreeScrubOrphans() and
+     * xaccAccountTreeScrubImbalance() would make, but each
+     * transaction is visited once and only if it needs it. */
+    for (n = 0; n < flagged->len; n++)
+    {
+        Transaction *trans;
+        Account *root;
+
+        trans = xaccTransLookup (&g_array_index (flagged, GncGUID, n), book);
+        if (trans)
+        {
+            root = gnc_book_get_root_account (book);
+            TransScrubOrphansFast (trans, root);
+            xaccTransScrubCurrencyFromSplits (trans);
+            xaccTransScrubImbalance (trans, root, NULL);
+        }
+        scrub_progress (percentage_func, _("Repairing transactions"),
+                        n + 1, flagged->len, &last);
+    }
+    if (percentage_func)
+        percentage_func (NULL, -1.0);
+
+    g_array_free (flagged, TRUE);
+    LEAVE ("(acc=%s)", xaccAccountGetName (acc));
+}
+
 /* ================================================================ */
 
 void
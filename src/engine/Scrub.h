@@ -111,6 +111,22 @@ void xaccTransScrubImbalance (Transaction *trans, Account *root,
 void xaccAccountScrubImbalance (Account *acc);
 void xaccAccountTreeScrubImbalance (Account *acc);
 
+/** The xaccAccountTreeScrubParallel() method makes the same repairs
+ *    as xaccAccountTreeScrubOrphans() followed by
+ *    xaccAccountTreeScrubImbalance(), but spreads the work over the
+ *    processors.  Worker threads check the transactions for orphans,
+ *    mismatched currencies and imbalance; only the transactions they
+ *    flag are then repaired, one at a time, on the calling thread.
+ *
+ *    If percentage_func is not NULL it is called on the calling
+ *    thread: once with 0 before the check starts, as the repairs
+ *    progress, and with a NULL message and a negative percentage when
+ *    it is done.  It is not called while the workers run, so it may
+ *    run the main loop.  Transactions deleted by then are skipped.
+ */
+void xaccAccountTreeScrubParallel (Account *acc,
+                                   QofPercentageFunc percentage_func);
+
 /** The xaccTransScrubCurrency method fixes transactions without a
  * common_currency by using the old account currency and security
  * fields of the parent accounts of the transaction's splits. */
@@ -57,16 +57,19 @@ static QofLogModule log_module = GNC_MOD_LOT;
 void
 xaccAccountAssignLots (Account *acc)
 {
-    SplitList *splits, *node;
+    SplitList *splits = NULL, *node;
 
     if (!acc) return;
 
     ENTER ("acc=%s", xaccAccountGetName(acc));
     xaccAccountBeginEdit (acc);
 
-restart_loop:
-    splits = xaccAccountGetSplitList(acc);
-    for (node = splits; node; node = node->next)
+    /* Take the unassigned splits in date order up front.  Assigning a
+     * split may cut it in two, but xaccSplitAssign() puts every piece
+     * in a lot before returning, so the new splits never need to be
+     * visited and the walk doesn't have to start over. */
+    xaccAccountSortSplits (acc, TRUE);
+    for (node = xaccAccountGetSplitList(acc); node; node = node->next)
     {
         Split * split = node->data;
 
@@ -77,8 +80,13 @@ restart_loop:
         if (gnc_numeric_zero_p (split->amount) &&
                 xaccTransGetVoidStatus(split->parent)) continue;
 
-        if (xaccSplitAssign (split)) goto restart_loop;
+        splits = g_list_prepend (splits, split);
     }
+    splits = g_list_reverse (splits);
+
+    for (node = splits; node; node = node->next)
+        xaccSplitAssign (node->data);
+    g_list_free (splits);
     xaccAccountCommitEdit (acc);
     LEAVE ("acc=%s", xaccAccountGetName(acc));
 }
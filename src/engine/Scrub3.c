@@ -155,12 +155,93 @@ rethin:
 
 /* ============================================================== */
 
-void
-xaccAccountScrubLots (Account *acc)
+/* Scrubbing lots creates and changes many gains transactions, which
+ * land in the accounts being scrubbed and in their gains accounts.
+ * Holding just those accounts open means each split is simply filed
+ * as it arrives, and sorting and rebalancing happen once per account
+ * when the batch is committed.  Split events are queued and coalesced
+ * by the event batch in the same way.  A gains account that has to be
+ * created while scrubbing is not held open, which only costs it the
+ * per-split sort. */
+
+typedef struct
 {
-    LotList *lots, *node;
-    if (!acc) return;
+    QofBook *book;
+    GHashTable *seen;
+    GList *accounts;
+} LotScrubAccounts;
+
+static void
+lot_scrub_add (LotScrubAccounts *lsa, Account *acc)
+{
+    if (!acc || g_hash_table_lookup (lsa->seen, acc)) return;
+    g_hash_table_insert (lsa->seen, acc, acc);
+    lsa->accounts = g_list_prepend (lsa->accounts, acc);
+    xaccAccountBeginEdit (acc);
+}
+
+static void
+lot_scrub_add_gains_cb (const char *key, KvpValue *value, gpointer data)
+{
+    LotScrubAccounts *lsa = data;
+
+    lot_scrub_add (lsa, xaccAccountLookup (kvp_value_get_guid (value),
+                                           lsa->book));
+}
+
+static void
+lot_scrub_add_cb (Account *acc, gpointer data)
+{
+    LotScrubAccounts *lsa = data;
+    KvpFrame *gains;
+
     if (FALSE == xaccAccountHasTrades (acc)) return;
+    lot_scrub_add (lsa, acc);
+
+    gains = kvp_frame_get_frame_slash (xaccAccountGetSlots (acc),
+                                       "/lot-mgmt/gains-act/");
+    if (gains)
+        kvp_frame_for_each_slot (gains, lot_scrub_add_gains_cb, lsa);
+}
+
+/* Open the accounts scrubbing acc (and, if tree is set, its
+ * descendants) will change, and start the event batch. */
+static GList *
+lot_scrub_begin (Account *acc, gboolean tree)
+{
+    LotScrubAccounts lsa;
+
+    qof_event_begin_batch ();
+    lsa.book = gnc_account_get_book (acc);
+    lsa.seen = g_hash_table_new (g_direct_hash, g_direct_equal);
+    lsa.accounts = NULL;
+    if (tree)
+        gnc_account_foreach_descendant (acc, lot_scrub_add_cb, &lsa);
+    lot_scrub_add_cb (acc, &lsa);
+    g_hash_table_destroy (lsa.seen);
+    return lsa.accounts;
+}
+
+static void
+lot_scrub_commit_cb (Account *acc, gpointer data)
+{
+    xaccAccountCommitEdit (acc);
+}
+
+static void
+lot_scrub_end (GList *accounts)
+{
+    /* Accounts made while scrubbing (new gains accounts) were never
+     * opened here, so only the ones we opened are committed. */
+    g_list_foreach (accounts, (GFunc) lot_scrub_commit_cb, NULL);
+    g_list_free (accounts);
+    qof_event_end_batch ();
+}
+
+static void
+scrub_account_lots (Account *acc)
+{
+    LotList *lots, *node;
 
     ENTER ("(acc=%s)", xaccAccountGetName(acc));
     xaccAccountBeginEdit(acc);
@@ -177,22 +258,39 @@ xaccAccountScrubLots (Account *acc)
     LEAVE ("(acc=%s)", xaccAccountGetName(acc));
 }
 
+void
+xaccAccountScrubLots (Account *acc)
+{
+    GList *accounts;
+
+    if (!acc) return;
+    if (FALSE == xaccAccountHasTrades (acc)) return;
+
+    accounts = lot_scrub_begin (acc, FALSE);
+    scrub_account_lots (acc);
+    lot_scrub_end (accounts);
+}
+
 /* ============================================================== */
 
 static void
 lot_scrub_cb (Account *acc, gpointer data)
 {
     if (FALSE == xaccAccountHasTrades (acc)) return;
-    xaccAccountScrubLots (acc);
+    scrub_account_lots (acc);
 }
 
 void
 xaccAccountTreeScrubLots (Account *acc)
 {
+    GList *accounts;
+
     if (!acc) return;
 
+    accounts = lot_scrub_begin (acc, TRUE);
     gnc_account_foreach_descendant(acc, lot_scrub_cb, NULL);
-    xaccAccountScrubLots (acc);
+    lot_scrub_cb (acc, NULL);
+    lot_scrub_end (accounts);
 }
 
 /* ========================== END OF FILE  ========================= */
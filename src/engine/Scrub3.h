@@ -65,6 +65,12 @@ gboolean xaccScrubLot (GNCLot *lot);
  * Most GUI routines will want to use one of these xacc[*]ScrubLots()
  * routines, instead of the various component routines, since it will
  * usually makes sense to work only with these high-level routines.
+ *
+ * Both routines work as a single batch: every account in the book is
+ * held open for editing and events are coalesced until the whole
+ * account (or tree) is done.  Gains transactions are therefore
+ * filed, sorted and balanced once at the end, and the GUI sees one
+ * round of changes rather than one per trade.
  */
 void xaccAccountScrubLots (Account *acc);
 void xaccAccountTreeScrubLots (Account *acc);
@@ -502,7 +502,7 @@ void mark_split (Split *s)
 {
     if (s->acc)
     {
-        g_object_set(s->acc, "sort-dirty", TRUE, "balance-dirty", TRUE, NULL);
+        gnc_account_split_changed(s->acc, s);
     }
 
     /* set dirty flag on lot too. */
@@ -784,7 +784,7 @@ xaccSplitCommitEdit(Split *s)
 
     if (acc)
     {
-        g_object_set(acc, "sort-dirty", TRUE, "balance-dirty", TRUE, NULL);
+        gnc_account_split_changed(acc, s);
         xaccAccountRecomputeBalance(acc);
     }
 }
@@ -1356,7 +1356,8 @@ xaccSplitDestroy (Split *split)
     ed.idx = xaccTransGetSplitIndex(trans, split);
     qof_instance_set_dirty(QOF_INSTANCE(split));
     qof_instance_set_destroying(split, TRUE);
-    qof_event_gen(&trans->inst, GNC_EVENT_ITEM_REMOVED, &ed);
+    qof_event_gen_about(&trans->inst, GNC_EVENT_ITEM_REMOVED,
+                        QOF_INSTANCE(split), &ed, sizeof(ed));
     xaccTransCommitEdit(trans);
 
     return TRUE;
@@ -1756,7 +1757,8 @@ xaccSplitSetParent(Split *s, Transaction *t)
     if (old_trans)
     {
         ed.idx = xaccTransGetSplitIndex(old_trans, s);
-        qof_event_gen(&old_trans->inst, GNC_EVENT_ITEM_REMOVED, &ed);
+        qof_event_gen_about(&old_trans->inst, GNC_EVENT_ITEM_REMOVED,
+                            QOF_INSTANCE(s), &ed, sizeof(ed));
     }
     s->parent = t;
 
@@ -1773,7 +1775,8 @@ xaccSplitSetParent(Split *s, Transaction *t)
             t->splits = g_list_append(t->splits, s);
 
         ed.idx = -1; /* unused */
-        qof_event_gen(&t->inst, GNC_EVENT_ITEM_ADDED, &ed);
+        qof_event_gen_about(&t->inst, GNC_EVENT_ITEM_ADDED,
+                            QOF_INSTANCE(s), &ed, sizeof(ed));
     }
     xaccTransCommitEdit(t);
 }
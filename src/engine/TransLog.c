@@ -24,9 +24,17 @@
 #include "config.h"
 
 #include <errno.h>
+#include <stdlib.h>
 #include <glib.h>
 #include <glib/gstdio.h>
 #include <string.h>
+#ifdef HAVE_UNISTD_H
+# include <unistd.h>
+#endif
+#ifdef G_OS_WIN32
+# include <io.h>
+# define fsync _commit
+#endif
 
 #include "Account.h"
 #include "Transaction.h"
@@ -76,6 +84,13 @@
  *     occurred at a certain time, it can be located.
  * (-) hack alert -- something better than just the account name
  *     is needed for identifying the account.
+ *
+ * Records are formatted in memory by the committing thread and handed
+ * to a writer thread, which writes whatever has piled up and flushes
+ * once per batch instead of once per transaction.  The file format is
+ * unchanged, gnc-log-replay reads it as before.  If no thread can be
+ * started the records are written and flushed right away, as they
+ * always were.
  */
 /* ------------------------------------------------------------------ */
 
@@ -85,6 +100,13 @@ static FILE * trans_log = NULL; /**< current log file handle */
 static char * trans_log_name = NULL; /**< current log file name */
 static char * log_base_name = NULL;
 
+/* A GAsyncQueue does its own locking and its timed pop lets the writer
+ * sleep until either a record arrives or the next sync is due. */
+static GAsyncQueue * log_queue = NULL; /**< GStrings waiting to be written */
+static GThread * log_thread = NULL;
+static guint log_sync_interval = 0; /**< msecs between fsyncs, 0 for none */
+static gchar log_stop_marker;       /**< queued to stop the writer */
+
 /********************************************************************\
 \********************************************************************/
 
@@ -100,6 +122,142 @@ void xaccLogEnable  (void)
 /********************************************************************\
 \********************************************************************/
 
+void
+xaccLogSetSyncInterval (guint msecs)
+{
+    /* Read by the writer thread; a stale value for one batch is harmless */
+    log_sync_interval = msecs;
+}
+
+/********************************************************************\
+\********************************************************************/
+
+static void
+log_sync (FILE *log)
+{
+    if (fsync (fileno (log)) != 0)
+    {
+        int norr = errno;
+        g_warning ("TransLog: cannot sync journal: %s", g_strerror (norr));
+    }
+}
+
+/* Write every record that is ready, then flush once.  When syncing is
+ * on, wait for more records no longer than the sync deadline, so that
+ * nothing stays unsynced for longer than the interval. */
+static gpointer
+log_writer_thread (gpointer data)
+{
+    FILE *log = data;
+    GTimeVal deadline;
+    gboolean unsynced = FALSE;
+    gboolean stop = FALSE;
+
+    while (!stop)
+    {
+        gpointer rec;
+
+        if (unsynced)
+        {
+            rec = g_async_queue_timed_pop (log_queue, &deadline);
+            if (!rec)
+            {
+                log_sync (log);
+                unsynced = FALSE;
+                continue;
+            }
+        }
+        else
+        {
+            rec = g_async_queue_pop (log_queue);
+        }
+
+        while (rec)
+        {
+            if (rec == &log_stop_marker)
+            {
+                stop = TRUE;
+                break;
+            }
+            fwrite (((GString *) rec)->str, 1, ((GString *) rec)->len, log);
+            g_string_free (rec, TRUE);
+            rec = g_async_queue_try_pop (log_queue);
+        }
+
+        /* get data out to the disk */
+        fflush (log);
+
+        if (log_sync_interval && !unsynced)
+        {
+            unsynced = TRUE;
+            g_get_current_time (&deadline);
+            g_time_val_add (&deadline, (glong) log_sync_interval * 1000);
+        }
+        else if (unsynced)
+        {
+            /* Records may keep coming faster than the deadline */
+            GTimeVal now;
+            g_get_current_time (&now);
+            if (now.tv_sec > deadline.tv_sec ||
+                    (now.tv_sec == deadline.tv_sec &&
+                     now.tv_usec >= deadline.tv_usec))
+            {
+                log_sync (log);
+                unsynced = FALSE;
+            }
+        }
+    }
+
+    if (unsynced)
+        log_sync (log);
+    return NULL;
+}
+
+static void log_stop_writer (void);
+
+static void
+log_start_writer (void)
+{
+    static gboolean registered = FALSE;
+    GError *error = NULL;
+
+    if (!g_thread_supported ()) return;
+
+    /* Nothing may be left in the queue when the program exits */
+    if (!registered)
+    {
+        atexit (log_stop_writer);
+        registered = TRUE;
+    }
+
+    log_queue = g_async_queue_new ();
+    log_thread = g_thread_create (log_writer_thread, trans_log, TRUE, &error);
+    if (!log_thread)
+    {
+        g_warning ("TransLog: could not create writer thread: %s",
+                   error->message);
+        g_error_free (error);
+        g_async_queue_unref (log_queue);
+        log_queue = NULL;
+    }
+}
+
+static void
+log_stop_writer (void)
+{
+    if (!log_thread) return;
+
+    /* The writer drains the queue up to the marker before it exits */
+    g_async_queue_push (log_queue, &log_stop_marker);
+    g_thread_join (log_thread);
+    g_async_queue_unref (log_queue);
+    log_thread = NULL;
+    log_queue = NULL;
+}
+
+/********************************************************************\
+\********************************************************************/
+
 void
 xaccReopenLog (void)
 {
@@ -194,6 +352,9 @@ xaccOpenLog (void)
              "notes\tmemo\taction\treconciled\t"
              "amount\tvalue\tdate_reconciled\n");
     fprintf (trans_log, "-----------------\n");
+    fflush (trans_log);
+
+    log_start_writer ();
 }
 
 /********************************************************************\
@@ -203,7 +364,10 @@ void
 xaccCloseLog (void)
 {
     if (!trans_log) return;
+    log_stop_writer ();
     fflush (trans_log);
+    if (log_sync_interval)
+        log_sync (trans_log);
     fclose (trans_log);
     trans_log = NULL;
 }
@@ -214,18 +378,29 @@ xaccCloseLog (void)
 void
 xaccTransWriteLog (Transaction *trans, char flag)
 {
+    static time_t last_now = 0;
+    static char dnow[100];
     GList *node;
     char trans_guid_str[GUID_ENCODING_LENGTH+1];
     char split_guid_str[GUID_ENCODING_LENGTH+1];
     const char *trans_notes;
-    char dnow[100], dent[100], dpost[100], drecn[100];
+    char dent[100], dpost[100], drecn[100];
     Timespec ts;
+    GString *rec;
+    time_t now;
 
     if (!gen_logs) return;
     if (!trans_log) return;
 
-    timespecFromTime_t(&ts, time(NULL));
-    gnc_timespec_to_iso8601_buff (ts, dnow);
+    /* Commits come in bursts, the time only needs formatting once a
+     * second. */
+    now = time(NULL);
+    if (now != last_now || !dnow[0])
+    {
+        timespecFromTime_t(&ts, now);
+        gnc_timespec_to_iso8601_buff (ts, dnow);
+        last_now = now;
+    }
 
     timespecFromTime_t(&ts, trans->date_entered.tv_sec);
     gnc_timespec_to_iso8601_buff (ts, dent);
@@ -235,7 +410,9 @@ xaccTransWriteLog (Transaction *trans, char flag)
 
     guid_to_string_buff (xaccTransGetGUID(trans), trans_guid_str);
     trans_notes = xaccTransGetNotes(trans);
-    fprintf (trans_log, "===== START\n");
+
+    rec = g_string_sized_new (512);
+    g_string_append (rec, "===== START\n");
 
     for (node = trans->splits; node; node = node->next)
     {
@@ -263,33 +440,42 @@ xaccTransWriteLog (Transaction *trans, char flag)
         val = xaccSplitGetValue (split);
 
         /* use tab-separated fields */
-        fprintf (trans_log,
-                 "%c\t%s\t%s\t%s\t%s\t%s\t%s\t%s\t%s\t"
-                 "%s\t%s\t%s\t%s\t%c\t%" G_GINT64_FORMAT "/%" G_GINT64_FORMAT "\t%" G_GINT64_FORMAT "/%" G_GINT64_FORMAT "\t%s\n",
-                 flag,
-                 trans_guid_str, split_guid_str,  /* trans+split make up unique id */
-                 /* Note that the next three strings always exist,
-                 		* so we don't need to test them. */
-                 dnow,
-                 dent,
-                 dpost,
-                 acc_guid_str,
-                 accname ? accname : "",
-                 trans->num ? trans->num : "",
-                 trans->description ? trans->description : "",
-                 trans_notes ? trans_notes : "",
-                 split->memo ? split->memo : "",
-                 split->action ? split->action : "",
-                 split->reconciled,
-                 gnc_numeric_num(amt),
-                 gnc_numeric_denom(amt),
-                 gnc_numeric_num(val),
-                 gnc_numeric_denom(val),
-                 /* The next string always exists. No need to test it. */
-                 drecn);
+        g_string_append_printf (rec,
+                                "%c\t%s\t%s\t%s\t%s\t%s\t%s\t%s\t%s\t"
+                                "%s\t%s\t%s\t%s\t%c\t%" G_GINT64_FORMAT "/%" G_GINT64_FORMAT "\t%" G_GINT64_FORMAT "/%" G_GINT64_FORMAT "\t%s\n",
+                                flag,
+                                trans_guid_str, split_guid_str,  /* trans+split make up unique id */
+                                /* Note that the next three strings always exist,
+                                 * so we don't need to test them. */
+                                dnow,
+                                dent,
+                                dpost,
+                                acc_guid_str,
+                                accname ? accname : "",
+                                trans->num ? trans->num : "",
+                                trans->description ? trans->description : "",
+                                trans_notes ? trans_notes : "",
+                                split->memo ? split->memo : "",
+                                split->action ? split->action : "",
+                                split->reconciled,
+                                gnc_numeric_num(amt),
+                                gnc_numeric_denom(amt),
+                                gnc_numeric_num(val),
+                                gnc_numeric_denom(val),
+                                /* The next string always exists. No need to test it. */
+                                drecn);
+    }
+
+    g_string_append (rec, "===== END\n");
+
+    if (log_thread)
+    {
+        g_async_queue_push (log_queue, rec);
+        return;
     }
 
-    fprintf (trans_log, "===== END\n");
+    fwrite (rec->str, 1, rec->len, trans_log);
+    g_string_free (rec, TRUE);
 
     /* get data out to the disk */
     fflush (trans_log);
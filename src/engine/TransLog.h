@@ -78,6 +78,15 @@ void    xaccLogDisable (void);
  */
 void    xaccLogSetBaseName (const char *);
 
+/** Records are written to the log by a background thread, which
+ *  flushes after each batch of records it writes.  When msecs is
+ *  not zero, the log is also synced to disk no later than msecs
+ *  after a record was written, so that a burst of commits costs one
+ *  fsync rather than one per transaction.  The default of zero never
+ *  syncs explicitly, leaving that to the operating system.  The GUI
+ *  sets this from the general/journal_sync_interval_msecs key. */
+void    xaccLogSetSyncInterval (guint msecs);
+
 /** Test a filename to see if it is the name of the current logfile */
 gboolean xaccFileIsCurrentLog (const gchar *name);
 
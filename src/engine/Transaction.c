@@ -241,7 +241,8 @@ void gen_event_trans (Transaction *trans)
         Account *account = s->acc;
         GNCLot *lot = s->lot;
         if (account)
-            qof_event_gen (&account->inst, GNC_EVENT_ITEM_CHANGED, s);
+            qof_event_gen_about (&account->inst, GNC_EVENT_ITEM_CHANGED,
+                                 QOF_INSTANCE(s), s, 0);
 
         if (lot)
         {
@@ -1286,6 +1287,10 @@ static void trans_cleanup_commit(Transaction *trans)
     }
     g_list_free(slist);
 
+    /* The online_id lives in the kvp data, which may have changed
+     * without marking any split dirty; refile every split. */
+    FOR_EACH_SPLIT(trans, if (s->acc) gnc_account_update_online_id(s->acc, s));
+
     xaccTransWriteLog (trans, 'C');
 
     /* Get rid of the copy we made. We won't be rolling back,
@@ -1396,6 +1401,7 @@ xaccTransRollbackEdit (Transaction *trans)
     Transaction *orig;
     GList *slist;
     int num_preexist, i;
+    gboolean date_changed;
     ENTER ("trans addr=%p\n", trans);
 
     check_open(trans);
@@ -1405,6 +1411,7 @@ xaccTransRollbackEdit (Transaction *trans)
     SWAP(trans->num, orig->num);
     SWAP(trans->description, orig->description);
     trans->date_entered = orig->date_entered;
+    date_changed = !timespec_equal(&trans->date_posted, &orig->date_posted);
     trans->date_posted = orig->date_posted;
     SWAP(trans->common_currency, orig->common_currency);
     SWAP(trans->inst.kvp_data, orig->inst.kvp_data);
@@ -1427,6 +1434,9 @@ xaccTransRollbackEdit (Transaction *trans)
             Split *so = onode->data;
 
             xaccSplitRollbackEdit(s);
+            /* The lot the split is leaving, if any, must forget it too */
+            if (s->lot && s->lot != so->lot)
+                gnc_lot_set_closed_unknown(s->lot);
             SWAP(s->action, so->action);
             SWAP(s->memo, so->memo);
             SWAP(s->inst.kvp_data, so->inst.kvp_data);
@@ -1437,6 +1447,8 @@ xaccTransRollbackEdit (Transaction *trans)
             s->gains_split = s->gains_split;
             //SET_GAINS_A_VDIRTY(s);
             s->date_reconciled = so->date_reconciled;
+            /* The account and lot cached the edited amount and date */
+            mark_split(s);
             qof_instance_mark_clean(QOF_INSTANCE(s));
             xaccFreeSplit(so);
         }
@@ -1468,6 +1480,10 @@ xaccTransRollbackEdit (Transaction *trans)
     g_list_free(orig->splits);
     orig->splits = NULL;
 
+    /* Splits that weren't edited still moved with the posted date */
+    if (date_changed)
+        mark_trans(trans);
+
     /* Now that the engine copy is back to its original version,
      * get the backend to fix it in the database */
     be = qof_book_get_backend(qof_instance_get_book(trans));
@@ -155,10 +155,13 @@ finder_helper (GNCLot *lot,  gpointer user_data)
         return NULL;
     }
 
+    /* The open lots are visited in order of their opening date, so
+       the first one that fits is the one we're after. */
     if (els->date_pred (els->ts, trans->date_posted))
     {
         els->ts = trans->date_posted;
         els->lot = lot;
+        return lot;
     }
 
     return NULL;
@@ -181,7 +184,8 @@ xaccAccountFindOpenLot (Account *acc, gnc_numeric sign,
     if (gnc_numeric_positive_p(sign)) es.numeric_pred = gnc_numeric_negative_p;
     else es.numeric_pred = gnc_numeric_positive_p;
 
-    xaccAccountForEachLot (acc, finder_helper, &es);
+    xaccAccountForEachOpenLot (acc, date_pred == latest_pred,
+                               finder_helper, &es);
     return es.lot;
 }
 
@@ -74,8 +74,17 @@ typedef struct LotPrivate
      */
     Account * account;
 
-    /* List of splits that belong to this lot. */
+    /* List of splits that belong to this lot, in the order given by
+     * xaccSplitOrderDateOnly() unless sort_dirty is set.  latest is
+     * the last split in that order. */
     SplitList *splits;
+    Split *latest;
+    gboolean sort_dirty;
+
+    /* Sum of the amounts of the splits, kept up to date as splits are
+     * added and removed.  Recomputed when a split in the lot changes. */
+    gnc_numeric balance;
+    gboolean balance_dirty;
 
     /* Handy cached value to indicate if lot is closed. */
     /* If value is negative, then the cache is invalid. */
@@ -104,6 +113,10 @@ gnc_lot_init(GNCLot* lot)
     priv = GET_PRIVATE(lot);
     priv->account = NULL;
     priv->splits = NULL;
+    priv->latest = NULL;
+    priv->sort_dirty = FALSE;
+    priv->balance = gnc_numeric_zero();
+    priv->balance_dirty = FALSE;
     priv->is_closed = LOT_CLOSED_UNKNOWN;
     priv->marker = 0;
 }
@@ -197,6 +210,16 @@ gnc_lot_class_init(GNCLotClass* klass)
 
 }
 
+/* Let the account know that this lot may have opened, closed or
+ * changed its opening date.  Not needed once the book is going away,
+ * and the account may well be gone by then. */
+static void
+lot_changed (GNCLot *lot, LotPrivate *priv)
+{
+    if (priv->account && !qof_book_shutting_down (gnc_lot_get_book (lot)))
+        gnc_account_lot_changed (priv->account, lot);
+}
+
 GNCLot *
 gnc_lot_new (QofBook *book)
 {
@@ -220,12 +243,15 @@ gnc_lot_free(GNCLot* lot)
     qof_event_gen (QOF_INSTANCE(lot), QOF_EVENT_DESTROY, NULL);
 
     priv = GET_PRIVATE(lot);
+    lot_changed (lot, priv);
     for (node = priv->splits; node; node = node->next)
     {
         Split *s = node->data;
         s->lot = NULL;
     }
     g_list_free (priv->splits);
+    priv->splits = NULL;
+    priv->latest = NULL;
 
     priv->account = NULL;
     priv->is_closed = TRUE;
@@ -348,8 +374,13 @@ gnc_lot_set_closed_unknown(GNCLot* lot)
     LotPrivate* priv;
     if (lot != NULL)
     {
+        /* One of the splits changed; its amount or date may be
+         * different, so nothing cached can be trusted. */
         priv = GET_PRIVATE(lot);
         priv->is_closed = LOT_CLOSED_UNKNOWN;
+        priv->balance_dirty = TRUE;
+        priv->sort_dirty = TRUE;
+        lot_changed (lot, priv);
     }
 }
 
@@ -431,15 +462,21 @@ gnc_lot_get_balance (GNCLot *lot)
         return zero;
     }
 
-    /* Sum over splits; because they all belong to same account
-     * they will have same denominator.
-     */
-    for (node = priv->splits; node; node = node->next)
+    if (priv->balance_dirty)
     {
-        Split *s = node->data;
-        gnc_numeric amt = xaccSplitGetAmount (s);
-        baln = gnc_numeric_add_fixed (baln, amt);
+        /* Sum over splits; because they all belong to same account
+         * they will have same denominator.
+         */
+        for (node = priv->splits; node; node = node->next)
+        {
+            Split *s = node->data;
+            gnc_numeric amt = xaccSplitGetAmount (s);
+            baln = gnc_numeric_add_fixed (baln, amt);
+        }
+        priv->balance = baln;
+        priv->balance_dirty = FALSE;
     }
+    baln = priv->balance;
 
     /* cache a zero balance as a closed lot */
     if (gnc_numeric_equal (baln, zero))
@@ -506,6 +543,40 @@ gnc_lot_get_balance_before (const GNCLot *lot, const Split *split,
 
 /* ============================================================= */
 
+/* Put the split after every split that doesn't sort after it, so the
+ * list ends up the same as if it had been appended and then sorted.
+ * Most new splits are the latest in their lot, so try the end first. */
+static void
+lot_insert_split (LotPrivate *priv, Split *split)
+{
+    GList *node, *prev = NULL;
+
+    if (priv->sort_dirty)
+    {
+        priv->splits = g_list_prepend (priv->splits, split);
+        return;
+    }
+
+    if (!priv->latest ||
+            xaccSplitOrderDateOnly (priv->latest, split) <= 0)
+    {
+        priv->splits = g_list_append (priv->splits, split);
+        priv->latest = split;
+        return;
+    }
+
+    for (node = priv->splits; node; node = node->next)
+    {
+        if (xaccSplitOrderDateOnly (node->data, split) > 0)
+            break;
+        prev = node;
+    }
+    if (prev)
+        g_list_insert_before (prev, prev->next, split);
+    else
+        priv->splits = g_list_prepend (priv->splits, split);
+}
+
 void
 gnc_lot_add_split (GNCLot *lot, Split *split)
 {
@@ -548,10 +619,14 @@ gnc_lot_add_split (GNCLot *lot, Split *split)
     }
     xaccSplitSetLot(split, lot);
 
-    priv->splits = g_list_append (priv->splits, split);
+    lot_insert_split (priv, split);
+    if (!priv->balance_dirty)
+        priv->balance = gnc_numeric_add_fixed (priv->balance,
+                                               xaccSplitGetAmount (split));
 
     /* for recomputation of is-closed */
     priv->is_closed = LOT_CLOSED_UNKNOWN;
+    lot_changed (lot, priv);
     gnc_lot_commit_edit(lot);
 
     qof_event_gen (QOF_INSTANCE(lot), QOF_EVENT_MODIFY, NULL);
@@ -562,13 +637,23 @@ void
 gnc_lot_remove_split (GNCLot *lot, Split *split)
 {
     LotPrivate* priv;
+    GList *node;
     if (!lot || !split) return;
     priv = GET_PRIVATE(lot);
 
     ENTER ("(lot=%p, split=%p)", lot, split);
     gnc_lot_begin_edit(lot);
     qof_instance_set_dirty(QOF_INSTANCE(lot));
-    priv->splits = g_list_remove (priv->splits, split);
+    node = g_list_find (priv->splits, split);
+    if (node)
+    {
+        if (!priv->balance_dirty)
+            priv->balance = gnc_numeric_sub_fixed (priv->balance,
+                                                   xaccSplitGetAmount (split));
+        if (split == priv->latest)
+            priv->latest = node->prev ? node->prev->data : NULL;
+        priv->splits = g_list_delete_link (priv->splits, node);
+    }
     xaccSplitSetLot(split, NULL);
     priv->is_closed = LOT_CLOSED_UNKNOWN;   /* force an is-closed computation */
 
@@ -576,6 +661,14 @@ gnc_lot_remove_split (GNCLot *lot, Split *split)
     {
         xaccAccountRemoveLot (priv->account, lot);
         priv->account = NULL;
+        priv->latest = NULL;
+        priv->sort_dirty = FALSE;
+        priv->balance = gnc_numeric_zero();
+        priv->balance_dirty = FALSE;
+    }
+    else
+    {
+        lot_changed (lot, priv);
     }
     gnc_lot_commit_edit(lot);
     qof_event_gen (QOF_INSTANCE(lot), QOF_EVENT_MODIFY, NULL);
@@ -584,6 +677,15 @@ gnc_lot_remove_split (GNCLot *lot, Split *split)
 /* ============================================================== */
 /* Utility function, get earliest split in lot */
 
+static void
+lot_sort_splits (LotPrivate *priv)
+{
+    if (!priv->sort_dirty) return;
+    priv->splits = g_list_sort (priv->splits, (GCompareFunc) xaccSplitOrderDateOnly);
+    priv->latest = priv->splits ? g_list_last (priv->splits)->data : NULL;
+    priv->sort_dirty = FALSE;
+}
+
 Split *
 gnc_lot_get_earliest_split (GNCLot *lot)
 {
@@ -591,7 +693,7 @@ gnc_lot_get_earliest_split (GNCLot *lot)
     if (!lot) return NULL;
     priv = GET_PRIVATE(lot);
     if (! priv->splits) return NULL;
-    priv->splits = g_list_sort (priv->splits, (GCompareFunc) xaccSplitOrderDateOnly);
+    lot_sort_splits (priv);
     return priv->splits->data;
 }
 
@@ -599,17 +701,12 @@ Split *
 gnc_lot_get_latest_split (GNCLot *lot)
 {
     LotPrivate* priv;
-    SplitList *node;
 
     if (!lot) return NULL;
     priv = GET_PRIVATE(lot);
     if (! priv->splits) return NULL;
-    priv->splits = g_list_sort (priv->splits, (GCompareFunc) xaccSplitOrderDateOnly);
-
-    for (node = priv->splits; node->next; node = node->next)
-        ;
-
-    return node->data;
+    lot_sort_splits (priv);
+    return priv->latest;
 }
 
 /* ============================================================= */
@@ -57,6 +57,7 @@ struct gnc_price_db_s
     QofInstance inst;              /* globally unique object identifier */
     GHashTable *commodity_hash;
     gboolean bulk_update;		 /* TRUE while reading XML file, etc. */
+    GHashTable *conversion_cache;	 /* conversion paths, see gnc-pricedb.c */
 };
 
 struct _GncPriceDBClass
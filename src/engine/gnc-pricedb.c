@@ -34,6 +34,7 @@ static QofLogModule log_module = GNC_MOD_PRICE;
 
 static gboolean add_price(GNCPriceDB *db, GNCPrice *p);
 static gboolean remove_price(GNCPriceDB *db, GNCPrice *p, gboolean cleanup);
+static void pricedb_invalidate_conversions(GNCPriceDB *db);
 
 enum
 {
@@ -473,6 +474,9 @@ gnc_price_set_value(GNCPrice *p, gnc_numeric value)
         p->value = value;
         gnc_price_set_dirty(p);
         gnc_price_commit_edit (p);
+        /* A zero price is skipped when looking for a conversion path */
+        if (p->db)
+            pricedb_invalidate_conversions(p->db);
     }
 }
 
@@ -719,15 +723,266 @@ gnc_price_list_equal(PriceList *prices1, PriceList *prices2)
     return TRUE;
 }
 
+/* ==================================================================== */
+/* Price series
+
+   All the prices of one commodity in one currency are kept in a
+   PriceSeries.  'prices' is an ordinary price list, sorted by
+   compare_prices_by_date() (most recent first), and is what gets
+   handed out and traversed.  'index' holds the nodes of that same
+   list in the opposite order, oldest first, so that a price can be
+   located by date with a binary search and a new most-recent price is
+   appended at the end of the array.  The two are always kept in step.
+ */
+
+typedef struct
+{
+    GList *prices;              /* GNCPrice*, most recent first */
+    GPtrArray *index;           /* GList* nodes of 'prices', oldest first */
+} PriceSeries;
+
+#define price_series_nth(series, i) \
+    ((GNCPrice *)((GList *)g_ptr_array_index((series)->index, (i)))->data)
+
+static PriceSeries *
+price_series_new (void)
+{
+    PriceSeries *series = g_new0 (PriceSeries, 1);
+    series->index = g_ptr_array_new ();
+    return series;
+}
+
+/* Free the series, dropping the list's reference on each price. */
+static void
+price_series_destroy (PriceSeries *series)
+{
+    if (!series) return;
+    gnc_price_list_destroy (series->prices);
+    g_ptr_array_free (series->index, TRUE);
+    g_free (series);
+}
+
+/* Return the index of the first price dated after 't', or at or after
+ * 't' if 'inclusive' is TRUE.  If 'by_day' is TRUE, the prices are
+ * compared by their canonical day time, and 't' must be one too. */
+static guint
+price_series_bisect (const PriceSeries *series, Timespec t,
+                     gboolean by_day, gboolean inclusive)
+{
+    guint lo = 0, hi = series->index->len;
+
+    while (lo < hi)
+    {
+        guint mid = lo + (hi - lo) / 2;
+        Timespec price_time = gnc_price_get_time (price_series_nth (series, mid));
+        gint cmp;
+
+        if (by_day)
+            price_time = timespecCanonicalDayTime (price_time);
+        cmp = timespec_cmp (&price_time, &t);
+        if (cmp > 0 || (inclusive && cmp == 0))
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+    return lo;
+}
+
+/* Return the index at which 'p' belongs, or is found, in the series.
+ * This is compare_prices_by_date() reversed, so ties are broken by
+ * guid exactly as they are in the list. */
+static guint
+price_series_position (const PriceSeries *series, GNCPrice *p)
+{
+    guint lo = 0, hi = series->index->len;
+
+    while (lo < hi)
+    {
+        guint mid = lo + (hi - lo) / 2;
+
+        if (compare_prices_by_date (p, price_series_nth (series, mid)) >= 0)
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+    return lo;
+}
+
+/* TRUE if the series holds a price with the same value on the same
+ * day as p.  The commodity and currency are the same by construction. */
+static gboolean
+price_series_has_duplicate (const PriceSeries *series, GNCPrice *p)
+{
+    Timespec day = timespecCanonicalDayTime (gnc_price_get_time (p));
+    guint i, end;
+
+    i = price_series_bisect (series, day, TRUE, TRUE);
+    end = price_series_bisect (series, day, TRUE, FALSE);
+    for (; i < end; i++)
+        if (gnc_numeric_equal (gnc_price_get_value (price_series_nth (series, i)),
+                               gnc_price_get_value (p)))
+            return TRUE;
+    return FALSE;
+}
+
+/* Add a price to the series, taking a reference on it. */
+static void
+price_series_insert (PriceSeries *series, GNCPrice *p)
+{
+    GList *link;
+    guint pos, len;
+
+    gnc_price_ref (p);
+    link = g_list_alloc ();
+    link->data = p;
+
+    pos = price_series_position (series, p);
+    len = series->index->len;
+    if (pos < len)
+    {
+        /* The next more recent price precedes the new one in the list. */
+        GList *newer = g_ptr_array_index (series->index, pos);
+
+        link->prev = newer;
+        link->next = newer->next;
+        if (link->next)
+            link->next->prev = link;
+        newer->next = link;
+    }
+    else
+    {
+        link->next = series->prices;
+        if (series->prices)
+            series->prices->prev = link;
+        series->prices = link;
+    }
+
+    g_ptr_array_add (series->index, NULL);
+    if (pos < len)
+        memmove (&series->index->pdata[pos + 1], &series->index->pdata[pos],
+                 (len - pos) * sizeof (gpointer));
+    series->index->pdata[pos] = link;
+}
+
+/* Find where a price is in the series.  Returns FALSE if it isn't. */
+static gboolean
+price_series_find (const PriceSeries *series, GNCPrice *p, guint *out_pos)
+{
+    guint pos;
+
+    pos = price_series_position (series, p);
+    if (pos < series->index->len && price_series_nth (series, pos) == p)
+    {
+        *out_pos = pos;
+        return TRUE;
+    }
+
+    /* Shouldn't happen, since dates are only changed by removing
+     * and re-adding the price, but don't lose track of it. */
+    for (pos = 0; pos < series->index->len; pos++)
+        if (price_series_nth (series, pos) == p)
+        {
+            PWARN ("price %p not at its sorted position", p);
+            *out_pos = pos;
+            return TRUE;
+        }
+    return FALSE;
+}
+
+/* Remove the price at 'pos' from the series, dropping the series'
+ * reference on it. */
+static void
+price_series_remove (PriceSeries *series, guint pos)
+{
+    GList *link = g_ptr_array_index (series->index, pos);
+    GNCPrice *p = link->data;
+
+    g_ptr_array_remove_index (series->index, pos);
+    series->prices = g_list_delete_link (series->prices, link);
+    gnc_price_unref (p);
+}
+
+/* The most recent price at or before 't', or NULL if none. */
+static GNCPrice *
+price_series_latest_before (const PriceSeries *series, Timespec t)
+{
+    guint pos = price_series_bisect (series, t, FALSE, FALSE);
+    return pos > 0 ? price_series_nth (series, pos - 1) : NULL;
+}
+
+/* The price closest in time to 't'.  If two prices are equally close,
+ * the older one is chosen when 'prefer_older' is TRUE. */
+static GNCPrice *
+price_series_nearest (const PriceSeries *series, Timespec t,
+                      gboolean prefer_older)
+{
+    GNCPrice *before, *after;
+    Timespec before_t, after_t, diff_before, diff_after, abs_before, abs_after;
+    guint pos, len = series->index->len;
+    gint cmp;
+
+    if (len == 0) return NULL;
+    pos = price_series_bisect (series, t, FALSE, FALSE);
+    if (pos == 0) return price_series_nth (series, 0);
+    if (pos == len) return price_series_nth (series, len - 1);
+
+    before = price_series_nth (series, pos - 1);
+    after = price_series_nth (series, pos);
+    before_t = gnc_price_get_time (before);
+    after_t = gnc_price_get_time (after);
+    diff_before = timespec_diff (&before_t, &t);
+    diff_after = timespec_diff (&after_t, &t);
+    abs_before = timespec_abs (&diff_before);
+    abs_after = timespec_abs (&diff_after);
+
+    cmp = timespec_cmp (&abs_after, &abs_before);
+    if (cmp < 0 || (cmp == 0 && !prefer_older))
+        return after;
+    return before;
+}
+
+/* Prepend the prices in the series dated exactly 't' (or on the same
+ * day, if 'by_day') to 'result', oldest first, taking a reference on
+ * each one. */
+static GList *
+price_series_collect (const PriceSeries *series, Timespec t, gboolean by_day,
+                      GList *result)
+{
+    guint start, i;
+
+    start = price_series_bisect (series, t, by_day, TRUE);
+    i = price_series_bisect (series, t, by_day, FALSE);
+    while (i > start)
+    {
+        GNCPrice *p = price_series_nth (series, --i);
+        result = g_list_prepend (result, p);
+        gnc_price_ref (p);
+    }
+    return result;
+}
+
+/* Fetch the series for a commodity/currency pair, or NULL. */
+static PriceSeries *
+pricedb_get_series (GNCPriceDB *db, const gnc_commodity *commodity,
+                    const gnc_commodity *currency)
+{
+    GHashTable *currency_hash;
+
+    currency_hash = g_hash_table_lookup (db->commodity_hash, commodity);
+    if (!currency_hash) return NULL;
+    return g_hash_table_lookup (currency_hash, currency);
+}
+
 /* ==================================================================== */
 /* GNCPriceDB functions
 
    Structurally a GNCPriceDB contains a hash mapping price commodities
    (of type gnc_commodity*) to hashes mapping price currencies (of
-   type gnc_commodity*) to GNCPrice lists (see gnc-pricedb.h for a
-   description of GNCPrice lists).  The top-level key is the commodity
-   you want the prices for, and the second level key is the commodity
-   that the value is expressed in terms of.
+   type gnc_commodity*) to PriceSeries, each of which holds a GNCPrice
+   list (see gnc-pricedb.h for a description of GNCPrice lists) and a
+   date index into it.  The top-level key is the commodity you want
+   the prices for, and the second level key is the commodity that the
+   value is expressed in terms of.
  */
 
 /* GObject Initialization */
@@ -778,6 +1033,7 @@ gnc_pricedb_create(QofBook * book)
 
     result->commodity_hash = g_hash_table_new(NULL, NULL);
     g_return_val_if_fail (result->commodity_hash, NULL);
+    result->conversion_cache = NULL;
     return result;
 }
 
@@ -786,18 +1042,18 @@ destroy_pricedb_currency_hash_data(gpointer key,
                                    gpointer data,
                                    gpointer user_data)
 {
-    GList *price_list = (GList *) data;
+    PriceSeries *series = (PriceSeries *) data;
     GList *node;
     GNCPrice *p;
 
-    for (node = price_list; node; node = node->next)
+    for (node = series->prices; node; node = node->next)
     {
         p = node->data;
 
         p->db = NULL;
     }
 
-    gnc_price_list_destroy(price_list);
+    price_series_destroy(series);
 }
 
 static void
@@ -817,6 +1073,11 @@ void
 gnc_pricedb_destroy(GNCPriceDB *db)
 {
     if (!db) return;
+    if (db->conversion_cache)
+    {
+        g_hash_table_destroy (db->conversion_cache);
+        db->conversion_cache = NULL;
+    }
     if (db->commodity_hash)
     {
         g_hash_table_foreach (db->commodity_hash,
@@ -907,7 +1168,7 @@ pricedb_equal_foreach_pricelist(gpointer key, gpointer val, gpointer user_data)
 {
     GNCPriceDBEqualData *equal_data = user_data;
     gnc_commodity *currency = key;
-    GList *price_list1 = val;
+    GList *price_list1 = ((PriceSeries *) val)->prices;
     GList *price_list2;
 
     price_list2 = gnc_pricedb_get_prices (equal_data->db2,
@@ -966,7 +1227,7 @@ add_price(GNCPriceDB *db, GNCPrice *p)
 {
     /* This function will use p, adding a ref, so treat p as read-only
        if this function succeeds. */
-    GList *price_list;
+    PriceSeries *series;
     gnc_commodity *commodity;
     gnc_commodity *currency;
     GHashTable *currency_hash;
@@ -1010,19 +1271,24 @@ add_price(GNCPriceDB *db, GNCPrice *p)
         g_hash_table_insert(db->commodity_hash, commodity, currency_hash);
     }
 
-    price_list = g_hash_table_lookup(currency_hash, currency);
-    if (!gnc_price_list_insert(&price_list, p, !db->bulk_update))
+    series = g_hash_table_lookup(currency_hash, currency);
+    if (!series)
     {
-        LEAVE ("gnc_price_list_insert failed");
-        return FALSE;
+        series = price_series_new();
+        g_hash_table_insert(currency_hash, currency, series);
     }
-    if (!price_list)
+    if (!db->bulk_update && price_series_has_duplicate(series, p))
     {
-        LEAVE (" no price list");
-        return FALSE;
+        /* Leave the duplicate out, but keep the reference that
+         * gnc_price_list_insert() always used to take. */
+        gnc_price_ref(p);
+    }
+    else
+    {
+        price_series_insert(series, p);
     }
-    g_hash_table_insert(currency_hash, currency, price_list);
     p->db = db;
+    pricedb_invalidate_conversions(db);
     qof_event_gen (&p->inst, QOF_EVENT_ADD, NULL);
 
     LEAVE ("db=%p, pr=%p dirty=%d dextroying=%d commodity=%s/%s currency_hash=%p",
@@ -1069,10 +1335,11 @@ gnc_pricedb_add_price(GNCPriceDB *db, GNCPrice *p)
 static gboolean
 remove_price(GNCPriceDB *db, GNCPrice *p, gboolean cleanup)
 {
-    GList *price_list;
+    PriceSeries *series;
     gnc_commodity *commodity;
     gnc_commodity *currency;
     GHashTable *currency_hash;
+    guint pos;
 
     if (!db || !p) return FALSE;
     ENTER ("db=%p, pr=%p dirty=%d destroying=%d",
@@ -1104,25 +1371,30 @@ remove_price(GNCPriceDB *db, GNCPrice *p, gboolean cleanup)
         return FALSE;
     }
 
-    qof_event_gen (&p->inst, QOF_EVENT_REMOVE, NULL);
-    price_list = g_hash_table_lookup(currency_hash, currency);
-    gnc_price_ref(p);
-    if (!gnc_price_list_remove(&price_list, p))
+    series = g_hash_table_lookup(currency_hash, currency);
+    if (!series)
     {
-        gnc_price_unref(p);
-        LEAVE (" cannot remove price list");
+        LEAVE (" no price series");
         return FALSE;
     }
 
-    /* if the price list is empty, then remove this currency from the
-       commodity hash */
-    if (price_list)
+    if (!price_series_find(series, p, &pos))
     {
-        g_hash_table_insert(currency_hash, currency, price_list);
+        LEAVE (" price not in the db");
+        return FALSE;
     }
-    else
+
+    qof_event_gen (&p->inst, QOF_EVENT_REMOVE, NULL);
+    gnc_price_ref(p);
+    price_series_remove(series, pos);
+    pricedb_invalidate_conversions(db);
+
+    /* if the price list is empty, then remove this currency from the
+       commodity hash */
+    if (!series->prices)
     {
         g_hash_table_remove(currency_hash, currency);
+        price_series_destroy(series);
 
         if (cleanup)
         {
@@ -1217,7 +1489,7 @@ pricedb_remove_foreach_pricelist (gpointer key,
                                   gpointer val,
                                   gpointer user_data)
 {
-    GList *price_list = (GList *) val;
+    GList *price_list = ((PriceSeries *) val)->prices;
     GList *node = price_list;
     remove_info *data = (remove_info *) user_data;
 
@@ -1297,9 +1569,8 @@ gnc_pricedb_lookup_latest(GNCPriceDB *db,
                           const gnc_commodity *commodity,
                           const gnc_commodity *currency)
 {
-    GList *price_list;
+    PriceSeries *series;
     GNCPrice *result;
-    GHashTable *currency_hash;
     QofBook *book;
     QofBackend *be;
 
@@ -1319,15 +1590,8 @@ gnc_pricedb_lookup_latest(GNCPriceDB *db,
     }
 #endif
 
-    currency_hash = g_hash_table_lookup(db->commodity_hash, commodity);
-    if (!currency_hash)
-    {
-        LEAVE (" no currency hash");
-        return NULL;
-    }
-
-    price_list = g_hash_table_lookup(currency_hash, currency);
-    if (!price_list)
+    series = pricedb_get_series(db, commodity, currency);
+    if (!series)
     {
         LEAVE (" no price list");
         return NULL;
@@ -1336,7 +1600,7 @@ gnc_pricedb_lookup_latest(GNCPriceDB *db,
     /* This works magically because prices are inserted in date-sorted
      * order, and the latest date always comes first. So return the
      * first in the list.  */
-    result = price_list->data;
+    result = series->prices->data;
     gnc_price_ref(result);
     LEAVE(" ");
     return result;
@@ -1347,7 +1611,7 @@ static void
 lookup_latest(gpointer key, gpointer val, gpointer user_data)
 {
     //gnc_commodity *currency = (gnc_commodity *)key;
-    GList *price_list = (GList *)val;
+    GList *price_list = ((PriceSeries *)val)->prices;
     GList **return_list = (GList **)user_data;
 
     if (!price_list) return;
@@ -1408,7 +1672,7 @@ static void
 hash_values_helper(gpointer key, gpointer value, gpointer data)
 {
     GList ** l = data;
-    *l = g_list_concat(*l, g_list_copy (value));
+    *l = g_list_concat(*l, g_list_copy (((PriceSeries *)value)->prices));
 }
 
 gboolean
@@ -1416,7 +1680,7 @@ gnc_pricedb_has_prices(GNCPriceDB *db,
                        const gnc_commodity *commodity,
                        const gnc_commodity *currency)
 {
-    GList *price_list;
+    PriceSeries *series;
     GHashTable *currency_hash;
     gint size;
     QofBook *book;
@@ -1446,8 +1710,8 @@ gnc_pricedb_has_prices(GNCPriceDB *db,
 
     if (currency)
     {
-        price_list = g_hash_table_lookup(currency_hash, currency);
-        if (price_list)
+        series = g_hash_table_lookup(currency_hash, currency);
+        if (series)
         {
             LEAVE("yes");
             return TRUE;
@@ -1467,7 +1731,7 @@ gnc_pricedb_get_prices(GNCPriceDB *db,
                        const gnc_commodity *commodity,
                        const gnc_commodity *currency)
 {
-    GList *price_list;
+    PriceSeries *series;
     GList *result;
     GList *node;
     GHashTable *currency_hash;
@@ -1498,13 +1762,13 @@ gnc_pricedb_get_prices(GNCPriceDB *db,
 
     if (currency)
     {
-        price_list = g_hash_table_lookup(currency_hash, currency);
-        if (!price_list)
+        series = g_hash_table_lookup(currency_hash, currency);
+        if (!series)
         {
             LEAVE (" no price list");
             return NULL;
         }
-        result = g_list_copy (price_list);
+        result = g_list_copy (series->prices);
     }
     else
     {
@@ -1525,10 +1789,8 @@ gnc_pricedb_lookup_day(GNCPriceDB *db,
                        const gnc_commodity *currency,
                        Timespec t)
 {
-    GList *price_list;
+    PriceSeries *series;
     GList *result = NULL;
-    GList *item = NULL;
-    GHashTable *currency_hash;
     QofBook *book;
     QofBackend *be;
 
@@ -1550,32 +1812,14 @@ gnc_pricedb_lookup_day(GNCPriceDB *db,
         (be->price_lookup) (be, &pl);
     }
 #endif
-    currency_hash = g_hash_table_lookup(db->commodity_hash, c);
-    if (!currency_hash)
-    {
-        LEAVE (" no currency hash");
-        return NULL;
-    }
-
-    price_list = g_hash_table_lookup(currency_hash, currency);
-    if (!price_list)
+    series = pricedb_get_series(db, c, currency);
+    if (!series)
     {
         LEAVE (" no price list");
         return NULL;
     }
 
-    item = price_list;
-    while (item)
-    {
-        GNCPrice *p = item->data;
-        Timespec price_time = timespecCanonicalDayTime(gnc_price_get_time(p));
-        if (timespec_equal(&price_time, &t))
-        {
-            result = g_list_prepend(result, p);
-            gnc_price_ref(p);
-        }
-        item = item->next;
-    }
+    result = price_series_collect(series, t, TRUE, NULL);
     LEAVE (" ");
     return result;
 }
@@ -1585,23 +1829,16 @@ static void
 lookup_day(gpointer key, gpointer val, gpointer user_data)
 {
     //gnc_commodity *currency = (gnc_commodity *)key;
-    GList *price_list = (GList *)val;
-    GList *item = NULL;
+    PriceSeries *series = (PriceSeries *)val;
     GNCPriceLookupHelper *lookup_helper = (GNCPriceLookupHelper *)user_data;
     GList **return_list = lookup_helper->return_list;
     Timespec t = lookup_helper->time;
+    guint i, end;
 
-    item = price_list;
-    while (item)
-    {
-        GNCPrice *p = item->data;
-        Timespec price_time = timespecCanonicalDayTime(gnc_price_get_time(p));
-        if (timespec_equal(&price_time, &t))
-        {
-            gnc_price_list_insert(return_list, item->data, FALSE);
-        }
-        item = item->next;
-    }
+    i = price_series_bisect(series, t, TRUE, TRUE);
+    end = price_series_bisect(series, t, TRUE, FALSE);
+    for (; i < end; i++)
+        gnc_price_list_insert(return_list, price_series_nth(series, i), FALSE);
 }
 
 PriceList *
@@ -1663,10 +1900,8 @@ gnc_pricedb_lookup_at_time(GNCPriceDB *db,
                            const gnc_commodity *currency,
                            Timespec t)
 {
-    GList *price_list;
+    PriceSeries *series;
     GList *result = NULL;
-    GList *item = NULL;
-    GHashTable *currency_hash;
     QofBook *book;
     QofBackend *be;
 
@@ -1686,32 +1921,14 @@ gnc_pricedb_lookup_at_time(GNCPriceDB *db,
         (be->price_lookup) (be, &pl);
     }
 #endif
-    currency_hash = g_hash_table_lookup(db->commodity_hash, c);
-    if (!currency_hash)
-    {
-        LEAVE (" no currency hash");
-        return NULL;
-    }
-
-    price_list = g_hash_table_lookup(currency_hash, currency);
-    if (!price_list)
+    series = pricedb_get_series(db, c, currency);
+    if (!series)
     {
         LEAVE (" no price list");
         return NULL;
     }
 
-    item = price_list;
-    while (item)
-    {
-        GNCPrice *p = item->data;
-        Timespec price_time = gnc_price_get_time(p);
-        if (timespec_equal(&price_time, &t))
-        {
-            result = g_list_prepend(result, p);
-            gnc_price_ref(p);
-        }
-        item = item->next;
-    }
+    result = price_series_collect(series, t, FALSE, NULL);
     LEAVE (" ");
     return result;
 }
@@ -1720,23 +1937,16 @@ static void
 lookup_time(gpointer key, gpointer val, gpointer user_data)
 {
     //gnc_commodity *currency = (gnc_commodity *)key;
-    GList *price_list = (GList *)val;
-    GList *item = NULL;
+    PriceSeries *series = (PriceSeries *)val;
     GNCPriceLookupHelper *lookup_helper = (GNCPriceLookupHelper *)user_data;
     GList **return_list = lookup_helper->return_list;
     Timespec t = lookup_helper->time;
+    guint i, end;
 
-    item = price_list;
-    while (item)
-    {
-        GNCPrice *p = item->data;
-        Timespec price_time = gnc_price_get_time(p);
-        if (timespec_equal(&price_time, &t))
-        {
-            gnc_price_list_insert(return_list, item->data, FALSE);
-        }
-        item = item->next;
-    }
+    i = price_series_bisect(series, t, FALSE, TRUE);
+    end = price_series_bisect(series, t, FALSE, FALSE);
+    for (; i < end; i++)
+        gnc_price_list_insert(return_list, price_series_nth(series, i), FALSE);
 }
 
 PriceList *
@@ -1796,12 +2006,8 @@ gnc_pricedb_lookup_nearest_in_time(GNCPriceDB *db,
                                    const gnc_commodity *currency,
                                    Timespec t)
 {
-    GList *price_list;
-    GNCPrice *current_price = NULL;
-    GNCPrice *next_price = NULL;
-    GNCPrice *result = NULL;
-    GList *item = NULL;
-    GHashTable *currency_hash;
+    PriceSeries *series;
+    GNCPrice *result;
     QofBook *book;
     QofBackend *be;
 
@@ -1821,68 +2027,17 @@ gnc_pricedb_lookup_nearest_in_time(GNCPriceDB *db,
         (be->price_lookup) (be, &pl);
     }
 #endif
-    currency_hash = g_hash_table_lookup(db->commodity_hash, c);
-    if (!currency_hash)
-    {
-        LEAVE ("no currency hash");
-        return NULL;
-    }
-
-    price_list = g_hash_table_lookup(currency_hash, currency);
-    if (!price_list)
+    series = pricedb_get_series(db, c, currency);
+    if (!series)
     {
         LEAVE ("no price list");
         return NULL;
     }
 
-    item = price_list;
-
-    /* default answer */
-    current_price = item->data;
-
-    /* find the first candidate past the one we want.  Remember that
-       prices are in most-recent-first order. */
-    while (!next_price && item)
-    {
-        GNCPrice *p = item->data;
-        Timespec price_time = gnc_price_get_time(p);
-        if (timespec_cmp(&price_time, &t) <= 0)
-        {
-            next_price = item->data;
-            break;
-        }
-        current_price = item->data;
-        item = item->next;
-    }
-
-    if (current_price)
-    {
-        if (!next_price)
-        {
-            result = current_price;
-        }
-        else
-        {
-            Timespec current_t = gnc_price_get_time(current_price);
-            Timespec next_t = gnc_price_get_time(next_price);
-            Timespec diff_current = timespec_diff(&current_t, &t);
-            Timespec diff_next = timespec_diff(&next_t, &t);
-            Timespec abs_current = timespec_abs(&diff_current);
-            Timespec abs_next = timespec_abs(&diff_next);
-
-            /* Choose the price that is closest to the given time. In case of
-             * a tie, prefer the older price since it actually existed at the
-             * time. (This also fixes bug #541970.) */
-            if (timespec_cmp(&abs_current, &abs_next) < 0)
-            {
-                result = current_price;
-            }
-            else
-            {
-                result = next_price;
-            }
-        }
-    }
+    /* Choose the price that is closest to the given time. In case of
+     * a tie, prefer the older price since it actually existed at the
+     * time. (This also fixes bug #541970.) */
+    result = price_series_nearest(series, t, TRUE);
 
     gnc_price_ref(result);
     LEAVE (" ");
@@ -1895,15 +2050,10 @@ gnc_pricedb_lookup_latest_before (GNCPriceDB *db,
                                   gnc_commodity *currency,
                                   Timespec t)
 {
-    GList *price_list;
-    GNCPrice *current_price = NULL;
-    /*  GNCPrice *next_price = NULL;
-        GNCPrice *result = NULL;*/
-    GList *item = NULL;
-    GHashTable *currency_hash;
+    PriceSeries *series;
+    GNCPrice *current_price;
     QofBook *book;
     QofBackend *be;
-    Timespec price_time;
 
     if (!db || !c || !currency) return NULL;
     ENTER ("db=%p commodity=%p currency=%p", db, c, currency);
@@ -1921,29 +2071,14 @@ gnc_pricedb_lookup_latest_before (GNCPriceDB *db,
         (be->price_lookup) (be, &pl);
     }
 #endif
-    currency_hash = g_hash_table_lookup(db->commodity_hash, c);
-    if (!currency_hash)
-    {
-        LEAVE ("no currency hash");
-        return NULL;
-    }
-
-    price_list = g_hash_table_lookup(currency_hash, currency);
-    if (!price_list)
+    series = pricedb_get_series(db, c, currency);
+    if (!series)
     {
         LEAVE ("no price list");
         return NULL;
     }
 
-    item = price_list;
-    do
-    {
-        price_time = gnc_price_get_time (item->data);
-        if (timespec_cmp(&price_time, &t) <= 0)
-            current_price = item->data;
-        item = item->next;
-    }
-    while (timespec_cmp(&price_time, &t) > 0 && item);
+    current_price = price_series_latest_before(series, t);
     gnc_price_ref(current_price);
     LEAVE (" ");
     return current_price;
@@ -1954,62 +2089,13 @@ static void
 lookup_nearest(gpointer key, gpointer val, gpointer user_data)
 {
     //gnc_commodity *currency = (gnc_commodity *)key;
-    GList *price_list = (GList *)val;
-    GNCPrice *current_price = NULL;
-    GNCPrice *next_price = NULL;
-    GNCPrice *result = NULL;
-    GList *item = NULL;
+    PriceSeries *series = (PriceSeries *)val;
     GNCPriceLookupHelper *lookup_helper = (GNCPriceLookupHelper *)user_data;
     GList **return_list = lookup_helper->return_list;
     Timespec t = lookup_helper->time;
 
-    item = price_list;
-
-    /* default answer */
-    current_price = item->data;
-
-    /* find the first candidate past the one we want.  Remember that
-       prices are in most-recent-first order. */
-    while (!next_price && item)
-    {
-        GNCPrice *p = item->data;
-        Timespec price_time = gnc_price_get_time(p);
-        if (timespec_cmp(&price_time, &t) <= 0)
-        {
-            next_price = item->data;
-            break;
-        }
-        current_price = item->data;
-        item = item->next;
-    }
-
-    if (current_price)
-    {
-        if (!next_price)
-        {
-            result = current_price;
-        }
-        else
-        {
-            Timespec current_t = gnc_price_get_time(current_price);
-            Timespec next_t = gnc_price_get_time(next_price);
-            Timespec diff_current = timespec_diff(&current_t, &t);
-            Timespec diff_next = timespec_diff(&next_t, &t);
-            Timespec abs_current = timespec_abs(&diff_current);
-            Timespec abs_next = timespec_abs(&diff_next);
-
-            if (timespec_cmp(&abs_current, &abs_next) <= 0)
-            {
-                result = current_price;
-            }
-            else
-            {
-                result = next_price;
-            }
-        }
-    }
-
-    gnc_price_list_insert(return_list, result, FALSE);
+    gnc_price_list_insert(return_list,
+                          price_series_nearest(series, t, FALSE), FALSE);
 }
 
 
@@ -2017,30 +2103,13 @@ static void
 lookup_latest_before(gpointer key, gpointer val, gpointer user_data)
 {
     //gnc_commodity *currency = (gnc_commodity *)key;
-    GList *price_list = (GList *)val;
-    GNCPrice *current_price = NULL;
-    /*  GNCPrice *next_price = NULL;
-        GNCPrice *result = NULL;*/
-    GList *item = NULL;
+    PriceSeries *series = (PriceSeries *)val;
     GNCPriceLookupHelper *lookup_helper = (GNCPriceLookupHelper *)user_data;
     GList **return_list = lookup_helper->return_list;
     Timespec t = lookup_helper->time;
-    Timespec price_time;
-
-    if (price_list)
-    {
-        item = price_list;
-        do
-        {
-            price_time = gnc_price_get_time (item->data);
-            if (timespec_cmp(&price_time, &t) <= 0)
-                current_price = item->data;
-            item = item->next;
-        }
-        while (timespec_cmp(&price_time, &t) > 0 && item);
-    }
 
-    gnc_price_list_insert(return_list, current_price, FALSE);
+    gnc_price_list_insert(return_list,
+                          price_series_latest_before(series, t), FALSE);
 }
 
 
@@ -2146,303 +2215,310 @@ gnc_pricedb_lookup_latest_before_any_currency(GNCPriceDB *db,
 }
 
 
-/*
- * Convert a balance from one currency to another.
+/* ==================================================================== */
+/* Balance conversion
+
+   Finding how to convert between two commodities takes up to a
+   handful of price lookups plus an allocated list of the prices of
+   the balance commodity in every currency.  Reports convert every
+   account balance with the same few commodity pairs and dates, so the
+   outcome of that search -- which price or pair of prices to use -- is
+   kept in db->conversion_cache, keyed by the two commodities, the kind
+   of lookup and its date.  The prices' values are read afresh each
+   time, so the cache only needs to be flushed when prices are added
+   or removed (which includes changing their date or commodities) or
+   when a value becomes or stops being zero.  Reports over many dates
+   would grow it without end, so it is also emptied whenever it holds
+   CONVERSION_CACHE_MAX entries; a report walks its dates in order and
+   rarely needs the older ones again.
  */
-gnc_numeric
-gnc_pricedb_convert_balance_latest_price(GNCPriceDB *pdb,
-        gnc_numeric balance,
-        const gnc_commodity *balance_currency,
-        const gnc_commodity *new_currency)
-{
-    GNCPrice *price, *currency_price;
-    GList *price_list, *list_helper;
-    gnc_numeric currency_price_value;
-    gnc_commodity *intermediate_currency;
 
-    if (gnc_numeric_zero_p (balance) ||
-            gnc_commodity_equiv (balance_currency, new_currency))
-        return balance;
+#define CONVERSION_CACHE_MAX 4096
 
-    /* Look for a direct price. */
-    price = gnc_pricedb_lookup_latest (pdb, balance_currency, new_currency);
-    if (price)
-    {
-        balance = gnc_numeric_mul (balance, gnc_price_get_value (price),
-                                   gnc_commodity_get_fraction (new_currency),
-                                   GNC_HOW_RND_ROUND_HALF_UP);
-        gnc_price_unref (price);
-        return balance;
-    }
-
-    /* Look for a price of the new currency in the balance currency and use
-     * the reciprocal if we find it
-     */
-    price = gnc_pricedb_lookup_latest (pdb, new_currency, balance_currency);
-    if (price)
-    {
-        balance = gnc_numeric_div (balance, gnc_price_get_value (price),
-                                   gnc_commodity_get_fraction (new_currency),
-                                   GNC_HOW_RND_ROUND_HALF_UP);
-        gnc_price_unref (price);
-        return balance;
-    }
+typedef struct
+{
+    const gnc_commodity *from;
+    const gnc_commodity *to;
+    PriceLookupType type;
+    Timespec t;
+} PriceConversionKey;
 
-    /*
-     * no direct price found, try if we find a price in another currency
-     * and convert in two stages
-     */
-    price_list = gnc_pricedb_lookup_latest_any_currency(pdb, balance_currency);
-    if (!price_list)
-    {
-        balance =  gnc_numeric_zero ();
-        return balance;
-    }
+typedef struct
+{
+    GNCPrice *price;            /* price of 'from', or NULL if none found */
+    gboolean reciprocal;        /* price is of 'to' in 'from' */
+    GNCPrice *currency_price;   /* second stage price, or NULL */
+    gboolean currency_reciprocal; /* currency_price is of 'to' in the
+                                   * intermediate currency */
+} PriceConversion;
 
-    list_helper = price_list;
-    currency_price_value = gnc_numeric_zero();
+static guint
+conversion_key_hash (gconstpointer key)
+{
+    const PriceConversionKey *k = key;
 
-    do
-    {
-        price = (GNCPrice *)(list_helper->data);
+    return (g_direct_hash (k->from) ^ (g_direct_hash (k->to) << 1) ^
+            (guint) k->type ^ (guint) k->t.tv_sec);
+}
 
-        intermediate_currency = gnc_price_get_currency(price);
-        currency_price = gnc_pricedb_lookup_latest(pdb, intermediate_currency,
-                         new_currency);
-        if (currency_price)
-        {
-            currency_price_value = gnc_price_get_value(currency_price);
-            gnc_price_unref(currency_price);
-        }
-        else
-        {
-            currency_price = gnc_pricedb_lookup_latest(pdb, new_currency,
-                             intermediate_currency);
-            if (currency_price)
-            {
-                /* here we need the reciprocal */
-                currency_price_value = gnc_numeric_div(gnc_numeric_create(1, 1),
-                                                       gnc_price_get_value(currency_price),
-                                                       GNC_DENOM_AUTO,
-                                                       GNC_HOW_DENOM_EXACT | GNC_HOW_RND_NEVER);
-                gnc_price_unref(currency_price);
-            }
-        }
+static gboolean
+conversion_key_equal (gconstpointer a, gconstpointer b)
+{
+    const PriceConversionKey *ka = a;
+    const PriceConversionKey *kb = b;
 
-        list_helper = list_helper->next;
-    }
-    while ((list_helper != NULL) &&
-            (gnc_numeric_zero_p(currency_price_value)));
+    return (ka->from == kb->from && ka->to == kb->to &&
+            ka->type == kb->type && timespec_equal (&ka->t, &kb->t));
+}
 
-    balance = gnc_numeric_mul (balance, currency_price_value,
-                               GNC_DENOM_AUTO,
-                               GNC_HOW_DENOM_EXACT | GNC_HOW_RND_NEVER);
-    balance = gnc_numeric_mul (balance, gnc_price_get_value (price),
-                               gnc_commodity_get_fraction (new_currency),
-                               GNC_HOW_RND_ROUND_HALF_UP);
+static void
+conversion_destroy (gpointer data)
+{
+    PriceConversion *conv = data;
 
-    gnc_price_list_destroy(price_list);
-    return balance;
+    gnc_price_unref (conv->price);
+    gnc_price_unref (conv->currency_price);
+    g_free (conv);
 }
 
-gnc_numeric
-gnc_pricedb_convert_balance_nearest_price(GNCPriceDB *pdb,
-        gnc_numeric balance,
-        const gnc_commodity *balance_currency,
-        const gnc_commodity *new_currency,
-        Timespec t)
+static void
+pricedb_invalidate_conversions (GNCPriceDB *db)
 {
-    GNCPrice *price, *currency_price;
-    GList *price_list, *list_helper;
-    gnc_numeric currency_price_value;
-    gnc_commodity *intermediate_currency;
-
-    if (gnc_numeric_zero_p (balance) ||
-            gnc_commodity_equiv (balance_currency, new_currency))
-        return balance;
+    if (db->conversion_cache && g_hash_table_size (db->conversion_cache))
+        g_hash_table_remove_all (db->conversion_cache);
+}
 
-    /* Look for a direct price. */
-    price = gnc_pricedb_lookup_nearest_in_time (pdb, balance_currency, new_currency, t);
-    if (price)
+static GNCPrice *
+conversion_lookup (GNCPriceDB *db, const gnc_commodity *c,
+                   const gnc_commodity *currency,
+                   PriceLookupType type, Timespec t)
+{
+    switch (type)
     {
-        balance = gnc_numeric_mul (balance, gnc_price_get_value (price),
-                                   gnc_commodity_get_fraction (new_currency),
-                                   GNC_HOW_RND_ROUND_HALF_UP);
-        gnc_price_unref (price);
-        return balance;
+    case LOOKUP_NEAREST_IN_TIME:
+        return gnc_pricedb_lookup_nearest_in_time (db, c, currency, t);
+    case LOOKUP_LATEST_BEFORE:
+        return gnc_pricedb_lookup_latest_before (db, (gnc_commodity *) c,
+                (gnc_commodity *) currency, t);
+    default:
+        return gnc_pricedb_lookup_latest (db, c, currency);
     }
+}
 
-    /* Look for a price of the new currency in the balance currency and use
-     * the reciprocal if we find it
-     */
-    price = gnc_pricedb_lookup_nearest_in_time (pdb, new_currency, balance_currency, t);
-    if (price)
+static PriceList *
+conversion_lookup_any (GNCPriceDB *db, const gnc_commodity *c,
+                       PriceLookupType type, Timespec t)
+{
+    switch (type)
     {
-        balance = gnc_numeric_div (balance, gnc_price_get_value (price),
-                                   gnc_commodity_get_fraction (new_currency),
-                                   GNC_HOW_RND_ROUND_HALF_UP);
-        gnc_price_unref (price);
-        return balance;
+    case LOOKUP_NEAREST_IN_TIME:
+        return gnc_pricedb_lookup_nearest_in_time_any_currency (db, c, t);
+    case LOOKUP_LATEST_BEFORE:
+        return gnc_pricedb_lookup_latest_before_any_currency (db,
+                (gnc_commodity *) c, t);
+    default:
+        return gnc_pricedb_lookup_latest_any_currency (db, c);
     }
+}
 
-    /*
-     * no direct price found, try if we find a price in another currency
-     * and convert in two stages
-     */
-    price_list = gnc_pricedb_lookup_nearest_in_time_any_currency(pdb, balance_currency, t);
-    if (!price_list)
-    {
-        balance =  gnc_numeric_zero ();
-        return balance;
-    }
+/* Find, or fetch from the cache, the prices to use to convert from
+ * one commodity to another.  First look for a direct price, then for
+ * the reverse price, and failing that, try each price of the balance
+ * commodity in some other currency, most recent first, until one is
+ * found for which that currency can be converted to the new one. */
+static const PriceConversion *
+pricedb_find_conversion (GNCPriceDB *db, const gnc_commodity *from,
+                         const gnc_commodity *to, PriceLookupType type,
+                         Timespec t)
+{
+    PriceConversionKey key, *new_key;
+    PriceConversion *conv;
+    PriceList *price_list, *node;
+    /* The latest-before conversion has always looked for the reverse
+     * second stage price nearest in time; keep it that way. */
+    PriceLookupType reverse_type =
+        (type == LOOKUP_LATEST_BEFORE) ? LOOKUP_NEAREST_IN_TIME : type;
+
+    key.from = from;
+    key.to = to;
+    key.type = type;
+    key.t = t;
 
-    list_helper = price_list;
-    currency_price_value = gnc_numeric_zero();
+    if (!db->conversion_cache)
+        db->conversion_cache = g_hash_table_new_full (conversion_key_hash,
+                               conversion_key_equal,
+                               g_free, conversion_destroy);
+    conv = g_hash_table_lookup (db->conversion_cache, &key);
+    if (conv)
+        return conv;
 
-    do
+    conv = g_new0 (PriceConversion, 1);
+    conv->price = conversion_lookup (db, from, to, type, t);
+    if (!conv->price)
     {
-        price = (GNCPrice *)(list_helper->data);
+        conv->price = conversion_lookup (db, to, from, type, t);
+        conv->reciprocal = (conv->price != NULL);
+    }
 
-        intermediate_currency = gnc_price_get_currency(price);
-        currency_price = gnc_pricedb_lookup_nearest_in_time(pdb, intermediate_currency,
-                         new_currency, t);
-        if (currency_price)
-        {
-            currency_price_value = gnc_price_get_value(currency_price);
-            gnc_price_unref(currency_price);
-        }
-        else
+    if (!conv->price)
+    {
+        price_list = conversion_lookup_any (db, from, type, t);
+        for (node = price_list; node; node = node->next)
         {
-            currency_price = gnc_pricedb_lookup_nearest_in_time(pdb, new_currency,
-                             intermediate_currency, t);
-            if (currency_price)
+            GNCPrice *price = node->data;
+            gnc_commodity *intermediate = gnc_price_get_currency (price);
+            GNCPrice *currency_price;
+            gboolean reciprocal = FALSE;
+
+            currency_price = conversion_lookup (db, intermediate, to, type, t);
+            if (!currency_price)
             {
-                /* here we need the reciprocal */
-                currency_price_value = gnc_numeric_div(gnc_numeric_create(1, 1),
-                                                       gnc_price_get_value(currency_price),
-                                                       gnc_commodity_get_fraction (new_currency),
-                                                       GNC_HOW_RND_ROUND_HALF_UP);
-                gnc_price_unref(currency_price);
+                currency_price = conversion_lookup (db, to, intermediate,
+                                                    reverse_type, t);
+                reciprocal = TRUE;
+            }
+            if (!currency_price)
+                continue;
+            if (gnc_numeric_zero_p (gnc_price_get_value (currency_price)))
+            {
+                gnc_price_unref (currency_price);
+                continue;
             }
-        }
 
-        list_helper = list_helper->next;
+            gnc_price_ref (price);
+            conv->price = price;
+            conv->currency_price = currency_price;
+            conv->currency_reciprocal = reciprocal;
+            break;
+        }
+        gnc_price_list_destroy (price_list);
     }
-    while ((list_helper != NULL) &&
-            (gnc_numeric_zero_p(currency_price_value)));
 
-    balance = gnc_numeric_mul (balance, currency_price_value,
-                               gnc_commodity_get_fraction (new_currency),
-                               GNC_HOW_RND_ROUND_HALF_UP);
-
-    balance = gnc_numeric_mul (balance, gnc_price_get_value (price),
-                               gnc_commodity_get_fraction (new_currency),
-                               GNC_HOW_RND_ROUND_HALF_UP);
+    if (g_hash_table_size (db->conversion_cache) >= CONVERSION_CACHE_MAX)
+        g_hash_table_remove_all (db->conversion_cache);
 
-    gnc_price_list_destroy(price_list);
-    return balance;
+    new_key = g_new (PriceConversionKey, 1);
+    *new_key = key;
+    g_hash_table_insert (db->conversion_cache, new_key, conv);
+    return conv;
 }
 
+/* Convert using a direct or reverse price.  All three flavours of
+ * conversion do this the same way. */
+static gnc_numeric
+convert_balance_direct (gnc_numeric balance, const PriceConversion *conv,
+                        const gnc_commodity *new_currency)
+{
+    if (conv->reciprocal)
+        return gnc_numeric_div (balance, gnc_price_get_value (conv->price),
+                                gnc_commodity_get_fraction (new_currency),
+                                GNC_HOW_RND_ROUND_HALF_UP);
+    return gnc_numeric_mul (balance, gnc_price_get_value (conv->price),
+                            gnc_commodity_get_fraction (new_currency),
+                            GNC_HOW_RND_ROUND_HALF_UP);
+}
 
+/*
+ * Convert a balance from one currency to another.
+ */
 gnc_numeric
-gnc_pricedb_convert_balance_latest_before(GNCPriceDB *pdb,
+gnc_pricedb_convert_balance_latest_price(GNCPriceDB *pdb,
         gnc_numeric balance,
-        gnc_commodity *balance_currency,
-        gnc_commodity *new_currency,
-        Timespec t)
+        const gnc_commodity *balance_currency,
+        const gnc_commodity *new_currency)
 {
-    GNCPrice *price, *currency_price;
-    GList *price_list, *list_helper;
+    const PriceConversion *conv;
     gnc_numeric currency_price_value;
-    gnc_commodity *intermediate_currency;
+    Timespec t = {0, 0};
 
     if (gnc_numeric_zero_p (balance) ||
             gnc_commodity_equiv (balance_currency, new_currency))
         return balance;
 
-    /* Look for a direct price. */
-    price = gnc_pricedb_lookup_latest_before (pdb, balance_currency, new_currency, t);
+    conv = pricedb_find_conversion (pdb, balance_currency, new_currency,
+                                    LOOKUP_LATEST, t);
+    if (!conv->price)
+        return gnc_numeric_zero ();
+    if (!conv->currency_price)
+        return convert_balance_direct (balance, conv, new_currency);
+
+    /* two stage conversion through another currency */
+    currency_price_value = gnc_price_get_value (conv->currency_price);
+    if (conv->currency_reciprocal)
+        currency_price_value = gnc_numeric_div(gnc_numeric_create(1, 1),
+                                               currency_price_value,
+                                               GNC_DENOM_AUTO,
+                                               GNC_HOW_DENOM_EXACT | GNC_HOW_RND_NEVER);
 
-    if (price)
-    {
-        balance = gnc_numeric_mul (balance, gnc_price_get_value (price),
-                                   gnc_commodity_get_fraction (new_currency),
-                                   GNC_HOW_RND_ROUND_HALF_UP);
-        gnc_price_unref (price);
-        return balance;
-    }
+    balance = gnc_numeric_mul (balance, currency_price_value,
+                               GNC_DENOM_AUTO,
+                               GNC_HOW_DENOM_EXACT | GNC_HOW_RND_NEVER);
+    balance = gnc_numeric_mul (balance, gnc_price_get_value (conv->price),
+                               gnc_commodity_get_fraction (new_currency),
+                               GNC_HOW_RND_ROUND_HALF_UP);
+    return balance;
+}
 
-    /* Look for a price of the new currency in the balance currency and use
-     * the reciprocal if we find it.
-     */
-    price = gnc_pricedb_lookup_latest_before (pdb, new_currency, balance_currency, t);
-    if (price)
-    {
-        balance = gnc_numeric_div (balance, gnc_price_get_value (price),
-                                   gnc_commodity_get_fraction (new_currency),
-                                   GNC_HOW_RND_ROUND_HALF_UP);
-        gnc_price_unref (price);
-        return balance;
-    }
+/* The nearest-in-time and latest-before conversions round each stage
+ * to the new currency's fraction. */
+static gnc_numeric
+convert_balance_at_time (GNCPriceDB *pdb, gnc_numeric balance,
+                         const gnc_commodity *balance_currency,
+                         const gnc_commodity *new_currency,
+                         PriceLookupType type, Timespec t)
+{
+    const PriceConversion *conv;
+    gnc_numeric currency_price_value;
 
-    /*
-     * no direct price found, try if we find a price in another currency
-     * and convert in two stages
-     */
-    price_list = gnc_pricedb_lookup_latest_before_any_currency(pdb, balance_currency, t);
-    if (!price_list)
-    {
-        balance =  gnc_numeric_zero ();
+    if (gnc_numeric_zero_p (balance) ||
+            gnc_commodity_equiv (balance_currency, new_currency))
         return balance;
-    }
-
-    list_helper = price_list;
-    currency_price_value = gnc_numeric_zero();
-
-    do
-    {
-        price = (GNCPrice *)(list_helper->data);
-
-        intermediate_currency = gnc_price_get_currency(price);
-        currency_price = gnc_pricedb_lookup_latest_before(pdb, intermediate_currency,
-                         new_currency, t);
-        if (currency_price)
-        {
-            currency_price_value = gnc_price_get_value(currency_price);
-            gnc_price_unref(currency_price);
-        }
-        else
-        {
-            currency_price = gnc_pricedb_lookup_nearest_in_time(pdb, new_currency,
-                             intermediate_currency, t);
-            if (currency_price)
-            {
-                /* here we need the reciprocal */
-                currency_price_value = gnc_numeric_div(gnc_numeric_create(1, 1),
-                                                       gnc_price_get_value(currency_price),
-                                                       gnc_commodity_get_fraction (new_currency),
-                                                       GNC_HOW_RND_ROUND_HALF_UP);
-                gnc_price_unref(currency_price);
-            }
-        }
 
-        list_helper = list_helper->next;
-    }
-    while ((list_helper != NULL) &&
-            (gnc_numeric_zero_p(currency_price_value)));
+    conv = pricedb_find_conversion (pdb, balance_currency, new_currency,
+                                    type, t);
+    if (!conv->price)
+        return gnc_numeric_zero ();
+    if (!conv->currency_price)
+        return convert_balance_direct (balance, conv, new_currency);
+
+    /* two stage conversion through another currency */
+    currency_price_value = gnc_price_get_value (conv->currency_price);
+    if (conv->currency_reciprocal)
+        currency_price_value = gnc_numeric_div(gnc_numeric_create(1, 1),
+                                               currency_price_value,
+                                               gnc_commodity_get_fraction (new_currency),
+                                               GNC_HOW_RND_ROUND_HALF_UP);
 
     balance = gnc_numeric_mul (balance, currency_price_value,
                                gnc_commodity_get_fraction (new_currency),
                                GNC_HOW_RND_ROUND_HALF_UP);
-    balance = gnc_numeric_mul (balance, gnc_price_get_value (price),
+    balance = gnc_numeric_mul (balance, gnc_price_get_value (conv->price),
                                gnc_commodity_get_fraction (new_currency),
                                GNC_HOW_RND_ROUND_HALF_UP);
-
-    gnc_price_list_destroy(price_list);
     return balance;
 }
 
+gnc_numeric
+gnc_pricedb_convert_balance_nearest_price(GNCPriceDB *pdb,
+        gnc_numeric balance,
+        const gnc_commodity *balance_currency,
+        const gnc_commodity *new_currency,
+        Timespec t)
+{
+    return convert_balance_at_time (pdb, balance, balance_currency,
+                                    new_currency, LOOKUP_NEAREST_IN_TIME, t);
+}
 
+gnc_numeric
+gnc_pricedb_convert_balance_latest_before(GNCPriceDB *pdb,
+        gnc_numeric balance,
+        gnc_commodity *balance_currency,
+        gnc_commodity *new_currency,
+        Timespec t)
+{
+    return convert_balance_at_time (pdb, balance, balance_currency,
+                                    new_currency, LOOKUP_LATEST_BEFORE, t);
+}
 
 /* ==================================================================== */
 /* gnc_pricedb_foreach_price infrastructure
@@ -2458,7 +2534,7 @@ typedef struct
 static void
 pricedb_foreach_pricelist(gpointer key, gpointer val, gpointer user_data)
 {
-    GList *price_list = (GList *) val;
+    GList *price_list = ((PriceSeries *) val)->prices;
     GList *node = price_list;
     GNCPriceDBForeachData *foreach_data = (GNCPriceDBForeachData *) user_data;
 
@@ -2552,7 +2628,7 @@ stable_price_traversal(GNCPriceDB *db,
         for (j = price_lists; j; j = j->next)
         {
             GHashTableKVPair *pricelist_kvp = (GHashTableKVPair *) j->data;
-            GList *price_list = (GList *) pricelist_kvp->value;
+            GList *price_list = ((PriceSeries *) pricelist_kvp->value)->prices;
             GList *node;
 
             for (node = (GList *) price_list; node; node = node->next)
@@ -2779,7 +2855,7 @@ VoidGNCPriceDBForeachData;
 static void
 void_pricedb_foreach_pricelist(gpointer key, gpointer val, gpointer user_data)
 {
-    GList *price_list = (GList *) val;
+    GList *price_list = ((PriceSeries *) val)->prices;
     GList *node = price_list;
     VoidGNCPriceDBForeachData *foreach_data = (VoidGNCPriceDBForeachData *) user_data;
 
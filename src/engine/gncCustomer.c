@@ -268,7 +268,9 @@ GncCustomer *gncCustomerCreate (QofBook *book)
 
     if (gs_address_event_handler_id == 0)
     {
-        gs_address_event_handler_id = qof_event_register_handler(listen_for_address_events, NULL);
+        gs_address_event_handler_id =
+            qof_event_register_handler_full(listen_for_address_events, NULL,
+                                            GNC_ID_ADDRESS, QOF_EVENT_MODIFY);
     }
 
     qof_event_gen (&cust->inst, QOF_EVENT_CREATE, NULL);
@@ -85,6 +85,187 @@ run_test (void)
     qof_session_destroy(sess);
 }
 
+static void
+test_guid_new_n(void)
+{
+    enum { N = 5000 };
+    GncGUID *guids = g_new0(GncGUID, N);
+    GHashTable *seen = guid_hash_table_new();
+    int i;
+
+    /* More than one buffer's worth, so the bulk path is taken too */
+    guid_new_n(guids, 7);
+    guid_new_n(guids + 7, N - 7);
+    for (i = 0; i < N; i++)
+    {
+        do_test(!guid_equal(&guids[i], guid_null()), "guid_new_n made a null guid");
+        do_test(g_hash_table_lookup(seen, &guids[i]) == NULL,
+                "guid_new_n made a duplicate");
+        g_hash_table_insert(seen, &guids[i], &guids[i]);
+    }
+
+    g_hash_table_destroy(seen);
+    g_free(guids);
+}
+
+static void
+remove_entity_cb (QofInstance *ent, gpointer data)
+{
+    guint *visited = data;
+
+    (*visited)++;
+    qof_collection_remove_entity (ent);
+}
+
+typedef struct
+{
+    QofCollection *col;
+    QofInstance **ents;
+    guint n_ents;
+    guint *seen;
+    QofInstance **added;
+    guint n_added;
+    guint visited;
+} GrowData;
+
+/* Adds enough entities on the first call to overflow the table */
+static void
+grow_entity_cb (QofInstance *ent, gpointer data)
+{
+    GrowData *gd = data;
+    GncGUID guid;
+    guint i;
+
+    for (i = 0; i < gd->n_ents; i++)
+        if (gd->ents[i] == ent)
+            gd->seen[i]++;
+    gd->visited++;
+    if (gd->visited > 1) return;
+    for (i = 0; i < gd->n_added; i++)
+    {
+        guid_new (&guid);
+        gd->added[i] = g_object_new (QOF_TYPE_INSTANCE, "guid", &guid, NULL);
+        gd->added[i]->e_type = qof_collection_get_type (gd->col);
+        qof_collection_insert_entity (gd->col, gd->added[i]);
+        do_test (qof_collection_lookup_entity (gd->col, &guid) == gd->added[i],
+                 "lookup of entity added during foreach");
+    }
+    /* Removing one of them again must work before the walk ends */
+    qof_collection_remove_entity (gd->added[0]);
+}
+
+static void
+run_foreach_insert_test (void)
+{
+    enum { N = 4, ADDED = 200 };
+    QofSession *sess;
+    QofBook *book;
+    QofInstance *ents[N], *added[ADDED];
+    guint seen[N] = { 0 };
+    GrowData gd;
+    GncGUID guid;
+    guint i;
+
+    sess = get_random_session ();
+    book = qof_session_get_book (sess);
+    gd.col = qof_book_get_collection (book, "zxcv");
+    gd.ents = ents;
+    gd.n_ents = N;
+    gd.seen = seen;
+    gd.added = added;
+    gd.n_added = ADDED;
+    gd.visited = 0;
+
+    for (i = 0; i < N; i++)
+    {
+        guid_new (&guid);
+        ents[i] = g_object_new (QOF_TYPE_INSTANCE, "guid", &guid, NULL);
+        ents[i]->e_type = qof_collection_get_type (gd.col);
+        qof_collection_insert_entity (gd.col, ents[i]);
+    }
+
+    qof_collection_foreach (gd.col, grow_entity_cb, &gd);
+    for (i = 0; i < N; i++)
+        do_test (seen[i] == 1, "foreach visits each original entity once");
+    do_test (qof_collection_count (gd.col) == N + ADDED - 1,
+             "count after adding during foreach");
+
+    for (i = 0; i < N; i++)
+        do_test (qof_collection_lookup_entity (gd.col,
+                 qof_instance_get_guid (ents[i])) == ents[i],
+                 "original entity found after foreach");
+    do_test (qof_collection_lookup_entity (gd.col,
+             qof_instance_get_guid (added[0])) == NULL,
+             "removed entity gone after foreach");
+    for (i = 1; i < ADDED; i++)
+        do_test (qof_collection_lookup_entity (gd.col,
+                 qof_instance_get_guid (added[i])) == added[i],
+                 "added entity found after foreach");
+
+    gd.n_ents = 0;
+    gd.visited = ADDED;     /* don't add any more */
+    i = gd.visited;
+    qof_collection_foreach (gd.col, grow_entity_cb, &gd);
+    do_test (gd.visited - i == N + ADDED - 1, "second foreach sees them all");
+
+    for (i = 0; i < N; i++)
+    {
+        qof_collection_remove_entity (ents[i]);
+        g_object_unref (ents[i]);
+    }
+    for (i = 0; i < ADDED; i++)
+    {
+        qof_collection_remove_entity (added[i]);
+        g_object_unref (added[i]);
+    }
+    qof_session_destroy (sess);
+}
+
+static void
+run_collection_test (void)
+{
+    enum { N = 1000 };
+    QofSession *sess;
+    QofBook *book;
+    QofCollection *col;
+    QofInstance *ents[N];
+    GncGUID guid;
+    guint i, visited = 0;
+
+    sess = get_random_session ();
+    book = qof_session_get_book (sess);
+    col = qof_book_get_collection (book, "qwer");
+    qof_collection_reserve (col, N / 2);
+
+    for (i = 0; i < N; i++)
+    {
+        guid_new (&guid);
+        ents[i] = g_object_new (QOF_TYPE_INSTANCE, "guid", &guid, NULL);
+        ents[i]->e_type = qof_collection_get_type (col);
+        qof_collection_insert_entity (col, ents[i]);
+    }
+    do_test (qof_collection_count (col) == N, "collection count");
+
+    for (i = 0; i < N; i += 2)
+        qof_collection_remove_entity (ents[i]);
+    do_test (qof_collection_count (col) == N / 2, "count after removal");
+    for (i = 0; i < N; i++)
+    {
+        QofInstance *found =
+            qof_collection_lookup_entity (col, qof_instance_get_guid (ents[i]));
+        do_test (found == (i % 2 ? ents[i] : NULL), "lookup after removal");
+    }
+
+    /* Entities may leave the collection while it is being walked */
+    qof_collection_foreach (col, remove_entity_cb, &visited);
+    do_test (visited == N / 2, "foreach visits every entity once");
+    do_test (qof_collection_count (col) == 0, "foreach removal");
+
+    for (i = 0; i < N; i++)
+        g_object_unref (ents[i]);
+    qof_session_destroy (sess);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -92,7 +273,10 @@ main (int argc, char **argv)
     if (cashobjects_register())
     {
         test_null_guid();
+        test_guid_new_n();
         run_test ();
+        run_collection_test ();
+        run_foreach_insert_test ();
         print_test_results();
     }
     qof_close();
@@ -35,10 +35,109 @@
 #include "test-stuff.h"
 #include "test-engine-stuff.h"
 #include "Transaction.h"
+#include "gnc-lot.h"
 
 static gint transaction_num = 320;
 static gint	max_iterate = 10;
 
+static Split *
+make_lot_split (QofBook *book, Account *acc, time_t date, gint64 amount)
+{
+    Transaction *trans;
+    Split *split;
+
+    trans = xaccMallocTransaction (book);
+    split = xaccMallocSplit (book);
+
+    xaccTransBeginEdit (trans);
+    xaccTransSetCurrency (trans, xaccAccountGetCommodity (acc));
+    xaccTransSetDatePostedSecs (trans, date);
+    xaccSplitSetParent (split, trans);
+    xaccSplitSetAccount (split, acc);
+    xaccSplitSetAmount (split, gnc_numeric_create (amount, 1));
+    xaccSplitSetValue (split, gnc_numeric_create (amount, 1));
+    xaccTransCommitEdit (trans);
+
+    return split;
+}
+
+static gpointer
+first_open_lot (GNCLot *lot, gpointer data)
+{
+    return lot;
+}
+
+static void
+test_lot_caches (void)
+{
+    QofSession *sess;
+    QofBook *book;
+    Account *acc;
+    Transaction *trans;
+    Split *s1, *s2, *s3;
+    GNCLot *lot1, *lot2;
+
+    sess = qof_session_new ();
+    book = qof_session_get_book (sess);
+    acc = get_random_account (book);
+
+    s1 = make_lot_split (book, acc, 2 * 86400, 10);
+    s2 = make_lot_split (book, acc, 1 * 86400, 5);
+    s3 = make_lot_split (book, acc, 3 * 86400, -10);
+    lot1 = gnc_lot_new (book);
+    lot2 = gnc_lot_new (book);
+    gnc_lot_add_split (lot1, s1);
+    gnc_lot_add_split (lot2, s2);
+
+    do_test (gnc_numeric_equal (gnc_lot_get_balance (lot1),
+                                gnc_numeric_create (10, 1)),
+             "lot balance after adding split");
+    do_test (xaccAccountForEachOpenLot (acc, FALSE, first_open_lot, NULL)
+             == lot2, "earliest open lot visited first");
+    do_test (xaccAccountForEachOpenLot (acc, TRUE, first_open_lot, NULL)
+             == lot1, "latest open lot visited first");
+
+    gnc_lot_add_split (lot1, s3);
+    do_test (gnc_lot_is_closed (lot1), "lot closed by balancing split");
+    do_test (gnc_lot_get_earliest_split (lot1) == s1 &&
+             gnc_lot_get_latest_split (lot1) == s3, "lot opening and closing splits");
+    do_test (xaccAccountForEachOpenLot (acc, TRUE, first_open_lot, NULL)
+             == lot2, "closed lot left out of open lots");
+
+    trans = xaccSplitGetParent (s3);
+    xaccTransBeginEdit (trans);
+    xaccTransSetDatePostedSecs (trans, 0);
+    xaccTransCommitEdit (trans);
+    do_test (gnc_lot_get_earliest_split (lot1) == s3 &&
+             gnc_lot_get_latest_split (lot1) == s1, "re-dated split reordered in lot");
+
+    gnc_lot_remove_split (lot1, s3);
+    do_test (!gnc_lot_is_closed (lot1) &&
+             gnc_numeric_equal (gnc_lot_get_balance (lot1),
+                                gnc_numeric_create (10, 1)),
+             "lot reopened by removing split");
+    do_test (xaccAccountForEachOpenLot (acc, TRUE, first_open_lot, NULL)
+             == lot1, "reopened lot back in open lots");
+
+    trans = xaccSplitGetParent (s1);
+    xaccTransBeginEdit (trans);
+    xaccSplitSetAmount (s1, gnc_numeric_create (7, 1));
+    xaccTransSetDatePostedSecs (trans, 0);
+    do_test (gnc_numeric_equal (gnc_lot_get_balance (lot1),
+                                gnc_numeric_create (7, 1)),
+             "lot balance follows edited split");
+    do_test (xaccAccountForEachOpenLot (acc, FALSE, first_open_lot, NULL)
+             == lot1, "lot order follows edited date");
+    xaccTransRollbackEdit (trans);
+    do_test (gnc_numeric_equal (gnc_lot_get_balance (lot1),
+                                gnc_numeric_create (10, 1)),
+             "lot balance restored by rollback");
+    do_test (xaccAccountForEachOpenLot (acc, FALSE, first_open_lot, NULL)
+             == lot2, "lot order restored by rollback");
+
+    qof_session_end (sess);
+}
+
 static void
 run_test (void)
 {
@@ -83,6 +182,7 @@ main (int argc, char **argv)
     g_log_set_always_fatal( G_LOG_LEVEL_CRITICAL | G_LOG_LEVEL_WARNING );
     /* Set up a reproducible test-case */
     srand(0);
+    test_lot_caches ();
     /* Iterate the test a number of times */
     for (i = 0; i < max_iterate; i++)
     {
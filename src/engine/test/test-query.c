@@ -65,6 +65,83 @@ test_trans_query (Transaction *trans, gpointer data)
     return 0;
 }
 
+static void
+add_to_set (GList *list, GHashTable *set)
+{
+    for (; list; list = list->next)
+        g_hash_table_insert (set, list->data, list->data);
+}
+
+static void
+test_update_results (QofBook *book)
+{
+    QofQuery *q, *fresh;
+    GHashTable *stale;
+    Transaction *trans, *victim;
+    GList *results, *changed, *matches, *node, *expected;
+
+    q = qof_query_create_for (GNC_ID_SPLIT);
+    qof_query_set_book (q, book);
+    results = qof_query_run (q);
+    if (!results)
+    {
+        qof_query_destroy (q);
+        return;
+    }
+
+    /* Change one transaction, destroy another and add a third. */
+    stale = g_hash_table_new (g_direct_hash, g_direct_equal);
+    trans = xaccSplitGetParent (results->data);
+    victim = xaccSplitGetParent (g_list_last (results)->data);
+    add_to_set (xaccTransGetSplitList (trans), stale);
+    add_to_set (xaccTransGetSplitList (victim), stale);
+
+    make_random_changes_to_transaction (book, trans);
+    if (victim != trans)
+    {
+        xaccTransBeginEdit (victim);
+        xaccTransDestroy (victim);
+        xaccTransCommitEdit (victim);
+    }
+
+    changed = g_list_copy (xaccTransGetSplitList (trans));
+    changed = g_list_concat (changed, g_list_copy (
+                                 xaccTransGetSplitList (get_random_transaction (book))));
+
+    if (!qof_query_update_results (q, stale, changed, &matches))
+    {
+        failure ("results of an unchanged query not updated");
+        goto done;
+    }
+    if (g_list_length (matches) != g_list_length (changed))
+    {
+        failure ("changed splits missing from the matches");
+        goto done;
+    }
+
+    fresh = qof_query_copy (q);
+    expected = qof_query_run (fresh);
+    for (node = qof_query_last_run (q); node && expected;
+            node = node->next, expected = expected->next)
+        if (node->data != expected->data)
+            break;
+    if (node || expected)
+        failure ("updated results differ from a fresh run");
+    else
+        success ("updated results match a fresh run");
+
+    qof_query_set_max_results (fresh, 5);
+    if (qof_query_update_results (fresh, NULL, changed, NULL))
+        failure ("cropped results were updated");
+    qof_query_destroy (fresh);
+
+done:
+    g_list_free (matches);
+    g_list_free (changed);
+    g_hash_table_destroy (stale);
+    qof_query_destroy (q);
+}
+
 static void
 run_test (void)
 {
@@ -80,6 +157,8 @@ run_test (void)
 
     xaccAccountTreeForEachTransaction (root, test_trans_query, book);
 
+    test_update_results (book);
+
     qof_session_end (session);
 }
 
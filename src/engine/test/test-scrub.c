@@ -0,0 +1,230 @@
+/***************************************************************************
+ *            test-scrub.c
+ ****************************************************************************/
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ *  02110-1301, USA.
+ */
+/**
+ * @file test-scrub.c
+ * @brief Check that the parallel scrub repairs what the serial one does.
+ */
+
+#include "config.h"
+#include <glib.h>
+#include "qof.h"
+#include "Account.h"
+#include "Scrub.h"
+#include "Transaction.h"
+#include "cashobjects.h"
+#include "gnc-commodity.h"
+#include "test-stuff.h"
+
+/* Enough transactions for the check to be shared among threads */
+static gint transaction_num = 1200;
+
+static gint last_percent;
+static gint n_progress;
+
+static Account *
+make_account (QofBook *book, Account *parent, const char *name,
+              GNCAccountType type, gnc_commodity *commodity)
+{
+    Account *acc = xaccMallocAccount (book);
+
+    xaccAccountBeginEdit (acc);
+    xaccAccountSetName (acc, name);
+    xaccAccountSetType (acc, type);
+    xaccAccountSetCommodity (acc, commodity);
+    gnc_account_append_child (parent, acc);
+    xaccAccountCommitEdit (acc);
+
+    return acc;
+}
+
+static Split *
+add_split (Transaction *trans, Account *acc, gint64 amount, gint64 value)
+{
+    Split *split = xaccMallocSplit (xaccTransGetBook (trans));
+
+    xaccSplitSetParent (split, trans);
+    if (acc)
+        xaccSplitSetAccount (split, acc);
+    xaccSplitSetAmount (split, gnc_numeric_create (amount, 100));
+    xaccSplitSetValue (split, gnc_numeric_create (value, 100));
+
+    return split;
+}
+
+/* Fill a book with the same mix of good and broken transactions each
+ * time: balanced ones, unbalanced ones, ones with an orphan split and
+ * ones whose amount and value disagree in a currency account. */
+static GPtrArray *
+make_book (QofBook *book)
+{
+    gnc_commodity_table *table;
+    gnc_commodity *usd;
+    Account *root, *bank, *expenses;
+    GPtrArray *trans_list;
+    gint i;
+
+    table = gnc_commodity_table_get_table (book);
+    usd = gnc_commodity_new (book, "US Dollar", "ISO4217", "USD", NULL, 100);
+    usd = gnc_commodity_table_insert (table, usd);
+
+    root = gnc_book_get_root_account (book);
+    bank = make_account (book, root, "Bank", ACCT_TYPE_BANK, usd);
+    expenses = make_account (book, root, "Expenses", ACCT_TYPE_EXPENSE, usd);
+
+    trans_list = g_ptr_array_new ();
+    xaccDisableDataScrubbing ();
+    for (i = 1; i <= transaction_num; i++)
+    {
+        Transaction *trans = xaccMallocTransaction (book);
+
+        xaccTransBeginEdit (trans);
+        xaccTransSetCurrency (trans, usd);
+        xaccTransSetDatePostedSecs (trans, i * 86400);
+        add_split (trans, bank, -i, -i);
+        switch (i % 4)
+        {
+        case 0:
+            add_split (trans, expenses, i, i);
+            break;
+        case 1:
+            add_split (trans, expenses, i + 1, i + 1);
+            break;
+        case 2:
+            add_split (trans, NULL, i, i);
+            break;
+        default:
+            add_split (trans, expenses, 2 * i, i);
+            break;
+        }
+        xaccTransCommitEdit (trans);
+        g_ptr_array_add (trans_list, trans);
+    }
+    xaccEnableDataScrubbing ();
+
+    return trans_list;
+}
+
+static void
+record_progress (const char *message, double percent)
+{
+    if (n_progress == 0 && percent != 0)
+        failure ("first progress report is not 0");
+    n_progress++;
+    last_percent = (gint) percent;
+}
+
+static void
+compare_accounts (Account *serial_root, Account *parallel_root)
+{
+    GList *children, *node;
+
+    do_test (gnc_account_n_children (serial_root) ==
+             gnc_account_n_children (parallel_root),
+             "same accounts after scrubbing");
+
+    children = gnc_account_get_children (serial_root);
+    for (node = children; node; node = node->next)
+    {
+        Account *serial = node->data;
+        Account *parallel;
+
+        parallel = gnc_account_lookup_by_name (parallel_root,
+                                               xaccAccountGetName (serial));
+        if (!parallel)
+        {
+            failure_args ("scrub", __FILE__, __LINE__,
+                          "account %s missing after parallel scrub",
+                          xaccAccountGetName (serial));
+            continue;
+        }
+        do_test (gnc_numeric_equal (xaccAccountGetBalance (serial),
+                                    xaccAccountGetBalance (parallel)),
+                 "same account balance after scrubbing");
+    }
+    g_list_free (children);
+}
+
+static void
+run_test (void)
+{
+    QofSession *serial_sess, *parallel_sess;
+    QofBook *serial_book, *parallel_book;
+    Account *serial_root, *parallel_root;
+    GPtrArray *serial_trans, *parallel_trans;
+    guint i;
+
+    serial_sess = qof_session_new ();
+    serial_book = qof_session_get_book (serial_sess);
+    serial_trans = make_book (serial_book);
+    serial_root = gnc_book_get_root_account (serial_book);
+
+    parallel_sess = qof_session_new ();
+    parallel_book = qof_session_get_book (parallel_sess);
+    parallel_trans = make_book (parallel_book);
+    parallel_root = gnc_book_get_root_account (parallel_book);
+
+    xaccAccountTreeScrubOrphans (serial_root);
+    xaccAccountTreeScrubImbalance (serial_root);
+
+    n_progress = 0;
+    xaccAccountTreeScrubParallel (parallel_root, record_progress);
+    do_test (n_progress > 1 && last_percent < 0,
+             "progress reported and finished");
+
+    for (i = 0; i < serial_trans->len; i++)
+    {
+        Transaction *serial = g_ptr_array_index (serial_trans, i);
+        Transaction *parallel = g_ptr_array_index (parallel_trans, i);
+
+        if (xaccTransCountSplits (serial) != xaccTransCountSplits (parallel) ||
+                xaccTransIsBalanced (serial) != xaccTransIsBalanced (parallel))
+        {
+            failure_args ("scrub", __FILE__, __LINE__,
+                          "transaction %u repaired differently", i);
+            break;
+        }
+    }
+    do_test (i == serial_trans->len, "same transactions after scrubbing");
+
+    compare_accounts (serial_root, parallel_root);
+
+    g_ptr_array_free (serial_trans, TRUE);
+    g_ptr_array_free (parallel_trans, TRUE);
+    qof_session_end (serial_sess);
+    qof_session_end (parallel_sess);
+}
+
+int
+main (int argc, char **argv)
+{
+    qof_init ();
+    if (!cashobjects_register ())
+        exit (1);
+
+    if (!g_thread_supported ())
+        g_thread_init (NULL);
+
+    run_test ();
+    success ("parallel scrub makes the same repairs");
+
+    print_test_results ();
+    qof_close ();
+    return get_rv ();
+}
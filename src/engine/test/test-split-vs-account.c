@@ -33,6 +33,173 @@
 #include "test-stuff.h"
 #include "Transaction.h"
 
+static Split *
+make_dated_split (QofBook *book, Account *acc, time_t date)
+{
+    Transaction *trans;
+    Split *split;
+
+    trans = xaccMallocTransaction(book);
+    split = xaccMallocSplit(book);
+
+    xaccTransBeginEdit(trans);
+    xaccTransSetCurrency(trans, xaccAccountGetCommodity(acc));
+    xaccTransSetDatePostedSecs(trans, date);
+    xaccSplitSetParent(split, trans);
+    xaccSplitSetAccount(split, acc);
+    xaccTransCommitEdit(trans);
+
+    return split;
+}
+
+static void
+count_split (gpointer data, gpointer user_data)
+{
+    (*(gint *)user_data)++;
+}
+
+static void
+test_split_order (QofBook *book)
+{
+    Account *acc;
+    Split *s1, *s2, *s3;
+    GList *splits;
+    gint count = 0;
+
+    acc = get_random_account(book);
+    s3 = make_dated_split(book, acc, 3 * 86400);
+    s1 = make_dated_split(book, acc, 1 * 86400);
+    s2 = make_dated_split(book, acc, 2 * 86400);
+
+    splits = xaccAccountGetSplitList(acc);
+    do_test(g_list_length(splits) == 3, "three splits in account");
+    do_test(splits->data == s1 && splits->next->data == s2 &&
+            splits->next->next->data == s3, "splits sorted on insert");
+    do_test(gnc_account_find_split(acc, s2), "split found in account");
+
+    gnc_account_foreach_split(acc, count_split, &count);
+    do_test(count == 3, "foreach visits every split");
+
+    xaccSplitDestroy(s2);
+    splits = xaccAccountGetSplitList(acc);
+    do_test(!gnc_account_find_split(acc, s2), "removed split not found");
+    do_test(g_list_length(splits) == 2 && splits->data == s1 &&
+            splits->next->data == s3 && splits->next->prev == splits,
+            "split list relinked after removal");
+}
+
+static void
+test_running_balance (QofBook *book)
+{
+    Account *acc;
+    Split *s1, *s2, *s3;
+    Transaction *trans;
+
+    acc = get_random_account(book);
+    s1 = make_dated_split(book, acc, 1 * 86400);
+    s2 = make_dated_split(book, acc, 2 * 86400);
+    s3 = make_dated_split(book, acc, 3 * 86400);
+
+    trans = xaccSplitGetParent(s1);
+    xaccTransBeginEdit(trans);
+    xaccSplitSetAmount(s1, gnc_numeric_create(1, 1));
+    xaccTransCommitEdit(trans);
+    trans = xaccSplitGetParent(s2);
+    xaccTransBeginEdit(trans);
+    xaccSplitSetAmount(s2, gnc_numeric_create(10, 1));
+    xaccTransCommitEdit(trans);
+    trans = xaccSplitGetParent(s3);
+    xaccTransBeginEdit(trans);
+    xaccSplitSetAmount(s3, gnc_numeric_create(100, 1));
+    xaccTransCommitEdit(trans);
+
+    do_test(gnc_numeric_equal(xaccSplitGetBalance(s2),
+                              gnc_numeric_create(11, 1)),
+            "running balance of middle split");
+    do_test(gnc_numeric_equal(xaccAccountGetBalance(acc),
+                              gnc_numeric_create(111, 1)),
+            "account balance");
+
+    /* Move the last split to the front. */
+    xaccTransSetDatePostedSecs(xaccSplitGetParent(s3), 0);
+    xaccAccountRecomputeBalance(acc);
+    do_test(xaccAccountGetSplitList(acc)->data == s3,
+            "re-dated split moved in account");
+    do_test(gnc_numeric_equal(xaccSplitGetBalance(s1),
+                              gnc_numeric_create(101, 1)),
+            "running balance follows re-dated split");
+    do_test(gnc_numeric_equal(xaccAccountGetBalance(acc),
+                              gnc_numeric_create(111, 1)),
+            "account balance unchanged by re-dating");
+
+    do_test(gnc_numeric_equal(xaccAccountGetBalanceAsOfDate(acc, 2 * 86400),
+                              gnc_numeric_create(101, 1)),
+            "balance as of date between splits");
+    do_test(gnc_numeric_zero_p(xaccAccountGetBalanceAsOfDate(acc, 0)),
+            "balance as of date before first split");
+    do_test(gnc_numeric_equal(xaccAccountGetBalanceAsOfDate(acc, 10 * 86400),
+                              gnc_numeric_create(111, 1)),
+            "balance as of date after last split");
+
+    xaccSplitSetReconcile(s1, CREC);
+    do_test(gnc_numeric_equal(xaccSplitGetClearedBalance(s2),
+                              gnc_numeric_create(1, 1)),
+            "cleared balance follows reconcile change");
+    do_test(gnc_numeric_equal(xaccAccountGetClearedBalanceAsOfDate(acc,
+                              2 * 86400), gnc_numeric_create(1, 1)),
+            "cleared balance as of date");
+}
+
+static void
+test_online_id (QofBook *book)
+{
+    Account *acc;
+    Split *s1, *s2, *s3;
+
+    acc = get_random_account(book);
+    s1 = make_dated_split(book, acc, 1 * 86400);
+    s2 = make_dated_split(book, acc, 2 * 86400);
+    kvp_frame_set_str(xaccSplitGetSlots(s1), "online_id", "A");
+    kvp_frame_set_str(xaccTransGetSlots(xaccSplitGetParent(s2)),
+                      "online_id", "B");
+
+    do_test(gnc_account_find_split_by_online_id(acc, "A", NULL) == s1,
+            "online_id of split found");
+    do_test(gnc_account_find_split_by_online_id(acc, "B", NULL) == s2,
+            "online_id of transaction found");
+    do_test(gnc_account_find_split_by_online_id(acc, "A", s1) == NULL,
+            "skipped split not found by online_id");
+
+    /* Splits added after the index is built are indexed too. */
+    s3 = make_dated_split(book, acc, 3 * 86400);
+    kvp_frame_set_str(xaccSplitGetSlots(s3), "online_id", "C");
+    gnc_account_update_online_id(acc, s3);
+    do_test(gnc_account_find_split_by_online_id(acc, "C", s1) == s3,
+            "updated online_id found");
+
+    xaccSplitDestroy(s3);
+    do_test(gnc_account_find_split_by_online_id(acc, "C", NULL) == NULL,
+            "removed split not found by online_id");
+
+    /* A stale entry is dropped rather than reported. */
+    kvp_frame_set_str(xaccSplitGetSlots(s1), "online_id", "D");
+    do_test(gnc_account_find_split_by_online_id(acc, "A", NULL) == NULL,
+            "changed online_id not found under old value");
+    do_test(gnc_account_find_split_by_online_id(acc, "D", NULL) == s1,
+            "changed online_id found under new value");
+
+    /* A change made in an edit of the transaction is picked up when it
+     * is committed, even if the new id is looked up first. */
+    xaccTransBeginEdit(xaccSplitGetParent(s2));
+    kvp_frame_set_str(xaccTransGetSlots(xaccSplitGetParent(s2)),
+                      "online_id", "E");
+    xaccTransCommitEdit(xaccSplitGetParent(s2));
+    do_test(gnc_account_find_split_by_online_id(acc, "E", NULL) == s2,
+            "committed online_id found under new value");
+    do_test(gnc_account_find_split_by_online_id(acc, "B", NULL) == NULL,
+            "committed online_id not found under old value");
+}
+
 static void
 run_test (void)
 {
@@ -50,6 +217,10 @@ run_test (void)
 
     act2 = get_random_account(book);
     do_test(act2 != NULL, "random account created");
+
+    test_split_order(book);
+    test_running_balance(book);
+    test_online_id(book);
 #if 0
     spl = get_random_split(book, act1, NULL);
     do_test(spl != NULL, "random split created");
@@ -54,6 +54,7 @@
 #include "dialog-totd.h"
 #include "gnc-ui-util.h"
 #include "gnc-session.h"
+#include "TransLog.h"
 #ifdef G_OS_WIN32
 #    include "gnc-help-utils.h"
 #endif
@@ -69,6 +70,7 @@ static int gnome_is_initialized = FALSE;
 
 
 #define ACCEL_MAP_NAME "accelerator-map"
+#define KEY_JOURNAL_SYNC_INTERVAL "journal_sync_interval_msecs"
 
 static void
 gnc_global_options_help_cb (GNCOptionWin *win, gpointer dat)
@@ -170,6 +172,23 @@ gnc_configure_date_completion (void)
     }
 }
 
+/* gnc_configure_journal_sync
+ *    sets how often the transaction log is synced to disk
+ *
+ * Args: Nothing
+ * Returns: Nothing
+ */
+static void
+gnc_configure_journal_sync (void)
+{
+    gint msecs = gnc_gconf_get_int(GCONF_GENERAL,
+                                   KEY_JOURNAL_SYNC_INTERVAL, NULL);
+
+    if (msecs < 0)
+        msecs = 0;
+    xaccLogSetSyncInterval (msecs);
+}
+
 char *
 gnc_gnome_locate_pixmap (const char *name)
 {
@@ -733,6 +752,7 @@ gnc_gui_init(void)
     gnc_ui_util_init();
     gnc_configure_date_format();
     gnc_configure_date_completion();
+    gnc_configure_journal_sync();
 
     gnc_gconf_general_register_cb(
         KEY_DATE_FORMAT, (GncGconfGeneralCb)gnc_configure_date_format, NULL);
@@ -740,6 +760,8 @@ gnc_gui_init(void)
         KEY_DATE_COMPLETION, (GncGconfGeneralCb)gnc_configure_date_completion, NULL);
     gnc_gconf_general_register_cb(
         KEY_DATE_BACKMONTHS, (GncGconfGeneralCb)gnc_configure_date_completion, NULL);
+    gnc_gconf_general_register_cb(
+        KEY_JOURNAL_SYNC_INTERVAL, (GncGconfGeneralCb)gnc_configure_journal_sync, NULL);
     gnc_gconf_general_register_any_cb(
         (GncGconfGeneralAnyCb)gnc_gui_refresh_all, NULL);
 
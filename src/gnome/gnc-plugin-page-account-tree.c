@@ -60,6 +60,7 @@
 #include "gnc-tree-model-account-types.h"
 #include "gnc-ui.h"
 #include "gnc-ui-util.h"
+#include "gnc-window.h"
 #include "lot-viewer.h"
 #include "window-reconcile.h"
 #include "window-autoclear.h"
@@ -1349,6 +1350,7 @@ gnc_plugin_page_account_tree_cmd_scrub (GtkAction *action, GncPluginPageAccountT
     g_return_if_fail (account != NULL);
 
     gnc_suspend_gui_refresh ();
+    qof_event_begin_batch ();
 
     xaccAccountScrubOrphans (account);
     xaccAccountScrubImbalance (account);
@@ -1357,6 +1359,7 @@ gnc_plugin_page_account_tree_cmd_scrub (GtkAction *action, GncPluginPageAccountT
     if (g_getenv("GNC_AUTO_SCRUB_LOTS") != NULL)
         xaccAccountScrubLots(account);
 
+    qof_event_end_batch ();
     gnc_resume_gui_refresh ();
 }
 
@@ -1368,14 +1371,15 @@ gnc_plugin_page_account_tree_cmd_scrub_sub (GtkAction *action, GncPluginPageAcco
     g_return_if_fail (account != NULL);
 
     gnc_suspend_gui_refresh ();
+    qof_event_begin_batch ();
 
-    xaccAccountTreeScrubOrphans (account);
-    xaccAccountTreeScrubImbalance (account);
+    xaccAccountTreeScrubParallel (account, gnc_window_show_progress);
 
     // XXX: Lots are disabled
     if (g_getenv("GNC_AUTO_SCRUB_LOTS") != NULL)
         xaccAccountTreeScrubLots(account);
 
+    qof_event_end_batch ();
     gnc_resume_gui_refresh ();
 }
 
@@ -1385,13 +1389,14 @@ gnc_plugin_page_account_tree_cmd_scrub_all (GtkAction *action, GncPluginPageAcco
     Account *root = gnc_get_current_root_account ();
 
     gnc_suspend_gui_refresh ();
+    qof_event_begin_batch ();
 
-    xaccAccountTreeScrubOrphans (root);
-    xaccAccountTreeScrubImbalance (root);
+    xaccAccountTreeScrubParallel (root, gnc_window_show_progress);
     // XXX: Lots are disabled
     if (g_getenv("GNC_AUTO_SCRUB_LOTS") != NULL)
         xaccAccountTreeScrubLots(root);
 
+    qof_event_end_batch ();
     gnc_resume_gui_refresh ();
 }
 
@@ -47,6 +47,7 @@
 #include "gnc-main-window.h"
 #include "gnc-plugin-page-register.h"
 #include "gnc-ui.h"
+#include "gnc-window.h"
 #include "guile-util.h"
 #include "reconcile-list.h"
 #include "window-reconcile.h"
@@ -1277,8 +1278,7 @@ gnc_recn_scrub_cb(GtkAction *action, gpointer data)
 
     gnc_suspend_gui_refresh ();
 
-    xaccAccountTreeScrubOrphans (account);
-    xaccAccountTreeScrubImbalance (account);
+    xaccAccountTreeScrubParallel (account, gnc_window_show_progress);
 
     // XXX: Lots are disabled.
     if (g_getenv("GNC_AUTO_SCRUB_LOTS") != NULL)
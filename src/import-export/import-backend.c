@@ -1070,54 +1070,10 @@ gnc_import_process_trans_item (GncImportMatchMap *matchmap,
     return FALSE;
 }
 
-/********************************************************************\
- * check_trans_online_id() Callback function used by
- * gnc_import_exists_online_id.  Takes pointers to transaction and split,
- * returns 0 if their online_id kvp_frames do NOT match, or if the split
- * belongs to the transaction
-\********************************************************************/
-static gint check_trans_online_id(Transaction *trans1, void *user_data)
-{
-    Account *account;
-    Split *split1;
-    Split *split2 = user_data;
-    const gchar *online_id1;
-    const gchar *online_id2;
-
-    account = xaccSplitGetAccount(split2);
-    split1 = xaccTransFindSplitByAccount(trans1, account);
-    if (split1 == split2)
-        return 0;
-
-    /* hack - we really want to iterate over the _splits_ of the account
-       instead of the transactions */
-    g_assert(split1 != NULL);
-
-    if (gnc_import_split_has_online_id(split1))
-        online_id1 = gnc_import_get_split_online_id(split1);
-    else
-        online_id1 = gnc_import_get_trans_online_id(trans1);
-
-    online_id2 = gnc_import_get_split_online_id(split2);
-
-    if ((online_id1 == NULL) ||
-            (online_id2 == NULL) ||
-            (strcmp(online_id1, online_id2) != 0))
-    {
-        return 0;
-    }
-    else
-    {
-        /*printf("test_trans_online_id(): Duplicate found\n");*/
-        return 1;
-    }
-}
-
 /** Checks whether the given transaction's online_id already exists in
   its parent account. */
 gboolean gnc_import_exists_online_id (Transaction *trans)
 {
-    int i;
     gboolean online_id_exists = FALSE;
     Account *dest_acct;
     Split *source_split;
@@ -1126,11 +1082,14 @@ gboolean gnc_import_exists_online_id (Transaction *trans)
     source_split = xaccTransGetSplit(trans, 0);
     g_assert(source_split);
 
-    /* DEBUG("%s%d%s","Checking split ",i," for duplicates"); */
+    /* The account indexes its splits by online_id, so this doesn't
+       have to walk the whole account history for every import. */
     dest_acct = xaccSplitGetAccount(source_split);
-    online_id_exists = xaccAccountForEachTransaction(dest_acct,
-                       check_trans_online_id,
-                       source_split);
+    if (dest_acct)
+        online_id_exists = (gnc_account_find_split_by_online_id(
+                                dest_acct,
+                                gnc_import_get_split_online_id(source_split),
+                                source_split) != NULL);
 
     /* If it does, abort the process for this transaction, since it is
        already in the system. */
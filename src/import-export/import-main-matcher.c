@@ -118,6 +118,7 @@ void gnc_gen_trans_list_delete (GNCImportMainMatcher *info)
             gnc_import_TransInfo_delete(trans_info);
         }
         while (gtk_tree_model_iter_next (model, &iter));
+    qof_event_end_batch();
     }
 
     gnc_save_window_size(GCONF_SECTION, GTK_WINDOW(info->dialog));
@@ -145,6 +146,8 @@ on_matcher_ok_clicked (GtkButton *button,
     if (!gtk_tree_model_get_iter_first(model, &iter))
         return;
 
+    /* Hold the engine's events back until every transaction is in */
+    qof_event_begin_batch();
     do
     {
         gtk_tree_model_get(model, &iter,
@@ -66,8 +66,17 @@ void gnc_import_set_trans_online_id(Transaction * transaction,
                                     const gchar * string_value)
 {
     kvp_frame * frame;
+    GList *node;
+
     frame = xaccTransGetSlots(transaction);
     kvp_frame_set_str (frame, "online_id", string_value);
+    for (node = xaccTransGetSplitList(transaction); node; node = node->next)
+    {
+        Split *split = node->data;
+        Account *account = xaccSplitGetAccount(split);
+        if (account)
+            gnc_account_update_online_id(account, split);
+    }
 }
 
 gboolean gnc_import_trans_has_online_id(Transaction * transaction)
@@ -88,8 +97,13 @@ void gnc_import_set_split_online_id(Split * split,
                                     const gchar * string_value)
 {
     kvp_frame * frame;
+    Account *account;
+
     frame = xaccSplitGetSlots(split);
     kvp_frame_set_str (frame, "online_id", string_value);
+    account = xaccSplitGetAccount(split);
+    if (account)
+        gnc_account_update_online_id(account, split);
 }
 
 gboolean gnc_import_split_has_online_id(Split * split)
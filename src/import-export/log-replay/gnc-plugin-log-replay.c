@@ -150,7 +150,9 @@ gnc_plugin_log_replay_cmd_new_log_replay (GtkAction *action,
         GncMainWindowActionData *data)
 {
     gnc_suspend_gui_refresh();
+    qof_event_begin_batch();
     gnc_file_log_replay ();
+    qof_event_end_batch();
     gnc_resume_gui_refresh();
 }
 
@@ -3116,6 +3116,7 @@ gnc_ui_qif_import_finish_cb(GnomeDruidPage * gpage,
     gboolean acct_tree_found = FALSE;
 
     gnc_suspend_gui_refresh();
+    qof_event_begin_batch();
 
     /* Prune any imported transactions that were determined to be duplicates. */
     if (wind->match_transactions != SCM_BOOL_F)
@@ -3127,6 +3128,7 @@ gnc_ui_qif_import_finish_cb(GnomeDruidPage * gpage,
                    scm_c_eval_string("(gnc-get-current-root-account)"),
                    wind->imported_account_tree);
 
+    qof_event_end_batch();
     gnc_resume_gui_refresh();
 
     /* Save the user's mapping preferences. */
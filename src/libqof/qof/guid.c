@@ -32,6 +32,8 @@
 #ifdef HAVE_DIRENT_H
 # include <dirent.h>
 #endif
+#include <errno.h>
+#include <fcntl.h>
 #include <glib.h>
 #include <glib/gstdio.h>
 #include <stdlib.h>
@@ -57,9 +59,21 @@
 #define THRESHOLD (2 * BLOCKSIZE)
 
 
+/* GUIDs are taken from the operating system's random number
+ * generator, read a few hundred at a time into random_buffer.  Only
+ * when that isn't available are they made by hashing an entropy pool
+ * with md5, the way they used to be. */
+#define RANDOM_BUFFER_SIZE (256 * GUID_DATA_SIZE)
+
 /* Static global variables *****************************************/
 static gboolean guid_initialized = FALSE;
 static struct md5_ctx guid_context;
+static gboolean md5_initialized = FALSE;
+
+static int random_fd = -1;
+static guchar random_buffer[RANDOM_BUFFER_SIZE];
+static gsize random_used = RANDOM_BUFFER_SIZE; /* bytes handed out */
+G_LOCK_DEFINE_STATIC (random_buffer);
 
 /* This static indicates the debugging module that this .o belongs to.  */
 static QofLogModule log_module = QOF_MOD_ENGINE;
@@ -358,8 +372,71 @@ init_from_buff(unsigned char * buf, size_t buflen)
     return buflen;
 }
 
+/* Read exactly len random bytes, or give up on the random device. */
+static gboolean
+read_random (guchar *buf, gsize len)
+{
+    while (len > 0 && random_fd >= 0)
+    {
+        gssize n = read (random_fd, buf, len);
+
+        if (n > 0)
+        {
+            buf += n;
+            len -= n;
+        }
+        else if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        else
+        {
+            PWARN ("cannot read from the random device, falling back to md5");
+            close (random_fd);
+            random_fd = -1;
+        }
+    }
+    return (len == 0);
+}
+
+static gboolean
+open_random (void)
+{
+#ifndef G_OS_WIN32
+    if (random_fd < 0)
+        random_fd = g_open ("/dev/urandom", O_RDONLY, 0);
+#endif
+    if (random_fd < 0)
+        return FALSE;
+
+    random_used = RANDOM_BUFFER_SIZE;
+    if (!read_random (random_buffer, RANDOM_BUFFER_SIZE))
+        return FALSE;
+    random_used = 0;
+    return TRUE;
+}
+
+static void guid_init_md5 (void);
+
 void
 guid_init(void)
+{
+    ENTER("");
+
+    if (open_random ())
+    {
+        guid_initialized = TRUE;
+        LEAVE("using /dev/urandom");
+        return;
+    }
+
+    guid_init_md5 ();
+    LEAVE("");
+}
+
+/* Gather an entropy pool for md5 from wherever we can. */
+static void
+guid_init_md5(void)
 {
     size_t bytes = 0;
 
@@ -522,6 +599,7 @@ guid_init(void)
               (unsigned long int)bytes);
 #endif
 
+    md5_initialized = TRUE;
     guid_initialized = TRUE;
     LEAVE();
 }
@@ -529,21 +607,25 @@ guid_init(void)
 void
 guid_shutdown (void)
 {
+    G_LOCK (random_buffer);
+    if (random_fd >= 0)
+        close (random_fd);
+    random_fd = -1;
+    random_used = RANDOM_BUFFER_SIZE;
+    guid_initialized = FALSE;
+    G_UNLOCK (random_buffer);
 }
 
 #define GUID_PERIOD 5000
 
-void
-guid_new(GncGUID *guid)
+static void
+guid_new_md5(GncGUID *guid)
 {
     static int counter = 0;
     struct md5_ctx ctx;
 
-    if (guid == NULL)
-        return;
-
-    if (!guid_initialized)
-        guid_init();
+    if (!md5_initialized)
+        guid_init_md5();
 
     /* make the id */
     ctx = guid_context;
@@ -584,6 +666,69 @@ guid_new(GncGUID *guid)
     counter--;
 }
 
+/* Take n ids from the random buffer, refilling it as needed.  Must be
+ * called with the lock held.  Returns the number of ids made. */
+static guint
+guid_new_random(GncGUID *guids, guint n)
+{
+    guint made = 0;
+
+    while (made < n && random_fd >= 0)
+    {
+        gsize want = (gsize) (n - made) * GUID_DATA_SIZE;
+        gsize avail = RANDOM_BUFFER_SIZE - random_used;
+
+        if (avail == 0)
+        {
+            /* Big requests go straight into the caller's array */
+            if (want >= RANDOM_BUFFER_SIZE)
+            {
+                if (read_random ((guchar *) &guids[made], want))
+                    made = n;
+                break;
+            }
+            if (!read_random (random_buffer, RANDOM_BUFFER_SIZE))
+                break;
+            random_used = 0;
+            avail = RANDOM_BUFFER_SIZE;
+        }
+
+        if (want > avail)
+            want = avail;
+        memcpy (&guids[made], random_buffer + random_used, want);
+        memset (random_buffer + random_used, 0, want);
+        random_used += want;
+        made += want / GUID_DATA_SIZE;
+    }
+    return made;
+}
+
+void
+guid_new(GncGUID *guid)
+{
+    guid_new_n (guid, 1);
+}
+
+void
+guid_new_n(GncGUID *guids, guint n)
+{
+    guint made;
+
+    if (guids == NULL || n == 0)
+        return;
+
+    G_LOCK (random_buffer);
+
+    if (!guid_initialized)
+        guid_init();
+
+    made = guid_new_random (guids, n);
+    for (; made < n; made++)
+        guid_new_md5 (&guids[made]);
+
+    G_UNLOCK (random_buffer);
+}
+
 GncGUID
 guid_new_return(void)
 {
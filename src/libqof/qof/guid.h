@@ -71,8 +71,9 @@ G_CONST_RETURN GncGUID* gnc_value_get_guid (const GValue *value);
 #define GUID_ENCODING_LENGTH 32
 
 
-/** Initialize the id generator with a variety of random
- *  sources.
+/** Initialize the id generator.  The operating system's random
+ *  number generator is used where there is one; otherwise an entropy
+ *  pool is gathered from a variety of random sources.
  *
  *  @note Only one of guid_init(), guid_init_with_salt() and
  *  guid_init_only_salt() should be called.  Calling any
@@ -92,8 +93,9 @@ void guid_shutdown (void);
  *  @param guid A pointer to an existing guid data structure.  The
  *  existing value will be replaced with a new value.
  *
- * This routine uses the md5 algorithm to build strong random guids.
- * Note that while guid's are generated randomly, the odds of this
+ * This routine takes strong random guids from the operating system's
+ * random number generator, or builds them with the md5 algorithm
+ * where there is none.  Note that while guid's are generated randomly, the odds of this
  * routine returning a non-unique id are astronomically small.
  * (Literally astronomically: If you had Cray's on every solar
  * system in the universe running for the entire age of the universe,
@@ -102,6 +104,16 @@ void guid_shutdown (void);
  */
 void guid_new(GncGUID *guid);
 
+/** Generate n new ids at once, as cheaply as possible.  If no
+ *  initialization function has been called, guid_init() will be
+ *  called before the ids are created.
+ *
+ *  @param guids An array of at least n guids, whose existing values
+ *  will be replaced with new ones.
+ *  @param n The number of ids to generate.
+ */
+void guid_new_n(GncGUID *guids, guint n);
+
 /** Generate a new id. If no initialization function has been called,
  *  guid_init() will be called before the id is created.
  *
@@ -32,13 +32,25 @@
 
 #include "qof.h"
 
-/* Note that we keep the keys for this hash table in a GCache
- * (qof_util_string_cache), as it is very likely we will see the
- * same keys over and over again  */
+/* A frame keeps its slots in a vector sorted by key.  Most frames
+ * only hold a handful of slots, and for those a small vector is both
+ * much smaller and faster to search than a hash table; it also lets
+ * the slots be walked in a stable order.  The keys are kept in a
+ * GCache (qof_util_string_cache), as it is very likely we will see
+ * the same keys over and over again, so every frame using a key
+ * shares one copy of it.  */
+
+typedef struct
+{
+    const gchar *key;
+    KvpValue    *value;
+} KvpSlot;
 
 struct _KvpFrame
 {
-    GHashTable  * hash;
+    KvpSlot     * slots;
+    guint         n_slots;
+    guint         n_alloc;
 };
 
 
@@ -48,6 +60,8 @@ typedef struct
     int         datasize;
 } KvpValueBinaryData;
 
+/* GUIDs are stored inline; they are no larger than a gnc_numeric or
+ * a Timespec, so this costs nothing and saves an allocation. */
 struct _KvpValue
 {
     KvpValueType type;
@@ -57,7 +71,7 @@ struct _KvpValue
         double dbl;
         gnc_numeric numeric;
         gchar *str;
-        GncGUID *guid;
+        GncGUID guid;
         Timespec timespec;
         KvpValueBinaryData binary;
         GList *list;
@@ -73,94 +87,138 @@ static QofLogModule log_module = QOF_MOD_KVP;
  * KvpFrame functions
  ********************************************************************/
 
-static guint
-kvp_hash_func(gconstpointer v)
+/* Compare a stored key with the first len bytes of key, ordering
+ * them the way strcmp would order the two strings. */
+static inline int
+kvp_key_compare (const gchar *stored, const gchar *key, gsize len)
 {
-    return g_str_hash(v);
+    int cmp = strncmp (stored, key, len);
+    if (cmp) return cmp;
+    return stored[len] ? 1 : 0;
 }
 
-static gint
-kvp_comp_func(gconstpointer v, gconstpointer v2)
+/* Binary search for the first len bytes of key.  Returns TRUE if
+ * the slot exists; either way *pos is set to where it is or where it
+ * would have to be inserted. */
+static gboolean
+kvp_frame_find (const KvpFrame *frame, const gchar *key, gsize len,
+                guint *pos)
 {
-    return g_str_equal(v, v2);
+    guint lo = 0, hi = frame->n_slots;
+
+    while (lo < hi)
+    {
+        guint mid = (lo + hi) / 2;
+        int cmp = kvp_key_compare (frame->slots[mid].key, key, len);
+
+        if (cmp == 0)
+        {
+            *pos = mid;
+            return TRUE;
+        }
+        if (cmp < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    *pos = lo;
+    return FALSE;
 }
 
-static gboolean
-init_frame_body_if_needed(KvpFrame *f)
+/* Insert a slot at pos, which must keep the vector sorted.  Keys
+ * mostly arrive in order (e.g. when loading a file), in which case
+ * pos is the end and nothing needs to move. */
+static void
+kvp_frame_insert_slot (KvpFrame *frame, guint pos, const gchar *key,
+                       KvpValue *value)
 {
-    if (!f->hash)
+    if (frame->n_slots == frame->n_alloc)
     {
-        f->hash = g_hash_table_new(&kvp_hash_func, &kvp_comp_func);
+        frame->n_alloc = frame->n_alloc ? frame->n_alloc * 2 : 2;
+        frame->slots = g_renew (KvpSlot, frame->slots, frame->n_alloc);
     }
-    return(f->hash != NULL);
+    if (pos < frame->n_slots)
+        memmove (&frame->slots[pos + 1], &frame->slots[pos],
+                 (frame->n_slots - pos) * sizeof (KvpSlot));
+    frame->slots[pos].key = key;
+    frame->slots[pos].value = value;
+    frame->n_slots++;
 }
 
-KvpFrame *
-kvp_frame_new(void)
+static void
+kvp_frame_remove_slot (KvpFrame *frame, guint pos)
 {
-    KvpFrame * retval = g_new0(KvpFrame, 1);
+    qof_util_string_cache_remove (frame->slots[pos].key);
+    frame->n_slots--;
+    if (pos < frame->n_slots)
+        memmove (&frame->slots[pos], &frame->slots[pos + 1],
+                 (frame->n_slots - pos) * sizeof (KvpSlot));
 
-    /* Save space until the frame is actually used */
-    retval->hash = NULL;
-    return retval;
+    /* Give the memory back once the frame is empty again */
+    if (frame->n_slots == 0)
+    {
+        g_free (frame->slots);
+        frame->slots = NULL;
+        frame->n_alloc = 0;
+    }
 }
 
-static void
-kvp_frame_delete_worker(gpointer key, gpointer value, gpointer user_data)
+KvpFrame *
+kvp_frame_new(void)
 {
-    qof_util_string_cache_remove(key);
-    kvp_value_delete((KvpValue *)value);
+    /* Save space until the frame is actually used */
+    return g_slice_new0(KvpFrame);
 }
 
 void
 kvp_frame_delete(KvpFrame * frame)
 {
+    guint i;
+
     if (!frame) return;
 
-    if (frame->hash)
+    /* free any allocated resource for frame or its children */
+    for (i = 0; i < frame->n_slots; i++)
     {
-        /* free any allocated resource for frame or its children */
-        g_hash_table_foreach(frame->hash, & kvp_frame_delete_worker,
-                             (gpointer)frame);
-
-        /* delete the hash table */
-        g_hash_table_destroy(frame->hash);
-        frame->hash = NULL;
+        qof_util_string_cache_remove(frame->slots[i].key);
+        kvp_value_delete(frame->slots[i].value);
     }
-    g_free(frame);
+    g_free(frame->slots);
+    g_slice_free(KvpFrame, frame);
 }
 
 gboolean
 kvp_frame_is_empty(const KvpFrame * frame)
 {
     if (!frame) return TRUE;
-    if (!frame->hash) return TRUE;
-    return FALSE;
+    return (frame->n_slots == 0);
 }
 
-static void
-kvp_frame_copy_worker(gpointer key, gpointer value, gpointer user_data)
+guint
+kvp_frame_count_slots(const KvpFrame * frame)
 {
-    KvpFrame * dest = (KvpFrame *)user_data;
-    g_hash_table_insert(dest->hash,
-                        qof_util_string_cache_insert(key),
-                        (gpointer)kvp_value_copy(value));
+    if (!frame) return 0;
+    return frame->n_slots;
 }
 
 KvpFrame *
 kvp_frame_copy(const KvpFrame * frame)
 {
     KvpFrame * retval = kvp_frame_new();
+    guint i;
 
-    if (!frame) return retval;
+    if (!frame || !frame->n_slots) return retval;
 
-    if (frame->hash)
+    /* The source is sorted already, so the copy can be filled in order */
+    retval->slots = g_new(KvpSlot, frame->n_slots);
+    retval->n_alloc = frame->n_slots;
+    for (i = 0; i < frame->n_slots; i++)
     {
-        if (!init_frame_body_if_needed(retval)) return(NULL);
-        g_hash_table_foreach(frame->hash,
-                             & kvp_frame_copy_worker,
-                             (gpointer)retval);
+        retval->slots[i].key =
+            qof_util_string_cache_insert(frame->slots[i].key);
+        retval->slots[i].value = kvp_value_copy(frame->slots[i].value);
     }
+    retval->n_slots = frame->n_slots;
     return retval;
 }
 
@@ -172,33 +230,27 @@ static KvpValue *
 kvp_frame_replace_slot_nc (KvpFrame * frame, const char * slot,
                            KvpValue * new_value)
 {
-    gpointer orig_key;
-    gpointer orig_value = NULL;
-    int      key_exists;
+    KvpValue *orig_value = NULL;
+    guint     pos;
 
     if (!frame || !slot) return NULL;
-    if (!init_frame_body_if_needed(frame)) return NULL; /* Error ... */
 
-    key_exists = g_hash_table_lookup_extended(frame->hash, slot,
-                 & orig_key, & orig_value);
-    if (key_exists)
+    if (kvp_frame_find (frame, slot, strlen (slot), &pos))
     {
-        g_hash_table_remove(frame->hash, slot);
-        qof_util_string_cache_remove(orig_key);
+        orig_value = frame->slots[pos].value;
+        if (new_value)
+            frame->slots[pos].value = new_value;
+        else
+            kvp_frame_remove_slot (frame, pos);
     }
-    else
+    else if (new_value)
     {
-        orig_value = NULL;
+        kvp_frame_insert_slot (frame, pos,
+                               qof_util_string_cache_insert ((gpointer) slot),
+                               new_value);
     }
 
-    if (new_value)
-    {
-        g_hash_table_insert(frame->hash,
-                            qof_util_string_cache_insert((gpointer) slot),
-                            new_value);
-    }
-
-    return (KvpValue *) orig_value;
+    return orig_value;
 }
 
 /* Passing in a null value into this routine has the effect
@@ -238,67 +290,68 @@ get_or_make (KvpFrame *fr, const char * key)
     return next_frame;
 }
 
-/* Get pointer to last frame in path. If the path doesn't exist,
- * it is created.  The string stored in keypath will be hopelessly
- * mangled .
+/* Get pointer to last frame in the first path_len bytes of key_path.
+ * If the path doesn't exist, it is created.  The path is walked in
+ * place; a key is only copied when a missing frame has to be made.
  */
-static inline KvpFrame *
-kvp_frame_get_frame_slash_trash (KvpFrame *frame, char *key_path)
+static KvpFrame *
+kvp_frame_make_path (KvpFrame *frame, const char *key_path, gsize path_len)
 {
-    char *key, *next;
-    if (!frame || !key_path) return frame;
-
-    key = key_path;
-    key --;
+    const char *key = key_path, *end = key_path + path_len;
 
-    while (key)
+    while (frame && key < end)
     {
-        key ++;
-        while ('/' == *key)
+        const char *next;
+        guint pos;
+
+        if ('/' == *key)
         {
             key++;
+            continue;
         }
-        if (0x0 == *key) break;    /* trailing slash */
-        next = strchr (key, '/');
-        if (next) *next = 0x0;
-
-        frame = get_or_make (frame, key);
-        if (!frame) break;  /* error - should never happen */
+        next = memchr (key, '/', end - key);
+        if (!next) next = end;
 
+        if (kvp_frame_find (frame, key, next - key, &pos))
+        {
+            frame = kvp_value_get_frame (frame->slots[pos].value);
+        }
+        else
+        {
+            gchar *name = g_strndup (key, next - key);
+            frame = get_or_make (frame, name);
+            g_free (name);
+        }
         key = next;
     }
     return frame;
 }
 
 /* ============================================================ */
-/* Get pointer to last frame in path, or NULL if the path doesn't
- * exist. The string stored in keypath will be hopelessly mangled .
+/* Get pointer to last frame in the first path_len bytes of key_path,
+ * or NULL if the path doesn't exist.
  */
-static inline const KvpFrame *
-kvp_frame_get_frame_or_null_slash_trash (const KvpFrame *frame, char *key_path)
+static const KvpFrame *
+kvp_frame_find_path (const KvpFrame *frame, const char *key_path,
+                     gsize path_len)
 {
-    KvpValue *value;
-    char *key, *next;
-    if (!frame || !key_path) return NULL;
-
-    key = key_path;
-    key --;
+    const char *key = key_path, *end = key_path + path_len;
 
-    while (key)
+    while (frame && key < end)
     {
-        key ++;
-        while ('/' == *key)
+        const char *next;
+        guint pos;
+
+        if ('/' == *key)
         {
             key++;
+            continue;
         }
-        if (0x0 == *key) break;    /* trailing slash */
-        next = strchr (key, '/');
-        if (next) *next = 0x0;
+        next = memchr (key, '/', end - key);
+        if (!next) next = end;
 
-        value = kvp_frame_get_slot (frame, key);
-        if (!value) return NULL;
-        frame = kvp_value_get_frame (value);
-        if (!frame) return NULL;
+        if (!kvp_frame_find (frame, key, next - key, &pos)) return NULL;
+        frame = kvp_value_get_frame (frame->slots[pos].value);
 
         key = next;
     }
@@ -332,13 +385,7 @@ get_trailer_make (KvpFrame * frame, const char * key_path, char **end_key)
     }
     else
     {
-        char *root, *lkey;
-        root = g_strdup (key_path);
-        lkey = strrchr (root, '/');
-        *lkey = 0;
-        frame = kvp_frame_get_frame_slash_trash (frame, root);
-        g_free(root);
-
+        frame = kvp_frame_make_path (frame, key_path, last_key - key_path);
         last_key ++;
     }
 
@@ -374,13 +421,7 @@ get_trailer_or_null (const KvpFrame * frame, const char * key_path, char **end_k
     }
     else
     {
-        char *root, *lkey;
-        root = g_strdup (key_path);
-        lkey = strrchr (root, '/');
-        *lkey = 0;
-        frame = kvp_frame_get_frame_or_null_slash_trash (frame, root);
-        g_free(root);
-
+        frame = kvp_frame_find_path (frame, key_path, last_key - key_path);
         last_key ++;
     }
 
@@ -607,11 +648,10 @@ kvp_frame_set_slot_nc(KvpFrame * frame, const char * slot,
 KvpValue *
 kvp_frame_get_slot(const KvpFrame * frame, const char * slot)
 {
-    KvpValue *v;
-    if (!frame) return NULL;
-    if (!frame->hash) return NULL;  /* Error ... */
-    v = g_hash_table_lookup(frame->hash, slot);
-    return v;
+    guint pos;
+    if (!frame || !slot) return NULL;
+    if (!kvp_frame_find(frame, slot, strlen(slot), &pos)) return NULL;
+    return frame->slots[pos].value;
 }
 
 /* ============================================================ */
@@ -885,13 +925,8 @@ kvp_frame_get_frame_path (KvpFrame *frame, const char *key,  ...)
 KvpFrame *
 kvp_frame_get_frame_slash (KvpFrame *frame, const char *key_path)
 {
-    char *root;
     if (!frame || !key_path) return frame;
-
-    root = g_strdup (key_path);
-    frame = kvp_frame_get_frame_slash_trash (frame, root);
-    g_free(root);
-    return frame;
+    return kvp_frame_make_path (frame, key_path, strlen (key_path));
 }
 
 /* ============================================================ */
@@ -1033,7 +1068,7 @@ kvp_glist_compare(const GList * list1, const GList * list2)
 KvpValue *
 kvp_value_new_gint64(gint64 value)
 {
-    KvpValue * retval  = g_new0(KvpValue, 1);
+    KvpValue * retval  = g_slice_new0(KvpValue);
     retval->type        = KVP_TYPE_GINT64;
     retval->value.int64 = value;
     return retval;
@@ -1042,7 +1077,7 @@ kvp_value_new_gint64(gint64 value)
 KvpValue *
 kvp_value_new_double(double value)
 {
-    KvpValue * retval  = g_new0(KvpValue, 1);
+    KvpValue * retval  = g_slice_new0(KvpValue);
     retval->type        = KVP_TYPE_DOUBLE;
     retval->value.dbl   = value;
     return retval;
@@ -1051,7 +1086,7 @@ kvp_value_new_double(double value)
 KvpValue *
 kvp_value_new_numeric(gnc_numeric value)
 {
-    KvpValue * retval    = g_new0(KvpValue, 1);
+    KvpValue * retval    = g_slice_new0(KvpValue);
     retval->type          = KVP_TYPE_NUMERIC;
     retval->value.numeric = value;
     return retval;
@@ -1063,7 +1098,7 @@ kvp_value_new_string(const char * value)
     KvpValue * retval;
     if (!value) return NULL;
 
-    retval = g_new0(KvpValue, 1);
+    retval = g_slice_new0(KvpValue);
     retval->type       = KVP_TYPE_STRING;
     retval->value.str  = g_strdup(value);
     return retval;
@@ -1075,17 +1110,16 @@ kvp_value_new_guid(const GncGUID * value)
     KvpValue * retval;
     if (!value) return NULL;
 
-    retval = g_new0(KvpValue, 1);
+    retval = g_slice_new0(KvpValue);
     retval->type       = KVP_TYPE_GUID;
-    retval->value.guid = g_new0(GncGUID, 1);
-    memcpy(retval->value.guid, value, sizeof(GncGUID));
+    retval->value.guid = *value;
     return retval;
 }
 
 KvpValue *
 kvp_value_new_timespec(Timespec value)
 {
-    KvpValue * retval = g_new0(KvpValue, 1);
+    KvpValue * retval = g_slice_new0(KvpValue);
     retval->type       = KVP_TYPE_TIMESPEC;
     retval->value.timespec = value;
     return retval;
@@ -1094,7 +1128,7 @@ kvp_value_new_timespec(Timespec value)
 KvpValue *
 kvp_value_new_gdate(GDate value)
 {
-    KvpValue * retval = g_new0(KvpValue, 1);
+    KvpValue * retval = g_slice_new0(KvpValue);
     retval->type       = KVP_TYPE_GDATE;
     retval->value.gdate = value;
     return retval;
@@ -1106,7 +1140,7 @@ kvp_value_new_binary(const void * value, guint64 datasize)
     KvpValue * retval;
     if (!value) return NULL;
 
-    retval = g_new0(KvpValue, 1);
+    retval = g_slice_new0(KvpValue);
     retval->type = KVP_TYPE_BINARY;
     retval->value.binary.data = g_new0(char, datasize);
     retval->value.binary.datasize = datasize;
@@ -1120,7 +1154,7 @@ kvp_value_new_binary_nc(void * value, guint64 datasize)
     KvpValue * retval;
     if (!value) return NULL;
 
-    retval = g_new0(KvpValue, 1);
+    retval = g_slice_new0(KvpValue);
     retval->type = KVP_TYPE_BINARY;
     retval->value.binary.data = value;
     retval->value.binary.datasize = datasize;
@@ -1133,7 +1167,7 @@ kvp_value_new_glist(const GList * value)
     KvpValue * retval;
     if (!value) return NULL;
 
-    retval = g_new0(KvpValue, 1);
+    retval = g_slice_new0(KvpValue);
     retval->type       = KVP_TYPE_GLIST;
     retval->value.list = kvp_glist_copy(value);
     return retval;
@@ -1145,7 +1179,7 @@ kvp_value_new_glist_nc(GList * value)
     KvpValue * retval;
     if (!value) return NULL;
 
-    retval = g_new0(KvpValue, 1);
+    retval = g_slice_new0(KvpValue);
     retval->type       = KVP_TYPE_GLIST;
     retval->value.list = value;
     return retval;
@@ -1157,7 +1191,7 @@ kvp_value_new_frame(const KvpFrame * value)
     KvpValue * retval;
     if (!value) return NULL;
 
-    retval  = g_new0(KvpValue, 1);
+    retval  = g_slice_new0(KvpValue);
     retval->type        = KVP_TYPE_FRAME;
     retval->value.frame = kvp_frame_copy(value);
     return retval;
@@ -1169,7 +1203,7 @@ kvp_value_new_frame_nc(KvpFrame * value)
     KvpValue * retval;
     if (!value) return NULL;
 
-    retval  = g_new0(KvpValue, 1);
+    retval  = g_slice_new0(KvpValue);
     retval->type        = KVP_TYPE_FRAME;
     retval->value.frame = value;
     return retval;
@@ -1185,9 +1219,6 @@ kvp_value_delete(KvpValue * value)
     case KVP_TYPE_STRING:
         g_free(value->value.str);
         break;
-    case KVP_TYPE_GUID:
-        g_free(value->value.guid);
-        break;
     case KVP_TYPE_BINARY:
         g_free(value->value.binary.data);
         break;
@@ -1201,11 +1232,12 @@ kvp_value_delete(KvpValue * value)
     case KVP_TYPE_GINT64:
     case KVP_TYPE_DOUBLE:
     case KVP_TYPE_NUMERIC:
+    case KVP_TYPE_GUID:
     case KVP_TYPE_TIMESPEC:
     case KVP_TYPE_GDATE:
         break;
     }
-    g_free(value);
+    g_slice_free(KvpValue, value);
 }
 
 KvpValueType
@@ -1277,7 +1309,7 @@ kvp_value_get_guid(const KvpValue * value)
     if (!value) return NULL;
     if (value->type == KVP_TYPE_GUID)
     {
-        return value->value.guid;
+        return (GncGUID *) &value->value.guid;
     }
     else
     {
@@ -1408,7 +1440,7 @@ kvp_value_copy(const KvpValue * value)
         return kvp_value_new_string(value->value.str);
         break;
     case KVP_TYPE_GUID:
-        return kvp_value_new_guid(value->value.guid);
+        return kvp_value_new_guid(&value->value.guid);
         break;
     case KVP_TYPE_GDATE:
         return kvp_value_new_gdate(value->value.gdate);
@@ -1437,11 +1469,13 @@ kvp_frame_for_each_slot(KvpFrame *f,
                                      gpointer data),
                         gpointer data)
 {
+    guint i;
+
     if (!f) return;
     if (!proc) return;
-    if (!(f->hash)) return;
 
-    g_hash_table_foreach(f->hash, (GHFunc) proc, data);
+    for (i = 0; i < f->n_slots; i++)
+        proc(f->slots[i].key, f->slots[i].value, data);
 }
 
 #ifdef _MSC_VER
@@ -1484,7 +1518,7 @@ kvp_value_compare(const KvpValue * kva, const KvpValue * kvb)
         return strcmp(kva->value.str, kvb->value.str);
         break;
     case KVP_TYPE_GUID:
-        return guid_compare(kva->value.guid, kvb->value.guid);
+        return guid_compare(&kva->value.guid, &kvb->value.guid);
         break;
     case KVP_TYPE_TIMESPEC:
         return timespec_cmp(&(kva->value.timespec), &(kvb->value.timespec));
@@ -1549,8 +1583,8 @@ kvp_frame_compare(const KvpFrame *fa, const KvpFrame *fb)
     if (fa && !fb) return 1;
 
     /* nothing is always less than something */
-    if (!fa->hash && fb->hash) return -1;
-    if (fa->hash && !fb->hash) return 1;
+    if (!fa->n_slots && fb->n_slots) return -1;
+    if (fa->n_slots && !fb->n_slots) return 1;
 
     status.compare = 0;
     status.other_frame = (KvpFrame *) fb;
@@ -1614,10 +1648,10 @@ static gchar*
 kvp_value_to_bare_string(const KvpValue *val);
 
 static void
-kvp_frame_to_bare_string_helper(gpointer key, gpointer value, gpointer data)
+kvp_frame_to_bare_string_helper(const char *key, KvpValue *value, gpointer data)
 {
     gchar **str = (gchar**)data;
-    *str = g_strdup_printf("%s", kvp_value_to_bare_string((KvpValue *)value));
+    *str = g_strdup_printf("%s", kvp_value_to_bare_string(value));
 }
 
 static gchar*
@@ -1689,11 +1723,7 @@ kvp_value_to_bare_string(const KvpValue *val)
         KvpFrame *frame;
 
         frame = kvp_value_get_frame(val);
-        if (frame->hash)
-        {
-            tmp1 = g_strdup("");
-            g_hash_table_foreach(frame->hash, kvp_frame_to_bare_string_helper, &tmp1);
-        }
+        kvp_frame_for_each_slot(frame, kvp_frame_to_bare_string_helper, &tmp1);
         return tmp1;
     }
     case KVP_TYPE_GDATE:
@@ -1789,17 +1819,17 @@ kvp_value_to_string(const KvpValue *val)
 }
 
 static void
-kvp_frame_to_string_helper(gpointer key, gpointer value, gpointer data)
+kvp_frame_to_string_helper(const char *key, KvpValue *value, gpointer data)
 {
     gchar *tmp_val;
     gchar **str = (gchar**)data;
     gchar *old_data = *str;
 
-    tmp_val = kvp_value_to_string((KvpValue *)value);
+    tmp_val = kvp_value_to_string(value);
 
     *str = g_strdup_printf("%s    %s => %s,\n",
                            *str ? *str : "",
-                           key ? (char *) key : "",
+                           key ? key : "",
                            tmp_val ? tmp_val : "");
 
     g_free(old_data);
@@ -1815,8 +1845,8 @@ kvp_frame_to_string(const KvpFrame *frame)
 
     tmp1 = g_strdup_printf("{\n");
 
-    if (frame->hash)
-        g_hash_table_foreach(frame->hash, kvp_frame_to_string_helper, &tmp1);
+    kvp_frame_for_each_slot((KvpFrame *) frame, kvp_frame_to_string_helper,
+                            &tmp1);
 
     {
         gchar *tmp2;
@@ -1828,11 +1858,4 @@ kvp_frame_to_string(const KvpFrame *frame)
     return tmp1;
 }
 
-GHashTable*
-kvp_frame_get_hash(const KvpFrame *frame)
-{
-    g_return_val_if_fail (frame != NULL, NULL);
-    return frame->hash;
-}
-
 /* ========================== END OF FILE ======================= */
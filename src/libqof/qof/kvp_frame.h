@@ -130,6 +130,9 @@ KvpFrame   * kvp_frame_copy(const KvpFrame * frame);
 /** Return TRUE if the KvpFrame is empty */
 gboolean     kvp_frame_is_empty(const KvpFrame * frame);
 
+/** Return the number of slots directly held by the KvpFrame */
+guint        kvp_frame_count_slots(const KvpFrame * frame);
+
 /** @} */
 
 /** @name KvpFrame Basic Value Storing
@@ -612,10 +615,11 @@ gboolean kvp_value_binary_append(KvpValue *v, void *data, guint64 size);
 /** @name  Iterators
 @{
 */
-/** Traverse all of the slots in the given kvp_frame.  This function
-   does not descend recursively to traverse any kvp_frames stored as
-   slot values.  You must handle that in proc, with a suitable
-   recursive call if desired. */
+/** Traverse all of the slots in the given kvp_frame, in order of
+   their keys (as sorted by strcmp).  This function does not descend
+   recursively to traverse any kvp_frames stored as slot values.  You
+   must handle that in proc, with a suitable recursive call if
+   desired.  proc must not add or remove slots of f. */
 void kvp_frame_for_each_slot(KvpFrame *f,
                              void (*proc)(const gchar *key,
                                      KvpValue *value,
@@ -627,7 +631,6 @@ void kvp_frame_for_each_slot(KvpFrame *f,
 /** Internal helper routines, you probably shouldn't be using these. */
 gchar* kvp_frame_to_string(const KvpFrame *frame);
 gchar* binary_to_string(const void *data, guint32 size);
-GHashTable* kvp_frame_get_hash(const KvpFrame *frame);
 
 /** @} */
 #endif
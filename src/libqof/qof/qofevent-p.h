@@ -34,9 +34,15 @@ typedef struct
     gpointer user_data;
 
     gint handler_id;
+
+    QofIdTypeConst type;        /* NULL for all entity types */
+    QofEventId event_mask;
 } HandlerInfo;
 
 /* generates an event even when events are suspended! */
 void qof_event_force (QofInstance *entity, QofEventId event_id, gpointer event_data);
 
+/* Forget any batched events of an entity that is going away. */
+void qof_event_purge_entity (QofInstance *entity);
+
 #endif
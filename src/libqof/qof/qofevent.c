@@ -24,6 +24,7 @@
 
 #include "config.h"
 #include <glib.h>
+#include <string.h>
 #include "qof.h"
 #include "qofevent-p.h"
 
@@ -34,6 +35,27 @@ static guint   handler_run_level = 0;
 static guint   pending_deletes   = 0;
 static GList   *handlers  =   NULL;
 
+/* Events queued by qof_event_begin_batch, in the order they were
+ * first generated.  pending_latest finds the latest undelivered event
+ * of each (entity, subject) pair, so that a repeat of it can be
+ * dropped; pending_by_instance finds every event naming an instance,
+ * as entity or as subject, so they can be dropped when it goes away. */
+typedef struct
+{
+    QofInstance *entity;
+    QofEventId   event_id;
+    QofInstance *subject;     /* what the event data is about, or NULL */
+    gpointer     data;        /* the event data, or a copy of it */
+    gsize        data_size;   /* size of the copy, 0 if not copied */
+    gboolean     done;        /* delivered, or dropped */
+} PendingEvent;
+
+static guint        batch_level         = 0;
+static gboolean     flushing_batch      = FALSE;
+static GPtrArray   *pending_events      = NULL;
+static GHashTable  *pending_latest      = NULL;
+static GHashTable  *pending_by_instance = NULL;
+
 /* This static indicates the debugging module that this .o belongs to.  */
 static QofLogModule log_module = QOF_MOD_ENGINE;
 
@@ -68,13 +90,30 @@ find_next_handler_id(void)
     return handler_id;
 }
 
+static void
+handler_info_free (HandlerInfo *hi)
+{
+    if (hi->type)
+        CACHE_REMOVE (hi->type);
+    g_free (hi);
+}
+
 gint
 qof_event_register_handler (QofEventHandler handler, gpointer user_data)
+{
+    return qof_event_register_handler_full (handler, user_data, NULL,
+                                            QOF_EVENT_ANY);
+}
+
+gint
+qof_event_register_handler_full (QofEventHandler handler, gpointer user_data,
+                                 QofIdTypeConst type, QofEventId event_mask)
 {
     HandlerInfo *hi;
     gint handler_id;
 
-    ENTER ("(handler=%p, data=%p)", handler, user_data);
+    ENTER ("(handler=%p, data=%p, type=%s, mask=%x)", handler, user_data,
+           type ? type : "(any)", event_mask);
 
     /* sanity check */
     if (!handler)
@@ -92,6 +131,8 @@ qof_event_register_handler (QofEventHandler handler, gpointer user_data)
     hi->handler = handler;
     hi->user_data = user_data;
     hi->handler_id = handler_id;
+    hi->type = type ? CACHE_INSERT (type) : NULL;
+    hi->event_mask = event_mask;
 
     handlers = g_list_prepend (handlers, hi);
     LEAVE ("(handler=%p, data=%p) handler_id=%d", handler, user_data, handler_id);
@@ -127,7 +168,7 @@ qof_event_unregister_handler (gint handler_id)
         {
             handlers = g_list_remove_link (handlers, node);
             g_list_free_1 (node);
-            g_free (hi);
+            handler_info_free (hi);
         }
         else
         {
@@ -193,6 +234,11 @@ qof_event_generate_internal (QofInstance *entity, QofEventId event_id,
         HandlerInfo *hi = node->data;
 
         next_node = node->next;
+        if (!(hi->event_mask & event_id))
+            continue;
+        if (hi->type && hi->type != entity->e_type &&
+                g_strcmp0 (hi->type, entity->e_type) != 0)
+            continue;
         if (hi->handler)
         {
             PINFO("id=%d hi=%p han=%p data=%p", hi->handler_id, hi,
@@ -216,7 +262,7 @@ qof_event_generate_internal (QofInstance *entity, QofEventId event_id,
                 /* remove this node from the list, then free this node */
                 handlers = g_list_remove_link (handlers, node);
                 g_list_free_1 (node);
-                g_free (hi);
+                handler_info_free (hi);
             }
         }
         pending_deletes = 0;
@@ -232,16 +278,219 @@ qof_event_force (QofInstance *entity, QofEventId event_id, gpointer event_data)
     qof_event_generate_internal (entity, event_id, event_data);
 }
 
+static guint
+pending_event_hash (gconstpointer key)
+{
+    const PendingEvent *pe = key;
+    return g_direct_hash (pe->entity) ^ (g_direct_hash (pe->subject) * 31);
+}
+
+static gboolean
+pending_event_equal (gconstpointer a, gconstpointer b)
+{
+    const PendingEvent *pa = a, *pb = b;
+    return pa->entity == pb->entity && pa->subject == pb->subject;
+}
+
+static void
+pending_index_instance (QofInstance *inst, PendingEvent *pe)
+{
+    GSList *list = g_hash_table_lookup (pending_by_instance, inst);
+    g_hash_table_insert (pending_by_instance, inst, g_slist_prepend (list, pe));
+}
+
+/* Take an event out of the running, so nothing is coalesced into it */
+static void
+pending_event_done (PendingEvent *pe)
+{
+    if (g_hash_table_lookup (pending_latest, pe) == pe)
+        g_hash_table_remove (pending_latest, pe);
+    pe->done = TRUE;
+}
+
+/* Queue an event of the current batch, unless the latest event queued
+ * for the same entity and subject is the same event with the same
+ * data.  A repeat separated from its first occurrence by another event
+ * of the pair, such as an add, remove and add of one split, is kept. */
+static void
+qof_event_queue (QofInstance *entity, QofEventId event_id,
+                 QofInstance *subject, gpointer data, gsize data_size)
+{
+    PendingEvent probe, *pe;
+
+    if (!pending_events)
+    {
+        pending_events = g_ptr_array_new ();
+        pending_latest = g_hash_table_new (pending_event_hash,
+                                           pending_event_equal);
+        pending_by_instance = g_hash_table_new (g_direct_hash, g_direct_equal);
+    }
+
+    probe.entity = entity;
+    probe.subject = subject;
+    pe = g_hash_table_lookup (pending_latest, &probe);
+    if (pe && pe->event_id == event_id && pe->data_size == data_size &&
+            (data_size ? memcmp (pe->data, data, data_size) == 0
+             : pe->data == data))
+        return;
+
+    pe = g_slice_new0 (PendingEvent);
+    pe->entity = entity;
+    pe->event_id = event_id;
+    pe->subject = subject;
+    pe->data = data_size ? g_memdup (data, data_size) : data;
+    pe->data_size = data_size;
+    g_ptr_array_add (pending_events, pe);
+    g_hash_table_replace (pending_latest, pe, pe);
+    pending_index_instance (entity, pe);
+    if (subject && subject != entity)
+        pending_index_instance (subject, pe);
+}
+
+void
+qof_event_purge_entity (QofInstance *entity)
+{
+    GSList *list, *node;
+
+    if (!pending_by_instance)
+        return;
+
+    list = g_hash_table_lookup (pending_by_instance, entity);
+    if (!list)
+        return;
+
+    /* The events stay in pending_events, they are skipped and freed
+     * when the batch is delivered. */
+    for (node = list; node; node = node->next)
+    {
+        PendingEvent *pe = node->data;
+        if (!pe->done)
+            pending_event_done (pe);
+    }
+    g_hash_table_remove (pending_by_instance, entity);
+    g_slist_free (list);
+}
+
+static void
+pending_free_list (gpointer key, gpointer value, gpointer user_data)
+{
+    g_slist_free (value);
+}
+
+/* Deliver everything queued.  Handlers may queue more events (in a
+ * batch of their own) or destroy instances still waiting; both are
+ * picked up as the loop goes on. */
+static void
+qof_event_flush_batch (void)
+{
+    guint i;
+
+    if (!pending_events)
+        return;
+
+    flushing_batch = TRUE;
+    for (i = 0; i < pending_events->len; i++)
+    {
+        PendingEvent *pe = g_ptr_array_index (pending_events, i);
+
+        if (pe->done)
+            continue;
+        pending_event_done (pe);
+        if (!suspend_counter)
+            qof_event_generate_internal (pe->entity, pe->event_id,
+                                         pe->data);
+    }
+    flushing_batch = FALSE;
+
+    for (i = 0; i < pending_events->len; i++)
+    {
+        PendingEvent *pe = g_ptr_array_index (pending_events, i);
+        if (pe->data_size)
+            g_free (pe->data);
+        g_slice_free (PendingEvent, pe);
+    }
+    g_ptr_array_free (pending_events, TRUE);
+    g_hash_table_destroy (pending_latest);
+    g_hash_table_foreach (pending_by_instance, pending_free_list, NULL);
+    g_hash_table_destroy (pending_by_instance);
+    pending_events = NULL;
+    pending_latest = NULL;
+    pending_by_instance = NULL;
+}
+
+void
+qof_event_begin_batch (void)
+{
+    batch_level++;
+
+    if (batch_level == 0)
+    {
+        PERR ("batch level overflow");
+    }
+}
+
+void
+qof_event_end_batch (void)
+{
+    if (batch_level == 0)
+    {
+        PERR ("batch level underflow");
+        return;
+    }
+
+    batch_level--;
+
+    if (batch_level == 0 && !flushing_batch)
+        qof_event_flush_batch ();
+}
+
 void
 qof_event_gen (QofInstance *entity, QofEventId event_id, gpointer event_data)
 {
     if (!entity)
         return;
 
+    if (batch_level && !suspend_counter && event_id != QOF_EVENT_NONE)
+    {
+        if (!event_data && event_id != QOF_EVENT_DESTROY)
+        {
+            qof_event_queue (entity, event_id, NULL, NULL, 0);
+            return;
+        }
+
+        /* This one can't wait.  Deliver what was queued before it
+         * first, so that handlers see the events in the order they
+         * happened. */
+        if (!flushing_batch)
+            qof_event_flush_batch ();
+    }
+
+    /* Nobody should hear about an entity after its destruction */
+    if (event_id == QOF_EVENT_DESTROY)
+        qof_event_purge_entity (entity);
+
     if (suspend_counter)
         return;
 
     qof_event_generate_internal (entity, event_id, event_data);
 }
 
+void
+qof_event_gen_about (QofInstance *entity, QofEventId event_id,
+                     QofInstance *subject, gpointer event_data,
+                     gsize data_size)
+{
+    if (!entity)
+        return;
+
+    if (batch_level && !suspend_counter && subject &&
+            event_id != QOF_EVENT_NONE && event_id != QOF_EVENT_DESTROY)
+    {
+        qof_event_queue (entity, event_id, subject, event_data, data_size);
+        return;
+    }
+
+    qof_event_gen (entity, event_id, event_data);
+}
+
 /* =========================== END OF FILE ======================= */
@@ -72,6 +72,8 @@ for future libqof1 or libqof2 usage.
 #define QOF_EVENT_REMOVE   QOF_MAKE_EVENT(4)
 #define QOF_EVENT__LAST    QOF_MAKE_EVENT(QOF_EVENT_BASE-1)
 #define QOF_EVENT_ALL      (0xff)
+/** Every event, including application defined ones. */
+#define QOF_EVENT_ANY      (~0)
 
 /** \brief Handler invoked when an event is generated.
  *
@@ -93,6 +95,25 @@ typedef void (*QofEventHandler) (QofInstance *ent,  QofEventId event_type,
  */
 gint qof_event_register_handler (QofEventHandler handler, gpointer handler_data);
 
+/** \brief Register a handler for some events of some entities only.
+ *
+ * The handler is only invoked for entities of the given type whose
+ * event id shares a bit with event_mask, so handlers that ignore most
+ * events are not called for them at all.
+ *
+ * @param handler:   handler to register
+ * @param handler_data: data provided when handler is invoked
+ * @param type: the entity type to listen to, or NULL for all types
+ * @param event_mask: the events to listen to, e.g. QOF_EVENT_MODIFY |
+ * QOF_EVENT_DESTROY, or QOF_EVENT_ANY
+ *
+ * @return id identifying handler
+ */
+gint qof_event_register_handler_full (QofEventHandler handler,
+                                      gpointer handler_data,
+                                      QofIdTypeConst type,
+                                      QofEventId event_mask);
+
 /** \brief Unregister an event handler.
  *
  * @param handler_id: the id of the handler to unregister
@@ -134,5 +155,45 @@ void qof_event_suspend (void);
 /** Resume engine event generation. */
 void qof_event_resume (void);
 
+/** \brief Start collecting events instead of delivering them.
+ *
+ *   Between qof_event_begin_batch and the matching qof_event_end_batch,
+ *   events without event data, and events generated with
+ *   qof_event_gen_about, are queued and delivered when the outermost
+ *   batch ends, in the order they were first generated.  An event is
+ *   dropped when the latest one queued for the same entity and subject
+ *   is the same event with the same data, so a run of modifies becomes
+ *   one, but an add, a remove and an add again are all delivered.
+ *
+ *   Other events that carry event data are delivered at once, as the
+ *   data often lives on the caller's stack, and so is a
+ *   QOF_EVENT_DESTROY.  Everything queued before such an event is
+ *   delivered ahead of it, so handlers never see events out of order.
+ *   Queued events naming an instance that is disposed of before the
+ *   batch ends are dropped.  Events generated while events are
+ *   suspended are dropped as usual.
+ *
+ *   Batches nest; an equal number of calls to qof_event_end_batch
+ *   must be made.  Callers doing bulk changes, such as imports and
+ *   scrubs, open a batch around them.
+ */
+void qof_event_begin_batch (void);
+
+/** End a batch started by qof_event_begin_batch, delivering the
+ *  queued events if it was the outermost one. */
+void qof_event_end_batch (void);
+
+/** Generate an event whose event data is about another instance, the
+ *  subject, such as the split added to an account.  Outside a batch
+ *  this is qof_event_gen.  Within one the event is queued with the
+ *  event data, or with a copy of the data_size bytes at event_data if
+ *  data_size is not zero, so that data on the caller's stack can be
+ *  queued too.  Data that isn't copied must stay valid for as long
+ *  as the subject does.
+ */
+void qof_event_gen_about (QofInstance *entity, QofEventId event_type,
+                          QofInstance *subject, gpointer event_data,
+                          gsize data_size);
+
 #endif
 /** @} */
@@ -33,15 +33,47 @@
 static QofLogModule log_module = QOF_MOD_ENGINE;
 static gboolean qof_alt_dirty_mode = FALSE;
 
+/* The entities of a collection are kept in an open addressing table
+ * with linear probing.  Each slot holds a copy of the entity's GncGUID
+ * next to the entity pointer: GUIDs are random, so their first bytes
+ * are already a perfectly good hash, and a lookup only compares the
+ * 128-bit keys stored in the table, two words at a time, without
+ * touching the entities themselves.  Removed entities leave a
+ * tombstone behind so that removing the entity being visited by
+ * qof_collection_foreach doesn't move any of the others.  For the same
+ * reason the table is never grown under a running foreach: entities
+ * that don't fit are parked in a plain hash table until the outermost
+ * walk is over.
+ */
+typedef struct
+{
+    guint64       key[2];    /* copy of the entity's GncGUID */
+    QofInstance * ent;       /* NULL if the slot was never used */
+} QofCollectionSlot;
+
 struct QofCollection_s
 {
     QofIdType    e_type;
     gboolean     is_dirty;
 
-    GHashTable * hash_of_entities;
+    QofCollectionSlot * slots;
+    guint        size;       /* number of slots: 0 or a power of two */
+    guint        count;      /* number of entities */
+    guint        used;       /* entities plus tombstones */
+    guint        iterating;  /* nesting depth of qof_collection_foreach */
+    GHashTable * pending;    /* inserted while iterating, table full */
+
     gpointer     data;       /* place where object class can hang arbitrary data */
 };
 
+static gchar slot_deleted_marker;
+#define SLOT_DELETED ((QofInstance *) &slot_deleted_marker)
+#define SLOT_LIVE(slot) ((slot)->ent && (slot)->ent != SLOT_DELETED)
+
+/* The table is grown once it is three quarters full. */
+#define SLOTS_FOR(n) ((n) + (n) / 3 + 1)
+#define MIN_SLOTS 8
+
 /* =============================================================== */
 
 gboolean
@@ -58,13 +90,191 @@ qof_set_alt_dirty_mode (gboolean enabled)
 
 /* =============================================================== */
 
+static inline void
+guid_to_key (const GncGUID *guid, guint64 key[2])
+{
+    memcpy (key, guid->data, sizeof (guint64) * 2);
+}
+
+static inline guint
+key_hash (const guint64 key[2])
+{
+    return (guint) (key[0] ^ (key[0] >> 32));
+}
+
+static QofCollectionSlot *
+collection_find_slot (const QofCollection *col, const guint64 key[2])
+{
+    guint mask, i;
+
+    if (!col->size) return NULL;
+    mask = col->size - 1;
+
+    /* There is always at least one never used slot to stop at */
+    for (i = key_hash (key) & mask; col->slots[i].ent; i = (i + 1) & mask)
+    {
+        QofCollectionSlot *slot = &col->slots[i];
+        if (slot->key[0] == key[0] && slot->key[1] == key[1] &&
+                slot->ent != SLOT_DELETED)
+            return slot;
+    }
+    return NULL;
+}
+
+/* Rehash the entities into a table big enough for n of them,
+ * dropping any tombstones on the way. */
+static void
+collection_resize (QofCollection *col, guint n)
+{
+    QofCollectionSlot *old_slots = col->slots;
+    guint old_size = col->size, size = MIN_SLOTS, i;
+
+    while (size < SLOTS_FOR (n))
+        size <<= 1;
+
+    col->slots = g_new0 (QofCollectionSlot, size);
+    col->size = size;
+    col->used = col->count;
+
+    for (i = 0; i < old_size; i++)
+    {
+        QofCollectionSlot *slot = &old_slots[i];
+        guint j;
+
+        if (!SLOT_LIVE (slot)) continue;
+        for (j = key_hash (slot->key) & (size - 1); col->slots[j].ent;
+                j = (j + 1) & (size - 1))
+            ;
+        col->slots[j] = *slot;
+    }
+    g_free (old_slots);
+}
+
+/* Give the memory back once a collection has been emptied, as
+ * happens to all of them when a book is closed. */
+static void
+collection_release_if_empty (QofCollection *col)
+{
+    if (col->count || col->iterating || col->pending) return;
+    g_free (col->slots);
+    col->slots = NULL;
+    col->size = 0;
+    col->used = 0;
+}
+
+/* Store ent under guid, replacing any entity already stored there. */
+static void
+collection_insert (QofCollection *col, const GncGUID *guid, QofInstance *ent)
+{
+    QofCollectionSlot *slot;
+    guint64 key[2];
+    guint mask, i;
+
+    guid_to_key (guid, key);
+    slot = collection_find_slot (col, key);
+    if (slot)
+    {
+        slot->ent = ent;
+        return;
+    }
+
+    if (col->size < SLOTS_FOR (col->used + 1))
+    {
+        /* Resizing would move the entities under a running foreach,
+         * so wait until it is done, see collection_merge_pending. */
+        if (col->iterating)
+        {
+            if (!col->pending)
+                col->pending = g_hash_table_new (guid_hash_to_guint,
+                                                 guid_g_hash_table_equal);
+            if (!g_hash_table_lookup (col->pending, guid))
+                col->count++;
+            g_hash_table_replace (col->pending, (gpointer) guid, ent);
+            return;
+        }
+        collection_resize (col, col->count + 1);
+    }
+
+    mask = col->size - 1;
+    for (i = key_hash (key) & mask; SLOT_LIVE (&col->slots[i]); i = (i + 1) & mask)
+        ;
+    slot = &col->slots[i];
+    if (!slot->ent)
+        col->used++;
+    slot->key[0] = key[0];
+    slot->key[1] = key[1];
+    slot->ent = ent;
+    col->count++;
+}
+
+static void
+collection_remove (QofCollection *col, const GncGUID *guid)
+{
+    QofCollectionSlot *slot;
+    guint64 key[2];
+    guint mask, i;
+
+    if (col->pending && g_hash_table_remove (col->pending, guid))
+    {
+        col->count--;
+        return;
+    }
+
+    guid_to_key (guid, key);
+    slot = collection_find_slot (col, key);
+    if (!slot) return;
+
+    slot->ent = SLOT_DELETED;
+    col->count--;
+
+    /* A tombstone followed by a never used slot ends every probe
+     * sequence running through it, so it and any tombstones right
+     * before it can be freed.  No entity moves, so this is safe even
+     * in the middle of qof_collection_foreach. */
+    mask = col->size - 1;
+    i = slot - col->slots;
+    if (!col->slots[(i + 1) & mask].ent)
+    {
+        while (col->slots[i].ent == SLOT_DELETED)
+        {
+            col->slots[i].ent = NULL;
+            col->used--;
+            i = (i - 1) & mask;
+        }
+    }
+    collection_release_if_empty (col);
+}
+
+/* Move the entities parked by collection_insert during a foreach
+ * into the table, growing it once for all of them. */
+static void
+collection_merge_pending (QofCollection *col)
+{
+    GHashTable *pending = col->pending;
+    GHashTableIter iter;
+    gpointer guid, ent;
+
+    if (!pending || col->iterating) return;
+    col->pending = NULL;
+    col->count -= g_hash_table_size (pending);
+    if (col->size < SLOTS_FOR (col->used + g_hash_table_size (pending)))
+        collection_resize (col, col->count + g_hash_table_size (pending));
+
+    g_hash_table_iter_init (&iter, pending);
+    while (g_hash_table_iter_next (&iter, &guid, &ent))
+        collection_insert (col, guid, ent);
+    g_hash_table_destroy (pending);
+}
+
 QofCollection *
 qof_collection_new (QofIdType type)
 {
     QofCollection *col;
     col = g_new0(QofCollection, 1);
     col->e_type = CACHE_INSERT (type);
-    col->hash_of_entities = guid_hash_table_new();
+    /* The table is only allocated when the first entity arrives, most
+     * books leave most of their collections empty. */
+    col->slots = NULL;
     col->data = NULL;
     return col;
 }
@@ -73,13 +283,26 @@ void
 qof_collection_destroy (QofCollection *col)
 {
     CACHE_REMOVE (col->e_type);
-    g_hash_table_destroy(col->hash_of_entities);
+    if (col->pending)
+        g_hash_table_destroy (col->pending);
+    g_free (col->slots);
     col->e_type = NULL;
-    col->hash_of_entities = NULL;
+    col->slots = NULL;
     col->data = NULL;   /** XXX there should be a destroy notifier for this */
     g_free (col);
 }
 
+void
+qof_collection_reserve (QofCollection *col, guint n)
+{
+    g_return_if_fail (col);
+
+    /* Growing would reorder the slots under a running iteration */
+    if (col->iterating) return;
+    if (col->size >= SLOTS_FOR (n)) return;
+    collection_resize (col, n);
+}
+
 /* =============================================================== */
 /* getters */
 
@@ -101,7 +324,7 @@ qof_collection_remove_entity (QofInstance *ent)
     col = qof_instance_get_collection(ent);
     if (!col) return;
     guid = qof_instance_get_guid(ent);
-    g_hash_table_remove (col->hash_of_entities, guid);
+    collection_remove (col, guid);
     if (!qof_alt_dirty_mode)
         qof_collection_mark_dirty(col);
     qof_instance_set_collection(ent, NULL);
@@ -117,7 +340,7 @@ qof_collection_insert_entity (QofCollection *col, QofInstance *ent)
     if (guid_equal(guid, guid_null())) return;
     g_return_if_fail (col->e_type == ent->e_type);
     qof_collection_remove_entity (ent);
-    g_hash_table_insert (col->hash_of_entities, (gpointer)guid, ent);
+    collection_insert (col, guid, ent);
     if (!qof_alt_dirty_mode)
         qof_collection_mark_dirty(col);
     qof_instance_set_collection(ent, col);
@@ -145,7 +368,7 @@ qof_collection_add_entity (QofCollection *coll, QofInstance *ent)
     {
         return FALSE;
     }
-    g_hash_table_insert (coll->hash_of_entities, (gpointer)guid, ent);
+    collection_insert (coll, guid, ent);
     if (!qof_alt_dirty_mode)
         qof_collection_mark_dirty(coll);
     return TRUE;
@@ -231,11 +454,15 @@ qof_collection_compare (QofCollection *target, QofCollection *merge)
 QofInstance *
 qof_collection_lookup_entity (const QofCollection *col, const GncGUID * guid)
 {
-    QofInstance *ent;
+    QofCollectionSlot *slot;
+    guint64 key[2];
+
     g_return_val_if_fail (col, NULL);
     if (guid == NULL) return NULL;
-    ent = g_hash_table_lookup (col->hash_of_entities, guid);
-    return ent;
+    guid_to_key (guid, key);
+    slot = collection_find_slot (col, key);
+    if (slot) return slot->ent;
+    return col->pending ? g_hash_table_lookup (col->pending, guid) : NULL;
 }
 
 QofCollection *
@@ -260,10 +487,7 @@ qof_collection_from_glist (QofIdType type, const GList *glist)
 guint
 qof_collection_count (const QofCollection *col)
 {
-    guint c;
-
-    c = g_hash_table_size(col->hash_of_entities);
-    return c;
+    return col->count;
 }
 
 /* =============================================================== */
@@ -319,33 +543,30 @@ qof_collection_set_data (QofCollection *col, gpointer user_data)
 
 /* =============================================================== */
 
-struct _iterate
-{
-    QofInstanceForeachCB      fcn;
-    gpointer                data;
-};
-
-static void foreach_cb (gpointer key, gpointer item, gpointer arg)
-{
-    struct _iterate *iter = arg;
-    QofInstance *ent = item;
-
-    iter->fcn (ent, iter->data);
-}
-
 void
 qof_collection_foreach (const QofCollection *col, QofInstanceForeachCB cb_func,
                         gpointer user_data)
 {
-    struct _iterate iter;
+    QofCollection *coll = (QofCollection *) col;
+    guint i;
 
     g_return_if_fail (col);
     g_return_if_fail (cb_func);
 
-    iter.fcn = cb_func;
-    iter.data = user_data;
-
-    g_hash_table_foreach (col->hash_of_entities, foreach_cb, &iter);
+    /* The callback may destroy the entity it is given (book_end does),
+     * which only leaves a tombstone.  Entities it adds either land in
+     * a free slot, which may or may not be visited, or wait in
+     * coll->pending and are not visited at all. */
+    coll->iterating++;
+    for (i = 0; i < coll->size; i++)
+    {
+        QofCollectionSlot *slot = &coll->slots[i];
+        if (SLOT_LIVE (slot))
+            cb_func (slot->ent, user_data);
+    }
+    coll->iterating--;
+    collection_merge_pending (coll);
+    collection_release_if_empty (coll);
 }
 
 /* =============================================================== */
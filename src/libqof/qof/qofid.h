@@ -167,6 +167,12 @@ QofCollection * qof_collection_new (QofIdType type);
 /** return the number of entities in the collection. */
 guint qof_collection_count (const QofCollection *col);
 
+/** Make room for n entities in the collection, so that loading a
+ *  book whose size is known up front doesn't rehash it over and
+ *  over again.  This is only a hint; it never shrinks the
+ *  collection. */
+void qof_collection_reserve (QofCollection *col, guint n);
+
 /** destroy the collection */
 void qof_collection_destroy (QofCollection *col);
 
@@ -180,7 +186,10 @@ QofInstance * qof_collection_lookup_entity (const QofCollection *, const GncGUID
 /** Callback type for qof_collection_foreach */
 typedef void (*QofInstanceForeachCB) (QofInstance *, gpointer user_data);
 
-/** Call the callback for each entity in the collection. */
+/** Call the callback for each entity in the collection, in no
+ *  particular order.  The callback may remove or destroy the entity
+ *  it is called for.  It may also add entities to the collection,
+ *  but those are not guaranteed to be visited. */
 void qof_collection_foreach (const QofCollection *, QofInstanceForeachCB,
                              gpointer user_data);
 
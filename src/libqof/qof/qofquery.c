@@ -868,6 +868,86 @@ qof_query_last_run (QofQuery *query)
     return query->results;
 }
 
+gboolean
+qof_query_update_results (QofQuery *q, GHashTable *stale,
+                          GList *changed, GList **matches)
+{
+    GHashTable *dropped;
+    GList *found = NULL;
+    GList *node, *next, *result, *last;
+
+    if (matches)
+        *matches = NULL;
+    g_return_val_if_fail (q, FALSE);
+
+    /* The cached results only say something about the query as it
+     * was when it last ran, and a cropped list can't be patched. */
+    if (q->changed || q->max_results > -1)
+        return FALSE;
+
+    ENTER (" q=%p", q);
+
+    dropped = g_hash_table_new (g_direct_hash, g_direct_equal);
+    for (node = changed; node; node = node->next)
+    {
+        g_hash_table_insert (dropped, node->data, node->data);
+        if (check_object (q, node->data))
+            found = g_list_prepend (found, node->data);
+    }
+
+    for (node = q->results; node; node = next)
+    {
+        next = node->next;
+        if (g_hash_table_lookup (dropped, node->data) ||
+                (stale && g_hash_table_lookup_extended (stale, node->data,
+                        NULL, NULL)))
+            q->results = g_list_delete_link (q->results, node);
+    }
+    g_hash_table_destroy (dropped);
+
+    found = g_list_reverse (found);
+    if (q->primary_sort.comp_fcn || q->primary_sort.obj_cmp ||
+            (q->primary_sort.use_default && q->defaultSort))
+    {
+        found = g_list_sort_with_data (found, sort_func, q);
+
+        /* Both lists are sorted, so one pass merges them. */
+        result = q->results;
+        last = NULL;
+        for (node = found; node; node = node->next)
+        {
+            while (result && sort_func (result->data, node->data, q) <= 0)
+            {
+                last = result;
+                result = result->next;
+            }
+
+            if (result)
+                q->results = g_list_insert_before (q->results, result,
+                                                   node->data);
+            else if (last)
+            {
+                last = g_list_append (last, node->data);
+                last = last->next;
+            }
+            else
+                q->results = last = g_list_append (NULL, node->data);
+        }
+    }
+    else
+        q->results = g_list_concat (q->results, g_list_copy (found));
+
+    PINFO ("merged %d changed objects", g_list_length (found));
+
+    if (matches)
+        *matches = found;
+    else
+        g_list_free (found);
+
+    LEAVE (" q=%p", q);
+    return TRUE;
+}
+
 void qof_query_clear (QofQuery *query)
 {
     QofQuery *q2 = qof_query_create ();
@@ -232,6 +232,24 @@ GList * qof_query_last_run (QofQuery *query);
 GList * qof_query_run_subquery (QofQuery *subquery,
                                 const QofQuery* primary_query);
 
+/** Bring the results of the last run of the query up to date after a
+ *  few objects have changed, without searching the books again.
+ *
+ *  The objects in @a stale (a set made with g_direct_hash()) and in
+ *  @a changed are dropped from the results.  Stale objects are only
+ *  compared, so they may already have been freed.  Each object in
+ *  @a changed is then checked against the query terms and, if it
+ *  matches, merged back into the results in sort order.  If @a matches
+ *  is not NULL it is set to a list of those objects, which the caller
+ *  must free with g_list_free().
+ *
+ *  Returns FALSE, leaving the results alone, if the query has to be
+ *  run again in full: because it was changed since it was last run,
+ *  or because it limits the number of results.
+ */
+gboolean qof_query_update_results (QofQuery *query, GHashTable *stale,
+                                   GList *changed, GList **matches);
+
 /** Remove all query terms from query.  query matches nothing
  *  after qof_query_clear().
  */
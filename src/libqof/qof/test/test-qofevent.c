@@ -0,0 +1,260 @@
+/********************************************************************
+ * test_qofevent.c: GLib g_test test suite for qofevent.            *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+\********************************************************************/
+#include "config.h"
+#include <glib.h>
+#include "qof.h"
+
+static const gchar *suitename = "/qof/qofevent";
+void test_suite_qofevent ( void );
+
+#define TEST_TYPE_A "TestTypeA"
+#define TEST_TYPE_B "TestTypeB"
+
+typedef struct
+{
+    QofInstance *a;
+    QofInstance *b;
+    gint handler_id;
+    guint n_events;
+    QofInstance *last_entity;
+    QofEventId last_event;
+    QofEventId events[8];       /* the first events delivered */
+    gpointer data[8];
+    gint removed_value;         /* data of the last QOF_EVENT_REMOVE */
+} Fixture;
+
+static void
+record_event( QofInstance *ent, QofEventId event_type,
+              gpointer handler_data, gpointer event_data )
+{
+    Fixture *fixture = handler_data;
+
+    if (fixture->n_events < G_N_ELEMENTS(fixture->events))
+    {
+        fixture->events[fixture->n_events] = event_type;
+        fixture->data[fixture->n_events] = event_data;
+    }
+    if (event_type == QOF_EVENT_REMOVE && event_data)
+        fixture->removed_value = *(gint *)event_data;
+    fixture->n_events++;
+    fixture->last_entity = ent;
+    fixture->last_event = event_type;
+}
+
+static void
+setup( Fixture *fixture, gconstpointer pData )
+{
+    fixture->a = g_object_new(QOF_TYPE_INSTANCE, NULL);
+    fixture->a->e_type = TEST_TYPE_A;
+    fixture->b = g_object_new(QOF_TYPE_INSTANCE, NULL);
+    fixture->b->e_type = TEST_TYPE_B;
+    fixture->handler_id = 0;
+    fixture->n_events = 0;
+    fixture->last_entity = NULL;
+    fixture->last_event = QOF_EVENT_NONE;
+    fixture->removed_value = 0;
+}
+
+static void
+teardown( Fixture *fixture, gconstpointer pData )
+{
+    if (fixture->handler_id)
+        qof_event_unregister_handler( fixture->handler_id );
+    g_object_unref( fixture->a );
+    g_object_unref( fixture->b );
+}
+
+static void
+test_typed_handler( Fixture *fixture, gconstpointer pData )
+{
+    fixture->handler_id =
+        qof_event_register_handler_full( record_event, fixture, TEST_TYPE_A,
+                                         QOF_EVENT_MODIFY | QOF_EVENT_DESTROY );
+
+    qof_event_gen( fixture->b, QOF_EVENT_MODIFY, NULL );
+    g_assert_cmpuint( fixture->n_events, ==, 0 );
+    qof_event_gen( fixture->a, QOF_EVENT_CREATE, NULL );
+    g_assert_cmpuint( fixture->n_events, ==, 0 );
+    qof_event_gen( fixture->a, QOF_EVENT_MODIFY, NULL );
+    g_assert_cmpuint( fixture->n_events, ==, 1 );
+    g_assert( fixture->last_entity == fixture->a );
+    g_assert_cmpint( fixture->last_event, ==, QOF_EVENT_MODIFY );
+}
+
+static void
+test_batch_coalesces( Fixture *fixture, gconstpointer pData )
+{
+    fixture->handler_id = qof_event_register_handler( record_event, fixture );
+
+    qof_event_begin_batch();
+    qof_event_gen( fixture->a, QOF_EVENT_MODIFY, NULL );
+    qof_event_begin_batch();
+    qof_event_gen( fixture->a, QOF_EVENT_MODIFY, NULL );
+    qof_event_gen( fixture->b, QOF_EVENT_MODIFY, NULL );
+    qof_event_end_batch();
+    qof_event_gen( fixture->a, QOF_EVENT_MODIFY, NULL );
+    g_assert_cmpuint( fixture->n_events, ==, 0 );
+
+    qof_event_end_batch();
+    g_assert_cmpuint( fixture->n_events, ==, 2 );
+    g_assert( fixture->last_entity == fixture->b );
+    g_assert_cmpint( fixture->last_event, ==, QOF_EVENT_MODIFY );
+}
+
+static void
+test_batch_order( Fixture *fixture, gconstpointer pData )
+{
+    gint data = 0;
+
+    fixture->handler_id = qof_event_register_handler( record_event, fixture );
+
+    qof_event_begin_batch();
+    qof_event_gen( fixture->a, QOF_EVENT_ADD, NULL );
+    g_assert_cmpuint( fixture->n_events, ==, 0 );
+
+    /* Events carrying data are not held back, and what was queued
+     * before them goes out first */
+    qof_event_gen( fixture->a, QOF_EVENT_REMOVE, &data );
+    g_assert_cmpuint( fixture->n_events, ==, 2 );
+    g_assert( fixture->last_entity == fixture->a );
+    g_assert_cmpint( fixture->last_event, ==, QOF_EVENT_REMOVE );
+
+    qof_event_gen( fixture->b, QOF_EVENT_MODIFY, NULL );
+    g_assert_cmpuint( fixture->n_events, ==, 2 );
+    qof_event_end_batch();
+    g_assert_cmpuint( fixture->n_events, ==, 3 );
+    g_assert( fixture->last_entity == fixture->b );
+}
+
+static void
+test_batch_destroy( Fixture *fixture, gconstpointer pData )
+{
+    QofInstance *c;
+
+    fixture->handler_id = qof_event_register_handler( record_event, fixture );
+
+    qof_event_begin_batch();
+    qof_event_gen( fixture->a, QOF_EVENT_MODIFY, NULL );
+    qof_event_gen( fixture->b, QOF_EVENT_MODIFY, NULL );
+    qof_event_gen( fixture->a, QOF_EVENT_DESTROY, NULL );
+    g_assert_cmpuint( fixture->n_events, ==, 3 );
+    g_assert( fixture->last_entity == fixture->a );
+    g_assert_cmpint( fixture->last_event, ==, QOF_EVENT_DESTROY );
+
+    /* Freeing an entity drops its queued events as well */
+    c = g_object_new(QOF_TYPE_INSTANCE, NULL);
+    c->e_type = TEST_TYPE_A;
+    qof_event_gen( c, QOF_EVENT_MODIFY, NULL );
+    g_object_unref( c );
+
+    qof_event_gen( fixture->b, QOF_EVENT_MODIFY, NULL );
+    qof_event_end_batch();
+    g_assert_cmpuint( fixture->n_events, ==, 4 );
+    g_assert( fixture->last_entity == fixture->b );
+}
+
+static void
+test_batch_first_occurrence( Fixture *fixture, gconstpointer pData )
+{
+    fixture->handler_id = qof_event_register_handler( record_event, fixture );
+
+    /* A later repeat goes out with the first occurrence, but events of
+     * different entities are not regrouped */
+    qof_event_begin_batch();
+    qof_event_gen( fixture->a, QOF_EVENT_ADD, NULL );
+    qof_event_gen( fixture->b, QOF_EVENT_MODIFY, NULL );
+    qof_event_gen( fixture->a, QOF_EVENT_MODIFY, NULL );
+    qof_event_gen( fixture->b, QOF_EVENT_MODIFY, NULL );
+    qof_event_end_batch();
+    g_assert_cmpuint( fixture->n_events, ==, 3 );
+    g_assert_cmpint( fixture->events[0], ==, QOF_EVENT_ADD );
+    g_assert_cmpint( fixture->events[1], ==, QOF_EVENT_MODIFY );
+    g_assert( fixture->last_entity == fixture->a );
+    g_assert_cmpint( fixture->last_event, ==, QOF_EVENT_MODIFY );
+}
+
+static void
+test_batch_subject( Fixture *fixture, gconstpointer pData )
+{
+    QofInstance *c, *d;
+    gint idx = 7;
+
+    c = g_object_new(QOF_TYPE_INSTANCE, NULL);
+    c->e_type = TEST_TYPE_B;
+    d = g_object_new(QOF_TYPE_INSTANCE, NULL);
+    d->e_type = TEST_TYPE_B;
+    fixture->handler_id = qof_event_register_handler( record_event, fixture );
+
+    qof_event_begin_batch();
+    qof_event_gen_about( fixture->a, QOF_EVENT_ADD, c, c, 0 );
+    qof_event_gen( fixture->a, QOF_EVENT_MODIFY, NULL );
+    qof_event_gen_about( fixture->a, QOF_EVENT_REMOVE, c, &idx, sizeof(idx) );
+    qof_event_gen( fixture->a, QOF_EVENT_MODIFY, NULL );
+    qof_event_gen_about( fixture->a, QOF_EVENT_ADD, c, c, 0 );
+    qof_event_gen_about( fixture->a, QOF_EVENT_ADD, c, c, 0 );
+    qof_event_gen_about( fixture->a, QOF_EVENT_ADD, d, d, 0 );
+    qof_event_gen( fixture->b, QOF_EVENT_MODIFY, NULL );
+    g_assert_cmpuint( fixture->n_events, ==, 0 );
+
+    /* The data was copied when queued */
+    idx = 9;
+    /* Events about an instance that goes away are dropped */
+    g_object_unref( d );
+
+    qof_event_end_batch();
+    g_assert_cmpuint( fixture->n_events, ==, 5 );
+    g_assert_cmpint( fixture->events[0], ==, QOF_EVENT_ADD );
+    g_assert( fixture->data[0] == c );
+    g_assert_cmpint( fixture->events[1], ==, QOF_EVENT_MODIFY );
+    g_assert_cmpint( fixture->events[2], ==, QOF_EVENT_REMOVE );
+    g_assert_cmpint( fixture->removed_value, ==, 7 );
+    g_assert_cmpint( fixture->events[3], ==, QOF_EVENT_ADD );
+    g_assert( fixture->data[3] == c );
+    g_assert_cmpint( fixture->events[4], ==, QOF_EVENT_MODIFY );
+    g_assert( fixture->last_entity == fixture->b );
+
+    g_object_unref( c );
+}
+
+void
+test_suite_qofevent ( void )
+{
+    gchar *path;
+
+    path = g_strdup_printf( "%s/typed handler", suitename );
+    g_test_add( path, Fixture, NULL, setup, test_typed_handler, teardown );
+    g_free( path );
+    path = g_strdup_printf( "%s/batch coalesces", suitename );
+    g_test_add( path, Fixture, NULL, setup, test_batch_coalesces, teardown );
+    g_free( path );
+    path = g_strdup_printf( "%s/batch order", suitename );
+    g_test_add( path, Fixture, NULL, setup, test_batch_order, teardown );
+    g_free( path );
+    path = g_strdup_printf( "%s/batch destroy", suitename );
+    g_test_add( path, Fixture, NULL, setup, test_batch_destroy, teardown );
+    g_free( path );
+    path = g_strdup_printf( "%s/batch first occurrence", suitename );
+    g_test_add( path, Fixture, NULL, setup, test_batch_first_occurrence, teardown );
+    g_free( path );
+    path = g_strdup_printf( "%s/batch subject", suitename );
+    g_test_add( path, Fixture, NULL, setup, test_batch_subject, teardown );
+    g_free( path );
+}
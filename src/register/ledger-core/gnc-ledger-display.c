@@ -66,6 +66,11 @@ struct gnc_ledger_display
     gpointer user_data;
 
     gint component_id;
+
+    /* The splits of the transactions in the register when it was last
+     * loaded, by transaction GncGUID. NULL if the register may not
+     * match the query results. */
+    GHashTable *trans_splits;
 };
 
 
@@ -542,6 +547,123 @@ gnc_ledger_display_set_watches (GNCLedgerDisplay *ld, GList *splits)
     }
 }
 
+static void
+gnc_ledger_display_index_trans (GNCLedgerDisplay *ld, Transaction *trans)
+{
+    const GncGUID *guid = xaccTransGetGUID (trans);
+
+    if (g_hash_table_lookup (ld->trans_splits, guid))
+        return;
+
+    g_hash_table_insert (ld->trans_splits, guid_copy (guid),
+                         g_list_copy (xaccTransGetSplitList (trans)));
+}
+
+/* Remember the transactions of the splits just loaded into the
+ * register, or forget them if the register was not loaded. */
+static void
+gnc_ledger_display_index_splits (GNCLedgerDisplay *ld, GList *splits,
+                                 gboolean loaded)
+{
+    GList *node;
+
+    if (ld->trans_splits)
+    {
+        g_hash_table_destroy (ld->trans_splits);
+        ld->trans_splits = NULL;
+    }
+
+    if (!loaded)
+        return;
+
+    ld->trans_splits = g_hash_table_new_full (guid_hash_to_guint,
+                       guid_g_hash_table_equal,
+                       (GDestroyNotify) guid_free,
+                       (GDestroyNotify) g_list_free);
+
+    for (node = splits; node; node = node->next)
+        gnc_ledger_display_index_trans (ld, xaccSplitGetParent (node->data));
+}
+
+/* Update the query results and the register for the transactions in
+ * changes only. Returns FALSE if the query must be run again. */
+static gboolean
+gnc_ledger_display_refresh_changes (GNCLedgerDisplay *ld, GHashTable *changes)
+{
+    QofBook *book = gnc_get_current_book ();
+    Account *leader;
+    GHashTableIter iter;
+    GHashTable *stale;
+    GList *changed = NULL;
+    GList *matches;
+    GList *splits;
+    GList *node;
+    gpointer key;
+    gboolean ok;
+
+    if (!ld->trans_splits || !gnc_split_register_full_refresh_ok (ld->reg))
+        return FALSE;
+
+    ENTER("ld=%p, changes=%p", ld, changes);
+
+    /* The splits the transactions had when they were loaded may be
+     * gone by now, so they are dropped by address. */
+    stale = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+    g_hash_table_iter_init (&iter, changes);
+    while (g_hash_table_iter_next (&iter, &key, NULL))
+    {
+        Transaction *trans;
+
+        for (node = g_hash_table_lookup (ld->trans_splits, key); node;
+                node = node->next)
+            g_hash_table_insert (stale, node->data, node->data);
+        g_hash_table_remove (ld->trans_splits, key);
+
+        trans = xaccTransLookup (key, book);
+        if (!trans)
+            continue;
+
+        for (node = xaccTransGetSplitList (trans); node; node = node->next)
+            changed = g_list_prepend (changed, node->data);
+    }
+
+    ok = qof_query_update_results (ld->query, stale, changed, &matches);
+
+    g_hash_table_destroy (stale);
+    g_list_free (changed);
+
+    if (!ok)
+    {
+        LEAVE("query must be run again");
+        return FALSE;
+    }
+
+    for (node = matches; node; node = node->next)
+    {
+        Transaction *trans = xaccSplitGetParent (node->data);
+
+        gnc_ledger_display_index_trans (ld, trans);
+        gnc_gui_component_watch_entity (ld->component_id,
+                                        xaccTransGetGUID (trans),
+                                        QOF_EVENT_MODIFY);
+    }
+    g_list_free (matches);
+
+    splits = qof_query_last_run (ld->query);
+    leader = gnc_ledger_display_leader (ld);
+
+    ld->loading = TRUE;
+
+    if (!gnc_split_register_load_changes (ld->reg, splits, changes, leader))
+        gnc_split_register_load (ld->reg, splits, leader);
+
+    ld->loading = FALSE;
+
+    LEAVE(" ");
+    return TRUE;
+}
+
 static void
 refresh_handler (GHashTable *changes, gpointer user_data)
 {
@@ -582,6 +704,15 @@ refresh_handler (GHashTable *changes, gpointer user_data)
         }
     }
 
+    /* Only look at the transactions that changed, if that can be
+     * done. Otherwise run the query again.
+     */
+    if (changes && gnc_ledger_display_refresh_changes (ld, changes))
+    {
+        LEAVE("refreshed changes");
+        return;
+    }
+
     /* Its not clear if we should re-run the query, or if we should
      * just use qof_query_last_run().  Its possible that the dates
      * changed, requiring a full new query.  Similar considerations
@@ -614,6 +745,9 @@ close_handler (gpointer user_data)
     qof_query_destroy (ld->query);
     ld->query = NULL;
 
+    if (ld->trans_splits)
+        g_hash_table_destroy (ld->trans_splits);
+
     g_free (ld);
 }
 
@@ -772,6 +906,7 @@ gnc_ledger_display_internal (Account *lead_account, Query *q,
     ld->destroy = NULL;
     ld->get_parent = NULL;
     ld->user_data = NULL;
+    ld->trans_splits = NULL;
 
     limit = gnc_gconf_get_float(GCONF_GENERAL_REGISTER, "max_transactions", NULL);
 
@@ -836,7 +971,10 @@ gnc_ledger_display_refresh_internal (GNCLedgerDisplay *ld, GList *splits)
         return;
 
     if (!gnc_split_register_full_refresh_ok (ld->reg))
+    {
+        gnc_ledger_display_index_splits (ld, NULL, FALSE);
         return;
+    }
 
     ld->loading = TRUE;
 
@@ -844,6 +982,8 @@ gnc_ledger_display_refresh_internal (GNCLedgerDisplay *ld, GList *splits)
                              gnc_ledger_display_leader (ld));
 
     ld->loading = FALSE;
+
+    gnc_ledger_display_index_splits (ld, splits, TRUE);
 }
 
 void
@@ -210,8 +210,7 @@ _find_split_with_parent_txn(gconstpointer a, gconstpointer b)
     return xaccSplitGetParent(split) == txn ? 0 : 1;
 }
 
-static void add_quickfill_completions(TableLayout *layout, Transaction *trans,
-                                      gboolean has_last_num)
+static void add_quickfill_completions(TableLayout *layout, Transaction *trans)
 {
     Split *s;
     int i = 0;
@@ -224,11 +223,6 @@ static void add_quickfill_completions(TableLayout *layout, Transaction *trans,
         (QuickFillCell *) gnc_table_layout_get_cell(layout, NOTES_CELL),
         xaccTransGetNotes(trans));
 
-    if (!has_last_num)
-        gnc_num_cell_set_last_num(
-            (NumCell *) gnc_table_layout_get_cell(layout, NUM_CELL),
-            xaccTransGetNum(trans));
-
     while ((s = xaccTransGetSplit(trans, i)) != NULL)
     {
         gnc_quickfill_cell_add_completion(
@@ -238,58 +232,62 @@ static void add_quickfill_completions(TableLayout *layout, Transaction *trans,
     }
 }
 
-void
-gnc_split_register_load (SplitRegister *reg, GList * slist,
-                         Account *default_account)
+/* Number of queued transactions added to the quickfill cells each time
+ * the main loop is idle. */
+#define QUICKFILL_IDLE_CHUNK 250
+
+/* Add the next chunk of queued transactions to the quickfill cells.
+ * They are added in the order they were loaded, so the completions end
+ * up the same as if they had all been added during the load.
+ * Transactions deleted in the meantime are skipped. */
+static gboolean
+gnc_split_register_quickfill_idle (gpointer data)
 {
-    SRInfo *info;
-    Transaction *pending_trans;
-    CursorBuffer *cursor_buffer;
-    GHashTable *trans_table = NULL;
-    CellBlock *cursor_header;
-    CellBlock *lead_cursor;
-    CellBlock *split_cursor;
-    Transaction *blank_trans;
-    Transaction *find_trans;
-    Transaction *trans;
-    CursorClass find_class;
-    Split *find_trans_split;
-    Split *blank_split;
-    Split *find_split;
-    Split *split;
-    Table *table;
-    GList *node;
+    SplitRegister *reg = data;
+    SRInfo *info = gnc_split_register_get_info (reg);
+    QofBook *book = gnc_get_current_book ();
+    guint end;
 
-    gboolean start_primary_color = TRUE;
-    gboolean found_pending = FALSE;
-    gboolean found_divider = FALSE;
-    gboolean has_last_num = FALSE;
-    gboolean multi_line;
-    gboolean dynamic;
-    gboolean we_own_slist = FALSE;
+    end = MIN (info->quickfill_next + QUICKFILL_IDLE_CHUNK,
+               info->quickfill_guids->len);
 
-    VirtualCellLocation vcell_loc;
-    VirtualLocation save_loc;
+    for (; info->quickfill_next < end; info->quickfill_next++)
+    {
+        Transaction *trans;
 
-    int new_trans_split_row = -1;
-    int new_trans_row = -1;
-    int new_split_row = -1;
-    time_t present;
+        trans = xaccTransLookup (&g_array_index (info->quickfill_guids, GncGUID,
+                                 info->quickfill_next), book);
+        if (trans)
+            add_quickfill_completions (reg->table->layout, trans);
+    }
 
-    g_return_if_fail(reg);
-    table = reg->table;
-    g_return_if_fail(table);
-    info = gnc_split_register_get_info (reg);
-    g_return_if_fail(info);
+    if (info->quickfill_next < info->quickfill_guids->len)
+        return TRUE;
 
-    ENTER("reg=%p, slist=%p, default_account=%p", reg, slist, default_account);
+    DEBUG("added %u transactions to the quickfill cells",
+          info->quickfill_guids->len);
+
+    g_array_free (info->quickfill_guids, TRUE);
+    info->quickfill_guids = NULL;
+    info->quickfill_next = 0;
+    info->quickfill_source_id = 0;
+
+    return FALSE;
+}
+
+/* Look up the blank split of the register, making a new one in a new
+ * transaction if there is none. */
+static Split *
+gnc_split_register_ensure_blank_split (SplitRegister *reg,
+                                       Account *default_account,
+                                       Transaction *pending_trans)
+{
+    SRInfo *info = gnc_split_register_get_info (reg);
+    Split *blank_split;
 
     blank_split = xaccSplitLookup (&info->blank_split_guid,
                                    gnc_get_current_book ());
 
-    pending_trans = xaccTransLookup (&info->pending_trans_guid,
-                                     gnc_get_current_book ());
-
     /* make sure we have a blank split */
     if (blank_split == NULL)
     {
@@ -366,6 +364,144 @@ gnc_split_register_load (SplitRegister *reg, GList * slist,
         gnc_resume_gui_refresh ();
     }
 
+    return blank_split;
+}
+
+/* Put the cursor back where it belongs after (re)loading the rows of
+ * the register, and bring the hints and the GUI up to date.  The
+ * cursor buffer, if any, is destroyed. */
+static void
+gnc_split_register_load_finish (SplitRegister *reg, VirtualLocation save_loc,
+                                CursorBuffer *cursor_buffer, Split *find_split,
+                                int new_split_row, int new_trans_split_row,
+                                int new_trans_row)
+{
+    SRInfo *info = gnc_split_register_get_info (reg);
+    Table *table = reg->table;
+    gboolean multi_line = (reg->style == REG_STYLE_JOURNAL);
+    gboolean dynamic = (reg->style == REG_STYLE_AUTO_LEDGER);
+
+    /* restore the cursor to its rightful position */
+    {
+        VirtualLocation trans_split_loc;
+        Split *trans_split;
+
+        if (new_split_row > 0)
+            save_loc.vcell_loc.virt_row = new_split_row;
+        else if (new_trans_split_row > 0)
+            save_loc.vcell_loc.virt_row = new_trans_split_row;
+        else if (new_trans_row > 0)
+            save_loc.vcell_loc.virt_row = new_trans_row;
+
+        trans_split_loc = save_loc;
+
+        trans_split =
+            gnc_split_register_get_trans_split (reg, save_loc.vcell_loc,
+                                                &trans_split_loc.vcell_loc);
+
+        if (dynamic || multi_line || info->trans_expanded)
+        {
+            gnc_table_set_virt_cell_cursor(
+                table, trans_split_loc.vcell_loc,
+                gnc_split_register_get_active_cursor (reg));
+            gnc_split_register_set_trans_visible (reg, trans_split_loc.vcell_loc,
+                                                  TRUE, multi_line);
+
+            info->trans_expanded = (reg->style == REG_STYLE_LEDGER);
+        }
+        else
+        {
+            save_loc = trans_split_loc;
+            info->trans_expanded = FALSE;
+        }
+
+        if (gnc_table_find_close_valid_cell (table, &save_loc, FALSE))
+        {
+            gnc_table_move_cursor_gui (table, save_loc);
+
+            if (find_split == gnc_split_register_get_current_split (reg))
+                gnc_table_restore_current_cursor (table, cursor_buffer);
+        }
+
+        gnc_cursor_buffer_destroy (cursor_buffer);
+        cursor_buffer = NULL;
+    }
+
+    /* Set up the hint transaction, split, transaction split, and column. */
+    info->cursor_hint_trans = gnc_split_register_get_current_trans (reg);
+    info->cursor_hint_split = gnc_split_register_get_current_split (reg);
+    info->cursor_hint_trans_split =
+        gnc_split_register_get_current_trans_split (reg, NULL);
+    info->cursor_hint_cursor_class =
+        gnc_split_register_get_current_cursor_class (reg);
+    info->hint_set_by_traverse = FALSE;
+    info->traverse_to_new = FALSE;
+    info->exact_traversal = FALSE;
+    info->first_pass = FALSE;
+    info->reg_loaded = TRUE;
+
+    gnc_split_register_set_cell_fractions(
+        reg, gnc_split_register_get_current_split (reg));
+
+    gnc_table_refresh_gui (table, TRUE);
+
+    gnc_split_register_show_trans (reg, table->current_cursor_loc.vcell_loc);
+
+    /* enable callback for cursor user-driven moves */
+    gnc_table_control_allow_move (table->control, TRUE);
+}
+
+void
+gnc_split_register_load (SplitRegister *reg, GList * slist,
+                         Account *default_account)
+{
+    SRInfo *info;
+    Transaction *pending_trans;
+    CursorBuffer *cursor_buffer;
+    GHashTable *trans_table = NULL;
+    CellBlock *cursor_header;
+    CellBlock *lead_cursor;
+    CellBlock *split_cursor;
+    Transaction *blank_trans;
+    Transaction *find_trans;
+    Transaction *trans;
+    CursorClass find_class;
+    Split *find_trans_split;
+    Split *blank_split;
+    Split *find_split;
+    Split *split;
+    Table *table;
+    GList *node;
+
+    gboolean start_primary_color = TRUE;
+    gboolean found_pending = FALSE;
+    gboolean found_divider = FALSE;
+    gboolean has_last_num = FALSE;
+    gboolean multi_line;
+    gboolean we_own_slist = FALSE;
+
+    VirtualCellLocation vcell_loc;
+    VirtualLocation save_loc;
+
+    int new_trans_split_row = -1;
+    int new_trans_row = -1;
+    int new_split_row = -1;
+    time_t present;
+
+    g_return_if_fail(reg);
+    table = reg->table;
+    g_return_if_fail(table);
+    info = gnc_split_register_get_info (reg);
+    g_return_if_fail(info);
+
+    ENTER("reg=%p, slist=%p, default_account=%p", reg, slist, default_account);
+
+    pending_trans = xaccTransLookup (&info->pending_trans_guid,
+                                     gnc_get_current_book ());
+
+    blank_split = gnc_split_register_ensure_blank_split (reg, default_account,
+                  pending_trans);
+
     blank_trans = xaccSplitGetParent (blank_split);
 
     DEBUG("blank_split=%p, blank_trans=%p, pending_trans=%p",
@@ -376,7 +512,6 @@ gnc_split_register_load (SplitRegister *reg, GList * slist,
     // gnc_table_leave_update (table, table->current_cursor_loc);
 
     multi_line = (reg->style == REG_STYLE_JOURNAL);
-    dynamic    = (reg->style == REG_STYLE_AUTO_LEDGER);
 
     lead_cursor = gnc_split_register_get_passive_cursor (reg);
     split_cursor = gnc_table_layout_get_cursor (table->layout, CURSOR_SPLIT);
@@ -448,6 +583,9 @@ gnc_split_register_load (SplitRegister *reg, GList * slist,
             }
         }
 
+        if (!info->quickfill_guids)
+            info->quickfill_guids = g_array_new (FALSE, FALSE, sizeof (GncGUID));
+
         /* load up account names into the transfer combobox menus */
         gnc_split_register_load_xfer_cells (reg, default_account);
         gnc_split_register_load_recn_cells (reg);
@@ -536,10 +674,20 @@ gnc_split_register_load (SplitRegister *reg, GList * slist,
             found_divider = TRUE;
         }
 
-        /* If this is the first load of the register,
-         * fill up the quickfill cells. */
+        /* If this is the first load of the register, queue the
+         * transaction for the quickfill cells.  Filling them is the
+         * bulk of the work of loading a long register, so it is left
+         * to the main loop and the register shows up right away. */
         if (info->first_pass)
-            add_quickfill_completions(reg->table->layout, trans, has_last_num);
+        {
+            if (!has_last_num)
+                gnc_num_cell_set_last_num(
+                    (NumCell *) gnc_table_layout_get_cell(table->layout, NUM_CELL),
+                    xaccTransGetNum(trans));
+
+            g_array_append_vals (info->quickfill_guids,
+                                 xaccTransGetGUID (trans), 1);
+        }
 
         if (trans == find_trans)
             new_trans_row = vcell_loc.virt_row;
@@ -561,6 +709,10 @@ gnc_split_register_load (SplitRegister *reg, GList * slist,
     if (multi_line)
         g_hash_table_destroy (trans_table);
 
+    if (info->first_pass && !info->quickfill_source_id)
+        info->quickfill_source_id =
+            g_idle_add (gnc_split_register_quickfill_idle, reg);
+
     /* add the blank split at the end. */
     if (pending_trans == blank_trans)
         found_pending = TRUE;
@@ -607,80 +759,487 @@ gnc_split_register_load (SplitRegister *reg, GList * slist,
     /* num_virt_cols is always one. */
     gnc_table_set_size (table, vcell_loc.virt_row, 1);
 
-    /* restore the cursor to its rightful position */
+    gnc_split_register_load_finish (reg, save_loc, cursor_buffer, find_split,
+                                    new_split_row, new_trans_split_row,
+                                    new_trans_row);
+
+    if (we_own_slist)
+        g_list_free(slist);
+
+    LEAVE(" ");
+}
+
+/* ===================================================================== */
+
+/* One change to the rows of a loaded register.  The changes are all
+ * worked out before any row is touched and then applied from the
+ * bottom up, so virt_row is a row of the register as it was loaded. */
+typedef struct
+{
+    int virt_row;   /* first row affected */
+    int num_rows;   /* number of rows to remove, 0 to add a transaction */
+    int new_row;    /* where an added transaction ends up */
+    Split *split;   /* anchoring split of an added transaction */
+} SRRowChange;
+
+/* Return the number of rows gnc_split_register_add_transaction() uses
+ * for a transaction. */
+static int
+gnc_split_register_count_trans_rows (Transaction *trans, gboolean add_empty)
+{
+    GList *node;
+    int rows = 1;
+
+    for (node = xaccTransGetSplitList (trans); node; node = node->next)
+        if (xaccTransStillHasSplit (trans, node->data))
+            rows++;
+
+    return add_empty ? rows + 1 : rows;
+}
+
+/* Return the first row after the transaction leading at virt_row. */
+static int
+gnc_split_register_trans_end_row (SplitRegister *reg, int virt_row)
+{
+    VirtualCellLocation vcell_loc;
+
+    vcell_loc.virt_row = virt_row + 1;
+    vcell_loc.virt_col = 0;
+
+    while ((vcell_loc.virt_row < reg->table->num_virt_rows) &&
+            (gnc_split_register_get_cursor_class (reg, vcell_loc) ==
+             CURSOR_CLASS_SPLIT))
+        vcell_loc.virt_row++;
+
+    return vcell_loc.virt_row;
+}
+
+/* Return TRUE if the transaction leading at virt_row is gone or has
+ * changed. Otherwise *split is set to its anchoring split. */
+static gboolean
+gnc_split_register_trans_changed (SplitRegister *reg, int virt_row,
+                                  GHashTable *changes, Split **split)
+{
+    VirtualCellLocation vcell_loc;
+    Transaction *trans;
+
+    vcell_loc.virt_row = virt_row;
+    vcell_loc.virt_col = 0;
+
+    *split = gnc_split_register_get_split (reg, vcell_loc);
+    trans = xaccSplitGetParent (*split);
+    if (!trans || !xaccTransStillHasSplit (trans, *split))
+        return TRUE;
+
+    return gnc_gui_get_entity_events (changes, xaccTransGetGUID (trans)) != NULL;
+}
+
+/* Look for the rows of the cursor hints in a transaction that keeps
+ * its rows, the way gnc_split_register_add_transaction() does for a
+ * new one. offset is how far the rows will move. */
+static void
+gnc_split_register_find_kept_rows (SplitRegister *reg,
+                                   int virt_row, int end_row, int offset,
+                                   Transaction *trans, Split *split,
+                                   Transaction *find_trans, Split *find_split,
+                                   CursorClass find_class, int *new_split_row)
+{
+    VirtualCellLocation vcell_loc;
+
+    if (split == find_split)
+        *new_split_row = MAX (*new_split_row, virt_row + offset);
+
+    if ((trans != find_trans) || (find_class != CURSOR_CLASS_SPLIT))
+        return;
+
+    /* This also finds the empty row when find_split is NULL. */
+    vcell_loc.virt_col = 0;
+    for (vcell_loc.virt_row = virt_row + 1; vcell_loc.virt_row < end_row;
+            vcell_loc.virt_row++)
+        if (gnc_split_register_get_split (reg, vcell_loc) == find_split)
+            *new_split_row = MAX (*new_split_row, vcell_loc.virt_row + offset);
+}
+
+/* Give every transaction the passive cursor, its color and collapsed
+ * splits back, as they would be after a full load. */
+static void
+gnc_split_register_reset_rows (SplitRegister *reg, CellBlock *lead_cursor,
+                               gboolean multi_line)
+{
+    Table *table = reg->table;
+    VirtualCellLocation vcell_loc;
+    gboolean start_primary_color = TRUE;
+
+    vcell_loc.virt_col = 0;
+    for (vcell_loc.virt_row = 1; vcell_loc.virt_row < table->num_virt_rows;
+            vcell_loc.virt_row++)
     {
-        VirtualLocation trans_split_loc;
-        Split *trans_split;
+        VirtualCell *vcell = gnc_table_get_virtual_cell (table, vcell_loc);
+        const GncGUID *guid = vcell->vcell_data;
 
-        if (new_split_row > 0)
-            save_loc.vcell_loc.virt_row = new_split_row;
-        else if (new_trans_split_row > 0)
-            save_loc.vcell_loc.virt_row = new_trans_split_row;
-        else if (new_trans_row > 0)
-            save_loc.vcell_loc.virt_row = new_trans_row;
+        if (gnc_split_register_get_cursor_class (reg, vcell_loc) ==
+                CURSOR_CLASS_TRANS)
+        {
+            vcell->cellblock = lead_cursor;
+            vcell->start_primary_color = start_primary_color ? 1 : 0;
 
-        trans_split_loc = save_loc;
+            if (!multi_line)
+                start_primary_color = !start_primary_color;
+        }
+        else
+            vcell->visible = (multi_line && guid &&
+                              !guid_equal (guid, guid_null ())) ? 1 : 0;
+    }
+}
 
-        trans_split =
-            gnc_split_register_get_trans_split (reg, save_loc.vcell_loc,
-                                                &trans_split_loc.vcell_loc);
+gboolean
+gnc_split_register_load_changes (SplitRegister *reg, GList *slist,
+                                 GHashTable *changes,
+                                 Account *default_account)
+{
+    SRInfo *info;
+    Transaction *pending_trans;
+    CursorBuffer *cursor_buffer;
+    GHashTable *trans_table = NULL;
+    GArray *row_changes;
+    CellBlock *lead_cursor;
+    CellBlock *split_cursor;
+    Transaction *blank_trans;
+    Transaction *find_trans;
+    Transaction *trans;
+    CursorClass find_class;
+    Split *find_trans_split;
+    Split *blank_split;
+    Split *find_split;
+    Split *kept_split;
+    Split *split;
+    Table *table;
+    GList *node;
 
-        if (dynamic || multi_line || info->trans_expanded)
+    gboolean found_divider = FALSE;
+    gboolean multi_line;
+    gboolean ok = TRUE;
+
+    VirtualCellLocation vcell_loc;
+    VirtualLocation save_loc;
+
+    int new_trans_split_row = -1;
+    int new_trans_row = -1;
+    int new_split_row = -1;
+    int dividing_row = -1;
+    int virt_row, end_row, blank_row, new_row, save_row, found_row;
+    int i;
+    time_t present;
+
+    g_return_val_if_fail(reg, FALSE);
+    table = reg->table;
+    g_return_val_if_fail(table, FALSE);
+    info = gnc_split_register_get_info (reg);
+    g_return_val_if_fail(info, FALSE);
+
+    if (!changes || !info->reg_loaded || info->first_pass ||
+            info->separator_changed)
+        return FALSE;
+
+    ENTER("reg=%p, slist=%p, changes=%p, default_account=%p", reg, slist,
+          changes, default_account);
+
+    pending_trans = xaccTransLookup (&info->pending_trans_guid,
+                                     gnc_get_current_book ());
+    blank_split = xaccSplitLookup (&info->blank_split_guid,
+                                   gnc_get_current_book ());
+
+    /* A transaction being edited stays in the register even if it no
+     * longer belongs there. Leave that to a full load. */
+    if (pending_trans &&
+            (!blank_split || (pending_trans != xaccSplitGetParent (blank_split))))
+    {
+        LEAVE("pending transaction");
+        return FALSE;
+    }
+
+    /* The blank transaction is always the last one. */
+    vcell_loc.virt_col = 0;
+    for (blank_row = table->num_virt_rows - 1; blank_row > 0; blank_row--)
+    {
+        vcell_loc.virt_row = blank_row;
+        if (gnc_split_register_get_cursor_class (reg, vcell_loc) ==
+                CURSOR_CLASS_TRANS)
+            break;
+    }
+    if (blank_row <= 0)
+    {
+        LEAVE("no blank transaction");
+        return FALSE;
+    }
+
+    blank_split = gnc_split_register_ensure_blank_split (reg, default_account,
+                  pending_trans);
+    blank_trans = xaccSplitGetParent (blank_split);
+
+    info->default_account = *xaccAccountGetGUID (default_account);
+
+    multi_line = (reg->style == REG_STYLE_JOURNAL);
+
+    lead_cursor = gnc_split_register_get_passive_cursor (reg);
+    split_cursor = gnc_table_layout_get_cursor (table->layout, CURSOR_SPLIT);
+
+    /* figure out where we are going to. */
+    if (info->traverse_to_new)
+    {
+        find_trans = blank_trans;
+        find_split = NULL;
+        find_trans_split = blank_split;
+        find_class = CURSOR_CLASS_SPLIT;
+    }
+    else
+    {
+        find_trans = info->cursor_hint_trans;
+        find_split = info->cursor_hint_split;
+        find_trans_split = info->cursor_hint_trans_split;
+        find_class = info->cursor_hint_cursor_class;
+    }
+
+    save_loc = table->current_cursor_loc;
+    save_row = save_loc.vcell_loc.virt_row;
+
+    present = gnc_timet_get_today_end ();
+
+    /* Walk the new split list next to the loaded rows. Transactions
+     * that changed get new rows, the others must still be loaded in
+     * the same order, or a full load is needed after all. */
+    row_changes = g_array_new (FALSE, FALSE, sizeof (SRRowChange));
+
+    if (multi_line)
+        trans_table = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+    virt_row = 1;
+    new_row = 1;
+    kept_split = NULL;
+
+    for (node = slist; ok && node; node = node->next)
+    {
+        SRRowChange change;
+        int num_rows;
+
+        split = node->data;
+        trans = xaccSplitGetParent (split);
+
+        if (!xaccTransStillHasSplit(trans, split))
+            continue;
+
+        /* Do not load splits from the blank transaction. */
+        if (trans == blank_trans)
+            continue;
+
+        if (multi_line)
         {
-            gnc_table_set_virt_cell_cursor(
-                table, trans_split_loc.vcell_loc,
-                gnc_split_register_get_active_cursor (reg));
-            gnc_split_register_set_trans_visible (reg, trans_split_loc.vcell_loc,
-                                                  TRUE, multi_line);
+            /* Skip this split if its transaction has already been loaded. */
+            if (g_hash_table_lookup (trans_table, trans))
+                continue;
 
-            info->trans_expanded = (reg->style == REG_STYLE_LEDGER);
+            g_hash_table_insert (trans_table, trans, trans);
+        }
+
+        if (gnc_gui_get_entity_events (changes, xaccTransGetGUID (trans)))
+        {
+            change.virt_row = virt_row;
+            change.num_rows = 0;
+            change.new_row = new_row;
+            change.split = split;
+            g_array_append_val (row_changes, change);
+
+            num_rows = gnc_split_register_count_trans_rows (trans, TRUE);
         }
         else
         {
-            save_loc = trans_split_loc;
-            info->trans_expanded = FALSE;
+            /* Drop the rows of the transactions that changed or went
+             * away since, until we get to the one this split leads. */
+            while ((virt_row < blank_row) &&
+                    gnc_split_register_trans_changed (reg, virt_row, changes,
+                            &kept_split))
+            {
+                end_row = gnc_split_register_trans_end_row (reg, virt_row);
+
+                change.virt_row = virt_row;
+                change.num_rows = end_row - virt_row;
+                change.new_row = new_row;
+                change.split = NULL;
+                g_array_append_val (row_changes, change);
+
+                if ((save_row >= virt_row) && (save_row < end_row))
+                    save_loc.vcell_loc.virt_row = new_row;
+
+                virt_row = end_row;
+            }
+
+            if ((virt_row >= blank_row) || (kept_split != split))
+            {
+                ok = FALSE;
+                break;
+            }
+
+            end_row = gnc_split_register_trans_end_row (reg, virt_row);
+            num_rows = end_row - virt_row;
+
+            gnc_split_register_find_kept_rows (reg, virt_row, end_row,
+                                               new_row - virt_row, trans, split,
+                                               find_trans, find_split,
+                                               find_class, &new_split_row);
+
+            if ((save_row >= virt_row) && (save_row < end_row))
+                save_loc.vcell_loc.virt_row = save_row + new_row - virt_row;
+
+            virt_row = end_row;
         }
 
-        if (gnc_table_find_close_valid_cell (table, &save_loc, FALSE))
+        if (info->show_present_divider &&
+                !found_divider &&
+                (present < xaccTransGetDate (trans)))
         {
-            gnc_table_move_cursor_gui (table, save_loc);
-            new_split_row = save_loc.vcell_loc.virt_row;
+            dividing_row = new_row;
+            found_divider = TRUE;
+        }
 
-            if (find_split == gnc_split_register_get_current_split (reg))
-                gnc_table_restore_current_cursor (table, cursor_buffer);
+        if (trans == find_trans)
+            new_trans_row = new_row;
+
+        if (split == find_trans_split)
+            new_trans_split_row = new_row;
+
+        new_row += num_rows;
+    }
+
+    if (multi_line)
+        g_hash_table_destroy (trans_table);
+
+    /* Whatever is left above the blank transaction must be gone. */
+    while (ok && (virt_row < blank_row))
+    {
+        SRRowChange change;
+
+        if (!gnc_split_register_trans_changed (reg, virt_row, changes,
+                                               &kept_split))
+        {
+            ok = FALSE;
+            break;
         }
 
-        gnc_cursor_buffer_destroy (cursor_buffer);
+        end_row = gnc_split_register_trans_end_row (reg, virt_row);
+
+        change.virt_row = virt_row;
+        change.num_rows = end_row - virt_row;
+        change.new_row = new_row;
+        change.split = NULL;
+        g_array_append_val (row_changes, change);
+
+        if ((save_row >= virt_row) && (save_row < end_row))
+            save_loc.vcell_loc.virt_row = new_row;
+
+        virt_row = end_row;
+    }
+
+    if (!ok)
+    {
+        g_array_free (row_changes, TRUE);
+        LEAVE("rows differ from the split list");
+        return FALSE;
+    }
+
+    if (save_row >= blank_row)
+        save_loc.vcell_loc.virt_row = save_row + new_row - blank_row;
+
+    /* If the current cursor has changed we save the values for later
+     * possible restoration. */
+    if (gnc_table_current_cursor_changed (table, TRUE) &&
+            (find_split == gnc_split_register_get_current_split (reg)))
+    {
+        cursor_buffer = gnc_cursor_buffer_new ();
+        gnc_table_save_current_cursor (table, cursor_buffer);
+    }
+    else
         cursor_buffer = NULL;
+
+    /* disable move callback -- we don't want the cascade of
+     * callbacks while we are fiddling with loading the register */
+    gnc_table_control_allow_move (table->control, FALSE);
+
+    /* invalidate the cursor */
+    {
+        VirtualLocation virt_loc;
+
+        gnc_virtual_location_init(&virt_loc);
+        gnc_table_move_cursor_gui (table, virt_loc);
     }
 
-    /* Set up the hint transaction, split, transaction split, and column. */
-    info->cursor_hint_trans = gnc_split_register_get_current_trans (reg);
-    info->cursor_hint_split = gnc_split_register_get_current_split (reg);
-    info->cursor_hint_trans_split =
-        gnc_split_register_get_current_trans_split (reg, NULL);
-    info->cursor_hint_cursor_class =
-        gnc_split_register_get_current_cursor_class (reg);
-    info->hint_set_by_traverse = FALSE;
-    info->traverse_to_new = FALSE;
-    info->exact_traversal = FALSE;
-    info->first_pass = FALSE;
-    info->reg_loaded = TRUE;
+    table->model->dividing_row = dividing_row;
 
-    gnc_split_register_set_cell_fractions(
-        reg, gnc_split_register_get_current_split (reg));
+    /* The blank transaction is loaded again from scratch, being the
+     * last, then the changes are made from the bottom up. */
+    gnc_table_delete_virt_rows (table, blank_row,
+                                table->num_virt_rows - blank_row);
 
-    gnc_table_refresh_gui (table, TRUE);
+    if (blank_trans == find_trans)
+        new_trans_row = new_row;
 
-    gnc_split_register_show_trans (reg, table->current_cursor_loc.vcell_loc);
+    if (blank_split == find_trans_split)
+        new_trans_split_row = new_row;
 
-    /* enable callback for cursor user-driven moves */
-    gnc_table_control_allow_move (table->control, TRUE);
+    vcell_loc.virt_row = blank_row;
+    vcell_loc.virt_col = 0;
+    found_row = -1;
 
-    if (we_own_slist)
-        g_list_free(slist);
+    gnc_split_register_add_transaction (reg, blank_trans, blank_split,
+                                        lead_cursor, split_cursor,
+                                        multi_line, TRUE,
+                                        info->blank_split_edited, find_trans,
+                                        find_split, find_class, &found_row,
+                                        &vcell_loc);
+
+    if (found_row >= 0)
+        new_split_row = MAX (new_split_row, found_row + new_row - blank_row);
+
+    for (i = (int) row_changes->len - 1; i >= 0; i--)
+    {
+        SRRowChange *change = &g_array_index (row_changes, SRRowChange, i);
+
+        if (change->num_rows > 0)
+        {
+            gnc_table_delete_virt_rows (table, change->virt_row,
+                                        change->num_rows);
+            continue;
+        }
+
+        trans = xaccSplitGetParent (change->split);
+        gnc_table_insert_virt_rows (table, change->virt_row,
+                                    gnc_split_register_count_trans_rows (trans,
+                                            TRUE));
+
+        vcell_loc.virt_row = change->virt_row;
+        found_row = -1;
+
+        gnc_split_register_add_transaction (reg, trans, change->split,
+                                            lead_cursor, split_cursor,
+                                            multi_line, TRUE, TRUE,
+                                            find_trans, find_split, find_class,
+                                            &found_row, &vcell_loc);
+
+        if (found_row >= 0)
+            new_split_row = MAX (new_split_row, found_row + change->new_row -
+                                 change->virt_row);
+    }
+
+    PINFO ("%d row changes", row_changes->len);
+    g_array_free (row_changes, TRUE);
+
+    gnc_split_register_reset_rows (reg, lead_cursor, multi_line);
+
+    gnc_split_register_load_finish (reg, save_loc, cursor_buffer, find_split,
+                                    new_split_row, new_trans_split_row,
+                                    new_trans_row);
 
     LEAVE(" ");
+    return TRUE;
 }
 
 /* ===================================================================== */
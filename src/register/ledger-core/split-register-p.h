@@ -87,6 +87,13 @@ struct sr_info
     /* true if we are loading the register for the first time */
     gboolean first_pass;
 
+    /* GUIDs of the loaded transactions whose strings have yet to be
+     * added to the quickfill cells, the next one to add, and the idle
+     * source adding them */
+    GArray *quickfill_guids;
+    guint quickfill_next;
+    guint quickfill_source_id;
+
     /* true if the user has already confirmed changes of a reconciled
      * split */
     gboolean change_confirmed;
@@ -2602,6 +2602,11 @@ gnc_split_register_destroy_info (SplitRegister *reg)
     if (!info)
         return;
 
+    if (info->quickfill_source_id)
+        g_source_remove (info->quickfill_source_id);
+    if (info->quickfill_guids)
+        g_array_free (info->quickfill_guids, TRUE);
+
     g_free (info->debit_str);
     g_free (info->tdebit_str);
     g_free (info->credit_str);
@@ -500,6 +500,12 @@ void gnc_split_register_cancel_cursor_trans_changes (SplitRegister *reg);
  *  various default values for the blank split (such as currency, last check
  *  number, and transfer account) for the blank split.
  *
+ *  A virtual row is set up for every split in @a slist, so the time
+ *  taken still grows with the length of the list.  On the first load
+ *  the strings of the transactions are added to the quickfill cells
+ *  afterwards, from an idle handler, so completions for older
+ *  transactions may show up a little after the register does.
+ *
  *  @param reg a ::SplitRegister
  *
  *  @param slist a list of splits
@@ -509,6 +515,31 @@ void gnc_split_register_cancel_cursor_trans_changes (SplitRegister *reg);
 void gnc_split_register_load (SplitRegister *reg, GList * slist,
                               Account *default_account);
 
+/** Brings the rows of a loaded register up to date with a new list of
+ *  splits, without loading it again from scratch.
+ *
+ *  Only the rows of the transactions that have an entry in @a changes
+ *  (a hash of changes as passed to a component refresh handler) are
+ *  removed or added; all other transactions must still be in @a slist,
+ *  in the order they were loaded in.  The blank split area is loaded
+ *  again as well.
+ *
+ *  @param reg a ::SplitRegister
+ *
+ *  @param slist the complete, new list of splits
+ *
+ *  @param changes the entities that changed since the register was
+ *  last loaded
+ *
+ *  @param default_account an account to provide defaults for the blank split
+ *
+ *  @return FALSE, in which case gnc_split_register_load() must be
+ *  used, if the register could not be updated this way
+ */
+gboolean gnc_split_register_load_changes (SplitRegister *reg, GList *slist,
+        GHashTable *changes,
+        Account *default_account);
+
 /** Copy the contents of the current cursor to a split. The split and
  *    transaction that are updated are the ones associated with the
  *    current cursor (register entry) position. If the do_commit flag
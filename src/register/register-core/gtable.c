@@ -151,6 +151,70 @@ g_table_resize (GTable *gtable, int rows, int cols)
     gtable->cols = cols;
 }
 
+void
+g_table_insert_rows (GTable *gtable, int row, int num_rows)
+{
+    guint row_size;
+    gchar *entry;
+    guint i;
+
+    if (gtable == NULL)
+        return;
+    if ((row < 0) || (row > gtable->rows) || (num_rows <= 0))
+        return;
+    if (gtable->cols == 0)
+        return;
+
+    row_size = gtable->cols * gtable->entry_size;
+
+    g_array_set_size (gtable->array,
+                      gtable->array->len + num_rows * gtable->cols);
+
+    entry = &gtable->array->data[row * row_size];
+    g_memmove (entry + num_rows * row_size, entry,
+               (gtable->rows - row) * row_size);
+
+    if (gtable->constructor)
+        for (i = 0; i < num_rows * gtable->cols; i++)
+        {
+            gtable->constructor(entry, gtable->user_data);
+            entry += gtable->entry_size;
+        }
+
+    gtable->rows += num_rows;
+}
+
+void
+g_table_delete_rows (GTable *gtable, int row, int num_rows)
+{
+    gchar *entry;
+    guint i;
+
+    if (gtable == NULL)
+        return;
+    if ((row < 0) || (row >= gtable->rows) || (num_rows <= 0))
+        return;
+    if (gtable->cols == 0)
+        return;
+
+    num_rows = MIN (num_rows, gtable->rows - row);
+
+    if (gtable->destroyer)
+    {
+        entry = &gtable->array->data[row * gtable->cols * gtable->entry_size];
+        for (i = 0; i < num_rows * gtable->cols; i++)
+        {
+            gtable->destroyer(entry, gtable->user_data);
+            entry += gtable->entry_size;
+        }
+    }
+
+    g_array_remove_range (gtable->array, row * gtable->cols,
+                          num_rows * gtable->cols);
+
+    gtable->rows -= num_rows;
+}
+
 int
 g_table_rows (GTable *gtable)
 {
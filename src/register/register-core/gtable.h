@@ -61,6 +61,14 @@ gpointer g_table_index (GTable *gtable, int row, int col);
  * first. */
 void     g_table_resize (GTable *gtable, int rows, int cols);
 
+/* Insert num_rows new rows before the given row, moving the rows
+ * below it down. The new members are constructed as for resizing. */
+void     g_table_insert_rows (GTable *gtable, int row, int num_rows);
+
+/* Remove num_rows rows starting with the given row, moving the rows
+ * below them up. The removed members are destroyed. */
+void     g_table_delete_rows (GTable *gtable, int row, int num_rows);
+
 /* Return the number of table rows. */
 int      g_table_rows (GTable *gtable);
 
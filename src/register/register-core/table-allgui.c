@@ -623,6 +623,42 @@ gnc_table_set_size (Table * table, int virt_rows, int virt_cols)
     gnc_table_resize (table, virt_rows, virt_cols);
 }
 
+static void
+gnc_table_invalidate_cursor_from (Table *table, int virt_row)
+{
+    if (table->current_cursor_loc.vcell_loc.virt_row >= virt_row)
+    {
+        gnc_virtual_location_init (&table->current_cursor_loc);
+        table->current_cursor = NULL;
+    }
+}
+
+void
+gnc_table_insert_virt_rows (Table *table, int virt_row, int num_rows)
+{
+    if (!table) return;
+    if ((virt_row < 0) || (virt_row > table->num_virt_rows) || (num_rows <= 0))
+        return;
+
+    gnc_table_invalidate_cursor_from (table, virt_row);
+
+    g_table_insert_rows (table->virt_cells, virt_row, num_rows);
+    table->num_virt_rows = g_table_rows (table->virt_cells);
+}
+
+void
+gnc_table_delete_virt_rows (Table *table, int virt_row, int num_rows)
+{
+    if (!table) return;
+    if ((virt_row < 0) || (virt_row >= table->num_virt_rows) || (num_rows <= 0))
+        return;
+
+    gnc_table_invalidate_cursor_from (table, virt_row);
+
+    g_table_delete_rows (table->virt_cells, virt_row, num_rows);
+    table->num_virt_rows = g_table_rows (table->virt_cells);
+}
+
 static void
 gnc_table_free_data (Table * table)
 {
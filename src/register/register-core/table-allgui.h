@@ -245,6 +245,16 @@ VirtualCell *  gnc_table_get_header_cell (Table *table);
  *   indicated dimensions.  */
 void        gnc_table_set_size (Table * table, int virt_rows, int virt_cols);
 
+/* The gnc_table_insert_virt_rows() method inserts num_rows empty
+ *   virtual rows before virt_row, and gnc_table_delete_virt_rows()
+ *   removes num_rows virtual rows starting at virt_row.  The rows
+ *   below move along.  The cursor is invalidated if it was on or
+ *   below virt_row. */
+void        gnc_table_insert_virt_rows (Table *table, int virt_row,
+                                        int num_rows);
+void        gnc_table_delete_virt_rows (Table *table, int virt_row,
+                                        int num_rows);
+
 /* Indicate what handler should be used for a given virtual block */
 void        gnc_table_set_vcell (Table *table, CellBlock *cursor,
                                  gconstpointer vcell_data,
@@ -349,10 +349,31 @@ gnucash_sheet_cursor_move (GnucashSheet *sheet, VirtualLocation virt_loc)
 }
 
 
+/* The block offsets only grow going down the sheet, so the block at a
+ * given height is found by bisection rather than by walking down from
+ * the top.  This keeps scrolling through long registers cheap. */
 static gint
 gnucash_sheet_y_pixel_to_block (GnucashSheet *sheet, int y)
 {
     VirtualCellLocation vcell_loc = { 1, 0 };
+    gint high = sheet->num_virt_rows;
+
+    while (vcell_loc.virt_row < high)
+    {
+        VirtualCellLocation mid_loc = { (vcell_loc.virt_row + high) / 2, 0 };
+        SheetBlock *block;
+        gint bottom;
+
+        block = gnucash_sheet_get_block (sheet, mid_loc);
+        bottom = block->origin_y;
+        if (block->visible)
+            bottom += block->style->dimensions->height;
+
+        if (bottom > y)
+            high = mid_loc.virt_row;
+        else
+            vcell_loc.virt_row = mid_loc.virt_row + 1;
+    }
 
     for (;
             vcell_loc.virt_row < sheet->num_virt_rows;